@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../dxvk/dxvk_cs.h"
 #include "../dxvk/dxvk_device.h"
 
 #include "../d3d10/d3d10_buffer.h"
@@ -102,7 +103,7 @@ namespace dxvk {
     }
     
     DxvkBufferSliceHandle DiscardSlice() {
-      m_mapped = m_buffer->allocSlice();
+      m_mapped = m_buffer->allocDiscardSlice();
       return m_mapped;
     }
 
@@ -110,6 +111,27 @@ namespace dxvk {
       return m_mapped;
     }
 
+    /**
+     * \brief Sequence number of last CS chunk using the buffer
+     *
+     * Only meaningful for staging buffers. For any other
+     * buffer, this returns \c DxvkCsThread::SynchronizeAll.
+     * \returns Sequence number to synchronize with
+     */
+    uint64_t GetSequenceNumber() const {
+      return m_desc.Usage == D3D11_USAGE_STAGING
+        ? m_seq : DxvkCsThread::SynchronizeAll;
+    }
+
+    /**
+     * \brief Tracks sequence number
+     *
+     * \param [in] Seq Sequence number of the CS chunk
+     */
+    void TrackSequenceNumber(uint64_t Seq) {
+      m_seq = Seq;
+    }
+
     D3D10Buffer* GetD3D10Iface() {
       return &m_d3d10;
     }
@@ -131,6 +153,7 @@ namespace dxvk {
     Rc<DxvkBuffer>              m_buffer;
     Rc<DxvkBuffer>              m_soCounter;
     DxvkBufferSliceHandle       m_mapped;
+    uint64_t                    m_seq = 0ull;
 
     D3D11DXGIResource           m_resource;
     D3D10Buffer                 m_d3d10;
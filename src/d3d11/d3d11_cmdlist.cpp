@@ -54,6 +54,13 @@ namespace dxvk {
   }
 
 
+  void D3D11CommandList::TrackResourceUsage(
+          ID3D11Resource*     pResource,
+          UINT                Subresource) {
+    m_resources.push_back({ pResource, Subresource });
+  }
+
+
   void D3D11CommandList::EmitToCommandList(ID3D11CommandList* pCommandList) {
     auto cmdList = static_cast<D3D11CommandList*>(pCommandList);
     
@@ -63,18 +70,29 @@ namespace dxvk {
     for (const auto& query : m_queries)
       cmdList->m_queries.push_back(query);
 
+    for (const auto& resource : m_resources)
+      cmdList->m_resources.push_back(resource);
+
     MarkSubmitted();
   }
   
   
-  void D3D11CommandList::EmitToCsThread(DxvkCsThread* CsThread) {
+  uint64_t D3D11CommandList::EmitToCsThread(DxvkCsThread* CsThread) {
+    uint64_t seq = 0;
+
     for (const auto& query : m_queries)
       query->DoDeferredEnd();
 
     for (const auto& chunk : m_chunks)
-      CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
+      seq = CsThread->dispatchChunk(DxvkCsChunkRef(chunk));
+    
+    // Tracked resources may be used by any of the chunks,
+    // so conservatively use the last sequence number
+    for (const auto& resource : m_resources)
+      TrackResourceSequenceNumber(resource.resource.ptr(), resource.subresource, seq);
     
     MarkSubmitted();
+    return seq;
   }
   
   
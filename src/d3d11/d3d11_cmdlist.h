@@ -28,20 +28,30 @@ namespace dxvk {
 
     void AddQuery(
             D3D11Query*         pQuery);
+
+    void TrackResourceUsage(
+            ID3D11Resource*     pResource,
+            UINT                Subresource);
     
     void EmitToCommandList(
             ID3D11CommandList*  pCommandList);
     
-    void EmitToCsThread(
+    uint64_t EmitToCsThread(
             DxvkCsThread*       CsThread);
     
   private:
+
+    struct TrackedResource {
+      Com<ID3D11Resource> resource;
+      UINT                subresource;
+    };
     
     D3D11Device* const m_device;
     UINT         const m_contextFlags;
     
     std::vector<DxvkCsChunkRef>         m_chunks;
     std::vector<Com<D3D11Query, false>> m_queries;
+    std::vector<TrackedResource>        m_resources;
 
     std::atomic<bool> m_submitted = { false };
     std::atomic<bool> m_warned    = { false };
@@ -20,6 +20,7 @@ namespace dxvk {
     m_device    (Device),
     m_csFlags   (CsFlags),
     m_csChunk   (AllocCsChunk()),
+    m_csStateElimination(Device->config().csStateElimination),
     m_cmdData   (nullptr) {
 
   }
@@ -396,6 +397,9 @@ namespace dxvk {
             cSrcSlice.length());
         }
       });
+
+      TrackResourceUsage(pDstResource, 0);
+      TrackResourceUsage(pSrcResource, 0);
     } else {
       const D3D11CommonTexture* dstTextureInfo = GetCommonTexture(pDstResource);
       const D3D11CommonTexture* srcTextureInfo = GetCommonTexture(pSrcResource);
@@ -545,6 +549,9 @@ namespace dxvk {
 
       if (dstTextureInfo->CanUpdateMappedBufferEarly())
         UpdateMappedBuffer(dstTextureInfo, dstSubresource);
+
+      TrackResourceUsage(pDstResource, DstSubresource);
+      TrackResourceUsage(pSrcResource, SrcSubresource);
     }
   }
   
@@ -594,6 +601,9 @@ namespace dxvk {
           cSrcBuffer.offset(),
           cSrcBuffer.length());
       });
+
+      TrackResourceUsage(pDstResource, 0);
+      TrackResourceUsage(pSrcResource, 0);
     } else {
       auto dstTexture = GetCommonTexture(pDstResource);
       auto srcTexture = GetCommonTexture(pSrcResource);
@@ -652,6 +662,11 @@ namespace dxvk {
             UpdateMappedBuffer(dstTexture, { dstLayers.aspectMask, i, j });
         }
       }
+
+      for (uint32_t i = 0; i < dstTexture->CountSubresources(); i++) {
+        TrackResourceUsage(pDstResource, i);
+        TrackResourceUsage(pSrcResource, i);
+      }
     }
   }
 
@@ -683,6 +698,8 @@ namespace dxvk {
         cSrcSlice.offset(),
         sizeof(uint32_t));
     });
+
+    TrackResourceUsage(buf, 0);
   }
 
 
@@ -1187,6 +1204,8 @@ namespace dxvk {
             cBufferSlice.length(),
             cDataBuffer.ptr());
         });
+
+        TrackResourceUsage(pDstResource, 0);
       }
     } else {
       const D3D11CommonTexture* textureInfo = GetCommonTexture(pDstResource);
@@ -1268,6 +1287,8 @@ namespace dxvk {
 
       if (textureInfo->CanUpdateMappedBufferEarly())
         UpdateMappedBuffer(textureInfo, subresource);
+
+      TrackResourceUsage(pDstResource, DstSubresource);
     }
   }
 
@@ -3147,13 +3168,13 @@ namespace dxvk {
     auto inputLayout = m_state.ia.inputLayout.prvRef();
 
     if (likely(inputLayout != nullptr)) {
-      EmitCs([
+      EmitCsState(DxvkCsState::InputLayout, [
         cInputLayout = std::move(inputLayout)
       ] (DxvkContext* ctx) {
         cInputLayout->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCsState(DxvkCsState::InputLayout, [] (DxvkContext* ctx) {
         ctx->setInputLayout(0, nullptr, 0, nullptr);
       });
     }
@@ -3187,7 +3208,7 @@ namespace dxvk {
       iaState = { VK_PRIMITIVE_TOPOLOGY_PATCH_LIST, VK_FALSE, vertexCount };
     }
     
-    EmitCs([iaState] (DxvkContext* ctx) {
+    EmitCsState(DxvkCsState::InputAssembly, [iaState] (DxvkContext* ctx) {
       ctx->setInputAssemblyState(iaState);
     });
   }
@@ -3195,14 +3216,14 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyBlendState() {
     if (m_state.om.cbState != nullptr) {
-      EmitCs([
+      EmitCsState(DxvkCsState::BlendState, [
         cBlendState = m_state.om.cbState,
         cSampleMask = m_state.om.sampleMask
       ] (DxvkContext* ctx) {
         cBlendState->BindToContext(ctx, cSampleMask);
       });
     } else {
-      EmitCs([
+      EmitCsState(DxvkCsState::BlendState, [
         cSampleMask = m_state.om.sampleMask
       ] (DxvkContext* ctx) {
         DxvkBlendMode cbState;
@@ -3221,7 +3242,7 @@ namespace dxvk {
   
   
   void D3D11DeviceContext::ApplyBlendFactor() {
-    EmitCs([
+    EmitCsState(DxvkCsState::BlendConstants, [
       cBlendConstants = DxvkBlendConstants {
         m_state.om.blendFactor[0], m_state.om.blendFactor[1],
         m_state.om.blendFactor[2], m_state.om.blendFactor[3] }
@@ -3233,13 +3254,13 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyDepthStencilState() {
     if (m_state.om.dsState != nullptr) {
-      EmitCs([
+      EmitCsState(DxvkCsState::DepthStencilState, [
         cDepthStencilState = m_state.om.dsState
       ] (DxvkContext* ctx) {
         cDepthStencilState->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCsState(DxvkCsState::DepthStencilState, [] (DxvkContext* ctx) {
         DxvkDepthStencilState dsState;
         InitDefaultDepthStencilState(&dsState);
 
@@ -3250,7 +3271,7 @@ namespace dxvk {
   
   
   void D3D11DeviceContext::ApplyStencilRef() {
-    EmitCs([
+    EmitCsState(DxvkCsState::StencilReference, [
       cStencilRef = m_state.om.stencilRef
     ] (DxvkContext* ctx) {
       ctx->setStencilReference(cStencilRef);
@@ -3260,13 +3281,13 @@ namespace dxvk {
   
   void D3D11DeviceContext::ApplyRasterizerState() {
     if (m_state.rs.state != nullptr) {
-      EmitCs([
+      EmitCsState(DxvkCsState::RasterizerState, [
         cRasterizerState = m_state.rs.state
       ] (DxvkContext* ctx) {
         cRasterizerState->BindToContext(ctx);
       });
     } else {
-      EmitCs([] (DxvkContext* ctx) {
+      EmitCsState(DxvkCsState::RasterizerState, [] (DxvkContext* ctx) {
         DxvkRasterizerState rsState;
         InitDefaultRasterizerState(&rsState);
 
@@ -3345,7 +3366,7 @@ namespace dxvk {
     }
     
     if (likely(viewportCount == 1)) {
-      EmitCs([
+      EmitCsState(DxvkCsState::Viewports, [
         cViewport = viewports[0],
         cScissor  = scissors[0]
       ] (DxvkContext* ctx) {
@@ -3354,7 +3375,7 @@ namespace dxvk {
           &cScissor);
       });
     } else {
-      EmitCs([
+      EmitCsState(DxvkCsState::Viewports, [
         cViewportCount = viewportCount,
         cViewports     = viewports,
         cScissors      = scissors
@@ -3371,23 +3392,24 @@ namespace dxvk {
   template<DxbcProgramType ShaderStage>
   void D3D11DeviceContext::BindShader(
     const D3D11CommonShader*    pShaderModule) {
-    // Bind the shader and the ICB at once
-    EmitCs([
-      cSlice  = pShaderModule           != nullptr
-             && pShaderModule->GetIcb() != nullptr
-        ? DxvkBufferSlice(pShaderModule->GetIcb())
-        : DxvkBufferSlice(),
-      cShader = pShaderModule != nullptr
-        ? pShaderModule->GetShader()
-        : nullptr
+    // Bind the shader and the ICB at once. The shader may still
+    // be compiling, so only wait for it on the CS thread.
+    EmitCsState(DxvkCsStateKey(DxvkCsState::Shader, uint32_t(ShaderStage)), [
+      cModule = pShaderModule != nullptr
+        ? *pShaderModule
+        : D3D11CommonShader()
     ] (DxvkContext* ctx) {
       VkShaderStageFlagBits stage = GetShaderStage(ShaderStage);
 
       uint32_t slotId = computeConstantBufferBinding(ShaderStage,
         D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT);
 
-      ctx->bindShader        (stage,  cShader);
-      ctx->bindResourceBuffer(slotId, cSlice);
+      Rc<DxvkBuffer> icb = cModule.GetIcb();
+
+      ctx->bindShader        (stage,  cModule.GetShader());
+      ctx->bindResourceBuffer(slotId, icb != nullptr
+        ? DxvkBufferSlice(icb)
+        : DxvkBufferSlice());
     });
   }
 
@@ -3413,7 +3435,7 @@ namespace dxvk {
     }
     
     // Create and bind the framebuffer object to the context
-    EmitCs([
+    EmitCsState(DxvkCsState::RenderTargets, [
       cAttachments = std::move(attachments)
     ] (DxvkContext* ctx) {
       ctx->bindRenderTargets(cAttachments);
@@ -3438,7 +3460,7 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Stride) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::VertexBuffer, Slot), [
       cSlotId       = Slot,
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
       cStride       = Stride
@@ -3456,7 +3478,7 @@ namespace dxvk {
       ? VK_INDEX_TYPE_UINT16
       : VK_INDEX_TYPE_UINT32;
     
-    EmitCs([
+    EmitCsState(DxvkCsState::IndexBuffer, [
       cBufferSlice  = pBuffer != nullptr ? pBuffer->GetBufferSlice(Offset) : DxvkBufferSlice(),
       cIndexType    = indexType
     ] (DxvkContext* ctx) {
@@ -3499,7 +3521,7 @@ namespace dxvk {
   void D3D11DeviceContext::BindConstantBuffer(
           UINT                              Slot,
           D3D11Buffer*                      pBuffer) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::ResourceBuffer, Slot), [
       cSlotId      = Slot,
       cBufferSlice = pBuffer ? pBuffer->GetBufferSlice() : DxvkBufferSlice()
     ] (DxvkContext* ctx) {
@@ -3513,7 +3535,7 @@ namespace dxvk {
           D3D11Buffer*                      pBuffer,
           UINT                              Offset,
           UINT                              Length) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::ResourceBuffer, Slot), [
       cSlotId      = Slot,
       cBufferSlice = Length ? pBuffer->GetBufferSlice(16 * Offset, 16 * Length) : DxvkBufferSlice()
     ] (DxvkContext* ctx) {
@@ -3525,7 +3547,7 @@ namespace dxvk {
   void D3D11DeviceContext::BindSampler(
           UINT                              Slot,
           D3D11SamplerState*                pSampler) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::ResourceSampler, Slot), [
       cSlotId   = Slot,
       cSampler  = pSampler != nullptr ? pSampler->GetDXVKSampler() : nullptr
     ] (DxvkContext* ctx) {
@@ -3537,7 +3559,7 @@ namespace dxvk {
   void D3D11DeviceContext::BindShaderResource(
           UINT                              Slot,
           D3D11ShaderResourceView*          pResource) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::ResourceView, Slot), [
       cSlotId     = Slot,
       cImageView  = pResource != nullptr ? pResource->GetImageView()  : nullptr,
       cBufferView = pResource != nullptr ? pResource->GetBufferView() : nullptr
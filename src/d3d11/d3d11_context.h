@@ -716,6 +716,7 @@ namespace dxvk {
     
     DxvkCsChunkFlags            m_csFlags;
     DxvkCsChunkRef              m_csChunk;
+    bool                        m_csStateElimination;
     
     D3D11ContextState           m_state;
     D3D11CmdData*               m_cmdData;
@@ -933,6 +934,21 @@ namespace dxvk {
       }
     }
 
+    template<typename Cmd>
+    void EmitCsState(DxvkCsStateKey Key, Cmd&& command) {
+      m_cmdData = nullptr;
+
+      if (unlikely(!m_csStateElimination))
+        Key = DxvkCsStateKey();
+
+      if (unlikely(!m_csChunk->push(command, Key))) {
+        EmitCsChunk(std::move(m_csChunk));
+        
+        m_csChunk = AllocCsChunk();
+        m_csChunk->push(command, Key);
+      }
+    }
+
     template<typename M, typename Cmd, typename... Args>
     M* EmitCsCmd(Cmd&& command, Args&&... args) {
       M* data = m_csChunk->pushCmd<M, Cmd, Args...>(
@@ -959,6 +975,10 @@ namespace dxvk {
     }
     
     virtual void EmitCsChunk(DxvkCsChunkRef&& chunk) = 0;
+
+    virtual void TrackResourceUsage(
+            ID3D11Resource*                   pResource,
+            UINT                              Subresource) = 0;
     
   };
   
@@ -416,6 +416,19 @@ namespace dxvk {
   }
 
 
+  void D3D11DeferredContext::TrackResourceUsage(
+          ID3D11Resource*               pResource,
+          UINT                          Subresource) {
+    D3D11_COMMON_RESOURCE_DESC desc;
+    GetCommonResourceDesc(pResource, &desc);
+
+    // Only staging resources have their sequence number
+    // tracked, so there is no need to record anything else
+    if (desc.Usage == D3D11_USAGE_STAGING)
+      m_commandList->TrackResourceUsage(pResource, Subresource);
+  }
+
+
   DxvkCsChunkFlags D3D11DeferredContext::GetCsChunkFlags(
           D3D11Device*                  pDevice) {
     return pDevice->GetOptions()->dcSingleUseMode
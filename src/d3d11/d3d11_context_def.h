@@ -115,6 +115,10 @@ namespace dxvk {
     
     void EmitCsChunk(DxvkCsChunkRef&& chunk);
 
+    void TrackResourceUsage(
+            ID3D11Resource*               pResource,
+            UINT                          Subresource);
+
     static DxvkCsChunkFlags GetCsChunkFlags(
             D3D11Device*                  pDevice);
     
@@ -30,7 +30,7 @@ namespace dxvk {
   
   D3D11ImmediateContext::~D3D11ImmediateContext() {
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
     SynchronizeDevice();
   }
   
@@ -209,7 +209,8 @@ namespace dxvk {
     
     // Dispatch command list to the CS thread and
     // restore the immediate context's state
-    commandList->EmitToCsThread(&m_csThread);
+    uint64_t csSeqNum = commandList->EmitToCsThread(&m_csThread);
+    m_csSeqNum = std::max(m_csSeqNum, csSeqNum);
     
     if (RestoreContextState)
       RestoreState();
@@ -371,7 +372,7 @@ namespace dxvk {
     } else {
       // Wait until the resource is no longer in use
       if (MapType != D3D11_MAP_WRITE_NO_OVERWRITE) {
-        if (!WaitForResource(pResource->GetBuffer(), MapType, MapFlags))
+        if (!WaitForResource(pResource->GetBuffer(), pResource->GetSequenceNumber(), MapType, MapFlags))
           return DXGI_ERROR_WAS_STILL_DRAWING;
       }
 
@@ -426,7 +427,7 @@ namespace dxvk {
       const VkImageType imageType = mappedImage->info().type;
       
       // Wait for the resource to become available
-      if (!WaitForResource(mappedImage, MapType, MapFlags))
+      if (!WaitForResource(mappedImage, pResource->GetSequenceNumber(Subresource), MapType, MapFlags))
         return DXGI_ERROR_WAS_STILL_DRAWING;
       
       // Mark the given subresource as mapped
@@ -467,10 +468,12 @@ namespace dxvk {
          && !pResource->CanUpdateMappedBufferEarly()) {
           UpdateMappedBuffer(pResource, subresource);
           MapFlags &= ~D3D11_MAP_FLAG_DO_NOT_WAIT;
+
+          pResource->TrackSequenceNumber(Subresource, GetCurrentSequenceNumber());
         }
         
         // Wait for mapped buffer to become available
-        if (!WaitForResource(mappedBuffer, MapType, MapFlags))
+        if (!WaitForResource(mappedBuffer, pResource->GetSequenceNumber(Subresource), MapType, MapFlags))
           return DXGI_ERROR_WAS_STILL_DRAWING;
         
         physSlice = mappedBuffer->getSliceHandle();
@@ -541,6 +544,8 @@ namespace dxvk {
             cSrcBuffer, 0, cPackedFormat);
         }
       });
+
+      pResource->TrackSequenceNumber(Subresource, GetCurrentSequenceNumber());
     }
   }
   
@@ -571,15 +576,16 @@ namespace dxvk {
   }
 
 
-  void D3D11ImmediateContext::SynchronizeCsThread() {
+  void D3D11ImmediateContext::SynchronizeCsThread(uint64_t SequenceNumber) {
     D3D10DeviceLock lock = LockContext();
 
     // Dispatch current chunk so that all commands
     // recorded prior to this function will be run
-    FlushCsChunk();
+    if (SequenceNumber > m_csSeqNum)
+      FlushCsChunk();
     
     if (m_csThread.isBusy())
-      m_csThread.synchronize();
+      m_csThread.synchronize(SequenceNumber);
   }
   
   
@@ -590,6 +596,7 @@ namespace dxvk {
   
   bool D3D11ImmediateContext::WaitForResource(
     const Rc<DxvkResource>&                 Resource,
+          uint64_t                          SequenceNumber,
           D3D11_MAP                         MapType,
           UINT                              MapFlags) {
     // Determine access type to wait for based on map mode
@@ -599,9 +606,11 @@ namespace dxvk {
     
     // Wait for the any pending D3D11 command to be executed
     // on the CS thread so that we can determine whether the
-    // resource is currently in use or not.
+    // resource is currently in use or not. Staging
+    // resources only need to wait for the last chunk
+    // that accessed them, not for the entire queue.
     if (!Resource->isInUse(access))
-      SynchronizeCsThread();
+      SynchronizeCsThread(SequenceNumber);
     
     if (Resource->isInUse(access)) {
       if (MapFlags & D3D11_MAP_FLAG_DO_NOT_WAIT) {
@@ -614,7 +623,7 @@ namespace dxvk {
         // Make sure pending commands using the resource get
         // executed on the the GPU if we have to wait for it
         Flush();
-        SynchronizeCsThread();
+        SynchronizeCsThread(SequenceNumber);
         
         Resource->waitIdle(access);
       }
@@ -625,11 +634,26 @@ namespace dxvk {
   
   
   void D3D11ImmediateContext::EmitCsChunk(DxvkCsChunkRef&& chunk) {
-    m_csThread.dispatchChunk(std::move(chunk));
+    m_csSeqNum = m_csThread.dispatchChunk(std::move(chunk));
     m_csIsBusy = true;
   }
 
 
+  void D3D11ImmediateContext::TrackResourceUsage(
+          ID3D11Resource*             pResource,
+          UINT                        Subresource) {
+    TrackResourceSequenceNumber(pResource, Subresource,
+      GetCurrentSequenceNumber());
+  }
+
+
+  uint64_t D3D11ImmediateContext::GetCurrentSequenceNumber() {
+    // The chunk currently being recorded will be assigned
+    // the next sequence number once it gets dispatched.
+    return m_csSeqNum + 1;
+  }
+
+
   void D3D11ImmediateContext::FlushImplicit(BOOL StrongHint) {
     // Flush only if the GPU is about to go idle, in
     // order to keep the number of submissions low.
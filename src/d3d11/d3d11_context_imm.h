@@ -109,11 +109,13 @@ namespace dxvk {
            ID3DDeviceContextState*           pState,
            ID3DDeviceContextState**          ppPreviousState);
 
-    void SynchronizeCsThread();
+    void SynchronizeCsThread(
+            uint64_t                          SequenceNumber);
     
   private:
     
     DxvkCsThread m_csThread;
+    uint64_t     m_csSeqNum = 0ull;
     bool         m_csIsBusy = false;
 
     std::atomic<uint32_t> m_refCount = { 0 };
@@ -147,11 +149,18 @@ namespace dxvk {
     
     bool WaitForResource(
       const Rc<DxvkResource>&                 Resource,
+            uint64_t                          SequenceNumber,
             D3D11_MAP                         MapType,
             UINT                              MapFlags);
     
     void EmitCsChunk(DxvkCsChunkRef&& chunk);
 
+    void TrackResourceUsage(
+            ID3D11Resource*                   pResource,
+            UINT                              Subresource);
+
+    uint64_t GetCurrentSequenceNumber();
+
     void FlushImplicit(BOOL StrongHint);
 
     void SignalEvent(HANDLE hEvent);
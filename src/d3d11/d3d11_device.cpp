@@ -1985,27 +1985,9 @@ namespace dxvk {
     if (pClassLinkage != nullptr)
       Logger::warn("D3D11Device::CreateShaderModule: Class linkage not supported");
 
-    D3D11CommonShader commonShader;
-
-    HRESULT hr = m_shaderModules.GetShaderModule(this,
+    return m_shaderModules.GetShaderModule(this,
       &ShaderKey, pModuleInfo, pShaderBytecode, BytecodeLength,
-      &commonShader);
-
-    if (FAILED(hr))
-      return hr;
-
-    auto shader = commonShader.GetShader();
-
-    if (shader->flags().test(DxvkShaderFlag::ExportsStencilRef)
-     && !m_dxvkDevice->extensions().extShaderStencilExport)
-      return E_INVALIDARG;
-
-    if (shader->flags().test(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage)
-     && !m_dxvkDevice->extensions().extShaderViewportIndexLayer)
-      return E_INVALIDARG;
-
-    *pShaderModule = std::move(commonShader);
-    return S_OK;
+      pShaderModule);
   }
 
 
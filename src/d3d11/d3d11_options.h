@@ -64,6 +64,11 @@ namespace dxvk {
     /// Declare vertex positions in shaders as invariant
     bool invariantPosition;
 
+    /// Translate shaders on worker threads. Shader
+    /// creation returns immediately, and the shader is
+    /// waited for when it is first used for rendering.
+    bool asyncShaderCompile;
+
     /// Back buffer count for the Vulkan swap chain.
     /// Overrides DXGI_SWAP_CHAIN_DESC::BufferCount.
     int32_t numBackBuffers;
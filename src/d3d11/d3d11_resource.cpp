@@ -221,4 +221,21 @@ namespace dxvk {
     }
   }
 
-}
\ No newline at end of file
+
+
+  void TrackResourceSequenceNumber(
+          ID3D11Resource*             pResource,
+          UINT                        Subresource,
+          uint64_t                    SequenceNumber) {
+    auto buffer  = GetCommonBuffer (pResource);
+    auto texture = GetCommonTexture(pResource);
+
+    if (buffer != nullptr) {
+      if (buffer->Desc()->Usage == D3D11_USAGE_STAGING)
+        buffer->TrackSequenceNumber(SequenceNumber);
+    } else if (texture != nullptr) {
+      texture->TrackSequenceNumber(Subresource, SequenceNumber);
+    }
+  }
+
+}
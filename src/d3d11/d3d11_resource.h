@@ -140,4 +140,20 @@ namespace dxvk {
   HRESULT ResourceReleasePrivate(
           ID3D11Resource*             pResource);
 
-}
\ No newline at end of file
+  /**
+   * \brief Tracks CS sequence number of a staging resource
+   * 
+   * Helper method that figures out the exact type of the
+   * resource and stores the sequence number of the CS chunk
+   * that last accessed the given subresource. Has no effect
+   * on resources that do not use \c D3D11_USAGE_STAGING.
+   * \param [in] pResource The resource to track
+   * \param [in] Subresource Subresource index
+   * \param [in] SequenceNumber CS chunk sequence number
+   */
+  void TrackResourceSequenceNumber(
+          ID3D11Resource*             pResource,
+          UINT                        Subresource,
+          uint64_t                    SequenceNumber);
+
+}
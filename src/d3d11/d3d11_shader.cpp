@@ -3,47 +3,132 @@
 
 namespace dxvk {
   
-  D3D11CommonShader:: D3D11CommonShader() { }
-  D3D11CommonShader::~D3D11CommonShader() { }
-  
-  
-  D3D11CommonShader::D3D11CommonShader(
-          D3D11Device*    pDevice,
-    const DxvkShaderKey*  pShaderKey,
+  D3D11CommonShaderData::D3D11CommonShaderData(const DxvkShaderKey* pShaderKey)
+  : m_key(*pShaderKey), m_name(pShaderKey->toString()) { }
+
+
+  D3D11CommonShaderData::~D3D11CommonShaderData() { }
+
+
+  Rc<DxvkShader> D3D11CommonShaderData::GetShader() {
+    Wait();
+    return m_shader;
+  }
+
+
+  Rc<DxvkBuffer> D3D11CommonShaderData::GetIcb() {
+    Wait();
+    return m_buffer;
+  }
+
+
+  void D3D11CommonShaderData::Compile(
+    const Rc<DxvkDevice>& pDevice,
+    const DxbcModuleInfo* pDxbcModuleInfo,
+    const void*           pShaderBytecode,
+          size_t          BytecodeLength) {
+    try {
+      CompileShader(pDevice, pDxbcModuleInfo,
+        pShaderBytecode, BytecodeLength);
+    } catch (const DxvkError&) {
+      // Threads waiting for the shader must not
+      // block forever, so finish with no shader
+      m_shader = nullptr;
+      m_buffer = nullptr;
+      Finish();
+      throw;
+    }
+
+    Finish();
+  }
+
+
+  void D3D11CommonShaderData::Wait() {
+    if (likely(m_ready.load(std::memory_order_acquire)))
+      return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this] () {
+      return m_ready.load(std::memory_order_acquire);
+    });
+  }
+
+
+  void D3D11CommonShaderData::Finish() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ready.store(true, std::memory_order_release);
+    m_cond.notify_all();
+  }
+
+
+  void D3D11CommonShaderData::CompileShader(
+    const Rc<DxvkDevice>& pDevice,
     const DxbcModuleInfo* pDxbcModuleInfo,
     const void*           pShaderBytecode,
           size_t          BytecodeLength) {
-    const std::string name = pShaderKey->toString();
-    Logger::debug(str::format("Compiling shader ", name));
-    
     DxbcReader reader(
       reinterpret_cast<const char*>(pShaderBytecode),
       BytecodeLength);
     
-    DxbcModule module(reader);
-    
     // If requested by the user, dump both the raw DXBC
     // shader and the compiled SPIR-V module to a file.
     const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
     
     if (dumpPath.size() != 0) {
-      reader.store(std::ofstream(str::format(dumpPath, "/", name, ".dxbc"),
+      reader.store(std::ofstream(str::format(dumpPath, "/", m_name, ".dxbc"),
         std::ios_base::binary | std::ios_base::trunc));
     }
     
-    // Decide whether we need to create a pass-through
-    // geometry shader for vertex shader stream output
-    bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
-      && module.programInfo().type() != DxbcProgramType::GeometryShader;
-
-    m_shader = passthroughShader
-      ? module.compilePassthroughShader(*pDxbcModuleInfo, name)
-      : module.compile                 (*pDxbcModuleInfo, name);
-    m_shader->setShaderKey(*pShaderKey);
+    // Skip compilation if the shader was compiled
+    // with the same options in a previous run
+    Rc<DxvkShaderCache> shaderCache = pDevice->getShaderCache();
+    DxvkShaderCacheKey  shaderCacheKey = { m_key, GetOptionsHash(pDxbcModuleInfo) };
+
+    if (shaderCache != nullptr) {
+      DxvkShaderCacheData data;
+
+      if (shaderCache->lookup(shaderCacheKey, data)) {
+        if (!data.readShader(m_shader) || !data.eof())
+          m_shader = nullptr;
+      }
+    }
+
+    if (m_shader == nullptr) {
+      Logger::debug(str::format("Compiling shader ", m_name));
+
+      DxbcModule module(reader);
+      
+      // Decide whether we need to create a pass-through
+      // geometry shader for vertex shader stream output
+      bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
+        && module.programInfo().type() != DxbcProgramType::GeometryShader;
+
+      m_shader = passthroughShader
+        ? module.compilePassthroughShader(*pDxbcModuleInfo, m_name)
+        : module.compile                 (*pDxbcModuleInfo, m_name);
+
+      if (shaderCache != nullptr) {
+        DxvkShaderCacheData data;
+        data.writeShader(m_shader);
+        shaderCache->store(shaderCacheKey, data);
+      }
+    }
+
+    // Cached shaders may have been compiled on a device
+    // that supports more extensions, so check both paths
+    if (m_shader->flags().test(DxvkShaderFlag::ExportsStencilRef)
+     && !pDevice->extensions().extShaderStencilExport)
+      throw DxvkError(str::format("D3D11: ", m_name, ": Stencil export not supported"));
+
+    if (m_shader->flags().test(DxvkShaderFlag::ExportsViewportIndexLayerFromVertexStage)
+     && !pDevice->extensions().extShaderViewportIndexLayer)
+      throw DxvkError(str::format("D3D11: ", m_name, ": Viewport index / layer export not supported"));
+
+    m_shader->setShaderKey(m_key);
     
     if (dumpPath.size() != 0) {
       std::ofstream dumpStream(
-        str::format(dumpPath, "/", name, ".spv"),
+        str::format(dumpPath, "/", m_name, ".spv"),
         std::ios_base::binary | std::ios_base::trunc);
       
       m_shader->dump(dumpStream);
@@ -62,19 +147,58 @@ namespace dxvk {
         | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
         | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
       
-      m_buffer = pDevice->GetDXVKDevice()->createBuffer(info, memFlags);
+      m_buffer = pDevice->createBuffer(info, memFlags);
 
       std::memcpy(m_buffer->mapPtr(0),
         m_shader->shaderConstants().data(),
         m_shader->shaderConstants().sizeInBytes());
     }
 
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
+    pDevice->registerShader(m_shader);
   }
 
+
+  Sha1Hash D3D11CommonShaderData::GetOptionsHash(
+    const DxbcModuleInfo* pDxbcModuleInfo) {
+    // Stream output is already part of the shader key
+    float maxTessFactor = pDxbcModuleInfo->tess != nullptr
+      ? pDxbcModuleInfo->tess->maxTessFactor
+      : 0.0f;
+
+    Sha1Hash optionsHash = pDxbcModuleInfo->options.computeHash();
+
+    std::array<Sha1Data, 3> chunks = {{
+      { "D3D11",          5                     },
+      { &optionsHash,     sizeof(optionsHash)   },
+      { &maxTessFactor,   sizeof(maxTessFactor) },
+    }};
+
+    return Sha1Hash::compute(chunks.size(), chunks.data());
+  }
+
+
+  D3D11CommonShader:: D3D11CommonShader() { }
+  D3D11CommonShader::~D3D11CommonShader() { }
+
+
+  D3D11CommonShader::D3D11CommonShader(
+    const Rc<D3D11CommonShaderData>& pData)
+  : m_data(pData) { }
+
   
   D3D11ShaderModuleSet:: D3D11ShaderModuleSet() { }
-  D3D11ShaderModuleSet::~D3D11ShaderModuleSet() { }
+
+
+  D3D11ShaderModuleSet::~D3D11ShaderModuleSet() {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_workerStop = true;
+    }
+
+    m_workerCond.notify_all();
+
+    for (auto& worker : m_workerThreads)
+      worker.join();
+  }
   
   
   HRESULT D3D11ShaderModuleSet::GetShaderModule(
@@ -84,6 +208,8 @@ namespace dxvk {
     const void*               pShaderBytecode,
           size_t              BytecodeLength,
           D3D11CommonShader*  pShader) {
+    bool async = pDevice->GetOptions()->asyncShaderCompile;
+
     // Use the shader's unique key for the lookup
     { std::unique_lock<std::mutex> lock(m_mutex);
       
@@ -93,19 +219,72 @@ namespace dxvk {
         return S_OK;
       }
     }
+
+    if (async) {
+      // Errors that occur on the worker threads cannot be
+      // reported to the application anymore, so catch the
+      // ones that we can detect cheaply here.
+      HRESULT hr = ValidateShader(pDevice, pDxbcModuleInfo,
+        pShaderBytecode, BytecodeLength);
+
+      if (FAILED(hr))
+        return hr;
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      auto entry = m_modules.find(*pShaderKey);
+      if (entry != m_modules.end()) {
+        *pShader = entry->second;
+        return S_OK;
+      }
+
+      // Insert the pending module right away, so that other
+      // threads creating the same shader in the meantime use
+      // it instead of compiling the shader again.
+      D3D11ShaderCompileJob job;
+      job.key        = *pShaderKey;
+      job.shader     = new D3D11CommonShaderData(pShaderKey);
+      job.device     = pDevice->GetDXVKDevice();
+      job.moduleInfo = *pDxbcModuleInfo;
+
+      if (pDxbcModuleInfo->tess != nullptr)
+        job.tessInfo = *pDxbcModuleInfo->tess;
+
+      if (pDxbcModuleInfo->xfb != nullptr) {
+        job.xfbInfo = *pDxbcModuleInfo->xfb;
+
+        for (uint32_t i = 0; i < job.xfbInfo.entryCount; i++)
+          job.semanticNames.push_back(job.xfbInfo.entries[i].semanticName);
+      }
+
+      auto code = reinterpret_cast<const char*>(pShaderBytecode);
+      job.bytecode.assign(code, code + BytecodeLength);
+
+      *pShader = D3D11CommonShader(job.shader);
+      m_modules.insert({ *pShaderKey, *pShader });
+
+      if (m_workerThreads.empty())
+        StartWorkers();
+
+      m_workerQueue.push(std::move(job));
+      m_workerCond.notify_one();
+      return S_OK;
+    }
     
     // This shader has not been compiled yet, so we have to create a
     // new module. This takes a while, so we won't lock the structure.
-    D3D11CommonShader module;
+    Rc<D3D11CommonShaderData> data = new D3D11CommonShaderData(pShaderKey);
     
     try {
-      module = D3D11CommonShader(pDevice, pShaderKey,
+      data->Compile(pDevice->GetDXVKDevice(),
         pDxbcModuleInfo, pShaderBytecode, BytecodeLength);
     } catch (const DxvkError& e) {
       Logger::err(e.message());
       return E_INVALIDARG;
     }
     
+    D3D11CommonShader module(data);
+    
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
     // that object instead and discard the newly created module.
@@ -121,5 +300,120 @@ namespace dxvk {
     *pShader = std::move(module);
     return S_OK;
   }
+
+
+  void D3D11ShaderModuleSet::StartWorkers() {
+    // Shader translation is much cheaper than pipeline
+    // compilation, so a small number of threads suffices
+    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
+    uint32_t numWorkers  = std::max(1u, numCpuCores / 2);
+
+    if (numWorkers > 8) numWorkers = 8;
+
+    Logger::info(str::format("D3D11: Using ", numWorkers, " shader compiler threads"));
+
+    for (uint32_t i = 0; i < numWorkers; i++)
+      m_workerThreads.emplace_back([this] () { WorkerFunc(); });
+  }
+
+
+  void D3D11ShaderModuleSet::WorkerFunc() {
+    env::setThreadName("dxvk-dxbc");
+
+    while (true) {
+      D3D11ShaderCompileJob job;
+
+      { std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_workerCond.wait(lock, [this] () {
+          return m_workerQueue.size()
+              || m_workerStop;
+        });
+
+        // Finish pending jobs before exiting since
+        // other threads may be waiting for them
+        if (m_workerQueue.empty())
+          break;
+
+        job = std::move(m_workerQueue.front());
+        m_workerQueue.pop();
+      }
+
+      // Pointers into the job are only stable from here on
+      DxbcModuleInfo moduleInfo = job.moduleInfo;
+
+      if (moduleInfo.tess != nullptr)
+        moduleInfo.tess = &job.tessInfo;
+
+      if (moduleInfo.xfb != nullptr) {
+        for (uint32_t i = 0; i < job.xfbInfo.entryCount; i++)
+          job.xfbInfo.entries[i].semanticName = job.semanticNames[i].c_str();
+
+        moduleInfo.xfb = &job.xfbInfo;
+      }
+
+      try {
+        job.shader->Compile(job.device, &moduleInfo,
+          job.bytecode.data(), job.bytecode.size());
+      } catch (const DxvkError& e) {
+        Logger::err(e.message());
+
+        // Don't hand out the failed module to shaders
+        // created later, so that those fail properly
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_modules.erase(job.key);
+      }
+    }
+  }
+
+
+  HRESULT D3D11ShaderModuleSet::ValidateShader(
+          D3D11Device*        pDevice,
+    const DxbcModuleInfo*     pDxbcModuleInfo,
+    const void*               pShaderBytecode,
+          size_t              BytecodeLength) {
+    // This only parses the container and signatures,
+    // the code itself is decoded during compilation.
+    try {
+      DxbcReader reader(
+        reinterpret_cast<const char*>(pShaderBytecode),
+        BytecodeLength);
+
+      DxbcModule module(reader);
+
+      if (!module.hasCode())
+        throw DxvkError("D3D11: No SHDR/SHEX chunk");
+
+      const DxvkDeviceExtensions& extensions = pDevice->GetDXVKDevice()->extensions();
+      const Rc<DxbcIsgn> osgn = module.osgn();
+
+      DxbcProgramType type = module.programInfo().type();
+
+      if (osgn != nullptr && type == DxbcProgramType::PixelShader
+       && osgn->find("SV_StencilRef", 0, 0) != nullptr
+       && !extensions.extShaderStencilExport)
+        throw DxvkError("D3D11: Stencil export not supported");
+
+      // Vertex shaders with stream output are compiled to a
+      // pass-through geometry shader, which does not need it
+      bool needsViewportIndexLayer = false;
+
+      if (osgn != nullptr && pDxbcModuleInfo->xfb == nullptr
+       && (type == DxbcProgramType::VertexShader || type == DxbcProgramType::DomainShader)) {
+        for (const auto& e : *osgn) {
+          needsViewportIndexLayer |= e.systemValue == DxbcSystemValue::RenderTargetId
+                                  || e.systemValue == DxbcSystemValue::ViewportId;
+        }
+      }
+
+      if (needsViewportIndexLayer && !extensions.extShaderViewportIndexLayer)
+        throw DxvkError("D3D11: Viewport index / layer export not supported");
+
+      return S_OK;
+    } catch (const DxvkError& e) {
+      Logger::err(e.message());
+      return E_INVALIDARG;
+    }
+  }
   
 }
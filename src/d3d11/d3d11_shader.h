@@ -1,6 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <queue>
 #include <unordered_map>
 
 #include "../dxbc/dxbc_module.h"
@@ -10,6 +13,7 @@
 
 #include "../util/sha1/sha1_util.h"
 
+#include "../util/thread.h"
 #include "../util/util_env.h"
 
 #include "d3d11_device_child.h"
@@ -19,12 +23,94 @@ namespace dxvk {
   
   class D3D11Device;
   
+  /**
+   * \brief Common shader data
+   * 
+   * Stores the compiled shader and its constant buffer.
+   * Shared between all copies of a common shader object,
+   * so that the shader can be compiled asynchronously.
+   */
+  class D3D11CommonShaderData : public RcObject {
+    
+  public:
+    
+    D3D11CommonShaderData(const DxvkShaderKey* pShaderKey);
+    ~D3D11CommonShaderData();
+    
+    /**
+     * \brief Waits for the shader
+     * 
+     * Blocks the calling thread until the shader
+     * has been compiled. May return \c nullptr if
+     * compilation failed.
+     * \returns The compiled shader
+     */
+    Rc<DxvkShader> GetShader();
+    
+    /**
+     * \brief Waits for the constant buffer
+     * \returns Immediate constant buffer, if any
+     */
+    Rc<DxvkBuffer> GetIcb();
+    
+    std::string GetName() const {
+      return m_name;
+    }
+    
+    /**
+     * \brief Compiles the shader
+     * 
+     * Looks the shader up in the shader cache and runs
+     * the DXBC compiler on a cache miss. Wakes up all
+     * threads waiting for the shader, even on failure.
+     * \param [in] pDevice The DXVK device
+     * \param [in] pDxbcModuleInfo Module info
+     * \param [in] pShaderBytecode DXBC code
+     * \param [in] BytecodeLength Code size
+     * \throws DxvkError if the shader is invalid
+     */
+    void Compile(
+      const Rc<DxvkDevice>& pDevice,
+      const DxbcModuleInfo* pDxbcModuleInfo,
+      const void*           pShaderBytecode,
+            size_t          BytecodeLength);
+    
+  private:
+    
+    DxvkShaderKey           m_key;
+    std::string             m_name;
+    
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    std::atomic<bool>       m_ready = { false };
+    
+    Rc<DxvkShader>          m_shader;
+    Rc<DxvkBuffer>          m_buffer;
+    
+    void Wait();
+    
+    void Finish();
+    
+    void CompileShader(
+      const Rc<DxvkDevice>& pDevice,
+      const DxbcModuleInfo* pDxbcModuleInfo,
+      const void*           pShaderBytecode,
+            size_t          BytecodeLength);
+    
+    static Sha1Hash GetOptionsHash(
+      const DxbcModuleInfo* pDxbcModuleInfo);
+    
+  };
+  
+  
   /**
    * \brief Common shader object
    * 
    * Stores the compiled SPIR-V shader and the SHA-1
    * hash of the original DXBC shader, which can be
-   * used to identify the shader.
+   * used to identify the shader. If the shader is
+   * compiled asynchronously, accessing the shader
+   * waits for compilation to finish.
    */
   class D3D11CommonShader {
     
@@ -32,29 +118,24 @@ namespace dxvk {
     
     D3D11CommonShader();
     D3D11CommonShader(
-            D3D11Device*    pDevice,
-      const DxvkShaderKey*  pShaderKey,
-      const DxbcModuleInfo* pDxbcModuleInfo,
-      const void*           pShaderBytecode,
-            size_t          BytecodeLength);
+      const Rc<D3D11CommonShaderData>& pData);
     ~D3D11CommonShader();
 
     Rc<DxvkShader> GetShader() const {
-      return m_shader;
+      return m_data != nullptr ? m_data->GetShader() : nullptr;
     }
 
     Rc<DxvkBuffer> GetIcb() const {
-      return m_buffer;
+      return m_data != nullptr ? m_data->GetIcb() : nullptr;
     }
     
     std::string GetName() const {
-      return m_shader->debugName();
+      return m_data->GetName();
     }
     
   private:
     
-    Rc<DxvkShader> m_shader;
-    Rc<DxvkBuffer> m_buffer;
+    Rc<D3D11CommonShaderData> m_data;
     
   };
   
@@ -125,6 +206,25 @@ namespace dxvk {
   using D3D11ComputeShader  = D3D11Shader<ID3D11ComputeShader,  ID3D10DeviceChild>;
   
   
+  /**
+   * \brief Shader compile job
+   * 
+   * Stores a copy of everything needed to compile
+   * a shader on a worker thread, since the app may
+   * free the bytecode as soon as creation returns.
+   */
+  struct D3D11ShaderCompileJob {
+    DxvkShaderKey             key;
+    Rc<D3D11CommonShaderData> shader;
+    Rc<DxvkDevice>            device;
+    DxbcModuleInfo            moduleInfo;
+    DxbcTessInfo              tessInfo;
+    DxbcXfbInfo               xfbInfo;
+    std::vector<std::string>  semanticNames;
+    std::vector<char>         bytecode;
+  };
+  
+  
   /**
    * \brief Shader module set
    * 
@@ -132,6 +232,13 @@ namespace dxvk {
    * times, so we should cache the resulting shader modules
    * and reuse them rather than creating new ones. This
    * class is thread-safe.
+   * 
+   * With asynchronous compilation, new shaders are added
+   * to the set right away and compiled on a small pool of
+   * worker threads, so that threads creating a shader that
+   * is still being compiled share the pending module. The
+   * container and any required device features are checked
+   * up front so that invalid shaders still fail to create.
    */
   class D3D11ShaderModuleSet {
     
@@ -157,6 +264,21 @@ namespace dxvk {
       D3D11CommonShader,
       DxvkHash, DxvkEq> m_modules;
     
+    std::condition_variable           m_workerCond;
+    std::queue<D3D11ShaderCompileJob> m_workerQueue;
+    bool                              m_workerStop = false;
+    std::vector<dxvk::thread>         m_workerThreads;
+    
+    void StartWorkers();
+    
+    void WorkerFunc();
+    
+    static HRESULT ValidateShader(
+            D3D11Device*        pDevice,
+      const DxbcModuleInfo*     pDxbcModuleInfo,
+      const void*               pShaderBytecode,
+            size_t              BytecodeLength);
+    
   };
   
 }
@@ -166,6 +166,8 @@ namespace dxvk {
           m_buffers.push_back(CreateMappedBuffer(j));
         if (m_mapMode != D3D11_COMMON_TEXTURE_MAP_MODE_NONE)
           m_mapTypes.push_back(D3D11_MAP(~0u));
+        if (m_desc.Usage == D3D11_USAGE_STAGING)
+          m_seqs.push_back(0ull);
       }
     }
     
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../dxvk/dxvk_cs.h"
 #include "../dxvk/dxvk_device.h"
 
 #include "../d3d10/d3d10_texture.h"
@@ -115,6 +116,35 @@ namespace dxvk {
       if (Subresource < m_mapTypes.size())
         m_mapTypes[Subresource] = MapType;
     }
+
+    /**
+     * \brief Sequence number of last CS chunk using a subresource
+     *
+     * Only tracked for staging resources, since they can
+     * only be accessed through copy commands. For all other
+     * resources, this returns \c DxvkCsThread::SynchronizeAll.
+     * \param [in] Subresource Subresource index
+     * \returns Sequence number to synchronize with
+     */
+    uint64_t GetSequenceNumber(UINT Subresource) const {
+      return Subresource < m_seqs.size()
+        ? m_seqs[Subresource]
+        : DxvkCsThread::SynchronizeAll;
+    }
+
+    /**
+     * \brief Tracks sequence number for a subresource
+     *
+     * Must be called for every command that accesses
+     * the mapped buffer of a staging subresource, or
+     * mapping it may return while a copy is pending.
+     * \param [in] Subresource Subresource index
+     * \param [in] Seq Sequence number of the CS chunk
+     */
+    void TrackSequenceNumber(UINT Subresource, uint64_t Seq) {
+      if (Subresource < m_seqs.size())
+        m_seqs[Subresource] = Seq;
+    }
     
     /**
      * \brief The DXVK image
@@ -214,6 +244,7 @@ namespace dxvk {
     Rc<DxvkImage>                 m_image;
     std::vector<Rc<DxvkBuffer>>   m_buffers;
     std::vector<D3D11_MAP>        m_mapTypes;
+    std::vector<uint64_t>         m_seqs;
     
     Rc<DxvkBuffer> CreateMappedBuffer(
             UINT                  MipLevel) const;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../dxvk/dxvk_cs.h"
 #include "../dxvk/dxvk_device.h"
 
 #include "d3d9_device_child.h"
@@ -122,7 +123,7 @@ namespace dxvk {
     }
 
     DxvkBufferSliceHandle DiscardMapSlice() {
-      m_sliceHandle = GetMapBuffer()->allocSlice();
+      m_sliceHandle = GetMapBuffer()->allocDiscardSlice();
       return m_sliceHandle;
     }
 
@@ -159,6 +160,29 @@ namespace dxvk {
     void MarkNeedsUpload()   { m_needsUpload = true; }
     bool NeedsUpload() const { return m_needsUpload; }
 
+    /**
+     * \brief Tracks sequence number of the mapping buffer
+     *
+     * Stores the sequence number of the last CS chunk
+     * that accessed the mapping buffer in a copy command.
+     * \param [in] Seq Sequence number of the CS chunk
+     */
+    void TrackMappingBufferSequenceNumber(uint64_t Seq) {
+      m_seq = Seq;
+    }
+
+    /**
+     * \brief Sequence number to synchronize with before locking
+     *
+     * If the buffer is mapped directly, the mapping buffer can
+     * be used by any draw, so the entire queue must be drained.
+     * \returns Sequence number of the last chunk using the buffer
+     */
+    uint64_t GetMappingBufferSequenceNumber() const {
+      return GetMapMode() == D3D9_COMMON_BUFFER_MAP_MODE_BUFFER
+        ? m_seq : DxvkCsThread::SynchronizeAll;
+    }
+
     bool MarkLocked() {
       bool locked = m_readLocked;
       m_readLocked = true;
@@ -201,6 +225,8 @@ namespace dxvk {
 
     bool                        m_needsUpload = false;
 
+    uint64_t                    m_seq = 0ull;
+
   };
 
 }
\ No newline at end of file
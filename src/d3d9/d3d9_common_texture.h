@@ -4,6 +4,7 @@
 #include "d3d9_util.h"
 #include "d3d9_caps.h"
 
+#include "../dxvk/dxvk_cs.h"
 #include "../dxvk/dxvk_device.h"
 
 #include "../util/util_bit.h"
@@ -154,6 +155,31 @@ namespace dxvk {
       return handle;
     }
 
+    /**
+     * \brief Tracks sequence number of a mapping buffer
+     *
+     * Mapping buffers are only ever accessed by copy commands,
+     * so locking a subresource only needs to wait for the last
+     * CS chunk that used its buffer. This must be called for
+     * every command that accesses the mapping buffer, including
+     * format conversions, or locks may return too early.
+     * \param [in] Subresource Subresource index
+     * \param [in] Seq Sequence number of the CS chunk
+     */
+    void TrackMappingBufferSequenceNumber(UINT Subresource, uint64_t Seq) {
+      m_seqs[Subresource] = Seq;
+    }
+
+    /**
+     * \brief Sequence number of a mapping buffer
+     *
+     * \param [in] Subresource Subresource index
+     * \returns Sequence number of the last chunk using the buffer
+     */
+    uint64_t GetMappingBufferSequenceNumber(UINT Subresource) const {
+      return m_seqs[Subresource];
+    }
+
     /**
      * \brief Computes subresource from the subresource index
      *
@@ -379,6 +405,8 @@ namespace dxvk {
       Rc<DxvkBuffer>>             m_buffers;
     D3D9SubresourceArray<
       DxvkBufferSliceHandle>      m_mappedSlices;
+    D3D9SubresourceArray<
+      uint64_t>                   m_seqs = { };
 
     D3D9_VK_FORMAT_MAPPING        m_mapping;
 
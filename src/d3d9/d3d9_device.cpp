@@ -42,6 +42,7 @@ namespace dxvk {
     , m_dxvkDevice     ( dxvkDevice )
     , m_csThread       ( dxvkDevice->createContext() )
     , m_csChunk        ( AllocCsChunk() )
+    , m_csStateElimination ( dxvkDevice->config().csStateElimination )
     , m_parent         ( pParent )
     , m_deviceType     ( DeviceType )
     , m_window         ( hFocusWindow )
@@ -85,7 +86,7 @@ namespace dxvk {
 
   D3D9DeviceEx::~D3D9DeviceEx() {
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
     delete m_initializer;
     delete m_converter;
@@ -301,7 +302,7 @@ namespace dxvk {
       return hr;
 
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
     return D3D_OK;
   }
@@ -699,6 +700,9 @@ namespace dxvk {
         cSrcExtent);
     });
 
+    srcTextureInfo->TrackMappingBufferSequenceNumber(
+      src->GetSubresource(), GetCurrentSequenceNumber());
+
     dstTextureInfo->SetDirty(dst->GetSubresource(), true);
 
     if (dstTextureInfo->IsAutomaticMip())
@@ -728,7 +732,8 @@ namespace dxvk {
     uint32_t arraySlices = std::min(srcTexInfo->Desc()->ArraySize, dstTexInfo->Desc()->ArraySize);
     for (uint32_t a = 0; a < arraySlices; a++) {
       for (uint32_t m = 0; m < mipLevels; m++) {
-        Rc<DxvkBuffer> srcBuffer = srcTexInfo->GetBuffer(srcTexInfo->CalcSubresource(a, m));
+        UINT srcSubresource = srcTexInfo->CalcSubresource(a, m);
+        Rc<DxvkBuffer> srcBuffer = srcTexInfo->GetBuffer(srcSubresource);
 
         VkImageSubresourceLayers dstLayers = { VK_IMAGE_ASPECT_COLOR_BIT, m, a, 1 };
         
@@ -745,6 +750,9 @@ namespace dxvk {
             VkOffset3D{ 0, 0, 0 }, cExtent,
             cSrcBuffer, 0, { 0u, 0u });
         });
+
+        srcTexInfo->TrackMappingBufferSequenceNumber(
+          srcSubresource, GetCurrentSequenceNumber());
       }
     }
 
@@ -811,6 +819,9 @@ namespace dxvk {
         cLevelExtent);
     });
 
+    dstTexInfo->TrackMappingBufferSequenceNumber(
+      dst->GetSubresource(), GetCurrentSequenceNumber());
+
     dstTexInfo->SetDirty(dst->GetSubresource(), true);
 
     return D3D_OK;
@@ -2527,6 +2538,8 @@ namespace dxvk {
       ](DxvkContext* ctx) {
         ctx->copyBuffer(cDstBuffer, cOffset, cSrcBuffer, cOffset, cCopySize);
       });
+
+      dst->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
     }
 
     dst->SetReadLocked(true);
@@ -3832,6 +3845,7 @@ namespace dxvk {
 
   bool D3D9DeviceEx::WaitForResource(
   const Rc<DxvkResource>&                 Resource,
+        uint64_t                          SequenceNumber,
         DWORD                             MapFlags) {
     // Wait for the any pending D3D9 command to be executed
     // on the CS thread so that we can determine whether the
@@ -3843,7 +3857,7 @@ namespace dxvk {
       : DxvkAccess::Read;
 
     if (!Resource->isInUse(access))
-      SynchronizeCsThread();
+      SynchronizeCsThread(SequenceNumber);
 
     if (Resource->isInUse(access)) {
       if (MapFlags & D3DLOCK_DONOTWAIT) {
@@ -3857,7 +3871,7 @@ namespace dxvk {
         // Make sure pending commands using the resource get
         // executed on the the GPU if we have to wait for it
         Flush();
-        SynchronizeCsThread();
+        SynchronizeCsThread(SequenceNumber);
 
         Resource->waitIdle(access);
       }
@@ -4005,7 +4019,7 @@ namespace dxvk {
       if (alloced)
         std::memset(physSlice.mapPtr, 0, physSlice.length);
       else if ((managed || (systemmem && !dirty)) && !(Flags & D3DLOCK_DONOTWAIT) && !skipWait) {
-        if (!WaitForResource(mappedBuffer, D3DLOCK_DONOTWAIT)) {
+        if (!WaitForResource(mappedBuffer, pResource->GetMappingBufferSequenceNumber(Subresource), D3DLOCK_DONOTWAIT)) {
           // if the mapped buffer is currently being copied to image
           // we can just avoid a stall by allocating a new slice and copying the existing contents
           DxvkBufferSliceHandle oldSlice = physSlice;
@@ -4019,7 +4033,7 @@ namespace dxvk {
           });
         }
       } else if (!skipWait) {
-        if (!WaitForResource(mappedBuffer, Flags))
+        if (!WaitForResource(mappedBuffer, pResource->GetMappingBufferSequenceNumber(Subresource), Flags))
           return D3DERR_WASSTILLDRAWING;
       }
     }
@@ -4092,7 +4106,10 @@ namespace dxvk {
           }
         });
 
-        if (!WaitForResource(mappedBuffer, Flags))
+        pResource->TrackMappingBufferSequenceNumber(
+          Subresource, GetCurrentSequenceNumber());
+
+        if (!WaitForResource(mappedBuffer, pResource->GetMappingBufferSequenceNumber(Subresource), Flags))
           return D3DERR_WASSTILLDRAWING;
       } else if (alloced) {
         // If we are a new alloc, and we weren't dirty
@@ -4221,15 +4238,23 @@ namespace dxvk {
           VkOffset3D{ 0, 0, 0 }, cDstLevelExtent,
           cSrcBuffer, 0, { 0u, 0u });
       });
+
+      pResource->TrackMappingBufferSequenceNumber(
+        Subresource, GetCurrentSequenceNumber());
     } 
     else {
       Flush();
-      SynchronizeCsThread();
+      SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
       m_converter->ConvertFormat(
         convertFormat,
         image, subresourceLayers,
         copyBuffer);
+
+      // The conversion reads the mapping buffer as well, so
+      // locks must not use the sequence number of an older copy
+      pResource->TrackMappingBufferSequenceNumber(
+        Subresource, GetCurrentSequenceNumber());
     }
 
     if (pResource->IsAutomaticMip())
@@ -4351,7 +4376,7 @@ namespace dxvk {
                             (boundsCheck && !pResource->DirtyRange().Overlaps(pResource->LockRange()));
       if (!skipWait) {
         if ((IsPoolManaged(desc.Pool) || desc.Pool == D3DPOOL_SYSTEMMEM) && !(Flags & D3DLOCK_DONOTWAIT) && pResource->GetLockCount() == 0) {
-          if (!WaitForResource(mappingBuffer, D3DLOCK_DONOTWAIT)) {
+          if (!WaitForResource(mappingBuffer, pResource->GetMappingBufferSequenceNumber(), D3DLOCK_DONOTWAIT)) {
             // if the mapped buffer is currently being copied to the primary buffer
             // we can just avoid a stall by allocating a new slice and copying the existing contents
             DxvkBufferSliceHandle oldSlice = physSlice;
@@ -4365,7 +4390,7 @@ namespace dxvk {
             });
           }
         } else {
-          if (!WaitForResource(mappingBuffer, Flags))
+          if (!WaitForResource(mappingBuffer, pResource->GetMappingBufferSequenceNumber(), Flags))
             return D3DERR_WASSTILLDRAWING;
         }
 
@@ -4415,6 +4440,8 @@ namespace dxvk {
         cSrcSlice.length());
     });
 
+    pResource->TrackMappingBufferSequenceNumber(GetCurrentSequenceNumber());
+
     pResource->DirtyRange().Conjoin(pResource->LockRange());
     pResource->LockRange().Clear();
     pResource->MarkUploaded();
@@ -4450,11 +4477,18 @@ namespace dxvk {
 
 
   void D3D9DeviceEx::EmitCsChunk(DxvkCsChunkRef&& chunk) {
-    m_csThread.dispatchChunk(std::move(chunk));
+    m_csSeqNum = m_csThread.dispatchChunk(std::move(chunk));
     m_csIsBusy = true;
   }
 
 
+  uint64_t D3D9DeviceEx::GetCurrentSequenceNumber() {
+    // The chunk currently being recorded will be assigned
+    // the next sequence number once it gets dispatched.
+    return m_csSeqNum + 1;
+  }
+
+
   void D3D9DeviceEx::FlushImplicit(BOOL StrongHint) {
     // Flush only if the GPU is about to go idle, in
     // order to keep the number of submissions low.
@@ -4473,15 +4507,16 @@ namespace dxvk {
   }
 
 
-  void D3D9DeviceEx::SynchronizeCsThread() {
+  void D3D9DeviceEx::SynchronizeCsThread(uint64_t SequenceNumber) {
     D3D9DeviceLock lock = LockDevice();
 
     // Dispatch current chunk so that all commands
     // recorded prior to this function will be run
-    FlushCsChunk();
+    if (SequenceNumber > m_csSeqNum)
+      FlushCsChunk();
 
     if (m_csThread.isBusy())
-      m_csThread.synchronize();
+      m_csThread.synchronize(SequenceNumber);
   }
 
 
@@ -5165,7 +5200,7 @@ namespace dxvk {
     }
 
     // Create and bind the framebuffer object to the context
-    EmitCs([
+    EmitCsState(DxvkCsState::RenderTargets, [
       cAttachments = std::move(attachments)
     ] (DxvkContext* ctx) {
       ctx->bindRenderTargets(cAttachments);
@@ -5233,7 +5268,7 @@ namespace dxvk {
         VkExtent2D { vp.Width,      vp.Height     }};
     }
 
-    EmitCs([
+    EmitCsState(DxvkCsState::Viewports, [
       cViewport = viewport,
       cScissor = scissor
     ] (DxvkContext* ctx) {
@@ -5254,7 +5289,7 @@ namespace dxvk {
       : 0xffffffff;
     msState.enableAlphaToCoverage = IsAlphaToCoverageEnabled();
 
-    EmitCs([
+    EmitCsState(DxvkCsState::MultisampleState, [
       cState = msState
     ] (DxvkContext* ctx) {
       ctx->setMultisampleState(cState);
@@ -5302,7 +5337,7 @@ namespace dxvk {
     for (uint32_t i = 0; i < 3; i++)
       extraWriteMasks[i] = state[ColorWriteIndex(i + 1)];
 
-    EmitCs([
+    EmitCsState(DxvkCsState::BlendState, [
       cMode       = mode,
       cWriteMasks = extraWriteMasks,
       cAlphaMasks = m_alphaSwizzleRTs
@@ -5342,7 +5377,7 @@ namespace dxvk {
       D3DCOLOR(m_state.renderStates[D3DRS_BLENDFACTOR]),
       reinterpret_cast<float*>(&blendConstants));
 
-    EmitCs([
+    EmitCsState(DxvkCsState::BlendConstants, [
       cBlendConstants = blendConstants
     ](DxvkContext* ctx) {
       ctx->setBlendConstants(cBlendConstants);
@@ -5388,7 +5423,7 @@ namespace dxvk {
     else
       state.stencilOpBack = state.stencilOpFront;
 
-    EmitCs([
+    EmitCsState(DxvkCsState::DepthStencilState, [
       cState = state
     ](DxvkContext* ctx) {
       ctx->setDepthStencilState(cState);
@@ -5409,7 +5444,7 @@ namespace dxvk {
     state.polygonMode     = DecodeFillMode(D3DFILLMODE(rs[D3DRS_FILLMODE]));
     state.sampleCount     = 0;
 
-    EmitCs([
+    EmitCsState(DxvkCsState::RasterizerState, [
       cState  = state
     ](DxvkContext* ctx) {
       ctx->setRasterizerState(cState);
@@ -5430,7 +5465,7 @@ namespace dxvk {
     biases.depthBiasSlope    = slopeScaledDepthBias;
     biases.depthBiasClamp    = 0.0f;
 
-    EmitCs([
+    EmitCsState(DxvkCsState::DepthBias, [
       cBiases = biases
     ](DxvkContext* ctx) {
       ctx->setDepthBias(cBiases);
@@ -5447,7 +5482,9 @@ namespace dxvk {
       ? DecodeCompareOp(D3DCMPFUNC(rs[D3DRS_ALPHAFUNC]))
       : VK_COMPARE_OP_ALWAYS;
     
-    EmitCs([cAlphaOp = alphaOp] (DxvkContext* ctx) {
+    DxvkCsStateKey stateKey(DxvkCsState::SpecConstant, D3D9SpecConstantId::AlphaTestEnable);
+
+    EmitCsState(stateKey, [cAlphaOp = alphaOp] (DxvkContext* ctx) {
       ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::AlphaTestEnable, cAlphaOp != VK_COMPARE_OP_ALWAYS);
       ctx->setSpecConstant(VK_PIPELINE_BIND_POINT_GRAPHICS, D3D9SpecConstantId::AlphaCompareOp,  cAlphaOp);
     });
@@ -5459,7 +5496,7 @@ namespace dxvk {
 
     uint32_t ref = uint32_t(rs[D3DRS_STENCILREF]);
 
-    EmitCs([cRef = ref] (DxvkContext* ctx) {
+    EmitCsState(DxvkCsState::StencilReference, [cRef = ref] (DxvkContext* ctx) {
       ctx->setStencilReference(cRef);
     });
   }
@@ -5841,7 +5878,7 @@ namespace dxvk {
   void D3D9DeviceEx::BindShader(
   const D3D9CommonShader*                 pShaderModule,
         D3D9ShaderPermutation             Permutation) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::Shader, uint32_t(ShaderStage)), [
       cShader = pShaderModule->GetShader(Permutation)
     ] (DxvkContext* ctx) {
       ctx->bindShader(GetShaderStage(ShaderStage), cShader);
@@ -5967,7 +6004,7 @@ namespace dxvk {
         D3D9VertexBuffer*                 pBuffer,
         UINT                              Offset,
         UINT                              Stride) {
-    EmitCs([
+    EmitCsState(DxvkCsStateKey(DxvkCsState::VertexBuffer, Slot), [
       cSlotId       = Slot,
       cBufferSlice  = pBuffer != nullptr ? 
           pBuffer->GetCommonBuffer()->GetBufferSlice<D3D9_COMMON_BUFFER_TYPE_REAL>(Offset) 
@@ -5987,7 +6024,7 @@ namespace dxvk {
 
     const VkIndexType indexType = DecodeIndexType(format);
 
-    EmitCs([
+    EmitCsState(DxvkCsState::IndexBuffer, [
       cBufferSlice = buffer != nullptr ? buffer->GetBufferSlice<D3D9_COMMON_BUFFER_TYPE_REAL>() : DxvkBufferSlice(),
       cIndexType   = indexType
     ](DxvkContext* ctx) {
@@ -6926,7 +6963,7 @@ namespace dxvk {
       return hr;
 
     Flush();
-    SynchronizeCsThread();
+    SynchronizeCsThread(DxvkCsThread::SynchronizeAll);
 
     return D3D_OK;
   }
@@ -665,6 +665,7 @@ namespace dxvk {
 
     bool WaitForResource(
       const Rc<DxvkResource>&                 Resource,
+            uint64_t                          SequenceNumber,
             DWORD                             MapFlags);
 
     /**
@@ -734,7 +735,7 @@ namespace dxvk {
 
     void CreateConstantBuffers();
 
-    void SynchronizeCsThread();
+    void SynchronizeCsThread(uint64_t SequenceNumber);
 
     void Flush();
 
@@ -928,6 +929,7 @@ namespace dxvk {
     dxvk::high_resolution_clock::time_point m_lastFlush
       = dxvk::high_resolution_clock::now();
     DxvkCsThread                    m_csThread;
+    uint64_t                        m_csSeqNum = 0ull;
     bool                            m_csIsBusy = false;
 
     uint32_t                        m_frameLatency = DefaultFrameLatency;
@@ -936,6 +938,7 @@ namespace dxvk {
     D3D9FormatHelper*               m_converter   = nullptr;
 
     DxvkCsChunkRef                  m_csChunk;
+    bool                            m_csStateElimination;
 
     D3D9FFShaderModuleSet           m_ffModules;
     D3D9SWVPEmulator                m_swvpEmulator;
@@ -955,8 +958,23 @@ namespace dxvk {
       }
     }
 
+    template<typename Cmd>
+    void EmitCsState(DxvkCsStateKey Key, Cmd&& command) {
+      if (unlikely(!m_csStateElimination))
+        Key = DxvkCsStateKey();
+
+      if (unlikely(!m_csChunk->push(command, Key))) {
+        EmitCsChunk(std::move(m_csChunk));
+
+        m_csChunk = AllocCsChunk();
+        m_csChunk->push(command, Key);
+      }
+    }
+
     void EmitCsChunk(DxvkCsChunkRef&& chunk);
 
+    uint64_t GetCurrentSequenceNumber();
+
     void FlushCsChunk() {
       if (likely(!m_csChunk->empty())) {
         EmitCsChunk(std::move(m_csChunk));
@@ -22,7 +22,6 @@ namespace dxvk {
     DxvkShaderKey shaderKey = { ShaderStage, *pHash };
 
     const std::string name = shaderKey.toString();
-    Logger::debug(str::format("Compiling shader ", name));
     
     // If requested by the user, dump both the raw DXBC
     // shader and the compiled SPIR-V module to a file.
@@ -51,16 +50,42 @@ namespace dxvk {
       }
     }
     
-    // Decide whether we need to create a pass-through
-    // geometry shader for vertex shader stream output
-
     const D3D9ConstantLayout& constantLayout = ShaderStage == VK_SHADER_STAGE_VERTEX_BIT
       ? pDevice->GetVertexConstantLayout()
       : pDevice->GetPixelConstantLayout();
 
-    m_shaders      = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
-    m_isgn         = pModule->isgn();
-    m_usedSamplers = pModule->usedSamplers();
+    // Skip compilation if the shader was compiled
+    // with the same options in a previous run
+    Rc<DxvkShaderCache> shaderCache = pDevice->GetDXVKDevice()->getShaderCache();
+    DxvkShaderCacheKey  shaderCacheKey = { shaderKey, GetOptionsHash(pDxsoModuleInfo, constantLayout) };
+
+    bool cached = false;
+
+    if (shaderCache != nullptr) {
+      DxvkShaderCacheData data;
+
+      cached = shaderCache->lookup(shaderCacheKey, data)
+            && ReadCacheData(data);
+    }
+
+    if (!cached) {
+      Logger::debug(str::format("Compiling shader ", name));
+
+      m_shaders      = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo, constantLayout);
+      m_isgn         = pModule->isgn();
+      m_usedSamplers = pModule->usedSamplers();
+      m_usedRTs      = pModule->usedRTs();
+
+      m_info      = pModule->info();
+      m_meta      = pModule->meta();
+      m_constants = pModule->constants();
+
+      if (shaderCache != nullptr) {
+        DxvkShaderCacheData data;
+        WriteCacheData(data);
+        shaderCache->store(shaderCacheKey, data);
+      }
+    }
 
     // Shift up these sampler bits so we can just
     // do an or per-draw in the device.
@@ -68,12 +93,6 @@ namespace dxvk {
     if (ShaderStage == VK_SHADER_STAGE_VERTEX_BIT)
       m_usedSamplers <<= 17;
 
-    m_usedRTs      = pModule->usedRTs();
-
-    m_info      = pModule->info();
-    m_meta      = pModule->meta();
-    m_constants = pModule->constants();
-
     m_shaders[0]->setShaderKey(shaderKey);
 
     if (m_shaders[1] != nullptr) {
@@ -96,6 +115,53 @@ namespace dxvk {
   }
 
 
+  bool D3D9CommonShader::ReadCacheData(
+          DxvkShaderCacheData&  Data) {
+    for (auto& shader : m_shaders) {
+      if (!Data.readShader(shader))
+        return false;
+    }
+
+    return m_shaders[D3D9ShaderPermutations::None] != nullptr
+        && Data.read(m_isgn)
+        && Data.read(m_usedSamplers)
+        && Data.read(m_usedRTs)
+        && Data.read(m_info)
+        && Data.read(m_meta)
+        && Data.readVector(m_constants)
+        && Data.eof();
+  }
+
+
+  void D3D9CommonShader::WriteCacheData(
+          DxvkShaderCacheData&  Data) const {
+    for (const auto& shader : m_shaders)
+      Data.writeShader(shader);
+
+    Data.write(m_isgn);
+    Data.write(m_usedSamplers);
+    Data.write(m_usedRTs);
+    Data.write(m_info);
+    Data.write(m_meta);
+    Data.writeVector(m_constants);
+  }
+
+
+  Sha1Hash D3D9CommonShader::GetOptionsHash(
+    const DxsoModuleInfo*     pDxsoModuleInfo,
+    const D3D9ConstantLayout& ConstantLayout) {
+    Sha1Hash optionsHash = pDxsoModuleInfo->options.computeHash();
+
+    std::array<Sha1Data, 3> chunks = {{
+      { "D3D9",           4                       },
+      { &optionsHash,     sizeof(optionsHash)     },
+      { &ConstantLayout,  sizeof(ConstantLayout)  },
+    }};
+
+    return Sha1Hash::compute(chunks.size(), chunks.data());
+  }
+
+
   D3D9CommonShader D3D9ShaderModuleSet::GetShaderModule(
             D3D9DeviceEx*         pDevice,
             VkShaderStageFlagBits ShaderStage,
@@ -70,6 +70,16 @@ namespace dxvk {
 
     std::vector<uint8_t>  m_bytecode;
 
+    bool ReadCacheData(
+            DxvkShaderCacheData&  Data);
+
+    void WriteCacheData(
+            DxvkShaderCacheData&  Data) const;
+
+    static Sha1Hash GetOptionsHash(
+      const DxsoModuleInfo*     pDxsoModuleInfo,
+      const D3D9ConstantLayout& ConstantLayout);
+
   };
 
   /**
@@ -443,6 +443,9 @@ namespace dxvk {
         cImage, cSubresources, VkOffset3D { 0, 0, 0 },
         cLevelExtent);
     });
+
+    dstTexInfo->TrackMappingBufferSequenceNumber(
+      dst->GetSubresource(), m_parent->GetCurrentSequenceNumber());
     
     dstTexInfo->SetDirty(dst->GetSubresource(), true);
 
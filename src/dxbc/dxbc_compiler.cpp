@@ -253,13 +253,17 @@ namespace dxvk {
         shaderOptions.xfbStrides[i] = m_moduleInfo.xfb->strides[i];
     }
 
+    // Remove redundancies from the generated code
+    SpirvOptimizer optimizer(m_module.compile());
+    optimizer.run(m_moduleInfo.options.spirvPasses);
+
     // Create the shader module object
     return new DxvkShader(
       m_programInfo.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile(),
+      optimizer.getCode(),
       shaderOptions,
       std::move(m_immConstData));
   }
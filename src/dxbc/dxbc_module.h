@@ -48,6 +48,14 @@ namespace dxvk {
     Rc<DxbcIsgn> isgn() const { return m_isgnChunk; }
     Rc<DxbcIsgn> osgn() const { return m_osgnChunk; }
     
+    /**
+     * \brief Checks whether the module has code
+     * \returns \c true if a SHDR or SHEX chunk exists
+     */
+    bool hasCode() const {
+      return m_shexChunk != nullptr;
+    }
+    
     /**
      * \brief Compiles DXBC shader to SPIR-V module
      * 
@@ -57,6 +57,35 @@ namespace dxvk {
     
     // Apply shader-related options
     applyTristate(useSubgroupOpsForEarlyDiscard, device->config().useEarlyDiscard);
+
+    if (device->config().spirvEliminateDeadCode)
+      spirvPasses.set(SpirvOptimizerPass::EliminateDeadCode);
+    if (device->config().spirvFoldConstants)
+      spirvPasses.set(SpirvOptimizerPass::FoldConstants);
+    if (device->config().spirvForwardStores)
+      spirvPasses.set(SpirvOptimizerPass::ForwardStores);
+  }
+
+
+  Sha1Hash DxbcOptions::computeHash() const {
+    // Hash members individually since the struct has padding
+    const std::array<uint64_t, 13> data = {{
+      useDepthClipWorkaround,
+      useStorageImageReadWithoutFormat,
+      useSubgroupOpsForAtomicCounters,
+      useDemoteToHelperInvocation,
+      useSubgroupOpsForEarlyDiscard,
+      useSdivForBufferIndex,
+      enableRtOutputNanFixup,
+      dynamicIndexedConstantBufferAsSsbo,
+      zeroInitWorkgroupMemory,
+      invariantPosition,
+      forceTgsmBarriers,
+      minSsboAlignment,
+      spirvPasses.raw(),
+    }};
+
+    return Sha1Hash::compute(data);
   }
   
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "../dxvk/dxvk_device.h"
 
+#include "../spirv/spirv_optimizer.h"
+
 namespace dxvk {
 
   struct D3D11Options;
@@ -10,6 +12,10 @@ namespace dxvk {
     DxbcOptions();
     DxbcOptions(const Rc<DxvkDevice>& device, const D3D11Options& options);
 
+    /// Hashes all options, since they affect the
+    /// generated code. Used for the shader cache.
+    Sha1Hash computeHash() const;
+
     // Clamp oDepth in fragment shaders if the depth
     // clip device feature is not supported
     bool useDepthClipWorkaround = false;
@@ -50,6 +56,9 @@ namespace dxvk {
 
     /// Minimum storage buffer alignment
     VkDeviceSize minSsboAlignment = 0;
+
+    /// SPIR-V optimizer passes to run on the generated code
+    SpirvOptimizerPasses spirvPasses;
   };
   
 }
\ No newline at end of file
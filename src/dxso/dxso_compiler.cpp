@@ -245,12 +245,15 @@ namespace dxvk {
     DxvkShaderOptions shaderOptions = { };
     DxvkShaderConstData constData = { };
 
+    SpirvOptimizer optimizer(m_module.compile());
+    optimizer.run(m_moduleInfo.options.spirvPasses);
+
     return new DxvkShader(
       m_programInfo.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile(),
+      optimizer.getCode(),
       shaderOptions,
       std::move(constData));
   }
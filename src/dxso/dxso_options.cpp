@@ -47,6 +47,33 @@ namespace dxvk {
     vertexConstantBufferAsSSBO = pDevice->GetVertexConstantLayout().totalSize() > devInfo.core.properties.limits.maxUniformBufferRange;
 
     longMad = options.longMad;
+
+    if (device->config().spirvEliminateDeadCode)
+      spirvPasses.set(SpirvOptimizerPass::EliminateDeadCode);
+    if (device->config().spirvFoldConstants)
+      spirvPasses.set(SpirvOptimizerPass::FoldConstants);
+    if (device->config().spirvForwardStores)
+      spirvPasses.set(SpirvOptimizerPass::ForwardStores);
+  }
+
+
+  Sha1Hash DxsoOptions::computeHash() const {
+    // Hash members individually since the struct has padding
+    const std::array<uint32_t, 11> data = {{
+      useDemoteToHelperInvocation,
+      useSubgroupOpsForEarlyDiscard,
+      strictConstantCopies,
+      d3d9FloatEmulation,
+      strictPow,
+      shaderModel,
+      invariantPosition,
+      forceSamplerTypeSpecConstants,
+      vertexConstantBufferAsSSBO,
+      longMad,
+      spirvPasses.raw(),
+    }};
+
+    return Sha1Hash::compute(data);
   }
 
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../dxvk/dxvk_device.h"
+
+#include "../spirv/spirv_optimizer.h"
 #include "../d3d9/d3d9_options.h"
 
 namespace dxvk {
@@ -12,6 +14,10 @@ namespace dxvk {
     DxsoOptions();
     DxsoOptions(D3D9DeviceEx* pDevice, const D3D9Options& options);
 
+    /// Hashes all options, since they affect the
+    /// generated code. Used for the shader cache.
+    Sha1Hash computeHash() const;
+
     /// Use a SPIR-V extension to implement D3D-style discards
     bool useDemoteToHelperInvocation = false;
 
@@ -50,6 +56,9 @@ namespace dxvk {
     /// This solves some rendering bugs in games that have z-pass shaders which
     /// don't match entirely to the regular vertex shader in this way.
     bool longMad;
+
+    /// SPIR-V optimizer passes to run on the generated code
+    SpirvOptimizerPasses spirvPasses;
   };
 
 }
\ No newline at end of file
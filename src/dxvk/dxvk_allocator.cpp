@@ -0,0 +1,297 @@
+#include "dxvk_allocator.h"
+
+namespace dxvk {
+
+  DxvkRangeAllocator::DxvkRangeAllocator(VkDeviceSize size)
+  : m_size(size) {
+    for (auto& heads : m_heads)
+      heads.fill(NullBlock);
+
+    // Mark the entire range as free
+    uint32_t block = this->createBlock(0, size, NullBlock, NullBlock);
+    this->insertFreeBlock(block);
+  }
+
+
+  DxvkRangeAllocator::~DxvkRangeAllocator() {
+
+  }
+
+
+  DxvkRange DxvkRangeAllocator::alloc(
+          VkDeviceSize          size,
+          VkDeviceSize          align) {
+    align = std::max<VkDeviceSize>(align, 1);
+
+    VkDeviceSize length = dxvk::align(std::max<VkDeviceSize>(size, 1), align);
+
+    if (length > m_size)
+      return DxvkRange();
+
+    // Look up a free block that is large enough to hold the
+    // allocation. If the block we find cannot accomodate the
+    // alignment, retry with the worst-case padding added,
+    // which is guaranteed to succeed if any block fits.
+    uint32_t block = this->findFreeBlock(length);
+
+    if (block != NullBlock) {
+      const Block& b = m_blocks[block];
+
+      if (dxvk::align(b.offset, align) + length > b.offset + b.length)
+        block = NullBlock;
+    }
+
+    if (block == NullBlock && align > 1)
+      block = this->findFreeBlock(length + align - 1);
+
+    if (block == NullBlock)
+      return DxvkRange();
+
+    this->removeFreeBlock(block);
+
+    // Return any alignment padding at the start of
+    // the block to the free lists as a separate block
+    VkDeviceSize padding = dxvk::align(m_blocks[block].offset, align)
+                         - m_blocks[block].offset;
+
+    if (padding) {
+      uint32_t next = this->splitBlock(block, padding);
+      this->insertFreeBlock(block);
+      block = next;
+    }
+
+    // Same for the unused space at the end
+    if (m_blocks[block].length > length) {
+      uint32_t next = this->splitBlock(block, length);
+      this->insertFreeBlock(next);
+    }
+
+    m_blocks[block].isFree = false;
+    m_used += length;
+
+    DxvkRange result;
+    result.offset = m_blocks[block].offset;
+    result.length = length;
+    result.block  = block;
+    return result;
+  }
+
+
+  void DxvkRangeAllocator::free(
+          uint32_t              block) {
+    m_used -= m_blocks[block].length;
+
+    // Merge with the physically adjacent blocks if they are
+    // free. Since free blocks are always merged eagerly, we
+    // never need to look further than one block either way.
+    uint32_t prev = m_blocks[block].prevPhys;
+
+    if (prev != NullBlock && m_blocks[prev].isFree) {
+      this->removeFreeBlock(prev);
+
+      m_blocks[prev].length  += m_blocks[block].length;
+      m_blocks[prev].nextPhys = m_blocks[block].nextPhys;
+
+      if (m_blocks[prev].nextPhys != NullBlock)
+        m_blocks[m_blocks[prev].nextPhys].prevPhys = prev;
+
+      this->destroyBlock(block);
+      block = prev;
+    }
+
+    uint32_t next = m_blocks[block].nextPhys;
+
+    if (next != NullBlock && m_blocks[next].isFree) {
+      this->removeFreeBlock(next);
+
+      m_blocks[block].length  += m_blocks[next].length;
+      m_blocks[block].nextPhys = m_blocks[next].nextPhys;
+
+      if (m_blocks[block].nextPhys != NullBlock)
+        m_blocks[m_blocks[block].nextPhys].prevPhys = block;
+
+      this->destroyBlock(next);
+    }
+
+    this->insertFreeBlock(block);
+  }
+
+
+  uint32_t DxvkRangeAllocator::createBlock(
+          VkDeviceSize          offset,
+          VkDeviceSize          length,
+          uint32_t              prevPhys,
+          uint32_t              nextPhys) {
+    uint32_t index;
+
+    if (!m_unusedBlocks.empty()) {
+      index = m_unusedBlocks.back();
+      m_unusedBlocks.pop_back();
+    } else {
+      index = uint32_t(m_blocks.size());
+      m_blocks.emplace_back();
+    }
+
+    Block& b = m_blocks[index];
+    b.offset   = offset;
+    b.length   = length;
+    b.prevPhys = prevPhys;
+    b.nextPhys = nextPhys;
+    b.prevFree = NullBlock;
+    b.nextFree = NullBlock;
+    b.isFree   = false;
+    return index;
+  }
+
+
+  void DxvkRangeAllocator::destroyBlock(
+          uint32_t              block) {
+    m_unusedBlocks.push_back(block);
+  }
+
+
+  void DxvkRangeAllocator::insertFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    mapSize(m_blocks[block].length, fl, sl);
+
+    uint32_t head = m_heads[fl][sl];
+
+    Block& b = m_blocks[block];
+    b.isFree   = true;
+    b.prevFree = NullBlock;
+    b.nextFree = head;
+
+    if (head != NullBlock)
+      m_blocks[head].prevFree = block;
+
+    m_heads[fl][sl] = block;
+    m_slMasks[fl] |= 1u << sl;
+    m_flMask      |= uint64_t(1) << fl;
+  }
+
+
+  void DxvkRangeAllocator::removeFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    mapSize(m_blocks[block].length, fl, sl);
+
+    Block& b = m_blocks[block];
+    b.isFree = false;
+
+    if (b.prevFree != NullBlock)
+      m_blocks[b.prevFree].nextFree = b.nextFree;
+    else
+      m_heads[fl][sl] = b.nextFree;
+
+    if (b.nextFree != NullBlock)
+      m_blocks[b.nextFree].prevFree = b.prevFree;
+
+    if (m_heads[fl][sl] == NullBlock) {
+      m_slMasks[fl] &= ~(1u << sl);
+
+      if (!m_slMasks[fl])
+        m_flMask &= ~(uint64_t(1) << fl);
+    }
+  }
+
+
+  uint32_t DxvkRangeAllocator::findFreeBlock(
+          VkDeviceSize          size) const {
+    if (size > m_size)
+      return NullBlock;
+
+    // Round the size up to the next size class so
+    // that any block in the list we find will fit
+    VkDeviceSize roundedSize = size;
+
+    if (size >= SlCount)
+      roundedSize += (VkDeviceSize(1) << (findMsb(size) - SlBits)) - 1;
+
+    uint32_t fl, sl;
+    mapSize(roundedSize, fl, sl);
+
+    uint32_t slMask = m_slMasks[fl] & (~0u << sl);
+
+    if (!slMask) {
+      uint64_t flMask = fl + 1 < FlCount
+        ? m_flMask & (~uint64_t(0) << (fl + 1))
+        : uint64_t(0);
+
+      if (flMask) {
+        fl = findLsb(flMask);
+        slMask = m_slMasks[fl];
+      }
+    }
+
+    if (slMask) {
+      sl = bit::tzcnt(slMask);
+      return m_heads[fl][sl];
+    }
+
+    // No larger size class has any free blocks, but the
+    // first block in the exact size class may still fit
+    mapSize(size, fl, sl);
+    uint32_t head = m_heads[fl][sl];
+
+    if (head != NullBlock && m_blocks[head].length >= size)
+      return head;
+
+    return NullBlock;
+  }
+
+
+  uint32_t DxvkRangeAllocator::splitBlock(
+          uint32_t              block,
+          VkDeviceSize          length) {
+    uint32_t next = this->createBlock(
+      m_blocks[block].offset + length,
+      m_blocks[block].length - length,
+      block, m_blocks[block].nextPhys);
+
+    if (m_blocks[next].nextPhys != NullBlock)
+      m_blocks[m_blocks[next].nextPhys].prevPhys = next;
+
+    m_blocks[block].length   = length;
+    m_blocks[block].nextPhys = next;
+    return next;
+  }
+
+
+  void DxvkRangeAllocator::mapSize(
+          VkDeviceSize          size,
+          uint32_t&             fl,
+          uint32_t&             sl) {
+    if (size < SlCount) {
+      fl = 0;
+      sl = uint32_t(size);
+    } else {
+      uint32_t msb = findMsb(size);
+      fl = msb - SlBits + 1;
+      sl = uint32_t(size >> (msb - SlBits)) - SlCount;
+    }
+  }
+
+
+  uint32_t DxvkRangeAllocator::findMsb(
+          uint64_t              n) {
+    uint32_t hi = uint32_t(n >> 32);
+    uint32_t lo = uint32_t(n);
+
+    return hi
+      ? 63 - bit::lzcnt(hi)
+      : 31 - bit::lzcnt(lo);
+  }
+
+
+  uint32_t DxvkRangeAllocator::findLsb(
+          uint64_t              n) {
+    uint32_t hi = uint32_t(n >> 32);
+    uint32_t lo = uint32_t(n);
+
+    return lo
+      ? bit::tzcnt(lo)
+      : bit::tzcnt(hi) + 32;
+  }
+
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "dxvk_include.h"
+
+#include "../util/util_bit.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Range allocation
+   *
+   * Describes a range that has been sub-allocated from a
+   * \ref DxvkRangeAllocator. The block index must be passed
+   * back to the allocator in order to free the range.
+   */
+  struct DxvkRange {
+    VkDeviceSize offset = 0;
+    VkDeviceSize length = 0;
+    uint32_t     block  = ~0u;
+  };
+
+
+  /**
+   * \brief Segregated-fit range allocator
+   *
+   * Two-level segregated fit allocator that manages a linear
+   * address range. Free blocks are kept in size-class lists
+   * indexed by a pair of bit masks, so that both allocation
+   * and deallocation run in constant time, and adjacent free
+   * blocks are merged immediately so that fragmentation stays
+   * bounded. This is not thread-safe.
+   */
+  class DxvkRangeAllocator {
+    /// Number of second-level bits. Each power-of-two
+    /// size class is split into 2^SlBits sub-classes.
+    constexpr static uint32_t SlBits  = 4;
+    constexpr static uint32_t SlCount = 1u << SlBits;
+    constexpr static uint32_t FlCount = 64 - SlBits + 1;
+    /// Null block index
+    constexpr static uint32_t NullBlock = ~0u;
+  public:
+
+    DxvkRangeAllocator(VkDeviceSize size);
+
+    ~DxvkRangeAllocator();
+
+    /**
+     * \brief Total size of the managed range
+     * \returns Size, in bytes
+     */
+    VkDeviceSize size() const {
+      return m_size;
+    }
+
+    /**
+     * \brief Number of bytes currently allocated
+     *
+     * Includes alignment padding that could
+     * not be returned to the free lists.
+     * \returns Allocated size, in bytes
+     */
+    VkDeviceSize used() const {
+      return m_used;
+    }
+
+    /**
+     * \brief Checks whether the range is unused
+     * \returns \c true if no allocations are live
+     */
+    bool isEmpty() const {
+      return m_used == 0;
+    }
+
+    /**
+     * \brief Allocates a range
+     *
+     * The allocated length will be a multiple of the
+     * requested alignment. On failure, the returned
+     * range will have a length of zero.
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment
+     * \returns The allocated range
+     */
+    DxvkRange alloc(
+            VkDeviceSize          size,
+            VkDeviceSize          align);
+
+    /**
+     * \brief Frees a range
+     *
+     * Merges the block with adjacent free blocks.
+     * \param [in] block Block index of the range
+     */
+    void free(
+            uint32_t              block);
+
+  private:
+
+    struct Block {
+      VkDeviceSize offset;
+      VkDeviceSize length;
+      uint32_t     prevPhys;
+      uint32_t     nextPhys;
+      uint32_t     prevFree;
+      uint32_t     nextFree;
+      bool         isFree;
+    };
+
+    VkDeviceSize              m_size;
+    VkDeviceSize              m_used = 0;
+
+    std::vector<Block>        m_blocks;
+    std::vector<uint32_t>     m_unusedBlocks;
+
+    uint64_t                                                m_flMask = 0;
+    std::array<uint32_t, FlCount>                           m_slMasks = { };
+    std::array<std::array<uint32_t, SlCount>, FlCount>      m_heads;
+
+    uint32_t createBlock(
+            VkDeviceSize          offset,
+            VkDeviceSize          length,
+            uint32_t              prevPhys,
+            uint32_t              nextPhys);
+
+    void destroyBlock(
+            uint32_t              block);
+
+    void insertFreeBlock(
+            uint32_t              block);
+
+    void removeFreeBlock(
+            uint32_t              block);
+
+    uint32_t findFreeBlock(
+            VkDeviceSize          size) const;
+
+    uint32_t splitBlock(
+            uint32_t              block,
+            VkDeviceSize          length);
+
+    static void mapSize(
+            VkDeviceSize          size,
+            uint32_t&             fl,
+            uint32_t&             sl);
+
+    static uint32_t findMsb(
+            uint64_t              n);
+
+    static uint32_t findLsb(
+            uint64_t              n);
+
+  };
+
+}
@@ -1,5 +1,6 @@
 #include "dxvk_buffer.h"
 #include "dxvk_device.h"
+#include "dxvk_discard_ring.h"
 
 #include <algorithm>
 
@@ -18,6 +19,7 @@ namespace dxvk {
     // requirements imposed by the Vulkan device/driver
     VkDeviceSize sliceAlignment = computeSliceAlignment();
     m_physSliceLength = createInfo.size;
+    m_physSliceAlign  = sliceAlignment;
     m_physSliceStride = align(createInfo.size, sliceAlignment);
     m_physSliceCount  = std::max<VkDeviceSize>(1, 256 / m_physSliceStride);
 
@@ -39,10 +41,19 @@ namespace dxvk {
 
     m_physSlice = slice;
     m_lazyAlloc = m_physSliceCount > 1;
+
+    m_physSliceTotal   = m_physSliceCount;
+    m_sliceWindowStart = high_resolution_clock::now();
   }
 
 
   DxvkBuffer::~DxvkBuffer() {
+    if (m_defrag)
+      m_defrag->unregisterBuffer(this);
+
+    if (m_ring)
+      m_ring->free(m_physSlice);
+
     auto vkd = m_device->vkd();
 
     for (const auto& buffer : m_buffers)
@@ -108,6 +119,7 @@ namespace dxvk {
     // Ask driver whether we should be using a dedicated allocation
     handle.memory = m_memAlloc->alloc(&memReq.memoryRequirements,
       dedicatedRequirements, dedMemoryAllocInfo, m_memFlags, priority);
+    handle.sliceCount = sliceCount;
     
     if (vkd->vkBindBufferMemory(vkd->device(), handle.buffer,
         handle.memory.memory(), handle.memory.offset()) != VK_SUCCESS)
@@ -150,6 +162,91 @@ namespace dxvk {
   }
 
 
+  DxvkBufferSliceHandle DxvkBuffer::allocRingSlice() {
+    return m_ring->alloc(m_memFlags, m_physSliceAlign, m_physSliceLength);
+  }
+
+
+  void DxvkBuffer::freeRingSlices(std::vector<DxvkBufferSliceHandle>& slices) {
+    slices.erase(std::remove_if(slices.begin(), slices.end(),
+      [this] (const DxvkBufferSliceHandle& slice) {
+        return m_ring->free(slice);
+      }), slices.end());
+  }
+
+
+  void DxvkBuffer::trackSliceUsage() {
+    VkDeviceSize used = m_physSliceTotal - m_freeSlices.size();
+    m_sliceUsePeak = std::max(m_sliceUsePeak, used);
+
+    auto now = high_resolution_clock::now();
+
+    if (now - m_sliceWindowStart < SliceWindow)
+      return;
+
+    // Consider the previous window as well so that we
+    // don't shrink the pool right after a usage spike
+    VkDeviceSize peak = std::max(m_sliceUsePeak, m_sliceUsePrevPeak);
+
+    m_sliceUsePrevPeak = m_sliceUsePeak;
+    m_sliceUsePeak     = used;
+    m_sliceWindowStart = now;
+
+    // Keep twice the peak number of slices around in order
+    // to not immediately have to grow the pool again
+    if (m_physSliceTotal > 2 * peak)
+      retireSlices(2 * peak);
+  }
+
+
+  void DxvkBuffer::retireSlices(VkDeviceSize targetCount) {
+    // Buffer views are cached per slice, so we cannot
+    // destroy buffers that may have views pointing to
+    // them without potentially reusing stale views.
+    if (m_info.usage & (VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT
+                      | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT))
+      return;
+
+    // Slices are only freed once the GPU is done using
+    // them, so any backing buffer whose slices are all
+    // in the free list can safely be destroyed.
+    std::unordered_map<VkBuffer, VkDeviceSize> freeCounts;
+
+    for (const auto& slice : m_freeSlices)
+      freeCounts[slice.handle] += 1;
+
+    std::vector<DxvkBufferHandle> retired;
+
+    for (size_t i = m_buffers.size(); i > 0; i--) {
+      const DxvkBufferHandle& handle = m_buffers[i - 1];
+
+      if (m_physSliceTotal - handle.sliceCount < targetCount
+       || freeCounts[handle.buffer] != handle.sliceCount)
+        continue;
+
+      m_physSliceTotal -= handle.sliceCount;
+      m_physSliceCount  = handle.sliceCount;
+
+      retired.push_back(std::move(m_buffers[i - 1]));
+      m_buffers.erase(m_buffers.begin() + (i - 1));
+    }
+
+    if (retired.empty())
+      return;
+
+    m_freeSlices.erase(std::remove_if(m_freeSlices.begin(), m_freeSlices.end(),
+      [&retired] (const DxvkBufferSliceHandle& slice) {
+        return std::find_if(retired.begin(), retired.end(),
+          [&slice] (const DxvkBufferHandle& handle) {
+            return handle.buffer == slice.handle;
+          }) != retired.end();
+      }), m_freeSlices.end());
+
+    auto vkd = m_device->vkd();
+
+    for (const auto& handle : retired)
+      vkd->vkDestroyBuffer(vkd->device(), handle.buffer, nullptr);
+  }
 
   
   DxvkBufferView::DxvkBufferView(
@@ -226,11 +323,23 @@ namespace dxvk {
   void DxvkBufferTracker::reset() {
     std::sort(m_entries.begin(), m_entries.end(),
       [] (const Entry& a, const Entry& b) {
+        if (a.buffer != b.buffer)
+          return a.buffer.ptr() < b.buffer.ptr();
         return a.slice.handle < b.slice.handle;
       });
 
-    for (const auto& e : m_entries)
-      e.buffer->freeSlice(e.slice);
+    // Return slices to each buffer in one batch. The
+    // scratch vector is reused to avoid allocations.
+    for (size_t i = 0; i < m_entries.size(); ) {
+      size_t j = i;
+      m_slices.clear();
+
+      while (j < m_entries.size() && m_entries[j].buffer == m_entries[i].buffer)
+        m_slices.push_back(m_entries[j++].slice);
+
+      m_entries[i].buffer->freeSlices(m_slices);
+      i = j;
+    }
       
     m_entries.clear();
   }
@@ -9,8 +9,13 @@
 #include "dxvk_memory.h"
 #include "dxvk_resource.h"
 
+#include "../util/sync/sync_list.h"
+
 namespace dxvk {
 
+  class DxvkDiscardRing;
+  class DxvkMemoryDefragmenter;
+
   /**
    * \brief Buffer create info
    * 
@@ -60,6 +65,7 @@ namespace dxvk {
   struct DxvkBufferHandle {
     VkBuffer      buffer = VK_NULL_HANDLE;
     DxvkMemory    memory;
+    VkDeviceSize  sliceCount = 0;
   };
   
 
@@ -101,6 +107,10 @@ namespace dxvk {
    */
   class DxvkBuffer : public DxvkResource {
     friend class DxvkBufferView;
+    friend class DxvkDiscardRing;
+    friend class DxvkMemoryDefragmenter;
+    /// Duration of a slice usage tracking window
+    constexpr static std::chrono::milliseconds SliceWindow = std::chrono::milliseconds(1000);
   public:
     
     DxvkBuffer(
@@ -130,6 +140,17 @@ namespace dxvk {
       return m_memFlags;
     }
     
+    /**
+     * \brief Backing memory
+     *
+     * Memory of the buffer's initial backing resource.
+     * Only meaningful if the buffer was never discarded.
+     * \returns Memory object of the backing buffer
+     */
+    const DxvkMemory& getMemory() const {
+      return m_buffer.memory;
+    }
+
     /**
      * \brief Map pointer
      * 
@@ -205,6 +226,42 @@ namespace dxvk {
     DxvkBufferSliceHandle rename(const DxvkBufferSliceHandle& slice) {
       return std::exchange(m_physSlice, slice);
     }
+
+    /**
+     * \brief Checks whether the buffer can be relocated
+     *
+     * Buffers that have been discarded own more than one
+     * backing resource and cannot be moved in memory.
+     * \returns \c true if the buffer was never discarded
+     */
+    bool canRelocate() {
+      std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+      return !m_discarded;
+    }
+
+    /**
+     * \brief Exchanges backing storage with another buffer
+     *
+     * Used to move a buffer to a different memory location.
+     * The other buffer must have been created with the same
+     * properties, and its contents must have been initialized
+     * with the contents of this buffer. Afterwards, the other
+     * buffer owns the old backing resource. Fails if either
+     * buffer has been discarded in the meantime.
+     * \param [in] other The buffer to exchange storage with
+     * \returns \c true on success
+     */
+    bool exchangeStorage(DxvkBuffer& other) {
+      std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+      std::unique_lock<sync::Spinlock> otherLock(other.m_freeMutex);
+
+      if (m_discarded || other.m_discarded)
+        return false;
+
+      std::swap(m_buffer,    other.m_buffer);
+      std::swap(m_physSlice, other.m_physSlice);
+      return true;
+    }
     
     /**
      * \brief Transform feedback vertex stride
@@ -235,15 +292,25 @@ namespace dxvk {
     DxvkBufferSliceHandle allocSlice() {
       std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
       
-      // If no slices are available, swap the two free lists.
+      // If no slices are available, take all slices that
+      // have been returned since we last ran out of slices.
       if (unlikely(m_freeSlices.empty())) {
-        std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
-        std::swap(m_freeSlices, m_nextSlices);
+        m_returnedSlices.drain([this] (const std::vector<DxvkBufferSliceHandle>& slices) {
+          m_freeSlices.insert(m_freeSlices.end(), slices.begin(), slices.end());
+        });
+
+        // The free list only runs dry after all slices have
+        // been handed out once, so this is a good place to
+        // sample the number of slices in use.
+        if (unlikely(!m_buffers.empty()))
+          trackSliceUsage();
       }
 
       // If there are still no slices available, create a new
       // backing buffer and add all slices to the free list.
       if (unlikely(m_freeSlices.empty())) {
+        m_discarded = true;
+
         if (likely(!m_lazyAlloc)) {
           DxvkBufferHandle handle = allocBuffer(m_physSliceCount);
 
@@ -251,6 +318,7 @@ namespace dxvk {
             pushSlice(handle, i);
 
           m_buffers.push_back(std::move(handle));
+          m_physSliceTotal += m_physSliceCount;
           m_physSliceCount = std::min(m_physSliceCount * 2, m_physSliceMaxCount);
         } else {
           for (uint32_t i = 1; i < m_physSliceCount; i++)
@@ -267,17 +335,42 @@ namespace dxvk {
     }
     
     /**
-     * \brief Frees a buffer slice
-     * 
-     * Marks the slice as free so that it can be used for
-     * subsequent allocations. Called automatically when
-     * the slice is no longer needed by the GPU.
-     * \param [in] slice The buffer slice to free
+     * \brief Allocates buffer slice for discarding
+     *
+     * Small host-visible buffers allocate slices from the
+     * device's discard ring rather than their own slice
+     * pool. Only use this for slices that will be made
+     * the buffer's backing resource right away.
+     * \returns The new buffer slice
      */
-    void freeSlice(const DxvkBufferSliceHandle& slice) {
-      // Add slice to a separate free list to reduce lock contention.
-      std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
-      m_nextSlices.push_back(slice);
+    DxvkBufferSliceHandle allocDiscardSlice() {
+      if (m_ring != nullptr)
+        return allocRingSlice();
+
+      return allocSlice();
+    }
+
+    /**
+     * \brief Frees buffer slices
+     * 
+     * Marks the slices as free so that they can be used for
+     * subsequent allocations. Called automatically when the
+     * slices are no longer needed by the GPU. This does not
+     * take any locks, so it is best to free slices in bulk.
+     * The slices are copied, so callers can reuse the vector.
+     * \param [in] slices The buffer slices to free
+     */
+    void freeSlices(std::vector<DxvkBufferSliceHandle>& slices) {
+      // Slices allocated from the discard ring are not
+      // owned by the buffer and need to be returned.
+      if (unlikely(m_ring != nullptr))
+        freeRingSlices(slices);
+
+      if (!slices.empty()) {
+        m_returnedSlices.emplace([&slices] (std::vector<DxvkBufferSliceHandle>& item) {
+          item.assign(slices.begin(), slices.end());
+        });
+      }
     }
     
   private:
@@ -292,18 +385,29 @@ namespace dxvk {
 
     uint32_t                m_vertexStride = 0;
     uint32_t                m_lazyAlloc = false;
+    bool                    m_discarded = false;
+
+    DxvkMemoryDefragmenter* m_defrag = nullptr;
+    DxvkDiscardRing*        m_ring   = nullptr;
     
     sync::Spinlock m_freeMutex;
-    sync::Spinlock m_swapMutex;
     
     std::vector<DxvkBufferHandle>        m_buffers;
     std::vector<DxvkBufferSliceHandle>   m_freeSlices;
-    std::vector<DxvkBufferSliceHandle>   m_nextSlices;
+
+    sync::MpscStack<std::vector<DxvkBufferSliceHandle>> m_returnedSlices;
     
     VkDeviceSize m_physSliceLength   = 0;
+    VkDeviceSize m_physSliceAlign    = 0;
     VkDeviceSize m_physSliceStride   = 0;
     VkDeviceSize m_physSliceCount    = 1;
     VkDeviceSize m_physSliceMaxCount = 1;
+    VkDeviceSize m_physSliceTotal    = 1;
+
+    VkDeviceSize m_sliceUsePeak      = 0;
+    VkDeviceSize m_sliceUsePrevPeak  = 0;
+
+    high_resolution_clock::time_point m_sliceWindowStart;
 
     void pushSlice(const DxvkBufferHandle& handle, uint32_t index) {
       DxvkBufferSliceHandle slice;
@@ -318,6 +422,16 @@ namespace dxvk {
             VkDeviceSize          sliceCount) const;
 
     VkDeviceSize computeSliceAlignment() const;
+
+    DxvkBufferSliceHandle allocRingSlice();
+
+    void freeRingSlices(
+            std::vector<DxvkBufferSliceHandle>& slices);
+
+    void trackSliceUsage();
+
+    void retireSlices(
+            VkDeviceSize          targetCount);
     
   };
   
@@ -682,6 +796,7 @@ namespace dxvk {
     };
     
     std::vector<Entry> m_entries;
+    std::vector<DxvkBufferSliceHandle> m_slices;
     
   };
   
@@ -130,6 +130,8 @@ namespace dxvk {
       Logger::err(str::format("  cs  : ", m_shaders.cs->debugName()));
       return VK_NULL_HANDLE;
     }
+
+    m_pipeMgr->m_cache->notifyUpdate();
     
     if (Logger::logLevel() <= LogLevel::Debug) {
       t1 = dxvk::high_resolution_clock::now();
@@ -16,11 +16,15 @@ namespace dxvk {
     m_execBarriers(DxvkCmdBuffer::ExecBuffer),
     m_gfxBarriers (DxvkCmdBuffer::ExecBuffer),
     m_queryManager(m_common->queryPool()),
-    m_staging     (device) {
+    m_staging     (device),
+    m_capture     (device->m_csCapture.get()) {
     if (m_device->features().extRobustness2.nullDescriptor)
       m_features.set(DxvkContextFeature::NullDescriptors);
     if (m_device->features().extExtendedDynamicState.extendedDynamicState)
       m_features.set(DxvkContextFeature::ExtendedDynamicState);
+
+    if (unlikely(m_capture != nullptr))
+      m_captureId = m_capture->registerContext();
   }
   
   
@@ -65,12 +69,17 @@ namespace dxvk {
   
   
   Rc<DxvkCommandList> DxvkContext::endRecording() {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::EndRecording);
+
     this->spillRenderPass();
     
     m_sdmaBarriers.recordCommands(m_cmd);
     m_initBarriers.recordCommands(m_cmd);
     m_execBarriers.recordCommands(m_cmd);
 
+    m_staging.track(m_cmd);
+
     m_cmd->endRecording();
     return std::exchange(m_cmd, nullptr);
   }
@@ -84,21 +93,62 @@ namespace dxvk {
     
     this->beginRecording(
       m_device->createCommandList());
+
+    if (m_relocateBuffers)
+      this->relocateBuffers();
   }
   
   
+  void DxvkContext::relocateBuffers() {
+    auto relocations = m_device->getBufferRelocations();
+
+    for (const auto& r : relocations) {
+      // The buffer may have been discarded since it was picked,
+      // in which case we cannot move it anymore. We also cannot
+      // move buffers that any command list still uses, since
+      // those commands would keep using the old backing buffer
+      // which is only kept alive by our command list.
+      if (!r.buffer->canRelocate() || r.buffer->isInUse())
+        continue;
+
+      this->copyBuffer(r.storage, 0, r.buffer, 0, r.buffer->info().size);
+
+      // Other contexts only ever write to relocatable buffers in
+      // order to initialize them. If that happened while we were
+      // recording the copy, the copied data is stale.
+      if (r.buffer->isInUse(DxvkAccess::Write))
+        continue;
+
+      // The storage buffer now owns the old backing resource
+      // and keeps it alive until the GPU is done with it. This
+      // runs at the start of a command list, so there are no
+      // bindings or barriers referencing the old resource.
+      r.buffer->exchangeStorage(*r.storage);
+    }
+  }
+
+
   void DxvkContext::beginQuery(const Rc<DxvkGpuQuery>& query) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->recordUnsupported(m_captureId, "beginQuery");
+
     m_queryManager.enableQuery(m_cmd, query);
   }
 
 
   void DxvkContext::endQuery(const Rc<DxvkGpuQuery>& query) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->recordUnsupported(m_captureId, "endQuery");
+
     m_queryManager.disableQuery(m_cmd, query);
   }
   
   
   void DxvkContext::bindRenderTargets(
     const DxvkRenderTargets&    targets) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindRenderTargets, targets);
+
     // Set up default render pass ops
     m_state.om.renderTargets = targets;
     
@@ -121,6 +171,9 @@ namespace dxvk {
   void DxvkContext::bindDrawBuffers(
     const DxvkBufferSlice&      argBuffer,
     const DxvkBufferSlice&      cntBuffer) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindDrawBuffers, argBuffer, cntBuffer);
+
     m_state.id.argBuffer = argBuffer;
     m_state.id.cntBuffer = cntBuffer;
 
@@ -131,6 +184,9 @@ namespace dxvk {
   void DxvkContext::bindIndexBuffer(
     const DxvkBufferSlice&      buffer,
           VkIndexType           indexType) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindIndexBuffer, buffer, indexType);
+
     if (!m_state.vi.indexBuffer.matchesBuffer(buffer))
       m_vbTracked.clr(MaxNumVertexBindings);
 
@@ -144,6 +200,9 @@ namespace dxvk {
   void DxvkContext::bindResourceBuffer(
           uint32_t              slot,
     const DxvkBufferSlice&      buffer) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindResourceBuffer, slot, buffer);
+
     bool needsUpdate = !m_rc[slot].bufferSlice.matchesBuffer(buffer);
 
     if (likely(needsUpdate))
@@ -169,6 +228,9 @@ namespace dxvk {
           uint32_t              slot,
     const Rc<DxvkImageView>&    imageView,
     const Rc<DxvkBufferView>&   bufferView) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindResourceView, slot, imageView, bufferView);
+
     m_rc[slot].imageView   = imageView;
     m_rc[slot].bufferView  = bufferView;
     m_rc[slot].bufferSlice = bufferView != nullptr
@@ -185,6 +247,9 @@ namespace dxvk {
   void DxvkContext::bindResourceSampler(
           uint32_t              slot,
     const Rc<DxvkSampler>&      sampler) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindResourceSampler, slot, sampler);
+
     m_rc[slot].sampler = sampler;
     m_rcTracked.clr(slot);
 
@@ -197,6 +262,9 @@ namespace dxvk {
   void DxvkContext::bindShader(
           VkShaderStageFlagBits stage,
     const Rc<DxvkShader>&       shader) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindShader, stage, shader);
+
     Rc<DxvkShader>* shaderStage;
     
     switch (stage) {
@@ -229,6 +297,9 @@ namespace dxvk {
           uint32_t              binding,
     const DxvkBufferSlice&      buffer,
           uint32_t              stride) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindVertexBuffer, binding, buffer, stride);
+
     if (!m_state.vi.vertexBuffers[binding].matchesBuffer(buffer))
       m_vbTracked.clr(binding);
 
@@ -250,6 +321,9 @@ namespace dxvk {
           uint32_t              binding,
     const DxvkBufferSlice&      buffer,
     const DxvkBufferSlice&      counter) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BindXfbBuffer, binding, buffer, counter);
+
     if (!m_state.xfb.buffers [binding].matches(buffer)
      || !m_state.xfb.counters[binding].matches(counter)) {
       m_state.xfb.buffers [binding] = buffer;
@@ -267,6 +341,9 @@ namespace dxvk {
     const VkComponentMapping&   srcMapping,
     const VkImageBlit&          region,
           VkFilter              filter) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::BlitImage, dstImage, dstMapping, srcImage, srcMapping, region, filter);
+
     this->spillRenderPass();
 
     auto mapping = util::resolveSrcComponentMapping(dstMapping, srcMapping);
@@ -296,6 +373,9 @@ namespace dxvk {
   void DxvkContext::changeImageLayout(
     const Rc<DxvkImage>&        image,
           VkImageLayout         layout) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ChangeImageLayout, image, layout);
+
     if (image->info().layout != layout) {
       this->spillRenderPass();
 
@@ -326,6 +406,9 @@ namespace dxvk {
           VkDeviceSize          offset,
           VkDeviceSize          length,
           uint32_t              value) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearBuffer, buffer, offset, length, value);
+
     this->spillRenderPass();
     
     length = align(length, sizeof(uint32_t));
@@ -355,6 +438,9 @@ namespace dxvk {
           VkDeviceSize          offset,
           VkDeviceSize          length,
           VkClearColorValue     value) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearBufferView, bufferView, offset, length, value);
+
     this->spillRenderPass();
     this->unbindComputePipeline();
 
@@ -429,6 +515,9 @@ namespace dxvk {
     const Rc<DxvkImage>&            image,
     const VkClearColorValue&        value,
     const VkImageSubresourceRange&  subresources) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearColorImage, image, value, subresources);
+
     this->spillRenderPass();
 
     VkImageLayout imageLayoutClear = image->pickLayout(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
@@ -459,6 +548,9 @@ namespace dxvk {
     const Rc<DxvkImage>&            image,
     const VkClearDepthStencilValue& value,
     const VkImageSubresourceRange&  subresources) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearDepthStencilImage, image, value, subresources);
+
     this->spillRenderPass();
     
     m_execBarriers.recordCommands(m_cmd);
@@ -491,6 +583,9 @@ namespace dxvk {
   void DxvkContext::clearCompressedColorImage(
     const Rc<DxvkImage>&            image,
     const VkImageSubresourceRange&  subresources) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearCompressedColorImage, image, subresources);
+
     this->spillRenderPass();
 
     // Allocate enough staging buffer memory to fit one
@@ -546,6 +641,9 @@ namespace dxvk {
     const Rc<DxvkImageView>&    imageView,
           VkImageAspectFlags    clearAspects,
           VkClearValue          clearValue) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearRenderTarget, imageView, clearAspects, clearValue);
+
     // Make sure the color components are ordered correctly
     if (clearAspects & VK_IMAGE_ASPECT_COLOR_BIT) {
       clearValue.color = util::swizzleClearColor(clearValue.color,
@@ -578,6 +676,9 @@ namespace dxvk {
           VkExtent3D            extent,
           VkImageAspectFlags    aspect,
           VkClearValue          value) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ClearImageView, imageView, offset, extent, aspect, value);
+
     const VkImageUsageFlags viewUsage = imageView->info().usage;
 
     if (aspect & VK_IMAGE_ASPECT_COLOR_BIT) {
@@ -598,6 +699,9 @@ namespace dxvk {
     const Rc<DxvkBuffer>&       srcBuffer,
           VkDeviceSize          srcOffset,
           VkDeviceSize          numBytes) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyBuffer, dstBuffer, dstOffset, srcBuffer, srcOffset, numBytes);
+
     if (numBytes == 0)
       return;
     
@@ -640,6 +744,9 @@ namespace dxvk {
           VkDeviceSize          dstOffset,
           VkDeviceSize          srcOffset,
           VkDeviceSize          numBytes) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyBufferRegion, dstBuffer, dstOffset, srcOffset, numBytes);
+
     VkDeviceSize loOvl = std::max(dstOffset, srcOffset);
     VkDeviceSize hiOvl = std::min(dstOffset, srcOffset) + numBytes;
 
@@ -673,6 +780,9 @@ namespace dxvk {
     const Rc<DxvkBuffer>&       srcBuffer,
           VkDeviceSize          srcOffset,
           VkExtent2D            srcExtent) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyBufferToImage, dstImage, dstSubresource, dstOffset, dstExtent, srcBuffer, srcOffset, srcExtent);
+
     this->spillRenderPass();
 
     auto srcSlice = srcBuffer->getSliceHandle(srcOffset, 0);
@@ -747,6 +857,9 @@ namespace dxvk {
           VkImageSubresourceLayers srcSubresource,
           VkOffset3D            srcOffset,
           VkExtent3D            extent) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyImage, dstImage, dstSubresource, dstOffset, srcImage, srcSubresource, srcOffset, extent);
+
     this->spillRenderPass();
 
     bool useFb = dstSubresource.aspectMask != srcSubresource.aspectMask;
@@ -777,6 +890,9 @@ namespace dxvk {
           VkOffset3D            dstOffset,
           VkOffset3D            srcOffset,
           VkExtent3D            extent) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyImageRegion, dstImage, dstSubresource, dstOffset, srcOffset, extent);
+
     VkOffset3D loOvl = {
       std::max(dstOffset.x, srcOffset.x),
       std::max(dstOffset.y, srcOffset.y),
@@ -845,6 +961,9 @@ namespace dxvk {
           VkImageSubresourceLayers srcSubresource,
           VkOffset3D            srcOffset,
           VkExtent3D            srcExtent) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyImageToBuffer, dstBuffer, dstOffset, dstExtent, srcImage, srcSubresource, srcOffset, srcExtent);
+
     this->spillRenderPass();
     
     auto dstSlice = dstBuffer->getSliceHandle(dstOffset, 0);
@@ -913,6 +1032,9 @@ namespace dxvk {
           VkOffset2D            srcOffset,
           VkExtent2D            srcExtent,
           VkFormat              format) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyDepthStencilImageToPackedBuffer, dstBuffer, dstOffset, srcImage, srcSubresource, srcOffset, srcExtent, format);
+
     this->spillRenderPass();
     this->unbindComputePipeline();
 
@@ -1024,6 +1146,9 @@ namespace dxvk {
     const Rc<DxvkBuffer>&       srcBuffer,
           VkDeviceSize          srcOffset,
           VkFormat              format) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::CopyPackedBufferToDepthStencilImage, dstImage, dstSubresource, dstOffset, dstExtent, srcBuffer, srcOffset, format);
+
     this->spillRenderPass();
     this->unbindComputePipeline();
 
@@ -1201,6 +1326,9 @@ namespace dxvk {
   void DxvkContext::discardImage(
     const Rc<DxvkImage>&          image,
           VkImageSubresourceRange subresources) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DiscardImage, image, subresources);
+
     this->spillRenderPass();
 
     if (m_execBarriers.isImageDirty(image, subresources, DxvkAccess::Write))
@@ -1221,6 +1349,9 @@ namespace dxvk {
           uint32_t x,
           uint32_t y,
           uint32_t z) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::Dispatch, x, y, z);
+
     if (this->commitComputeState()) {
       this->commitComputeInitBarriers();
 
@@ -1241,6 +1372,9 @@ namespace dxvk {
   
   void DxvkContext::dispatchIndirect(
           VkDeviceSize      offset) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DispatchIndirect, offset);
+
     auto bufferSlice = m_state.id.argBuffer.getSliceHandle(
       offset, sizeof(VkDispatchIndirectCommand));
 
@@ -1280,6 +1414,9 @@ namespace dxvk {
           uint32_t instanceCount,
           uint32_t firstVertex,
           uint32_t firstInstance) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::Draw, vertexCount, instanceCount, firstVertex, firstInstance);
+
     if (this->commitGraphicsState<false, false>()) {
       m_cmd->cmdDraw(
         vertexCount, instanceCount,
@@ -1294,6 +1431,9 @@ namespace dxvk {
           VkDeviceSize      offset,
           uint32_t          count,
           uint32_t          stride) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DrawIndirect, offset, count, stride);
+
     if (this->commitGraphicsState<false, true>()) {
       auto descriptor = m_state.id.argBuffer.getDescriptor();
       
@@ -1312,6 +1452,9 @@ namespace dxvk {
           VkDeviceSize      countOffset,
           uint32_t          maxCount,
           uint32_t          stride) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DrawIndirectCount, offset, countOffset, maxCount, stride);
+
     if (this->commitGraphicsState<false, true>()) {
       auto argDescriptor = m_state.id.argBuffer.getDescriptor();
       auto cntDescriptor = m_state.id.cntBuffer.getDescriptor();
@@ -1334,6 +1477,9 @@ namespace dxvk {
           uint32_t firstIndex,
           uint32_t vertexOffset,
           uint32_t firstInstance) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DrawIndexed, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+
     if (this->commitGraphicsState<true, false>()) {
       m_cmd->cmdDrawIndexed(
         indexCount, instanceCount,
@@ -1349,6 +1495,9 @@ namespace dxvk {
           VkDeviceSize      offset,
           uint32_t          count,
           uint32_t          stride) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DrawIndexedIndirect, offset, count, stride);
+
     if (this->commitGraphicsState<true, true>()) {
       auto descriptor = m_state.id.argBuffer.getDescriptor();
       
@@ -1367,6 +1516,9 @@ namespace dxvk {
           VkDeviceSize      countOffset,
           uint32_t          maxCount,
           uint32_t          stride) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DrawIndexedIndirectCount, offset, countOffset, maxCount, stride);
+
     if (this->commitGraphicsState<true, true>()) {
       auto argDescriptor = m_state.id.argBuffer.getDescriptor();
       auto cntDescriptor = m_state.id.cntBuffer.getDescriptor();
@@ -1387,6 +1539,9 @@ namespace dxvk {
     const DxvkBufferSlice&  counterBuffer,
           uint32_t          counterDivisor,
           uint32_t          counterBias) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::DrawIndirectXfb, counterBuffer, counterDivisor, counterBias);
+
     if (this->commitGraphicsState<false, false>()) {
       auto physSlice = counterBuffer.getSliceHandle();
 
@@ -1416,6 +1571,9 @@ namespace dxvk {
     const Rc<DxvkImage>&           image,
     const VkImageSubresourceRange& subresources,
           VkImageLayout            initialLayout) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::InitImage, image, subresources, initialLayout);
+
     m_execBarriers.accessImage(image, subresources,
       initialLayout, 0, 0,
       image->info().layout,
@@ -1431,6 +1589,9 @@ namespace dxvk {
   void DxvkContext::generateMipmaps(
     const Rc<DxvkImageView>&        imageView,
           VkFilter                  filter) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::GenerateMipmaps, imageView, filter);
+
     if (imageView->info().numLevels <= 1)
       return;
     
@@ -1533,6 +1694,18 @@ namespace dxvk {
   
   
   void DxvkContext::invalidateBuffer(
+    const Rc<DxvkBuffer>&           buffer,
+    const DxvkBufferSliceHandle&    slice) {
+    if (unlikely(m_capture != nullptr)) {
+      m_capture->record(m_captureId, DxvkCsCaptureOp::InvalidateBuffer, buffer,
+        DxvkCsCaptureData { slice.mapPtr, slice.mapPtr ? size_t(slice.length) : size_t(0) });
+    }
+
+    this->invalidateBufferSlice(buffer, slice);
+  }
+
+
+  void DxvkContext::invalidateBufferSlice(
     const Rc<DxvkBuffer>&           buffer,
     const DxvkBufferSliceHandle&    slice) {
     // Allocate new backing resource
@@ -1582,6 +1755,9 @@ namespace dxvk {
           uint32_t                  offset,
           uint32_t                  size,
     const void*                     data) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::PushConstants, offset, DxvkCsCaptureData { data, size });
+
     std::memcpy(&m_state.pc.data[offset], data, size);
 
     m_flags.set(DxvkContextFlag::DirtyPushConstants);
@@ -1593,6 +1769,9 @@ namespace dxvk {
     const Rc<DxvkImage>&            srcImage,
     const VkImageResolve&           region,
           VkFormat                  format) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ResolveImage, dstImage, srcImage, region, format);
+
     this->spillRenderPass();
     
     if (format == VK_FORMAT_UNDEFINED)
@@ -1624,6 +1803,9 @@ namespace dxvk {
     const VkImageResolve&           region,
           VkResolveModeFlagBitsKHR  depthMode,
           VkResolveModeFlagBitsKHR  stencilMode) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::ResolveDepthStencilImage, dstImage, srcImage, region, depthMode, stencilMode);
+
     this->spillRenderPass();
 
     // Technically legal, but no-op
@@ -1676,6 +1858,9 @@ namespace dxvk {
     const VkImageSubresourceRange&  dstSubresources,
           VkImageLayout             srcLayout,
           VkImageLayout             dstLayout) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::TransformImage, dstImage, dstSubresources, srcLayout, dstLayout);
+
     this->spillRenderPass();
     
     if (srcLayout != dstLayout) {
@@ -1843,6 +2028,9 @@ namespace dxvk {
           VkDeviceSize              offset,
           VkDeviceSize              size,
     const void*                     data) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::UpdateBuffer, buffer, offset, DxvkCsCaptureData { data, size });
+
     bool replaceBuffer = (size == buffer->info().size)
                       && (size <= (1 << 20)); /* 1 MB */
     
@@ -1861,7 +2049,7 @@ namespace dxvk {
       bufferSlice = buffer->allocSlice();
       cmdBuffer   = DxvkCmdBuffer::InitBuffer;
 
-      this->invalidateBuffer(buffer, bufferSlice);
+      this->invalidateBufferSlice(buffer, bufferSlice);
     } else {
       this->spillRenderPass();
     
@@ -1924,6 +2112,11 @@ namespace dxvk {
     const void*                     data,
           VkDeviceSize              pitchPerRow,
           VkDeviceSize              pitchPerLayer) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::UpdateImage, image, subresources, imageOffset, imageExtent,
+        DxvkCsCaptureImageData { image->formatInfo(), imageExtent,
+          subresources.layerCount, data, pitchPerRow, pitchPerLayer });
+
     this->spillRenderPass();
     
     // Upload data through a staging buffer. Special care needs to
@@ -2013,6 +2206,11 @@ namespace dxvk {
           VkDeviceSize              pitchPerRow,
           VkDeviceSize              pitchPerLayer,
           VkFormat                  format) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::UpdateDepthStencilImage, image, subresources, imageOffset, imageExtent,
+        DxvkCsCaptureImageData { imageFormatInfo(format), VkExtent3D { imageExtent.width, imageExtent.height, 1u },
+          subresources.layerCount, data, pitchPerRow, pitchPerLayer }, format);
+
     auto formatInfo = imageFormatInfo(format);
     
     VkExtent3D extent3D;
@@ -2045,6 +2243,9 @@ namespace dxvk {
   void DxvkContext::uploadBuffer(
     const Rc<DxvkBuffer>&           buffer,
     const void*                     data) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::UploadBuffer, buffer, DxvkCsCaptureData { data, buffer->info().size });
+
     auto bufferSlice = buffer->getSliceHandle();
 
     auto stagingSlice = m_staging.alloc(CACHE_LINE_SIZE, bufferSlice.length);
@@ -2079,6 +2280,12 @@ namespace dxvk {
     const void*                     data,
           VkDeviceSize              pitchPerRow,
           VkDeviceSize              pitchPerLayer) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::UploadImage, image, subresources,
+        DxvkCsCaptureImageData { image->formatInfo(),
+          image->mipLevelExtent(subresources.mipLevel),
+          subresources.layerCount, data, pitchPerRow, pitchPerLayer });
+
     const DxvkFormatInfo* formatInfo = image->formatInfo();
 
     VkOffset3D imageOffset = { 0, 0, 0 };
@@ -2142,6 +2349,11 @@ namespace dxvk {
           uint32_t            viewportCount,
     const VkViewport*         viewports,
     const VkRect2D*           scissorRects) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetViewports, viewportCount,
+        DxvkCsCaptureData { viewports,    viewportCount * sizeof(*viewports) },
+        DxvkCsCaptureData { scissorRects, viewportCount * sizeof(*scissorRects) });
+
     if (m_state.gp.state.rs.viewportCount() != viewportCount) {
       m_state.gp.state.rs.setViewportCount(viewportCount);
       m_flags.set(DxvkContextFlag::GpDirtyPipelineState);
@@ -2169,6 +2381,9 @@ namespace dxvk {
   
   void DxvkContext::setBlendConstants(
           DxvkBlendConstants  blendConstants) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetBlendConstants, blendConstants);
+
     if (m_state.dyn.blendConstants != blendConstants) {
       m_state.dyn.blendConstants = blendConstants;
       m_flags.set(DxvkContextFlag::GpDirtyBlendConstants);
@@ -2178,6 +2393,9 @@ namespace dxvk {
   
   void DxvkContext::setDepthBias(
           DxvkDepthBias       depthBias) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetDepthBias, depthBias);
+
     if (m_state.dyn.depthBias != depthBias) {
       m_state.dyn.depthBias = depthBias;
       m_flags.set(DxvkContextFlag::GpDirtyDepthBias);
@@ -2187,6 +2405,9 @@ namespace dxvk {
 
   void DxvkContext::setDepthBounds(
           DxvkDepthBounds     depthBounds) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetDepthBounds, depthBounds);
+
     if (m_state.dyn.depthBounds != depthBounds) {
       m_state.dyn.depthBounds = depthBounds;
       m_flags.set(DxvkContextFlag::GpDirtyDepthBounds);
@@ -2201,6 +2422,9 @@ namespace dxvk {
   
   void DxvkContext::setStencilReference(
           uint32_t            reference) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetStencilReference, reference);
+
     if (m_state.dyn.stencilReference != reference) {
       m_state.dyn.stencilReference = reference;
       m_flags.set(DxvkContextFlag::GpDirtyStencilRef);
@@ -2209,6 +2433,9 @@ namespace dxvk {
   
   
   void DxvkContext::setInputAssemblyState(const DxvkInputAssemblyState& ia) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetInputAssemblyState, ia);
+
     m_state.gp.state.ia = DxvkIaInfo(
       ia.primitiveTopology,
       ia.primitiveRestart,
@@ -2223,6 +2450,11 @@ namespace dxvk {
     const DxvkVertexAttribute* attributes,
           uint32_t             bindingCount,
     const DxvkVertexBinding*   bindings) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetInputLayout, attributeCount,
+        DxvkCsCaptureData { attributes, attributeCount * sizeof(*attributes) }, bindingCount,
+        DxvkCsCaptureData { bindings,   bindingCount   * sizeof(*bindings) });
+
     m_flags.set(
       DxvkContextFlag::GpDirtyPipelineState,
       DxvkContextFlag::GpDirtyVertexBuffers);
@@ -2250,6 +2482,9 @@ namespace dxvk {
   
   
   void DxvkContext::setRasterizerState(const DxvkRasterizerState& rs) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetRasterizerState, rs);
+
     m_state.gp.state.rs = DxvkRsInfo(
       rs.depthClipEnable,
       rs.depthBiasEnable,
@@ -2264,6 +2499,9 @@ namespace dxvk {
   
   
   void DxvkContext::setMultisampleState(const DxvkMultisampleState& ms) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetMultisampleState, ms);
+
     m_state.gp.state.ms = DxvkMsInfo(
       m_state.gp.state.ms.sampleCount(),
       ms.sampleMask,
@@ -2274,6 +2512,9 @@ namespace dxvk {
   
   
   void DxvkContext::setDepthStencilState(const DxvkDepthStencilState& ds) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetDepthStencilState, ds);
+
     m_state.gp.state.ds = DxvkDsInfo(
       ds.enableDepthTest,
       ds.enableDepthWrite,
@@ -2289,6 +2530,9 @@ namespace dxvk {
   
   
   void DxvkContext::setLogicOpState(const DxvkLogicOpState& lo) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetLogicOpState, lo);
+
     m_state.gp.state.om = DxvkOmInfo(
       lo.enableLogicOp,
       lo.logicOp);
@@ -2300,6 +2544,9 @@ namespace dxvk {
   void DxvkContext::setBlendMode(
           uint32_t            attachment,
     const DxvkBlendMode&      blendMode) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetBlendMode, attachment, blendMode);
+
     m_state.gp.state.omBlend[attachment] = DxvkOmAttachmentBlend(
       blendMode.enableBlending,
       blendMode.colorSrcFactor,
@@ -2318,6 +2565,9 @@ namespace dxvk {
           VkPipelineBindPoint pipeline,
           uint32_t            index,
           uint32_t            value) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetSpecConstant, pipeline, index, value);
+
     auto& specConst = pipeline == VK_PIPELINE_BIND_POINT_GRAPHICS
       ? m_state.gp.state.sc.specConstants[index]
       : m_state.cp.state.sc.specConstants[index];
@@ -2335,6 +2585,9 @@ namespace dxvk {
   void DxvkContext::setPredicate(
     const DxvkBufferSlice&    predicate,
           VkConditionalRenderingFlagsEXT flags) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetPredicate, predicate, flags);
+
     if (!m_state.cond.predicate.matches(predicate)) {
       m_state.cond.predicate = predicate;
 
@@ -2355,11 +2608,17 @@ namespace dxvk {
 
 
   void DxvkContext::setBarrierControl(DxvkBarrierControlFlags control) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->record(m_captureId, DxvkCsCaptureOp::SetBarrierControl, control);
+
     m_barrierControl = control;
   }
   
   
   void DxvkContext::signalGpuEvent(const Rc<DxvkGpuEvent>& event) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->recordUnsupported(m_captureId, "signalGpuEvent");
+
     this->spillRenderPass();
     
     DxvkGpuEventHandle handle = m_common->eventPool().allocEvent();
@@ -2375,6 +2634,9 @@ namespace dxvk {
   void DxvkContext::writePredicate(
     const DxvkBufferSlice&    predicate,
     const Rc<DxvkGpuQuery>&   query) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->recordUnsupported(m_captureId, "writePredicate");
+
     DxvkBufferSliceHandle predicateHandle = predicate.getSliceHandle();
     DxvkGpuQueryHandle    queryHandle     = query->handle();
 
@@ -2388,6 +2650,9 @@ namespace dxvk {
 
 
   void DxvkContext::writeTimestamp(const Rc<DxvkGpuQuery>& query) {
+    if (unlikely(m_capture != nullptr))
+      m_capture->recordUnsupported(m_captureId, "writeTimestamp");
+
     m_queryManager.writeTimestamp(m_cmd, query);
   }
 
@@ -3773,11 +4038,22 @@ namespace dxvk {
       ? DxvkContextFlag::GpDynamicStencilRef
       : DxvkContextFlag::GpDirtyStencilRef);
     
-    // Retrieve and bind actual Vulkan pipeline handle
-    m_gpActivePipeline = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state, m_state.om.framebuffer->getRenderPass());
+    // Retrieve and bind actual Vulkan pipeline handle. Draws
+    // must not be skipped while queries observe their results.
+    bool async = m_device->config().asyncPipelineCompile
+      && !m_queryManager.hasEnabledQueries(VK_QUERY_TYPE_OCCLUSION)
+      && !m_queryManager.hasEnabledQueries(VK_QUERY_TYPE_PIPELINE_STATISTICS);
+
+    bool pending = false;
 
-    if (unlikely(!m_gpActivePipeline))
+    m_gpActivePipeline = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state,
+      m_state.om.framebuffer->getRenderPass(), async, pending);
+
+    if (unlikely(!m_gpActivePipeline)) {
+      if (pending)
+        m_cmd->addStatCtr(DxvkStatCounter::CmdDrawsDeferred, 1);
       return false;
+    }
 
     m_cmd->cmdBindPipeline(
       VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -4,6 +4,7 @@
 #include "dxvk_bind_mask.h"
 #include "dxvk_cmdlist.h"
 #include "dxvk_context_state.h"
+#include "dxvk_cs_capture.h"
 #include "dxvk_data.h"
 #include "dxvk_objects.h"
 #include "dxvk_util.h"
@@ -56,6 +57,19 @@ namespace dxvk {
      */
     void flushCommandList();
     
+    /**
+     * \brief Enables buffer relocation
+     *
+     * Allows the context to move buffers to different
+     * memory locations when flushing the command list.
+     * Must only be enabled on the context that executes
+     * the CS thread's commands, since other contexts may
+     * run concurrently on other threads.
+     */
+    void enableBufferRelocation() {
+      m_relocateBuffers = true;
+    }
+
     /**
      * \brief Begins generating query data
      * \param [in] query The query to end
@@ -1000,6 +1014,22 @@ namespace dxvk {
       const Rc<sync::Signal>&   signal,
             uint64_t            value);
     
+    /**
+     * \brief Adds to a stat counter
+     * 
+     * Used to report statistics that are gathered
+     * outside of the context itself, e.g. by the
+     * command stream. Ignored if not recording.
+     * \param [in] counter The counter
+     * \param [in] value Value to add
+     */
+    void addStatCtr(
+            DxvkStatCounter     counter,
+            uint32_t            value) {
+      if (m_cmd != nullptr)
+        m_cmd->addStatCtr(counter, value);
+    }
+    
     /**
      * \brief Trims staging buffers
      * 
@@ -1032,6 +1062,11 @@ namespace dxvk {
     
     DxvkGpuQueryManager     m_queryManager;
     DxvkStagingDataAlloc    m_staging;
+
+    DxvkCsCaptureWriter*    m_capture   = nullptr;
+    uint16_t                m_captureId = 0;
+
+    bool                    m_relocateBuffers = false;
     
     VkPipeline m_gpActivePipeline = VK_NULL_HANDLE;
     VkPipeline m_cpActivePipeline = VK_NULL_HANDLE;
@@ -1137,6 +1172,12 @@ namespace dxvk {
     
     void commitPredicateUpdates();
     
+    void relocateBuffers();
+
+    void invalidateBufferSlice(
+      const Rc<DxvkBuffer>&           buffer,
+      const DxvkBufferSliceHandle&    slice);
+
     void startRenderPass();
     void spillRenderPass(bool flushClears = true);
     
@@ -17,6 +17,62 @@ namespace dxvk {
   }
 
 
+  void DxvkCsChunk::eliminateRedundantState() {
+    if (!m_stateCmds || m_stateEliminated)
+      return;
+
+    m_stateEliminated = true;
+
+    // Maps state keys to the last command that set the given
+    // state. Entries from older generations count as empty, so
+    // that the table can be cleared in constant time whenever
+    // we encounter a command that is not a state command.
+    struct Entry {
+      uint32_t    key;
+      uint32_t    gen;
+      DxvkCsCmd*  cmd;
+    };
+
+    constexpr uint32_t TableSize = 256;
+
+    std::array<Entry, TableSize> table = { };
+    uint32_t gen  = 1;
+    uint32_t used = 0;
+
+    for (auto cmd = m_head; cmd != nullptr; cmd = cmd->next()) {
+      uint32_t key = cmd->stateKey();
+
+      // Keep the table sparse so that probe sequences stay short.
+      // Starting over only means that we may drop fewer commands.
+      if (!key || used == TableSize / 2) {
+        gen += used ? 1 : 0;
+        used = 0;
+
+        if (!key)
+          continue;
+      }
+
+      uint32_t index = (key * 0x9E3779B1u) >> 24;
+
+      while (table[index].gen == gen && table[index].key != key)
+        index = (index + 1) % TableSize;
+
+      Entry& entry = table[index];
+
+      if (entry.gen == gen) {
+        entry.cmd->setSkipped();
+        m_stateCmdsSkipped += 1;
+      } else {
+        entry.key = key;
+        entry.gen = gen;
+        used += 1;
+      }
+
+      entry.cmd = cmd;
+    }
+  }
+
+
   void DxvkCsChunk::executeAll(DxvkContext* ctx) {
     auto cmd = m_head;
     
@@ -25,7 +81,10 @@ namespace dxvk {
       
       while (cmd != nullptr) {
         auto next = cmd->next();
-        cmd->exec(ctx);
+
+        if (likely(!cmd->skipped()))
+          cmd->exec(ctx);
+
         cmd->~DxvkCsCmd();
         cmd = next;
       }
@@ -34,10 +93,20 @@ namespace dxvk {
       m_tail = nullptr;
     } else {
       while (cmd != nullptr) {
-        cmd->exec(ctx);
+        if (likely(!cmd->skipped()))
+          cmd->exec(ctx);
+
         cmd = cmd->next();
       }
     }
+
+    if (m_stateCmds) {
+      ctx->addStatCtr(DxvkStatCounter::CsStateCmdCount,   m_stateCmds);
+      ctx->addStatCtr(DxvkStatCounter::CsStateCmdSkipped, m_stateCmdsSkipped);
+
+      if (m_flags.test(DxvkCsChunkFlag::SingleUse))
+        this->resetStateCounters();
+    }
   }
   
   
@@ -54,6 +123,15 @@ namespace dxvk {
     m_tail = nullptr;
 
     m_commandOffset = 0;
+
+    this->resetStateCounters();
+  }
+
+
+  void DxvkCsChunk::resetStateCounters() {
+    m_stateCmds        = 0;
+    m_stateCmdsSkipped = 0;
+    m_stateEliminated  = false;
   }
   
   
@@ -96,36 +174,63 @@ namespace dxvk {
   
   
   DxvkCsThread::DxvkCsThread(const Rc<DxvkContext>& context)
-  : m_context(context), m_thread([this] { threadFunc(); }) {
-    
+  : m_context   (context),
+    // Spinning only takes time away from the other
+    // thread if both have to share a single core
+    m_spinCount (dxvk::thread::hardware_concurrency() > 1 ? SpinCount : 0),
+    m_thread    ([this] { threadFunc(); }) {
+    // Other contexts may record commands on other threads
+    // at any time, so only this one may move buffers. The
+    // thread cannot execute any chunks before this returns.
+    m_context->enableBufferRelocation();
   }
   
   
   DxvkCsThread::~DxvkCsThread() {
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      m_stopped.store(true);
-    }
-    
-    m_condOnAdd.notify_one();
+    m_stopped.store(true);
+
+    notify(m_waitOnAdd, m_condOnAdd);
     m_thread.join();
   }
   
   
-  void DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      m_chunksQueued.push(std::move(chunk));
-      m_chunksPending += 1;
+  uint64_t DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
+    // Drop redundant state commands on the calling thread
+    // so that the worker thread does not have to run them
+    chunk->eliminateRedundantState();
+
+    // Bump the counter first so that the number of
+    // executed chunks never exceeds this value
+    uint64_t seq = m_chunksDispatched.load(std::memory_order_relaxed) + 1;
+    m_chunksDispatched.store(seq, std::memory_order_release);
+
+    if (unlikely(!m_chunksQueued.tryPush(std::move(chunk)))) {
+      wait(m_waitOnPop, m_condOnPop, [this] {
+        return !m_chunksQueued.full();
+      });
+
+      m_chunksQueued.tryPush(std::move(chunk));
     }
     
-    m_condOnAdd.notify_one();
+    // The worker drains the entire queue once it wakes
+    // up, so only wake it up if it actually went to sleep
+    notify(m_waitOnAdd, m_condOnAdd);
+    return seq;
   }
   
   
-  void DxvkCsThread::synchronize() {
-    std::unique_lock<std::mutex> lock(m_mutex);
+  void DxvkCsThread::synchronize(uint64_t seq) {
+    // Avoid waiting if the chunk in question
+    // has already been executed, which is common
+    if (seq <= m_chunksExecuted.load(std::memory_order_acquire))
+      return;
+
+    // Never wait for chunks that have not been dispatched
+    // yet, this also handles the SynchronizeAll case
+    seq = std::min(seq, m_chunksDispatched.load(std::memory_order_relaxed));
     
-    m_condOnSync.wait(lock, [this] {
-      return !m_chunksPending.load();
+    wait(m_waitOnSync, m_condOnSync, [this, seq] {
+      return m_chunksExecuted.load(std::memory_order_acquire) >= seq;
     });
   }
   
@@ -135,31 +240,65 @@ namespace dxvk {
 
     DxvkCsChunkRef chunk;
     
-    while (!m_stopped.load()) {
-      { std::unique_lock<std::mutex> lock(m_mutex);
-        if (chunk) {
-          if (--m_chunksPending == 0)
-            m_condOnSync.notify_one();
-          
-          chunk = DxvkCsChunkRef();
-        }
-        
-        if (m_chunksQueued.size() == 0) {
-          m_condOnAdd.wait(lock, [this] {
-            return (m_chunksQueued.size() != 0)
-                || (m_stopped.load());
-          });
-        }
-        
-        if (m_chunksQueued.size() != 0) {
-          chunk = std::move(m_chunksQueued.front());
-          m_chunksQueued.pop();
-        }
-      }
-      
-      if (chunk)
+    while (true) {
+      wait(m_waitOnAdd, m_condOnAdd, [this] {
+        return !m_chunksQueued.empty()
+            || m_stopped.load(std::memory_order_acquire);
+      });
+
+      while (m_chunksQueued.tryPop(chunk)) {
+        notify(m_waitOnPop, m_condOnPop);
+
         chunk->executeAll(m_context.ptr());
+        chunk = DxvkCsChunkRef();
+
+        m_chunksExecuted.store(m_chunksExecuted.load(
+          std::memory_order_relaxed) + 1, std::memory_order_release);
+        notify(m_waitOnSync, m_condOnSync);
+      }
+
+      if (m_stopped.load())
+        break;
+    }
+  }
+
+
+  template<typename Pred>
+  void DxvkCsThread::wait(
+          std::atomic<uint32_t>&    waiting,
+          std::condition_variable&  cond,
+    const Pred&                     pred) {
+    for (uint32_t i = 0; i < m_spinCount; i++) {
+      if (pred())
+        return;
+
+      _mm_pause();
+    }
+
+    // Register as a waiter before checking the condition one
+    // last time, so that either we see the other thread's
+    // update, or the other thread sees the counter and wakes
+    // us up. The lock prevents the wakeup from getting lost.
+    // Multiple threads may wait on the same condition, e.g.
+    // when synchronizing, so this needs to be a counter.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    waiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    cond.wait(lock, pred);
+    waiting.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+
+  void DxvkCsThread::notify(
+          std::atomic<uint32_t>&    waiting,
+          std::condition_variable&  cond) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (unlikely(waiting.load(std::memory_order_relaxed))) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      cond.notify_all();
     }
   }
   
-}
\ No newline at end of file
+}
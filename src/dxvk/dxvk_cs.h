@@ -3,13 +3,63 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <queue>
 
 #include "../util/thread.h"
+
+#include "../util/sync/sync_ring.h"
+
 #include "dxvk_context.h"
 
 namespace dxvk {
   
+  /**
+   * \brief State command type
+   * 
+   * Identifies the kind of context state that
+   * a state command sets, see \ref DxvkCsStateKey.
+   */
+  enum class DxvkCsState : uint32_t {
+    None = 0,
+    InputLayout,
+    InputAssembly,
+    VertexBuffer,
+    IndexBuffer,
+    Shader,
+    RenderTargets,
+    Viewports,
+    RasterizerState,
+    DepthBias,
+    DepthStencilState,
+    StencilReference,
+    BlendState,
+    BlendConstants,
+    MultisampleState,
+    SpecConstant,
+    ResourceBuffer,
+    ResourceView,
+    ResourceSampler,
+  };
+
+
+  /**
+   * \brief State command key
+   * 
+   * Identifies the piece of context state that a command
+   * sets, i.e. the state type and an index such as a
+   * binding slot. Commands with the same key must fully
+   * overwrite each other's effect and must not do anything
+   * else, so that all but the last one can be dropped if
+   * no other command is recorded in between.
+   */
+  struct DxvkCsStateKey {
+    DxvkCsStateKey() { }
+    DxvkCsStateKey(DxvkCsState type, uint32_t index = 0)
+    : value((uint32_t(type) << 24) | index) { }
+
+    uint32_t value = 0;
+  };
+
+
   /**
    * \brief Command stream operation
    * 
@@ -41,6 +91,38 @@ namespace dxvk {
       m_next = next;
     }
     
+    /**
+     * \brief Retrieves state key
+     * \returns Key of the state that the command sets,
+     *    or 0 if the command is not a state command
+     */
+    uint32_t stateKey() const {
+      return m_stateKey;
+    }
+
+    /**
+     * \brief Sets state key
+     * \param [in] key State key
+     */
+    void setStateKey(DxvkCsStateKey key) {
+      m_stateKey = key.value;
+    }
+
+    /**
+     * \brief Checks whether the command is skipped
+     * \returns \c true if the command is redundant
+     */
+    bool skipped() const {
+      return m_skipped;
+    }
+
+    /**
+     * \brief Marks command as redundant
+     */
+    void setSkipped() {
+      m_skipped = true;
+    }
+    
     /**
      * \brief Executes embedded commands
      * \param [in] ctx The target context
@@ -49,7 +131,9 @@ namespace dxvk {
     
   private:
     
-    DxvkCsCmd* m_next = nullptr;
+    DxvkCsCmd* m_next     = nullptr;
+    uint32_t   m_stateKey = 0;
+    bool       m_skipped  = false;
     
   };
   
@@ -157,11 +241,13 @@ namespace dxvk {
      * will be consumed. Otherwise, a new chunk must be
      * created which is large enough to hold the command.
      * \param [in] command The command to add
+     * \param [in] stateKey State key if the command only
+     *    sets context state, see \ref DxvkCsStateKey
      * \returns \c true on success, \c false if
      *          a new chunk needs to be allocated
      */
     template<typename T>
-    bool push(T& command) {
+    bool push(T& command, DxvkCsStateKey stateKey = DxvkCsStateKey()) {
       using FuncType = DxvkCsTypedCmd<T>;
       
       if (unlikely(m_commandOffset > MaxBlockSize - sizeof(FuncType)))
@@ -172,6 +258,11 @@ namespace dxvk {
       m_tail = new (m_data + m_commandOffset)
         FuncType(std::move(command));
       
+      if (stateKey.value) {
+        m_tail->setStateKey(stateKey);
+        m_stateCmds += 1;
+      }
+      
       if (likely(tail != nullptr))
         tail->setNext(m_tail);
       else
@@ -214,6 +305,18 @@ namespace dxvk {
      */
     void init(DxvkCsChunkFlags flags);
     
+    /**
+     * \brief Drops redundant state commands
+     * 
+     * Marks state commands as skipped if a command with
+     * the same state key follows before any command that
+     * is not a state command, i.e. before any command that
+     * may depend on the current state. Must be called
+     * before the chunk gets submitted for execution, and
+     * only has an effect the first time it is called.
+     */
+    void eliminateRedundantState();
+
     /**
      * \brief Executes all commands
      * 
@@ -240,9 +343,15 @@ namespace dxvk {
     DxvkCsCmd* m_tail = nullptr;
 
     DxvkCsChunkFlags m_flags;
+
+    uint32_t m_stateCmds        = 0;
+    uint32_t m_stateCmdsSkipped = 0;
+    bool     m_stateEliminated  = false;
     
     alignas(64)
     char m_data[MaxBlockSize];
+
+    void resetStateCounters();
     
   };
   
@@ -374,11 +483,21 @@ namespace dxvk {
    * \brief Command stream thread
    * 
    * Spawns a thread that will execute
-   * commands on a DXVK context. 
+   * commands on a DXVK context. Chunks are passed
+   * to the worker through a lock-free ring, so only
+   * one thread may dispatch chunks at any given time.
+   * Both sides spin for a short while before going to
+   * sleep, and only a sleeping thread gets notified.
    */
   class DxvkCsThread {
-    
+    /// Maximum number of chunks in flight
+    constexpr static size_t   QueueSize = 1024;
+    /// Number of probes before a waiting thread sleeps
+    constexpr static uint32_t SpinCount = 1000;
   public:
+
+    /// Sequence number that synchronizes with all chunks
+    constexpr static uint64_t SynchronizeAll = ~0ull;
     
     DxvkCsThread(const Rc<DxvkContext>& context);
     ~DxvkCsThread();
@@ -389,18 +508,21 @@ namespace dxvk {
      * Can be used to efficiently play back large
      * command lists recorded on another thread.
      * \param [in] chunk The chunk to dispatch
+     * \returns Sequence number of the chunk
      */
-    void dispatchChunk(DxvkCsChunkRef&& chunk);
+    uint64_t dispatchChunk(DxvkCsChunkRef&& chunk);
     
     /**
      * \brief Synchronizes with the thread
      * 
-     * This waits for all chunks in the dispatch
-     * queue to be processed by the thread. Note
-     * that this does \e not implicitly call
-     * \ref flush.
+     * This waits for all chunks up to and including
+     * the one with the given sequence number to be
+     * processed by the thread. Note that this does
+     * \e not implicitly call \ref flush.
+     * \param [in] seq Sequence number to wait for,
+     *    or \c SynchronizeAll to drain the queue
      */
-    void synchronize();
+    void synchronize(uint64_t seq);
     
     /**
      * \brief Checks whether the worker thread is busy
@@ -411,22 +533,40 @@ namespace dxvk {
      * \returns \c true if there is still work to do
      */
     bool isBusy() const {
-      return m_chunksPending.load() != 0;
+      return m_chunksDispatched.load() != m_chunksExecuted.load();
     }
     
   private:
     
     const Rc<DxvkContext>       m_context;
+    const uint32_t              m_spinCount;
     
     std::atomic<bool>           m_stopped = { false };
     std::mutex                  m_mutex;
     std::condition_variable     m_condOnAdd;
+    std::condition_variable     m_condOnPop;
     std::condition_variable     m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
-    std::atomic<uint32_t>       m_chunksPending = { 0u };
+    std::atomic<uint32_t>       m_waitOnAdd  = { 0u };
+    std::atomic<uint32_t>       m_waitOnPop  = { 0u };
+    std::atomic<uint32_t>       m_waitOnSync = { 0u };
+
+    sync::SpscRing<DxvkCsChunkRef, QueueSize> m_chunksQueued;
+
+    std::atomic<uint64_t>       m_chunksDispatched = { 0ull };
+    std::atomic<uint64_t>       m_chunksExecuted   = { 0ull };
     dxvk::thread                m_thread;
     
     void threadFunc();
+
+    template<typename Pred>
+    void wait(
+            std::atomic<uint32_t>&    waiting,
+            std::condition_variable&  cond,
+      const Pred&                     pred);
+
+    void notify(
+            std::atomic<uint32_t>&    waiting,
+            std::condition_variable&  cond);
     
   };
   
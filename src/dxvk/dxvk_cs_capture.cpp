@@ -0,0 +1,969 @@
+#include <cstring>
+
+#include "dxvk_cs_capture.h"
+#include "dxvk_device.h"
+
+namespace dxvk {
+
+  DxvkCsCaptureWriter::DxvkCsCaptureWriter(
+    const std::string&            fileName,
+          uint32_t                firstFrame,
+          uint32_t                lastFrame)
+  : m_stream(fileName, std::ios_base::binary | std::ios_base::trunc),
+    m_firstFrame(firstFrame), m_lastFrame(lastFrame) {
+    if (!m_stream) {
+      Logger::warn(str::format("DxvkCsCaptureWriter: Failed to open ", fileName));
+      return;
+    }
+
+    Logger::info(str::format("DxvkCsCaptureWriter: Capturing frames ",
+      firstFrame, "-", lastFrame, " to ", fileName));
+
+    DxvkCsCaptureHeader header = { };
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    this->updateActive();
+  }
+
+
+  DxvkCsCaptureWriter::~DxvkCsCaptureWriter() {
+
+  }
+
+
+  void DxvkCsCaptureWriter::endFrame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_active.load(std::memory_order_relaxed)) {
+      m_record.clear();
+      this->writeRecord(0, DxvkCsCaptureOp::EndFrame, m_record);
+
+      // Resources may keep the device alive indefinitely,
+      // so we cannot rely on the stream getting closed
+      m_stream.flush();
+    }
+
+    m_frameId += 1;
+    this->updateActive();
+  }
+
+
+  bool DxvkCsCaptureWriter::validateHeader(
+    const DxvkCsCaptureHeader&    header) {
+    return !std::memcmp(header.magic, Magic, sizeof(Magic))
+        && header.version == Version;
+  }
+
+
+  std::unique_ptr<DxvkCsCaptureWriter> DxvkCsCaptureWriter::create() {
+    std::string path = env::getEnvVar("DXVK_CS_CAPTURE");
+
+    if (path.empty())
+      return nullptr;
+
+    std::string frames = env::getEnvVar("DXVK_CS_CAPTURE_FRAMES");
+
+    uint32_t firstFrame = 0;
+    uint32_t lastFrame  = ~0u;
+
+    if (!frames.empty()) {
+      size_t dash = frames.find('-');
+
+      firstFrame = uint32_t(std::strtoul(frames.c_str(), nullptr, 10));
+      lastFrame  = dash != std::string::npos
+        ? uint32_t(std::strtoul(frames.c_str() + dash + 1, nullptr, 10))
+        : firstFrame;
+    }
+
+    return std::make_unique<DxvkCsCaptureWriter>(path, firstFrame, lastFrame);
+  }
+
+
+  void DxvkCsCaptureWriter::writeRecord(
+          uint16_t                contextId,
+          DxvkCsCaptureOp         op,
+    const std::vector<char>&      data) {
+    DxvkCsCaptureRecord record;
+    record.op         = op;
+    record.contextId  = contextId;
+    record.size       = uint32_t(data.size());
+
+    m_stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_stream.write(data.data(), data.size());
+  }
+
+
+  void DxvkCsCaptureWriter::updateActive() {
+    bool active = m_stream.is_open()
+      && m_frameId >= m_firstFrame
+      && m_frameId <= m_lastFrame;
+
+    if (!active && m_stream.is_open() && m_frameId > m_lastFrame) {
+      Logger::info(str::format("DxvkCsCaptureWriter: Captured ",
+        m_lastFrame - m_firstFrame + 1, " frames, ", m_nextObjectId - 1, " objects"));
+
+      m_stream.close();
+      m_objectIds.clear();
+      m_resources.clear();
+      m_shaders.clear();
+    }
+
+    m_active.store(active, std::memory_order_release);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const DxvkCsCaptureData& data) {
+    write(dst, uint64_t(data.size));
+
+    auto bytes = reinterpret_cast<const char*>(data.data);
+    dst.insert(dst.end(), bytes, bytes + data.size);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const DxvkCsCaptureImageData& data) {
+    VkExtent3D blockCount = util::computeBlockCount(
+      data.extent, data.formatInfo->blockSize);
+    blockCount.depth *= data.layerCount;
+
+    std::vector<char> packed(data.formatInfo->elementSize
+      * util::flattenImageExtent(blockCount));
+
+    util::packImageData(packed.data(), data.data,
+      blockCount, data.formatInfo->elementSize,
+      data.pitchPerRow, data.pitchPerLayer);
+
+    write(dst, DxvkCsCaptureData { packed.data(), packed.size() });
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const DxvkBufferSlice& slice) {
+    write(dst, slice.buffer());
+    write(dst, uint64_t(slice.offset()));
+    write(dst, uint64_t(slice.length()));
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const DxvkRenderTargets& targets) {
+    write(dst, targets.depth.view);
+    write(dst, targets.depth.layout);
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      write(dst, targets.color[i].view);
+      write(dst, targets.color[i].layout);
+    }
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const Rc<DxvkBuffer>& buffer) {
+    uint32_t id;
+
+    if (!lookupObject(buffer.ptr(), id)) {
+      bool hostVisible = buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+      // Store current contents of mapped buffers since
+      // the application may have written to them directly
+      std::vector<char> data;
+      write(data, id);
+      write(data, buffer->info());
+      write(data, buffer->memFlags());
+      write(data, DxvkCsCaptureData {
+        hostVisible ? buffer->mapPtr(0) : nullptr,
+        hostVisible ? size_t(buffer->info().size) : 0 });
+
+      this->writeRecord(0, DxvkCsCaptureOp::CreateBuffer, data);
+      m_resources.push_back(buffer.ptr());
+    }
+
+    write(dst, id);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const Rc<DxvkBufferView>& view) {
+    uint32_t id;
+
+    if (!lookupObject(view.ptr(), id)) {
+      std::vector<char> data;
+      write(data, id);
+      write(data, view->buffer());
+      write(data, view->info());
+
+      this->writeRecord(0, DxvkCsCaptureOp::CreateBufferView, data);
+      m_resources.push_back(view.ptr());
+    }
+
+    write(dst, id);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const Rc<DxvkImage>& image) {
+    uint32_t id;
+
+    if (!lookupObject(image.ptr(), id)) {
+      DxvkImageCreateInfo info = image->info();
+
+      DxvkCsCaptureData viewFormats = {
+        info.viewFormats, info.viewFormatCount * sizeof(VkFormat) };
+      info.viewFormats = nullptr;
+
+      std::vector<char> data;
+      write(data, id);
+      write(data, info);
+      write(data, image->memFlags());
+      write(data, viewFormats);
+
+      this->writeRecord(0, DxvkCsCaptureOp::CreateImage, data);
+      m_resources.push_back(image.ptr());
+    }
+
+    write(dst, id);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const Rc<DxvkImageView>& view) {
+    uint32_t id;
+
+    if (!lookupObject(view.ptr(), id)) {
+      std::vector<char> data;
+      write(data, id);
+      write(data, view->image());
+      write(data, view->info());
+
+      this->writeRecord(0, DxvkCsCaptureOp::CreateImageView, data);
+      m_resources.push_back(view.ptr());
+    }
+
+    write(dst, id);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const Rc<DxvkSampler>& sampler) {
+    uint32_t id;
+
+    if (!lookupObject(sampler.ptr(), id)) {
+      std::vector<char> data;
+      write(data, id);
+      write(data, sampler->info());
+
+      this->writeRecord(0, DxvkCsCaptureOp::CreateSampler, data);
+      m_resources.push_back(sampler.ptr());
+    }
+
+    write(dst, id);
+  }
+
+
+  void DxvkCsCaptureWriter::write(std::vector<char>& dst, const Rc<DxvkShader>& shader) {
+    uint32_t id;
+
+    if (!lookupObject(shader.ptr(), id)) {
+      const auto& slots     = shader->resourceSlots();
+      const auto& constData = shader->shaderConstants();
+
+      SpirvCodeBuffer code = shader->getRawCode();
+
+      std::vector<char> data;
+      write(data, id);
+      write(data, shader->stage());
+      write(data, shader->getShaderKey());
+      write(data, DxvkCsCaptureData { slots.data(), slots.size() * sizeof(DxvkResourceSlot) });
+      write(data, shader->interfaceSlots());
+      write(data, shader->shaderOptions());
+      write(data, DxvkCsCaptureData { constData.data(), constData.sizeInBytes() });
+      write(data, DxvkCsCaptureData { code.data(), code.size() });
+
+      this->writeRecord(0, DxvkCsCaptureOp::CreateShader, data);
+      m_shaders.push_back(shader);
+    }
+
+    write(dst, id);
+  }
+
+
+  bool DxvkCsCaptureWriter::lookupObject(const void* object, uint32_t& id) {
+    if (!object) {
+      id = 0;
+      return true;
+    }
+
+    auto entry = m_objectIds.insert({ object, m_nextObjectId });
+    id = entry.first->second;
+
+    if (!entry.second)
+      return true;
+
+    m_nextObjectId += 1;
+    return false;
+  }
+
+
+
+
+  DxvkCsCaptureReader::DxvkCsCaptureReader(
+    const Rc<DxvkDevice>&         device,
+    const std::string&            fileName)
+  : m_device(device), m_stream(fileName, std::ios_base::binary) {
+    DxvkCsCaptureHeader header = { };
+
+    if (!m_stream.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+      Logger::err(str::format("DxvkCsCaptureReader: Failed to read ", fileName));
+      return;
+    }
+
+    if (!DxvkCsCaptureWriter::validateHeader(header)) {
+      Logger::err(str::format("DxvkCsCaptureReader: Invalid capture file ", fileName));
+      return;
+    }
+
+    m_valid = true;
+  }
+
+
+  DxvkCsCaptureReader::~DxvkCsCaptureReader() {
+
+  }
+
+
+  bool DxvkCsCaptureReader::readRecord(
+          DxvkCsCaptureRecord&    record) {
+    if (!m_valid || !m_stream.read(reinterpret_cast<char*>(&m_record), sizeof(m_record)))
+      return false;
+
+    m_data.resize(m_record.size);
+    m_offset = 0;
+
+    if (!m_stream.read(m_data.data(), m_data.size()))
+      return false;
+
+    record = m_record;
+    return true;
+  }
+
+
+  void DxvkCsCaptureReader::replayRecord(
+          DxvkContext*            ctx) {
+    switch (m_record.op) {
+      case DxvkCsCaptureOp::CreateBuffer:
+        this->createBuffer();
+        break;
+
+      case DxvkCsCaptureOp::CreateBufferView:
+        this->createBufferView();
+        break;
+
+      case DxvkCsCaptureOp::CreateImage:
+        this->createImage();
+        break;
+
+      case DxvkCsCaptureOp::CreateImageView:
+        this->createImageView();
+        break;
+
+      case DxvkCsCaptureOp::CreateSampler:
+        this->createSampler();
+        break;
+
+      case DxvkCsCaptureOp::CreateShader:
+        this->createShader();
+        break;
+
+      case DxvkCsCaptureOp::EndFrame:
+        break;
+
+      case DxvkCsCaptureOp::EndRecording: {
+        m_device->submitCommandList(ctx->endRecording(),
+          VK_NULL_HANDLE, VK_NULL_HANDLE);
+        ctx->beginRecording(m_device->createCommandList());
+      } break;
+
+      case DxvkCsCaptureOp::BindRenderTargets:
+        ctx->bindRenderTargets(readRenderTargets());
+        break;
+
+      case DxvkCsCaptureOp::BindDrawBuffers: {
+        DxvkBufferSlice argBuffer = readBufferSlice();
+        DxvkBufferSlice cntBuffer = readBufferSlice();
+        ctx->bindDrawBuffers(argBuffer, cntBuffer);
+      } break;
+
+      case DxvkCsCaptureOp::BindIndexBuffer: {
+        DxvkBufferSlice buffer = readBufferSlice();
+        ctx->bindIndexBuffer(buffer, read<VkIndexType>());
+      } break;
+
+      case DxvkCsCaptureOp::BindResourceBuffer: {
+        uint32_t slot = read<uint32_t>();
+        ctx->bindResourceBuffer(slot, readBufferSlice());
+      } break;
+
+      case DxvkCsCaptureOp::BindResourceView: {
+        uint32_t slot = read<uint32_t>();
+        Rc<DxvkImageView>  imageView  = readObject(m_imageViews);
+        Rc<DxvkBufferView> bufferView = readObject(m_bufferViews);
+        ctx->bindResourceView(slot, imageView, bufferView);
+      } break;
+
+      case DxvkCsCaptureOp::BindResourceSampler: {
+        uint32_t slot = read<uint32_t>();
+        ctx->bindResourceSampler(slot, readObject(m_samplers));
+      } break;
+
+      case DxvkCsCaptureOp::BindShader: {
+        auto stage = read<VkShaderStageFlagBits>();
+        ctx->bindShader(stage, readObject(m_shaders));
+      } break;
+
+      case DxvkCsCaptureOp::BindVertexBuffer: {
+        uint32_t binding = read<uint32_t>();
+        DxvkBufferSlice buffer = readBufferSlice();
+        ctx->bindVertexBuffer(binding, buffer, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearBuffer: {
+        Rc<DxvkBuffer> buffer = readObject(m_buffers);
+        auto offset = read<VkDeviceSize>();
+        auto length = read<VkDeviceSize>();
+        ctx->clearBuffer(buffer, offset, length, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearRenderTarget: {
+        Rc<DxvkImageView> view = readObject(m_imageViews);
+        auto aspects = read<VkImageAspectFlags>();
+        ctx->clearRenderTarget(view, aspects, read<VkClearValue>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearImageView: {
+        Rc<DxvkImageView> view = readObject(m_imageViews);
+        auto offset = read<VkOffset3D>();
+        auto extent = read<VkExtent3D>();
+        auto aspect = read<VkImageAspectFlags>();
+        ctx->clearImageView(view, offset, extent, aspect, read<VkClearValue>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyBuffer: {
+        Rc<DxvkBuffer> dstBuffer = readObject(m_buffers);
+        auto dstOffset = read<VkDeviceSize>();
+        Rc<DxvkBuffer> srcBuffer = readObject(m_buffers);
+        auto srcOffset = read<VkDeviceSize>();
+        ctx->copyBuffer(dstBuffer, dstOffset, srcBuffer, srcOffset, read<VkDeviceSize>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyBufferToImage: {
+        Rc<DxvkImage> dstImage = readObject(m_images);
+        auto dstSubresource = read<VkImageSubresourceLayers>();
+        auto dstOffset = read<VkOffset3D>();
+        auto dstExtent = read<VkExtent3D>();
+        Rc<DxvkBuffer> srcBuffer = readObject(m_buffers);
+        auto srcOffset = read<VkDeviceSize>();
+        ctx->copyBufferToImage(dstImage, dstSubresource, dstOffset, dstExtent,
+          srcBuffer, srcOffset, read<VkExtent2D>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyImage: {
+        Rc<DxvkImage> dstImage = readObject(m_images);
+        auto dstSubresource = read<VkImageSubresourceLayers>();
+        auto dstOffset = read<VkOffset3D>();
+        Rc<DxvkImage> srcImage = readObject(m_images);
+        auto srcSubresource = read<VkImageSubresourceLayers>();
+        auto srcOffset = read<VkOffset3D>();
+        ctx->copyImage(dstImage, dstSubresource, dstOffset,
+          srcImage, srcSubresource, srcOffset, read<VkExtent3D>());
+      } break;
+
+      case DxvkCsCaptureOp::Dispatch: {
+        auto x = read<uint32_t>();
+        auto y = read<uint32_t>();
+        ctx->dispatch(x, y, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::DispatchIndirect:
+        ctx->dispatchIndirect(read<VkDeviceSize>());
+        break;
+
+      case DxvkCsCaptureOp::Draw: {
+        auto vertexCount   = read<uint32_t>();
+        auto instanceCount = read<uint32_t>();
+        auto firstVertex   = read<uint32_t>();
+        ctx->draw(vertexCount, instanceCount, firstVertex, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::DrawIndexed: {
+        auto indexCount    = read<uint32_t>();
+        auto instanceCount = read<uint32_t>();
+        auto firstIndex    = read<uint32_t>();
+        auto vertexOffset  = read<uint32_t>();
+        ctx->drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::DrawIndirect: {
+        auto offset = read<VkDeviceSize>();
+        auto count  = read<uint32_t>();
+        ctx->drawIndirect(offset, count, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::DrawIndexedIndirect: {
+        auto offset = read<VkDeviceSize>();
+        auto count  = read<uint32_t>();
+        ctx->drawIndexedIndirect(offset, count, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::GenerateMipmaps: {
+        Rc<DxvkImageView> view = readObject(m_imageViews);
+        ctx->generateMipmaps(view, read<VkFilter>());
+      } break;
+
+      case DxvkCsCaptureOp::InvalidateBuffer: {
+        Rc<DxvkBuffer> buffer = readObject(m_buffers);
+        DxvkCsCaptureData data = readData();
+
+        DxvkBufferSliceHandle slice = buffer->allocSlice();
+
+        if (slice.mapPtr)
+          std::memcpy(slice.mapPtr, data.data, std::min<size_t>(data.size, slice.length));
+
+        ctx->invalidateBuffer(buffer, slice);
+      } break;
+
+      case DxvkCsCaptureOp::PushConstants: {
+        auto offset = read<uint32_t>();
+        DxvkCsCaptureData data = readData();
+        ctx->pushConstants(offset, uint32_t(data.size), data.data);
+      } break;
+
+      case DxvkCsCaptureOp::ResolveImage: {
+        Rc<DxvkImage> dstImage = readObject(m_images);
+        Rc<DxvkImage> srcImage = readObject(m_images);
+        auto region = read<VkImageResolve>();
+        ctx->resolveImage(dstImage, srcImage, region, read<VkFormat>());
+      } break;
+
+      case DxvkCsCaptureOp::UpdateBuffer: {
+        Rc<DxvkBuffer> buffer = readObject(m_buffers);
+        auto offset = read<VkDeviceSize>();
+        DxvkCsCaptureData data = readData();
+        ctx->updateBuffer(buffer, offset, data.size, data.data);
+      } break;
+
+      case DxvkCsCaptureOp::UpdateImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto subresources = read<VkImageSubresourceLayers>();
+        auto offset = read<VkOffset3D>();
+        auto extent = read<VkExtent3D>();
+        DxvkCsCaptureData data = readData();
+
+        // Image data is stored tightly packed
+        const DxvkFormatInfo* formatInfo = image->formatInfo();
+        VkExtent3D blockCount = util::computeBlockCount(extent, formatInfo->blockSize);
+        VkDeviceSize pitchPerRow   = formatInfo->elementSize * blockCount.width;
+        VkDeviceSize pitchPerLayer = pitchPerRow * blockCount.height;
+
+        ctx->updateImage(image, subresources, offset, extent,
+          data.data, pitchPerRow, pitchPerLayer);
+      } break;
+
+      case DxvkCsCaptureOp::UploadBuffer: {
+        Rc<DxvkBuffer> buffer = readObject(m_buffers);
+        ctx->uploadBuffer(buffer, readData().data);
+      } break;
+
+      case DxvkCsCaptureOp::UploadImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto subresources = read<VkImageSubresourceLayers>();
+        DxvkCsCaptureData data = readData();
+
+        const DxvkFormatInfo* formatInfo = image->formatInfo();
+        VkExtent3D extent = image->mipLevelExtent(subresources.mipLevel);
+        VkExtent3D blockCount = util::computeBlockCount(extent, formatInfo->blockSize);
+        VkDeviceSize pitchPerRow   = formatInfo->elementSize * blockCount.width;
+        VkDeviceSize pitchPerLayer = pitchPerRow * blockCount.height;
+
+        ctx->uploadImage(image, subresources, data.data, pitchPerRow, pitchPerLayer);
+      } break;
+
+      case DxvkCsCaptureOp::SetViewports: {
+        std::array<VkViewport, DxvkLimits::MaxNumViewports> viewports;
+        std::array<VkRect2D,   DxvkLimits::MaxNumViewports> scissors;
+
+        auto count = std::min<uint32_t>(read<uint32_t>(), DxvkLimits::MaxNumViewports);
+        std::memcpy(viewports.data(), readData().data, count * sizeof(VkViewport));
+        std::memcpy(scissors.data(),  readData().data, count * sizeof(VkRect2D));
+
+        ctx->setViewports(count, viewports.data(), scissors.data());
+      } break;
+
+      case DxvkCsCaptureOp::SetBlendConstants:
+        ctx->setBlendConstants(read<DxvkBlendConstants>());
+        break;
+
+      case DxvkCsCaptureOp::SetDepthBias:
+        ctx->setDepthBias(read<DxvkDepthBias>());
+        break;
+
+      case DxvkCsCaptureOp::SetDepthBounds:
+        ctx->setDepthBounds(read<DxvkDepthBounds>());
+        break;
+
+      case DxvkCsCaptureOp::SetStencilReference:
+        ctx->setStencilReference(read<uint32_t>());
+        break;
+
+      case DxvkCsCaptureOp::SetInputAssemblyState:
+        ctx->setInputAssemblyState(read<DxvkInputAssemblyState>());
+        break;
+
+      case DxvkCsCaptureOp::SetInputLayout: {
+        std::array<DxvkVertexAttribute, DxvkLimits::MaxNumVertexAttributes> attributes;
+        std::array<DxvkVertexBinding,   DxvkLimits::MaxNumVertexBindings>   bindings;
+
+        auto attributeCount = std::min<uint32_t>(read<uint32_t>(), DxvkLimits::MaxNumVertexAttributes);
+        std::memcpy(attributes.data(), readData().data, attributeCount * sizeof(DxvkVertexAttribute));
+
+        auto bindingCount = std::min<uint32_t>(read<uint32_t>(), DxvkLimits::MaxNumVertexBindings);
+        std::memcpy(bindings.data(), readData().data, bindingCount * sizeof(DxvkVertexBinding));
+
+        ctx->setInputLayout(attributeCount, attributes.data(), bindingCount, bindings.data());
+      } break;
+
+      case DxvkCsCaptureOp::SetRasterizerState:
+        ctx->setRasterizerState(read<DxvkRasterizerState>());
+        break;
+
+      case DxvkCsCaptureOp::SetMultisampleState:
+        ctx->setMultisampleState(read<DxvkMultisampleState>());
+        break;
+
+      case DxvkCsCaptureOp::SetDepthStencilState:
+        ctx->setDepthStencilState(read<DxvkDepthStencilState>());
+        break;
+
+      case DxvkCsCaptureOp::SetLogicOpState:
+        ctx->setLogicOpState(read<DxvkLogicOpState>());
+        break;
+
+      case DxvkCsCaptureOp::SetBlendMode: {
+        auto attachment = read<uint32_t>();
+        ctx->setBlendMode(attachment, read<DxvkBlendMode>());
+      } break;
+
+      case DxvkCsCaptureOp::SetSpecConstant: {
+        auto pipeline = read<VkPipelineBindPoint>();
+        auto index    = read<uint32_t>();
+        ctx->setSpecConstant(pipeline, index, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearBufferView: {
+        Rc<DxvkBufferView> view = readObject(m_bufferViews);
+        auto offset = read<VkDeviceSize>();
+        auto length = read<VkDeviceSize>();
+        ctx->clearBufferView(view, offset, length, read<VkClearColorValue>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyImageToBuffer: {
+        Rc<DxvkBuffer> dstBuffer = readObject(m_buffers);
+        auto dstOffset = read<VkDeviceSize>();
+        auto dstExtent = read<VkExtent2D>();
+        Rc<DxvkImage> srcImage = readObject(m_images);
+        auto srcSubresource = read<VkImageSubresourceLayers>();
+        auto srcOffset = read<VkOffset3D>();
+        ctx->copyImageToBuffer(dstBuffer, dstOffset, dstExtent,
+          srcImage, srcSubresource, srcOffset, read<VkExtent3D>());
+      } break;
+
+      case DxvkCsCaptureOp::DiscardImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        ctx->discardImage(image, read<VkImageSubresourceRange>());
+      } break;
+
+      case DxvkCsCaptureOp::DrawIndirectCount: {
+        auto offset      = read<VkDeviceSize>();
+        auto countOffset = read<VkDeviceSize>();
+        auto maxCount    = read<uint32_t>();
+        ctx->drawIndirectCount(offset, countOffset, maxCount, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::DrawIndexedIndirectCount: {
+        auto offset      = read<VkDeviceSize>();
+        auto countOffset = read<VkDeviceSize>();
+        auto maxCount    = read<uint32_t>();
+        ctx->drawIndexedIndirectCount(offset, countOffset, maxCount, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::InitImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto subresources = read<VkImageSubresourceRange>();
+        ctx->initImage(image, subresources, read<VkImageLayout>());
+      } break;
+
+      case DxvkCsCaptureOp::TransformImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto subresources = read<VkImageSubresourceRange>();
+        auto srcLayout = read<VkImageLayout>();
+        ctx->transformImage(image, subresources, srcLayout, read<VkImageLayout>());
+      } break;
+
+      case DxvkCsCaptureOp::SetBarrierControl:
+        ctx->setBarrierControl(read<DxvkBarrierControlFlags>());
+        break;
+
+      case DxvkCsCaptureOp::BindXfbBuffer: {
+        auto binding = read<uint32_t>();
+        DxvkBufferSlice buffer  = readBufferSlice();
+        DxvkBufferSlice counter = readBufferSlice();
+        ctx->bindXfbBuffer(binding, buffer, counter);
+      } break;
+
+      case DxvkCsCaptureOp::BlitImage: {
+        Rc<DxvkImage> dstImage = readObject(m_images);
+        auto dstMapping = read<VkComponentMapping>();
+        Rc<DxvkImage> srcImage = readObject(m_images);
+        auto srcMapping = read<VkComponentMapping>();
+        auto region = read<VkImageBlit>();
+        ctx->blitImage(dstImage, dstMapping, srcImage, srcMapping, region, read<VkFilter>());
+      } break;
+
+      case DxvkCsCaptureOp::ChangeImageLayout: {
+        Rc<DxvkImage> image = readObject(m_images);
+        ctx->changeImageLayout(image, read<VkImageLayout>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearColorImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto value = read<VkClearColorValue>();
+        ctx->clearColorImage(image, value, read<VkImageSubresourceRange>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearDepthStencilImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto value = read<VkClearDepthStencilValue>();
+        ctx->clearDepthStencilImage(image, value, read<VkImageSubresourceRange>());
+      } break;
+
+      case DxvkCsCaptureOp::ClearCompressedColorImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        ctx->clearCompressedColorImage(image, read<VkImageSubresourceRange>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyBufferRegion: {
+        Rc<DxvkBuffer> buffer = readObject(m_buffers);
+        auto dstOffset = read<VkDeviceSize>();
+        auto srcOffset = read<VkDeviceSize>();
+        ctx->copyBufferRegion(buffer, dstOffset, srcOffset, read<VkDeviceSize>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyImageRegion: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto subresource = read<VkImageSubresourceLayers>();
+        auto dstOffset = read<VkOffset3D>();
+        auto srcOffset = read<VkOffset3D>();
+        ctx->copyImageRegion(image, subresource, dstOffset, srcOffset, read<VkExtent3D>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyDepthStencilImageToPackedBuffer: {
+        Rc<DxvkBuffer> dstBuffer = readObject(m_buffers);
+        auto dstOffset = read<VkDeviceSize>();
+        Rc<DxvkImage> srcImage = readObject(m_images);
+        auto srcSubresource = read<VkImageSubresourceLayers>();
+        auto srcOffset = read<VkOffset2D>();
+        auto srcExtent = read<VkExtent2D>();
+        ctx->copyDepthStencilImageToPackedBuffer(dstBuffer, dstOffset,
+          srcImage, srcSubresource, srcOffset, srcExtent, read<VkFormat>());
+      } break;
+
+      case DxvkCsCaptureOp::CopyPackedBufferToDepthStencilImage: {
+        Rc<DxvkImage> dstImage = readObject(m_images);
+        auto dstSubresource = read<VkImageSubresourceLayers>();
+        auto dstOffset = read<VkOffset2D>();
+        auto dstExtent = read<VkExtent2D>();
+        Rc<DxvkBuffer> srcBuffer = readObject(m_buffers);
+        auto srcOffset = read<VkDeviceSize>();
+        ctx->copyPackedBufferToDepthStencilImage(dstImage, dstSubresource,
+          dstOffset, dstExtent, srcBuffer, srcOffset, read<VkFormat>());
+      } break;
+
+      case DxvkCsCaptureOp::DrawIndirectXfb: {
+        DxvkBufferSlice counter = readBufferSlice();
+        auto divisor = read<uint32_t>();
+        ctx->drawIndirectXfb(counter, divisor, read<uint32_t>());
+      } break;
+
+      case DxvkCsCaptureOp::ResolveDepthStencilImage: {
+        Rc<DxvkImage> dstImage = readObject(m_images);
+        Rc<DxvkImage> srcImage = readObject(m_images);
+        auto region = read<VkImageResolve>();
+        auto depthMode = read<VkResolveModeFlagBitsKHR>();
+        ctx->resolveDepthStencilImage(dstImage, srcImage, region,
+          depthMode, read<VkResolveModeFlagBitsKHR>());
+      } break;
+
+      case DxvkCsCaptureOp::SetPredicate: {
+        DxvkBufferSlice predicate = readBufferSlice();
+        ctx->setPredicate(predicate, read<VkConditionalRenderingFlagsEXT>());
+      } break;
+
+      case DxvkCsCaptureOp::UpdateDepthStencilImage: {
+        Rc<DxvkImage> image = readObject(m_images);
+        auto subresources = read<VkImageSubresourceLayers>();
+        auto offset = read<VkOffset2D>();
+        auto extent = read<VkExtent2D>();
+        DxvkCsCaptureData data = readData();
+        auto format = read<VkFormat>();
+
+        // Data is stored tightly packed in the packed format
+        const DxvkFormatInfo* formatInfo = imageFormatInfo(format);
+        VkDeviceSize pitchPerRow   = formatInfo->elementSize * extent.width;
+        VkDeviceSize pitchPerLayer = pitchPerRow * extent.height;
+
+        ctx->updateDepthStencilImage(image, subresources, offset, extent,
+          data.data, pitchPerRow, pitchPerLayer, format);
+      } break;
+
+      case DxvkCsCaptureOp::Unsupported: {
+        DxvkCsCaptureData data = readData();
+        std::string name(reinterpret_cast<const char*>(data.data), data.size);
+
+        if (m_unsupported.insert(name).second)
+          Logger::warn(str::format("DxvkCsCaptureReader: ", name, " not supported, replay may be inaccurate"));
+      } break;
+
+      default:
+        Logger::warn(str::format("DxvkCsCaptureReader: Unknown op ", uint32_t(m_record.op)));
+    }
+  }
+
+
+  const void* DxvkCsCaptureReader::readBytes(size_t size) {
+    if (m_offset + size > m_data.size())
+      throw DxvkError("DxvkCsCaptureReader: Unexpected end of record");
+
+    const void* result = m_data.data() + m_offset;
+    m_offset += size;
+    return result;
+  }
+
+
+  DxvkCsCaptureData DxvkCsCaptureReader::readData() {
+    DxvkCsCaptureData result;
+    result.size = size_t(read<uint64_t>());
+    result.data = readBytes(result.size);
+    return result;
+  }
+
+
+  DxvkBufferSlice DxvkCsCaptureReader::readBufferSlice() {
+    Rc<DxvkBuffer> buffer = readObject(m_buffers);
+    auto offset = read<uint64_t>();
+    auto length = read<uint64_t>();
+
+    return buffer != nullptr
+      ? DxvkBufferSlice(buffer, offset, length)
+      : DxvkBufferSlice();
+  }
+
+
+  DxvkRenderTargets DxvkCsCaptureReader::readRenderTargets() {
+    DxvkRenderTargets result;
+    result.depth.view   = readObject(m_imageViews);
+    result.depth.layout = read<VkImageLayout>();
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+      result.color[i].view   = readObject(m_imageViews);
+      result.color[i].layout = read<VkImageLayout>();
+    }
+
+    return result;
+  }
+
+
+  void DxvkCsCaptureReader::createBuffer() {
+    auto id       = read<uint32_t>();
+    auto info     = read<DxvkBufferCreateInfo>();
+    auto memFlags = read<VkMemoryPropertyFlags>();
+    auto data     = readData();
+
+    Rc<DxvkBuffer> buffer = m_device->createBuffer(info, memFlags);
+
+    if (data.size)
+      std::memcpy(buffer->mapPtr(0), data.data, std::min<size_t>(data.size, info.size));
+
+    m_buffers.insert({ id, std::move(buffer) });
+  }
+
+
+  void DxvkCsCaptureReader::createBufferView() {
+    auto id = read<uint32_t>();
+    Rc<DxvkBuffer> buffer = readObject(m_buffers);
+    auto info = read<DxvkBufferViewCreateInfo>();
+
+    m_bufferViews.insert({ id, m_device->createBufferView(buffer, info) });
+  }
+
+
+  void DxvkCsCaptureReader::createImage() {
+    auto id       = read<uint32_t>();
+    auto info     = read<DxvkImageCreateInfo>();
+    auto memFlags = read<VkMemoryPropertyFlags>();
+    auto formats  = readData();
+
+    std::vector<VkFormat> viewFormats(info.viewFormatCount);
+    std::memcpy(viewFormats.data(), formats.data, viewFormats.size() * sizeof(VkFormat));
+    info.viewFormats = viewFormats.data();
+
+    // Swap chain images do not have any memory flags
+    if (!memFlags)
+      memFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    m_images.insert({ id, m_device->createImage(info, memFlags) });
+  }
+
+
+  void DxvkCsCaptureReader::createImageView() {
+    auto id = read<uint32_t>();
+    Rc<DxvkImage> image = readObject(m_images);
+    auto info = read<DxvkImageViewCreateInfo>();
+
+    m_imageViews.insert({ id, m_device->createImageView(image, info) });
+  }
+
+
+  void DxvkCsCaptureReader::createSampler() {
+    auto id   = read<uint32_t>();
+    auto info = read<DxvkSamplerCreateInfo>();
+
+    m_samplers.insert({ id, m_device->createSampler(info) });
+  }
+
+
+  void DxvkCsCaptureReader::createShader() {
+    auto id    = read<uint32_t>();
+    auto stage = read<VkShaderStageFlagBits>();
+    auto key   = read<DxvkShaderKey>();
+
+    DxvkCsCaptureData slotData = readData();
+    std::vector<DxvkResourceSlot> slots(slotData.size / sizeof(DxvkResourceSlot));
+    std::memcpy(slots.data(), slotData.data, slots.size() * sizeof(DxvkResourceSlot));
+
+    auto iface   = read<DxvkInterfaceSlots>();
+    auto options = read<DxvkShaderOptions>();
+
+    DxvkCsCaptureData constData = readData();
+    std::vector<uint32_t> constDwords(constData.size / sizeof(uint32_t));
+    std::memcpy(constDwords.data(), constData.data, constDwords.size() * sizeof(uint32_t));
+
+    DxvkCsCaptureData codeData = readData();
+    std::vector<uint32_t> codeDwords(codeData.size / sizeof(uint32_t));
+    std::memcpy(codeDwords.data(), codeData.data, codeDwords.size() * sizeof(uint32_t));
+
+    Rc<DxvkShader> shader = new DxvkShader(stage,
+      slots.size(), slots.data(), iface,
+      SpirvCodeBuffer(codeDwords.size(), codeDwords.data()),
+      options, constDwords.empty()
+        ? DxvkShaderConstData()
+        : DxvkShaderConstData(constDwords.size(), constDwords.data()));
+    shader->setShaderKey(key);
+
+    m_shaders.insert({ id, std::move(shader) });
+  }
+
+}
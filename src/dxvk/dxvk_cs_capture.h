@@ -0,0 +1,415 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dxvk_buffer.h"
+#include "dxvk_constant_state.h"
+#include "dxvk_framebuffer.h"
+#include "dxvk_image.h"
+#include "dxvk_sampler.h"
+#include "dxvk_shader.h"
+
+namespace dxvk {
+
+  class DxvkContext;
+  class DxvkDevice;
+
+  /**
+   * \brief CS capture operation
+   *
+   * Resource creation records are emitted on the first
+   * use of a resource within the captured frame range,
+   * all other records correspond to a \c DxvkContext
+   * method with the same name. Queries and GPU events
+   * cannot be replayed, so the methods using them emit
+   * an \c Unsupported record with the method name.
+   */
+  enum class DxvkCsCaptureOp : uint16_t {
+    CreateBuffer,
+    CreateBufferView,
+    CreateImage,
+    CreateImageView,
+    CreateSampler,
+    CreateShader,
+    EndFrame,
+    EndRecording,
+    BindRenderTargets,
+    BindDrawBuffers,
+    BindIndexBuffer,
+    BindResourceBuffer,
+    BindResourceView,
+    BindResourceSampler,
+    BindShader,
+    BindVertexBuffer,
+    ClearBuffer,
+    ClearRenderTarget,
+    ClearImageView,
+    CopyBuffer,
+    CopyBufferToImage,
+    CopyImage,
+    Dispatch,
+    DispatchIndirect,
+    Draw,
+    DrawIndexed,
+    DrawIndirect,
+    DrawIndexedIndirect,
+    GenerateMipmaps,
+    InvalidateBuffer,
+    PushConstants,
+    ResolveImage,
+    UpdateBuffer,
+    UpdateImage,
+    UploadBuffer,
+    UploadImage,
+    SetViewports,
+    SetBlendConstants,
+    SetDepthBias,
+    SetDepthBounds,
+    SetStencilReference,
+    SetInputAssemblyState,
+    SetInputLayout,
+    SetRasterizerState,
+    SetMultisampleState,
+    SetDepthStencilState,
+    SetLogicOpState,
+    SetBlendMode,
+    SetSpecConstant,
+    ClearBufferView,
+    CopyImageToBuffer,
+    DiscardImage,
+    DrawIndirectCount,
+    DrawIndexedIndirectCount,
+    InitImage,
+    TransformImage,
+    SetBarrierControl,
+    BindXfbBuffer,
+    BlitImage,
+    ChangeImageLayout,
+    ClearColorImage,
+    ClearDepthStencilImage,
+    ClearCompressedColorImage,
+    CopyBufferRegion,
+    CopyImageRegion,
+    CopyDepthStencilImageToPackedBuffer,
+    CopyPackedBufferToDepthStencilImage,
+    DrawIndirectXfb,
+    ResolveDepthStencilImage,
+    SetPredicate,
+    UpdateDepthStencilImage,
+    Unsupported,
+  };
+
+
+  /**
+   * \brief CS capture file header
+   */
+  struct DxvkCsCaptureHeader {
+    char      magic[4];
+    uint32_t  version;
+  };
+
+
+  /**
+   * \brief CS capture record header
+   *
+   * Precedes the payload of each record. The context
+   * ID identifies the \c DxvkContext that executed
+   * the command, so that commands recorded on the
+   * CS thread and e.g. resource initialization can
+   * be replayed on separate contexts.
+   */
+  struct DxvkCsCaptureRecord {
+    DxvkCsCaptureOp op;
+    uint16_t        contextId;
+    uint32_t        size;
+  };
+
+
+  /**
+   * \brief Variable-size data
+   *
+   * Stored as a 64-bit size followed by the data.
+   */
+  struct DxvkCsCaptureData {
+    const void*     data;
+    size_t          size;
+  };
+
+
+  /**
+   * \brief Image data
+   *
+   * Image data with arbitrary pitches, which gets
+   * tightly packed when writing it to the capture.
+   */
+  struct DxvkCsCaptureImageData {
+    const DxvkFormatInfo* formatInfo;
+    VkExtent3D            extent;
+    uint32_t              layerCount;
+    const void*           data;
+    VkDeviceSize          pitchPerRow;
+    VkDeviceSize          pitchPerLayer;
+  };
+
+
+  /**
+   * \brief CS capture writer
+   *
+   * Records the commands executed by all contexts of a
+   * device, along with the parameters and initial data
+   * of all resources they use, so that the command stream
+   * can be replayed without the application. Enabled by
+   * setting \c DXVK_CS_CAPTURE to the path of the file
+   * to write. \c DXVK_CS_CAPTURE_FRAMES can be set to
+   * \c first-last in order to limit the frame range.
+   *
+   * The writer keeps all resources it has seen alive
+   * until the last frame has been captured, so that
+   * object IDs remain unique.
+   */
+  class DxvkCsCaptureWriter {
+    constexpr static char Magic[4] = { 'D', 'X', 'C', 'S' };
+  public:
+
+    constexpr static uint32_t Version = 1;
+
+    DxvkCsCaptureWriter(
+      const std::string&            fileName,
+            uint32_t                firstFrame,
+            uint32_t                lastFrame);
+
+    ~DxvkCsCaptureWriter();
+
+    /**
+     * \brief Allocates a context ID
+     * \returns Unique context ID
+     */
+    uint16_t registerContext() {
+      return m_nextContextId++;
+    }
+
+    /**
+     * \brief Records a command
+     *
+     * Does nothing if the current frame is
+     * outside of the captured frame range.
+     * \param [in] contextId Context ID
+     * \param [in] op The operation
+     * \param [in] args Command arguments
+     */
+    template<typename... Args>
+    void record(
+            uint16_t                contextId,
+            DxvkCsCaptureOp         op,
+      const Args&...                args) {
+      if (likely(!m_active.load(std::memory_order_acquire)))
+        return;
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (!m_active.load(std::memory_order_relaxed))
+        return;
+
+      m_record.clear();
+      (this->write(m_record, args), ...);
+      this->writeRecord(contextId, op, m_record);
+    }
+
+    /**
+     * \brief Records a command that cannot be replayed
+     *
+     * \param [in] contextId Context ID
+     * \param [in] name Name of the context method
+     */
+    void recordUnsupported(
+            uint16_t                contextId,
+      const char*                   name) {
+      this->record(contextId, DxvkCsCaptureOp::Unsupported,
+        DxvkCsCaptureData { name, std::strlen(name) });
+    }
+
+    /**
+     * \brief Ends the current frame
+     *
+     * Starts or stops capturing as necessary. Once the
+     * last frame of the range has been captured, the
+     * file is closed and all resources are released.
+     */
+    void endFrame();
+
+    /**
+     * \brief Checks whether a capture header is valid
+     *
+     * \param [in] header Header read from a capture file
+     * \returns \c true if magic and version match
+     */
+    static bool validateHeader(
+      const DxvkCsCaptureHeader&    header);
+
+    /**
+     * \brief Creates capture writer if enabled
+     *
+     * \returns Capture writer, or \c nullptr if
+     *    \c DXVK_CS_CAPTURE is not set
+     */
+    static std::unique_ptr<DxvkCsCaptureWriter> create();
+
+  private:
+
+    std::mutex                m_mutex;
+    std::ofstream             m_stream;
+    std::vector<char>         m_record;
+
+    std::atomic<bool>         m_active        = { false };
+    std::atomic<uint16_t>     m_nextContextId = { 0 };
+
+    uint32_t                  m_frameId       = 0;
+    uint32_t                  m_firstFrame;
+    uint32_t                  m_lastFrame;
+
+    uint32_t                  m_nextObjectId  = 1;
+
+    std::unordered_map<const void*, uint32_t> m_objectIds;
+
+    std::vector<Rc<DxvkResource>> m_resources;
+    std::vector<Rc<DxvkShader>>   m_shaders;
+
+    void writeRecord(
+            uint16_t                contextId,
+            DxvkCsCaptureOp         op,
+      const std::vector<char>&      data);
+
+    void updateActive();
+
+    template<typename T>
+    static void write(std::vector<char>& dst, const T& value) {
+      static_assert(std::is_trivially_copyable<T>::value,
+        "DxvkCsCaptureWriter: Type not serializable");
+
+      auto bytes = reinterpret_cast<const char*>(&value);
+      dst.insert(dst.end(), bytes, bytes + sizeof(value));
+    }
+
+    static void write(std::vector<char>& dst, const DxvkCsCaptureData& data);
+    static void write(std::vector<char>& dst, const DxvkCsCaptureImageData& data);
+
+    void write(std::vector<char>& dst, const DxvkBufferSlice& slice);
+    void write(std::vector<char>& dst, const DxvkRenderTargets& targets);
+    void write(std::vector<char>& dst, const Rc<DxvkBuffer>& buffer);
+    void write(std::vector<char>& dst, const Rc<DxvkBufferView>& view);
+    void write(std::vector<char>& dst, const Rc<DxvkImage>& image);
+    void write(std::vector<char>& dst, const Rc<DxvkImageView>& view);
+    void write(std::vector<char>& dst, const Rc<DxvkSampler>& sampler);
+    void write(std::vector<char>& dst, const Rc<DxvkShader>& shader);
+
+    bool lookupObject(const void* object, uint32_t& id);
+
+  };
+
+
+  /**
+   * \brief CS capture reader
+   *
+   * Reads records from a capture file and replays them
+   * on a device. Resources are created on the device as
+   * their creation records are encountered.
+   */
+  class DxvkCsCaptureReader {
+
+  public:
+
+    DxvkCsCaptureReader(
+      const Rc<DxvkDevice>&         device,
+      const std::string&            fileName);
+
+    ~DxvkCsCaptureReader();
+
+    /**
+     * \brief Checks whether the file could be opened
+     * \returns \c true if the header is valid
+     */
+    bool valid() const {
+      return m_valid;
+    }
+
+    /**
+     * \brief Reads next record
+     *
+     * \param [out] record Record header
+     * \returns \c false at the end of the file
+     */
+    bool readRecord(
+            DxvkCsCaptureRecord&    record);
+
+    /**
+     * \brief Replays the last record that was read
+     *
+     * Resource creation records do not use the
+     * context, so it may be \c nullptr for those.
+     * \param [in] ctx Context to execute the command on
+     */
+    void replayRecord(
+            DxvkContext*            ctx);
+
+  private:
+
+    Rc<DxvkDevice>            m_device;
+    std::ifstream             m_stream;
+    bool                      m_valid = false;
+
+    DxvkCsCaptureRecord       m_record = { };
+    std::vector<char>         m_data;
+    size_t                    m_offset = 0;
+
+    std::unordered_map<uint32_t, Rc<DxvkBuffer>>      m_buffers;
+    std::unordered_map<uint32_t, Rc<DxvkBufferView>>  m_bufferViews;
+    std::unordered_map<uint32_t, Rc<DxvkImage>>       m_images;
+    std::unordered_map<uint32_t, Rc<DxvkImageView>>   m_imageViews;
+    std::unordered_map<uint32_t, Rc<DxvkSampler>>     m_samplers;
+    std::unordered_map<uint32_t, Rc<DxvkShader>>      m_shaders;
+
+    std::unordered_set<std::string> m_unsupported;
+
+    template<typename T>
+    T read() {
+      static_assert(std::is_trivially_copyable<T>::value,
+        "DxvkCsCaptureReader: Type not serializable");
+
+      T value;
+      std::memcpy(&value, readBytes(sizeof(value)), sizeof(value));
+      return value;
+    }
+
+    const void* readBytes(size_t size);
+
+    DxvkCsCaptureData readData();
+
+    DxvkBufferSlice readBufferSlice();
+
+    DxvkRenderTargets readRenderTargets();
+
+    template<typename T>
+    Rc<T> readObject(const std::unordered_map<uint32_t, Rc<T>>& map) {
+      auto entry = map.find(read<uint32_t>());
+
+      return entry != map.end()
+        ? entry->second
+        : nullptr;
+    }
+
+    void createBuffer();
+    void createBufferView();
+    void createImage();
+    void createImageView();
+    void createSampler();
+    void createShader();
+
+  };
+
+}
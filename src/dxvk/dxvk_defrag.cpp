@@ -0,0 +1,219 @@
+#include "dxvk_defrag.h"
+#include "dxvk_device.h"
+
+namespace dxvk {
+
+  DxvkMemoryDefragmenter::DxvkMemoryDefragmenter(
+          DxvkDevice*           device,
+          DxvkMemoryAllocator&  memAlloc)
+  : m_device  (device),
+    m_memAlloc(&memAlloc),
+    m_budget  (VkDeviceSize(std::max(device->config().memoryDefragBudget, 0)) << 20),
+    m_evacuate(m_budget != 0) {
+    // Demoted buffers need to be moved back even
+    // if defragmentation itself is disabled
+    if (!m_budget && device->config().memoryBudgetThreshold > 0)
+      m_budget = PromoteBudget;
+  }
+
+
+  DxvkMemoryDefragmenter::~DxvkMemoryDefragmenter() {
+
+  }
+
+
+  void DxvkMemoryDefragmenter::registerBuffer(
+          DxvkBuffer*           buffer) {
+    if (!isEnabled())
+      return;
+
+    // Host-visible buffers may be mapped by the application,
+    // and texel buffer views store the Vulkan buffer handle,
+    // so neither can be moved without the client noticing.
+    VkBufferUsageFlags requiredUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                                     | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    VkBufferUsageFlags forbiddenUsage = VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT
+                                      | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+    if ((buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+     || !(buffer->memFlags() & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+     || (buffer->info().usage & requiredUsage) != requiredUsage
+     || (buffer->info().usage & forbiddenUsage)
+     || !buffer->getMemory().chunk())
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.insert(buffer);
+
+    if (isDemoted(buffer))
+      m_demoted.insert(buffer);
+
+    buffer->m_defrag = this;
+  }
+
+
+  void DxvkMemoryDefragmenter::unregisterBuffer(
+          DxvkBuffer*           buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.erase(buffer);
+    m_demoted.erase(buffer);
+  }
+
+
+  std::vector<DxvkBufferRelocation> DxvkMemoryDefragmenter::getRelocations(
+          uint32_t              frameId) {
+    std::vector<DxvkBufferRelocation> result;
+
+    if (!isEnabled())
+      return result;
+
+    std::vector<Rc<DxvkBuffer>> buffers;
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_frameId != frameId) {
+        m_frameId    = frameId;
+        m_frameBytes = 0;
+      }
+
+      if (m_frameBytes >= m_budget)
+        return result;
+
+      // Moving buffers back to video memory takes precedence
+      // over defragmentation, since it affects performance
+      if (m_chunk == nullptr && !m_memAlloc->isUnderPressure())
+        pickDemotedBuffers(buffers);
+
+      if (buffers.empty() && m_chunk == nullptr && !pickChunk(frameId))
+        return result;
+
+      if (m_chunk != nullptr)
+        pickChunkBuffers(buffers);
+    }
+
+    for (auto& buffer : buffers) {
+      DxvkBufferRelocation relocation;
+      relocation.storage = new DxvkBuffer(m_device,
+        buffer->info(), *m_memAlloc, buffer->memFlags());
+
+      // Do not move buffers to system memory here. This can
+      // happen if we are under memory pressure again, but for
+      // buffers that were demoted before, this is fine if the
+      // intention is to evacuate the chunk they live in.
+      bool isEvacuating = buffer->getMemory().chunk()->isEvacuating();
+
+      if (isDemoted(relocation.storage.ptr()) && !(isDemoted(buffer.ptr()) && isEvacuating))
+        continue;
+
+      relocation.buffer  = std::move(buffer);
+      result.push_back(std::move(relocation));
+    }
+
+    return result;
+  }
+
+
+  void DxvkMemoryDefragmenter::pickChunkBuffers(
+          std::vector<Rc<DxvkBuffer>>& buffers) {
+    uint32_t remaining = 0;
+    uint32_t eligible  = 0;
+
+    for (DxvkBuffer* buffer : m_buffers) {
+      const DxvkMemory& memory = buffer->getMemory();
+
+      if (memory.chunk() != m_chunk.ptr())
+        continue;
+
+      remaining += 1;
+
+      // Buffers that were discarded at some point own multiple
+      // backing buffers and cannot be relocated. The same goes
+      // for buffers that are larger than the per-frame budget.
+      if (memory.length() > m_budget || !buffer->canRelocate())
+        continue;
+
+      eligible += 1;
+
+      // Buffers still in use by the GPU are moved on a later
+      // frame, see DxvkContext::relocateBuffers.
+      if (m_frameBytes + memory.length() > m_budget || buffer->isInUse())
+        continue;
+
+      // The buffer may be in the process of being destroyed,
+      // in which case the destructor waits for our lock.
+      if (!buffer->tryIncRef())
+        continue;
+
+      buffers.push_back(buffer);
+      buffer->decRef();
+
+      m_frameBytes += memory.length();
+    }
+
+    if (!remaining || !eligible) {
+      // Releases the chunk if it is empty, or makes it available
+      // again if there are buffers left that cannot be moved
+      m_memAlloc->endEvacuation(m_chunk);
+      m_chunk = nullptr;
+    }
+  }
+
+
+  void DxvkMemoryDefragmenter::pickDemotedBuffers(
+          std::vector<Rc<DxvkBuffer>>& buffers) {
+    for (auto i = m_demoted.begin(); i != m_demoted.end(); ) {
+      DxvkBuffer* buffer = *i;
+
+      const DxvkMemory& memory = buffer->getMemory();
+
+      // Stop tracking buffers that were already moved back
+      // or that can no longer be moved for other reasons
+      if (!isDemoted(buffer) || !buffer->canRelocate()) {
+        i = m_demoted.erase(i);
+        continue;
+      }
+
+      // Same as for defragmentation, busy buffers are moved
+      // back once the GPU has stopped using them
+      if (m_frameBytes + memory.length() <= m_budget
+       && !buffer->isInUse() && buffer->tryIncRef()) {
+        buffers.push_back(buffer);
+        buffer->decRef();
+
+        m_frameBytes += memory.length();
+      }
+
+      i++;
+    }
+  }
+
+
+  bool DxvkMemoryDefragmenter::isDemoted(
+          DxvkBuffer*           buffer) {
+    VkMemoryPropertyFlags memFlags = buffer->getMemory().propertyFlags();
+    return (memFlags & buffer->memFlags()) != buffer->memFlags();
+  }
+
+
+  bool DxvkMemoryDefragmenter::pickChunk(
+          uint32_t              frameId) {
+    if (!m_evacuate || int32_t(frameId - m_scanFrame) < 0)
+      return false;
+
+    m_scanFrame = frameId + ScanInterval;
+
+    std::unordered_map<DxvkMemoryChunk*, VkDeviceSize> movable;
+
+    for (DxvkBuffer* buffer : m_buffers) {
+      const DxvkMemory& memory = buffer->getMemory();
+
+      if (memory.chunk() != nullptr)
+        movable[memory.chunk()] += memory.length();
+    }
+
+    m_chunk = m_memAlloc->beginEvacuation(movable, MaxChunkUsage);
+    return m_chunk != nullptr;
+  }
+
+}
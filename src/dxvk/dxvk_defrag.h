@@ -0,0 +1,130 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "dxvk_buffer.h"
+#include "dxvk_memory.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Buffer relocation
+   *
+   * Pairs a buffer with newly allocated storage. The
+   * context copies the buffer contents to the storage
+   * buffer and then exchanges the backing resources,
+   * so that the old backing memory is freed once the
+   * storage buffer is no longer used by the GPU.
+   */
+  struct DxvkBufferRelocation {
+    Rc<DxvkBuffer> buffer;
+    Rc<DxvkBuffer> storage;
+  };
+
+
+  /**
+   * \brief Memory defragmenter
+   *
+   * Keeps track of buffers that can be relocated and picks
+   * poorly utilized memory chunks to evacuate. Buffers from
+   * the chunk being evacuated are handed out to the context
+   * in small batches so that the amount of memory copied
+   * per frame stays within the configured budget.
+   *
+   * Buffers that were demoted to system memory due to memory
+   * pressure are moved back to device-local memory the same
+   * way once the pressure drops.
+   */
+  class DxvkMemoryDefragmenter {
+    /// Number of frames between chunk scans
+    constexpr static uint32_t ScanInterval = 60;
+    /// Maximum fraction of a chunk that may be in use
+    constexpr static float    MaxChunkUsage = 0.25f;
+    /// Per-frame budget used only to promote buffers
+    constexpr static VkDeviceSize PromoteBudget = 16 << 20;
+  public:
+
+    DxvkMemoryDefragmenter(
+            DxvkDevice*           device,
+            DxvkMemoryAllocator&  memAlloc);
+
+    ~DxvkMemoryDefragmenter();
+
+    /**
+     * \brief Checks whether defragmentation is enabled
+     * \returns \c true if buffers may be relocated
+     */
+    bool isEnabled() const {
+      return m_budget != 0;
+    }
+
+    /**
+     * \brief Registers a relocatable buffer
+     *
+     * Does nothing if the buffer cannot be relocated, e.g.
+     * because it is host-visible or used with texel views.
+     * \param [in] buffer The buffer
+     */
+    void registerBuffer(
+            DxvkBuffer*           buffer);
+
+    /**
+     * \brief Unregisters a buffer
+     *
+     * Called when the buffer gets destroyed.
+     * \param [in] buffer The buffer
+     */
+    void unregisterBuffer(
+            DxvkBuffer*           buffer);
+
+    /**
+     * \brief Picks buffers to relocate
+     *
+     * Returns buffers from the chunk that is currently
+     * being evacuated, along with new storage for each
+     * of them. The caller must perform the relocation.
+     * Buffers that are in use by any command list are
+     * skipped, since the old backing resource is only
+     * kept alive by the command list performing the copy.
+     * \param [in] frameId Current frame number
+     * \returns Buffers to relocate
+     */
+    std::vector<DxvkBufferRelocation> getRelocations(
+            uint32_t              frameId);
+
+  private:
+
+    DxvkDevice*                     m_device;
+    DxvkMemoryAllocator*            m_memAlloc;
+    VkDeviceSize                    m_budget;
+    bool                            m_evacuate;
+
+    std::mutex                      m_mutex;
+    std::unordered_set<DxvkBuffer*> m_buffers;
+    std::unordered_set<DxvkBuffer*> m_demoted;
+
+    Rc<DxvkMemoryChunk>             m_chunk;
+
+    uint32_t                        m_frameId    = 0;
+    VkDeviceSize                    m_frameBytes = 0;
+    uint32_t                        m_scanFrame  = 0;
+
+    bool pickChunk(
+            uint32_t              frameId);
+
+    void pickChunkBuffers(
+            std::vector<Rc<DxvkBuffer>>& buffers);
+
+    void pickDemotedBuffers(
+            std::vector<Rc<DxvkBuffer>>& buffers);
+
+    static bool isDemoted(
+            DxvkBuffer*           buffer);
+
+  };
+
+}
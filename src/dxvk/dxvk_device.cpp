@@ -18,7 +18,8 @@ namespace dxvk {
     m_properties        (adapter->devicePropertiesExt()),
     m_perfHints         (getPerfHints()),
     m_objects           (this),
-    m_submissionQueue   (this) {
+    m_submissionQueue   (this),
+    m_csCapture         (DxvkCsCaptureWriter::create()) {
     auto queueFamilies = m_adapter->findQueueFamilies();
     m_queues.graphics = getQueue(queueFamilies.graphics, 0);
     m_queues.transfer = getQueue(queueFamilies.transfer, 0);
@@ -124,7 +125,10 @@ namespace dxvk {
   Rc<DxvkBuffer> DxvkDevice::createBuffer(
     const DxvkBufferCreateInfo& createInfo,
           VkMemoryPropertyFlags memoryType) {
-    return new DxvkBuffer(this, createInfo, m_objects.memoryManager(), memoryType);
+    Rc<DxvkBuffer> buffer = new DxvkBuffer(this, createInfo, m_objects.memoryManager(), memoryType);
+    m_objects.memoryDefrag().registerBuffer(buffer.ptr());
+    m_objects.discardRing().registerBuffer(buffer.ptr());
+    return buffer;
   }
   
   
@@ -170,12 +174,24 @@ namespace dxvk {
   
   DxvkStatCounters DxvkDevice::getStatCounters() {
     DxvkPipelineCount pipe = m_objects.pipelineManager().getPipelineCount();
+    DxvkMemoryLockStats mem = m_objects.memoryManager().getLockStats();
     
     DxvkStatCounters result;
     result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
     result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
     result.setCtr(DxvkStatCounter::PipeCompilerBusy,  m_objects.pipelineManager().isCompilingShaders());
     result.setCtr(DxvkStatCounter::GpuIdleTicks,      m_submissionQueue.gpuIdleTicks());
+    result.setCtr(DxvkStatCounter::MemLockCount,      mem.lockCount);
+    result.setCtr(DxvkStatCounter::MemLockContended,  mem.lockContended);
+    result.setCtr(DxvkStatCounter::MemCacheHits,      mem.cacheHits);
+
+    Rc<DxvkShaderCache> shaderCache = m_objects.pipelineManager().shaderCache();
+
+    if (shaderCache != nullptr) {
+      DxvkShaderCacheStats shaderStats = shaderCache->getStats();
+      result.setCtr(DxvkStatCounter::ShaderCacheHits,   shaderStats.hits);
+      result.setCtr(DxvkStatCounter::ShaderCacheMisses, shaderStats.misses);
+    }
 
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
@@ -183,6 +199,11 @@ namespace dxvk {
   }
   
   
+  std::vector<DxvkBufferRelocation> DxvkDevice::getBufferRelocations() {
+    return m_objects.memoryDefrag().getRelocations(getCurrentFrameId());
+  }
+
+
   DxvkMemoryStats DxvkDevice::getMemoryStats(uint32_t heap) {
     return m_objects.memoryManager().getMemoryStats(heap);
   }
@@ -201,6 +222,11 @@ namespace dxvk {
   void DxvkDevice::registerShader(const Rc<DxvkShader>& shader) {
     m_objects.pipelineManager().registerShader(shader);
   }
+
+
+  Rc<DxvkShaderCache> DxvkDevice::getShaderCache() {
+    return m_objects.pipelineManager().shaderCache();
+  }
   
   
   void DxvkDevice::presentImage(
@@ -213,6 +239,12 @@ namespace dxvk {
     presentInfo.presenter = presenter;
     presentInfo.waitSync  = semaphore;
     m_submissionQueue.present(presentInfo, status);
+
+    m_objects.memoryManager().updateBudget();
+    m_objects.memoryManager().trimChunks(getCurrentFrameId());
+
+    if (unlikely(m_csCapture != nullptr))
+      m_csCapture->endFrame();
     
     std::lock_guard<sync::Spinlock> statLock(m_statLock);
     m_statCounters.addCtr(DxvkStatCounter::QueuePresentCount, 1);
@@ -351,6 +351,16 @@ namespace dxvk {
      */
     DxvkStatCounters getStatCounters();
 
+    /**
+     * \brief Retrieves buffers to relocate
+     *
+     * Used by the CS thread's context to defragment
+     * device memory.
+     * Returns an empty list if defragmentation is off.
+     * \returns Buffers to move, along with new storage
+     */
+    std::vector<DxvkBufferRelocation> getBufferRelocations();
+
     /**
      * \brief Retrieves memors statistics
      *
@@ -380,6 +390,15 @@ namespace dxvk {
      */
     void registerShader(
       const Rc<DxvkShader>&         shader);
+
+    /**
+     * \brief Retrieves shader cache
+     * 
+     * Allows front-ends to skip compiling shaders
+     * that were compiled in a previous run.
+     * \returns Shader cache, or \c nullptr if disabled
+     */
+    Rc<DxvkShaderCache> getShaderCache();
     
     /**
      * \brief Presents a swap chain image
@@ -486,6 +505,8 @@ namespace dxvk {
     
     DxvkSubmissionQueue m_submissionQueue;
 
+    std::unique_ptr<DxvkCsCaptureWriter> m_csCapture;
+
     DxvkDevicePerfHints getPerfHints();
     
     void recycleCommandList(
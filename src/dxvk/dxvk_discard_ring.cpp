@@ -0,0 +1,136 @@
+#include "dxvk_device.h"
+#include "dxvk_discard_ring.h"
+
+namespace dxvk {
+
+  DxvkDiscardRing::DxvkDiscardRing(
+          DxvkDevice*           device,
+          DxvkMemoryAllocator&  memAlloc)
+  : m_device  (device),
+    m_memAlloc(&memAlloc) {
+
+  }
+
+
+  DxvkDiscardRing::~DxvkDiscardRing() {
+
+  }
+
+
+  void DxvkDiscardRing::registerBuffer(
+          DxvkBuffer*           buffer) {
+    if (!(buffer->memFlags() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+     || (buffer->info().usage & ~PageUsage)
+     || (buffer->info().size > MaxSliceSize))
+      return;
+
+    buffer->m_ring = this;
+  }
+
+
+  DxvkBufferSliceHandle DxvkDiscardRing::alloc(
+          VkMemoryPropertyFlags memFlags,
+          VkDeviceSize          align,
+          VkDeviceSize          length) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t poolIndex = getPool(memFlags);
+
+    Pool& pool = m_pools[poolIndex];
+    Page* page = pool.current;
+
+    VkDeviceSize offset = page ? dxvk::align(page->offset, align) : 0;
+
+    if (!page || offset + length > PageSize) {
+      // The page may already be idle if all slices
+      // allocated from it have been returned
+      if (page && !page->live)
+        releasePage(page);
+
+      page = getPage(poolIndex);
+      pool.current = page;
+      offset = 0;
+    }
+
+    page->offset = offset + length;
+    page->live  += 1;
+
+    return page->buffer->getSliceHandle(offset, length);
+  }
+
+
+  bool DxvkDiscardRing::free(
+    const DxvkBufferSliceHandle& slice) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto entry = m_pages.find(slice.handle);
+
+    if (entry == m_pages.end())
+      return false;
+
+    Page* page = entry->second.get();
+
+    if (!(--page->live) && page != m_pools[page->pool].current)
+      releasePage(page);
+
+    return true;
+  }
+
+
+  size_t DxvkDiscardRing::getPool(
+          VkMemoryPropertyFlags memFlags) {
+    for (size_t i = 0; i < m_pools.size(); i++) {
+      if (m_pools[i].memFlags == memFlags)
+        return i;
+    }
+
+    Pool pool;
+    pool.memFlags = memFlags;
+
+    m_pools.push_back(std::move(pool));
+    return m_pools.size() - 1;
+  }
+
+
+  DxvkDiscardRing::Page* DxvkDiscardRing::getPage(
+          size_t                pool) {
+    auto& freePages = m_pools[pool].freePages;
+
+    if (!freePages.empty()) {
+      Page* page = freePages.back();
+      freePages.pop_back();
+      return page;
+    }
+
+    DxvkBufferCreateInfo info;
+    info.size   = PageSize;
+    info.usage  = PageUsage;
+    info.stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    info.access = VK_ACCESS_MEMORY_READ_BIT
+                | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    auto page = std::make_unique<Page>();
+    page->buffer = new DxvkBuffer(m_device, info,
+      *m_memAlloc, m_pools[pool].memFlags);
+    page->pool = pool;
+
+    Page* result = page.get();
+    m_pages.insert({ page->buffer->getSliceHandle().handle, std::move(page) });
+    return result;
+  }
+
+
+  void DxvkDiscardRing::releasePage(
+          Page*                 page) {
+    auto& freePages = m_pools[page->pool].freePages;
+
+    if (freePages.size() >= MaxFreePages) {
+      m_pages.erase(page->buffer->getSliceHandle().handle);
+      return;
+    }
+
+    page->offset = 0;
+    freePages.push_back(page);
+  }
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_buffer.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Discard ring
+   *
+   * Device-wide allocator for small, host-visible buffers
+   * that get discarded frequently, such as dynamic constant
+   * and vertex buffers. Rather than growing a slice pool
+   * for each individual buffer, slices are sub-allocated
+   * linearly from large, persistently mapped pages.
+   *
+   * Slices are returned to the ring by the owning buffer
+   * once the command list that last used them completes,
+   * and a page gets reused as soon as all slices that were
+   * allocated from it have been returned.
+   */
+  class DxvkDiscardRing {
+    /// Size of each page, in bytes
+    constexpr static VkDeviceSize PageSize     = 4 << 20;
+    /// Maximum size of buffers to allocate from the ring
+    constexpr static VkDeviceSize MaxSliceSize = 64 << 10;
+    /// Maximum number of idle pages to keep per pool
+    constexpr static size_t       MaxFreePages = 4;
+    /// Buffer usage flags supported by ring pages
+    constexpr static VkBufferUsageFlags PageUsage
+      = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+      | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+      | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
+      | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+      | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+      | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+  public:
+
+    DxvkDiscardRing(
+            DxvkDevice*           device,
+            DxvkMemoryAllocator&  memAlloc);
+
+    ~DxvkDiscardRing();
+
+    /**
+     * \brief Registers a buffer
+     *
+     * Enables ring allocations for the given buffer if
+     * it is small, host-visible and only used in ways
+     * that ring pages support. Texel buffers are not
+     * supported since views are cached per slice.
+     * \param [in] buffer The buffer
+     */
+    void registerBuffer(
+            DxvkBuffer*           buffer);
+
+    /**
+     * \brief Allocates a slice
+     *
+     * \param [in] memFlags Memory property flags
+     * \param [in] align Slice alignment
+     * \param [in] length Slice length
+     * \returns Slice handle within a ring page
+     */
+    DxvkBufferSliceHandle alloc(
+            VkMemoryPropertyFlags memFlags,
+            VkDeviceSize          align,
+            VkDeviceSize          length);
+
+    /**
+     * \brief Returns a slice to the ring
+     *
+     * Must only be called once the GPU has finished
+     * using the slice. Slices that were not allocated
+     * from the ring are ignored.
+     * \param [in] slice Slice handle
+     * \returns \c true if the slice belongs to the ring
+     */
+    bool free(
+      const DxvkBufferSliceHandle& slice);
+
+  private:
+
+    struct Page {
+      Rc<DxvkBuffer>  buffer;
+      size_t          pool    = 0;
+      VkDeviceSize    offset  = 0;
+      uint32_t        live    = 0;
+    };
+
+    struct Pool {
+      VkMemoryPropertyFlags memFlags = 0;
+      Page*                 current  = nullptr;
+      std::vector<Page*>    freePages;
+    };
+
+    DxvkDevice*               m_device;
+    DxvkMemoryAllocator*      m_memAlloc;
+
+    std::mutex                m_mutex;
+    std::vector<Pool>         m_pools;
+
+    std::unordered_map<VkBuffer, std::unique_ptr<Page>> m_pages;
+
+    size_t getPool(
+            VkMemoryPropertyFlags memFlags);
+
+    Page* getPage(
+            size_t                pool);
+
+    void releasePage(
+            Page*                 page);
+
+  };
+
+}
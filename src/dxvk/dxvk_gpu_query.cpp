@@ -351,6 +351,17 @@ namespace dxvk {
   }
 
 
+  bool DxvkGpuQueryManager::hasEnabledQueries(
+          VkQueryType           type) const {
+    for (const auto& query : m_activeQueries) {
+      if (query->type() == type)
+        return true;
+    }
+
+    return false;
+  }
+
+
   void DxvkGpuQueryManager::beginQueries(
     const Rc<DxvkCommandList>&  cmd,
           VkQueryType           type) {
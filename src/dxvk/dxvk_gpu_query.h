@@ -370,6 +370,16 @@ namespace dxvk {
       const Rc<DxvkCommandList>&  cmd,
       const Rc<DxvkGpuQuery>&     query);
 
+    /**
+     * \brief Checks for enabled queries of a given type
+     *
+     * \param [in] type Query type
+     * \returns \c true if any query of the given
+     *    type is currently enabled
+     */
+    bool hasEnabledQueries(
+            VkQueryType           type) const;
+
     /**
      * \brief Begins queries of a given type
      * 
@@ -62,24 +62,70 @@ namespace dxvk {
 
   VkPipeline DxvkGraphicsPipeline::getPipelineHandle(
     const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPass*                renderPass) {
-    DxvkGraphicsPipelineInstance* instance = nullptr;
+    const DxvkRenderPass*                renderPass,
+          bool                           async,
+          bool&                          pending) {
+    // Asynchronous compilation requires the worker
+    // threads of the state cache, which may be disabled
+    async &= m_pipeMgr->m_stateCache != nullptr;
+
+    // Skipping draws with side effects would lose
+    // storage or transform feedback writes entirely
+    async &= !m_flags.any(
+      DxvkGraphicsPipelineFlag::HasStorageDescriptors,
+      DxvkGraphicsPipelineFlag::HasTransformFeedback);
+
+    DxvkGraphicsPipelineInstance* instance = this->findInstance(state, renderPass);
+
+    if (unlikely(instance == nullptr)) {
+      bool created = false;
+
+      { std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+        // Another thread may have added the instance
+        // after our lookup, so we need to check again
+        instance = this->findInstance(state, renderPass);
+
+        if (!instance) {
+          instance = this->createInstance(state, renderPass, async);
+          created  = instance != nullptr;
+        }
+      }
 
-    { std::lock_guard<sync::Spinlock> lock(m_mutex);
-    
-      instance = this->findInstance(state, renderPass);
-      
-      if (instance)
-        return instance->pipeline();
-      
-      instance = this->createInstance(state, renderPass);
+      if (!instance)
+        return VK_NULL_HANDLE;
+
+      if (created) {
+        if (async)
+          m_pipeMgr->m_stateCache->compileGraphicsPipeline(this, instance);
+        else
+          this->writePipelineStateToCache(state, renderPass->format());
+      }
     }
-    
-    if (!instance)
-      return VK_NULL_HANDLE;
 
-    this->writePipelineStateToCache(state, renderPass->format());
-    return instance->pipeline();
+    // Let the state cache know which pipelines are used
+    // so that it can compile them first on the next run
+    if (unlikely(!instance->addUse()) && m_pipeMgr->m_stateCache != nullptr)
+      m_pipeMgr->m_stateCache->registerUse(this, instance);
+
+    VkPipeline pipeline = instance->pipeline();
+
+    // The instance may have been queued by an earlier async
+    // lookup, but the caller cannot skip the draw right now.
+    // Compile it here unless a worker is already doing so.
+    if (unlikely(!pipeline && !async && instance->isPending())) {
+      if (instance->claim()) {
+        this->compileClaimedInstance(instance);
+      } else {
+        while (instance->isPending())
+          dxvk::this_thread::yield();
+      }
+
+      pipeline = instance->pipeline();
+    }
+
+    pending = pipeline == VK_NULL_HANDLE && instance->isPending();
+    return pipeline;
   }
 
 
@@ -89,34 +135,61 @@ namespace dxvk {
     std::lock_guard<sync::Spinlock> lock(m_mutex);
 
     if (!this->findInstance(state, renderPass))
-      this->createInstance(state, renderPass);
+      this->createInstance(state, renderPass, false);
+  }
+
+
+  void DxvkGraphicsPipeline::compileInstance(
+          DxvkGraphicsPipelineInstance*  instance) {
+    if (instance->claim())
+      this->compileClaimedInstance(instance);
+  }
+
+
+  void DxvkGraphicsPipeline::compileClaimedInstance(
+          DxvkGraphicsPipelineInstance*  instance) {
+    const DxvkGraphicsPipelineStateInfo& state = instance->state();
+    const DxvkRenderPass* renderPass = instance->renderPass();
+
+    VkPipeline pipeline = this->createPipeline(state, renderPass);
+    instance->setPipeline(pipeline);
+
+    if (!pipeline)
+      return;
+
+    m_pipeMgr->m_numGraphicsPipelines += 1;
+    this->writePipelineStateToCache(state, renderPass->format());
   }
 
 
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::createInstance(
     const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPass*                renderPass) {
+    const DxvkRenderPass*                renderPass,
+          bool                           async) {
     // If the pipeline state vector is invalid, don't try
     // to create a new pipeline, it won't work anyway.
     if (!this->validatePipelineState(state))
       return nullptr;
 
-    VkPipeline newPipelineHandle = this->createPipeline(state, renderPass);
+    // Pending instances get their pipeline handle
+    // once a worker thread has compiled them
+    VkPipeline newPipelineHandle = VK_NULL_HANDLE;
 
-    m_pipeMgr->m_numGraphicsPipelines += 1;
-    return &m_pipelines.emplace_back(state, renderPass, newPipelineHandle);
+    if (!async) {
+      newPipelineHandle = this->createPipeline(state, renderPass);
+      m_pipeMgr->m_numGraphicsPipelines += 1;
+    }
+
+    auto instance = &m_pipelines.emplace_back(state, state.hash(), renderPass, newPipelineHandle, async);
+    m_lookupTable.insert(instance);
+    return instance;
   }
   
   
   DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
     const DxvkGraphicsPipelineStateInfo& state,
     const DxvkRenderPass*                renderPass) {
-    for (auto& instance : m_pipelines) {
-      if (instance.isCompatible(state, renderPass))
-        return &instance;
-    }
-    
-    return nullptr;
+    return m_lookupTable.find(state, renderPass);
   }
   
   
@@ -408,6 +481,8 @@ namespace dxvk {
       this->logPipelineState(LogLevel::Error, state);
       return VK_NULL_HANDLE;
     }
+
+    m_pipeMgr->m_cache->notifyUpdate();
     
     if (Logger::logLevel() <= LogLevel::Debug) {
       t1 = dxvk::high_resolution_clock::now();
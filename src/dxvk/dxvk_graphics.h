@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <mutex>
 
 #include "dxvk_bind_mask.h"
@@ -80,16 +83,24 @@ namespace dxvk {
 
     DxvkGraphicsPipelineInstance()
     : m_stateVector (),
+      m_stateHash   (0),
       m_renderPass  (VK_NULL_HANDLE),
-      m_pipeline    (VK_NULL_HANDLE) { }
+      m_pipeline    (VK_NULL_HANDLE),
+      m_pending     (false),
+      m_claimed     (false) { }
 
     DxvkGraphicsPipelineInstance(
       const DxvkGraphicsPipelineStateInfo&  state,
+            size_t                          hash,
       const DxvkRenderPass*                 rp,
-            VkPipeline                      pipe)
+            VkPipeline                      pipe,
+            bool                            pending)
     : m_stateVector (state),
+      m_stateHash   (hash),
       m_renderPass  (rp),
-      m_pipeline    (pipe) { }
+      m_pipeline    (pipe),
+      m_pending     (pending),
+      m_claimed     (!pending) { }
 
     /**
      * \brief Checks for matching pipeline state
@@ -107,17 +118,238 @@ namespace dxvk {
 
     /**
      * \brief Retrieves pipeline
+     *
+     * May be \c VK_NULL_HANDLE if the pipeline
+     * is still being compiled asynchronously.
      * \returns The pipeline handle
      */
     VkPipeline pipeline() const {
-      return m_pipeline;
+      return m_pipeline.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Checks whether the pipeline is pending
+     *
+     * Only \c true while a worker thread is still
+     * compiling the pipeline. If this returns \c false
+     * and the pipeline handle is \c VK_NULL_HANDLE,
+     * pipeline creation failed.
+     * \returns \c true if compilation is pending
+     */
+    bool isPending() const {
+      return m_pending.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Claims a pending instance for compilation
+     *
+     * Only one thread may compile a pending instance.
+     * This succeeds exactly once, for the thread that
+     * must then compile the pipeline and set its handle.
+     * \returns \c true if the caller must compile it
+     */
+    bool claim() {
+      return !m_claimed.exchange(true, std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Sets pipeline handle
+     *
+     * Publishes the handle of an asynchronously
+     * compiled pipeline to other threads and marks
+     * the instance as no longer pending. The handle
+     * may be \c VK_NULL_HANDLE if compilation failed.
+     * \param [in] pipe The pipeline handle
+     */
+    void setPipeline(VkPipeline pipe) {
+      m_pipeline.store(pipe, std::memory_order_release);
+      m_pending.store(false, std::memory_order_release);
+    }
+
+    /**
+     * \brief Retrieves state vector
+     * \returns Pipeline state vector
+     */
+    const DxvkGraphicsPipelineStateInfo& state() const {
+      return m_stateVector;
+    }
+
+    /**
+     * \brief Retrieves render pass
+     * \returns Render pass
+     */
+    const DxvkRenderPass* renderPass() const {
+      return m_renderPass;
+    }
+
+    /**
+     * \brief Retrieves state hash
+     * \returns Hash of the state vector
+     */
+    size_t hash() const {
+      return m_stateHash;
+    }
+
+    /**
+     * \brief Records use of the instance
+     * \returns Use count prior to this call
+     */
+    uint32_t addUse() {
+      return m_useCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * \brief Queries use count
+     *
+     * Number of times the pipeline was bound.
+     * \returns Use count
+     */
+    uint32_t useCount() const {
+      return m_useCount.load(std::memory_order_relaxed);
     }
 
   private:
 
     DxvkGraphicsPipelineStateInfo m_stateVector;
+    size_t                        m_stateHash;
     const DxvkRenderPass*         m_renderPass;
-    VkPipeline                    m_pipeline;
+    std::atomic<VkPipeline>       m_pipeline;
+    std::atomic<bool>             m_pending;
+    std::atomic<bool>             m_claimed;
+    std::atomic<uint32_t>         m_useCount = { 0u };
+
+  };
+
+
+  /**
+   * \brief Graphics pipeline instance table
+   *
+   * Open-addressing hash table that maps pipeline state
+   * vectors to pipeline instances. Lookups do not take
+   * any locks, insertions must be externally synchronized.
+   * Published slots are never modified, and tables that
+   * got replaced by a larger one are kept alive until the
+   * table gets destroyed, so that concurrent readers can
+   * safely finish their lookup on an outdated table. Such
+   * a lookup may miss an instance that was just added, so
+   * callers must look up the instance again while holding
+   * the lock before inserting a new one.
+   */
+  class DxvkGraphicsPipelineInstanceTable {
+    // Hashing the state vector costs about as much as a few
+    // comparisons, so small tables are searched linearly.
+    constexpr static size_t MinCapacity = 16;
+
+    struct Table {
+      Table(size_t capacity)
+      : mask(capacity - 1),
+        slots(new std::atomic<DxvkGraphicsPipelineInstance*>[capacity]) {
+        for (size_t i = 0; i < capacity; i++)
+          slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+
+      size_t mask;
+      std::unique_ptr<std::atomic<DxvkGraphicsPipelineInstance*>[]> slots;
+    };
+
+  public:
+
+    DxvkGraphicsPipelineInstanceTable() {
+      m_table.store(&m_tables.emplace_back(MinCapacity), std::memory_order_relaxed);
+    }
+
+    DxvkGraphicsPipelineInstanceTable             (const DxvkGraphicsPipelineInstanceTable&) = delete;
+    DxvkGraphicsPipelineInstanceTable& operator = (const DxvkGraphicsPipelineInstanceTable&) = delete;
+
+    /**
+     * \brief Looks up pipeline instance
+     *
+     * Safe to call concurrently with \c insert.
+     * \param [in] state Pipeline state vector
+     * \param [in] rp Render pass
+     * \returns Pipeline instance, or \c nullptr
+     */
+    DxvkGraphicsPipelineInstance* find(
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPass*                 rp) const {
+      const Table* table = m_table.load(std::memory_order_acquire);
+
+      if (table->mask < MinCapacity) {
+        for (size_t i = 0; i <= table->mask; i++) {
+          DxvkGraphicsPipelineInstance* instance =
+            table->slots[i].load(std::memory_order_acquire);
+
+          if (instance && instance->isCompatible(state, rp))
+            return instance;
+        }
+
+        return nullptr;
+      }
+
+      size_t hash = state.hash();
+
+      for (size_t i = hash; ; i++) {
+        DxvkGraphicsPipelineInstance* instance =
+          table->slots[i & table->mask].load(std::memory_order_acquire);
+
+        if (!instance)
+          return nullptr;
+
+        if (instance->hash() == hash && instance->isCompatible(state, rp))
+          return instance;
+      }
+    }
+
+    /**
+     * \brief Adds pipeline instance
+     *
+     * Grows the table if necessary. Must not be called
+     * concurrently with other calls to \c insert.
+     * \param [in] instance The instance to add. Must
+     *    stay valid for the lifetime of the table.
+     */
+    void insert(
+            DxvkGraphicsPipelineInstance*   instance) {
+      Table* table = m_table.load(std::memory_order_relaxed);
+
+      // Keep the load factor below 1/2 so that
+      // probe sequences for misses stay short
+      if (2 * (m_count + 1) > table->mask + 1) {
+        Table* newTable = &m_tables.emplace_back(2 * (table->mask + 1));
+
+        for (size_t i = 0; i <= table->mask; i++) {
+          auto entry = table->slots[i].load(std::memory_order_relaxed);
+
+          if (entry)
+            insertInto(newTable, entry);
+        }
+
+        m_table.store(newTable, std::memory_order_release);
+        table = newTable;
+      }
+
+      insertInto(table, instance);
+      m_count += 1;
+    }
+
+  private:
+
+    std::atomic<Table*> m_table = { nullptr };
+    std::deque<Table>   m_tables;
+    size_t              m_count = 0;
+
+    static void insertInto(
+            Table*                          table,
+            DxvkGraphicsPipelineInstance*   instance) {
+      for (size_t i = instance->hash(); ; i++) {
+        auto& slot = table->slots[i & table->mask];
+
+        if (!slot.load(std::memory_order_relaxed)) {
+          slot.store(instance, std::memory_order_release);
+          return;
+        }
+      }
+    }
 
   };
 
@@ -183,13 +415,30 @@ namespace dxvk {
      * 
      * Retrieves a pipeline handle for the given pipeline
      * state. If necessary, a new pipeline will be created.
+     * In async mode, missing pipelines are queued for
+     * compilation on the state cache worker threads, and
+     * no handle is returned until compilation finishes.
+     * Pipelines with side effects, i.e. ones that use
+     * storage descriptors or transform feedback, are
+     * always compiled synchronously since skipping draws
+     * would change the rendering results. In synchronous
+     * mode, this never returns a pending pipeline, and
+     * will compile or wait for instances that were queued
+     * by an earlier asynchronous lookup.
      * \param [in] state Pipeline state vector
      * \param [in] renderPass The render pass
-     * \returns Pipeline handle
+     * \param [in] async Compile missing pipelines asynchronously
+     * \param [out] pending Set to \c true if the pipeline
+     *    is still being compiled asynchronously, and to
+     *    \c false if it is ready or failed to compile
+     * \returns Pipeline handle, or \c VK_NULL_HANDLE if
+     *    the pipeline is pending or cannot be created
      */
     VkPipeline getPipelineHandle(
       const DxvkGraphicsPipelineStateInfo&    state,
-      const DxvkRenderPass*                   renderPass);
+      const DxvkRenderPass*                   renderPass,
+            bool                              async,
+            bool&                             pending);
     
     /**
      * \brief Compiles a pipeline
@@ -203,6 +452,18 @@ namespace dxvk {
       const DxvkGraphicsPipelineStateInfo&    state,
       const DxvkRenderPass*                   renderPass);
     
+    /**
+     * \brief Compiles a pending pipeline instance
+     * 
+     * Called by the worker threads for instances that
+     * were created by an asynchronous pipeline lookup.
+     * Does nothing if another thread already claimed
+     * the instance for synchronous compilation.
+     * \param [in] instance The pipeline instance
+     */
+    void compileInstance(
+            DxvkGraphicsPipelineInstance*     instance);
+    
   private:
     
     Rc<vk::DeviceFn>            m_vkd;
@@ -219,14 +480,20 @@ namespace dxvk {
     DxvkGraphicsPipelineFlags           m_flags;
     DxvkGraphicsCommonPipelineStateInfo m_common;
     
-    // List of pipeline instances, shared between threads
+    // List of pipeline instances, shared between threads.
+    // The lock only needs to be taken to add instances.
     alignas(CACHE_LINE_SIZE) sync::Spinlock   m_mutex;
-    std::vector<DxvkGraphicsPipelineInstance> m_pipelines;
+    std::deque<DxvkGraphicsPipelineInstance>  m_pipelines;
+    DxvkGraphicsPipelineInstanceTable         m_lookupTable;
     
     DxvkGraphicsPipelineInstance* createInstance(
       const DxvkGraphicsPipelineStateInfo& state,
-      const DxvkRenderPass*                renderPass);
+      const DxvkRenderPass*                renderPass,
+            bool                           async);
     
+    void compileClaimedInstance(
+            DxvkGraphicsPipelineInstance*     instance);
+
     DxvkGraphicsPipelineInstance* findInstance(
       const DxvkGraphicsPipelineStateInfo& state,
       const DxvkRenderPass*                renderPass);
@@ -648,6 +648,10 @@ namespace dxvk {
       return !bit::bcmpeq(this, &other);
     }
 
+    size_t hash() const {
+      return size_t(bit::bhash(this));
+    }
+
     bool useDynamicStencilRef() const {
       return ds.enableStencilTest();
     }
@@ -11,6 +11,7 @@ namespace dxvk {
           VkDeviceMemory        memory,
           VkDeviceSize          offset,
           VkDeviceSize          length,
+          uint32_t              block,
           void*                 mapPtr)
   : m_alloc   (alloc),
     m_chunk   (chunk),
@@ -18,6 +19,7 @@ namespace dxvk {
     m_memory  (memory),
     m_offset  (offset),
     m_length  (length),
+    m_block   (block),
     m_mapPtr  (mapPtr) { }
   
   
@@ -28,6 +30,7 @@ namespace dxvk {
     m_memory  (std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE))),
     m_offset  (std::exchange(other.m_offset, 0)),
     m_length  (std::exchange(other.m_length, 0)),
+    m_block   (std::exchange(other.m_block,  ~0u)),
     m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)) { }
   
   
@@ -39,6 +42,7 @@ namespace dxvk {
     m_memory  = std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE));
     m_offset  = std::exchange(other.m_offset, 0);
     m_length  = std::exchange(other.m_length, 0);
+    m_block   = std::exchange(other.m_block,  ~0u);
     m_mapPtr  = std::exchange(other.m_mapPtr, nullptr);
     return *this;
   }
@@ -59,15 +63,16 @@ namespace dxvk {
           DxvkMemoryAllocator*  alloc,
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory)
-  : m_alloc(alloc), m_type(type), m_memory(memory) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory),
+    m_allocator(memory.memSize) {
+
   }
   
   
   DxvkMemoryChunk::~DxvkMemoryChunk() {
-    // This call is technically not thread-safe, but it
-    // doesn't need to be since we don't free chunks
+    // This does not need to be synchronized with
+    // the memory type since it only updates atomic
+    // heap statistics and frees the memory object
     m_alloc->freeDeviceMemory(m_type, m_memory);
   }
   
@@ -79,93 +84,143 @@ namespace dxvk {
           float                 priority) {
     // Property flags must be compatible. This could
     // be refined a bit in the future if necessary.
-    if (m_memory.memFlags != flags
-     || m_memory.priority != priority)
-      return DxvkMemory();
-    
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
+    if (!this->isCompatible(flags, priority) || m_evacuating)
       return DxvkMemory();
     
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
-    
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    DxvkRange range = m_allocator.alloc(size, align);
+
+    if (!range.length)
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
     // Create the memory object with the aligned slice
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
-      reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
+      m_memory.memHandle, range.offset, range.length, range.block,
+      reinterpret_cast<char*>(m_memory.memPointer) + range.offset);
   }
   
   
   void DxvkMemoryChunk::free(
-          VkDeviceSize  offset,
-          VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+          uint32_t      block) {
+    m_allocator.free(block);
   }
   
   
+  bool DxvkMemoryCache::store(
+    const DxvkMemoryCacheEntry&   entry,
+          DxvkMemoryCacheEntry&   evicted) {
+    std::lock_guard<sync::Spinlock> lock(m_lock);
+
+    uint32_t cls = getClass(entry.length);
+    auto& entries = m_entries[cls];
+
+    if (m_counts[cls] < EntryCount) {
+      entries[m_counts[cls]++] = entry;
+      return false;
+    }
+
+    // Evict the oldest entry, which is the first. The
+    // caller may pass the same object for both entries.
+    DxvkMemoryCacheEntry oldest = entries[0];
+
+    for (uint32_t i = 1; i < EntryCount; i++)
+      entries[i - 1] = entries[i];
+
+    entries[EntryCount - 1] = entry;
+    evicted = oldest;
+    return true;
+  }
+
+
+  bool DxvkMemoryCache::take(
+          VkMemoryPropertyFlags   flags,
+          VkDeviceSize            length,
+          VkDeviceSize            align,
+          float                   priority,
+          DxvkMemoryCacheEntry&   entry) {
+    std::lock_guard<sync::Spinlock> lock(m_lock);
+
+    uint32_t cls = getClass(length);
+    auto& entries = m_entries[cls];
+
+    // Prefer the most recently freed slice
+    for (uint32_t i = m_counts[cls]; i > 0; i--) {
+      const auto& e = entries[i - 1];
+
+      if (e.length >= length && !(e.offset & (align - 1))
+       && e.chunk->isCompatible(flags, priority)) {
+        entry = e;
+
+        for (uint32_t j = i; j < m_counts[cls]; j++)
+          entries[j - 1] = entries[j];
+
+        m_counts[cls] -= 1;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+
+  void DxvkMemoryCache::flush(
+          std::vector<DxvkMemoryCacheEntry>& entries) {
+    std::lock_guard<sync::Spinlock> lock(m_lock);
+
+    for (uint32_t i = 0; i < ClassCount; i++) {
+      for (uint32_t j = 0; j < m_counts[i]; j++)
+        entries.push_back(m_entries[i][j]);
+
+      m_counts[i] = 0;
+    }
+  }
+
+
+  uint32_t DxvkMemoryCache::getClass(VkDeviceSize length) {
+    uint32_t bits = 32 - bit::lzcnt(uint32_t(length - 1));
+    return bits > MinClassBits ? bits - MinClassBits : 0;
+  }
+
+
   DxvkMemoryAllocator::DxvkMemoryAllocator(const DxvkDevice* device)
-  : m_vkd             (device->vkd()),
-    m_device          (device),
-    m_devProps        (device->adapter()->deviceProperties()),
-    m_memProps        (device->adapter()->memoryProperties()) {
+  : DxvkMemoryAllocator(device->vkd(), device->config(),
+      device->adapter()->deviceProperties(),
+      device->adapter()->memoryProperties()) {
+    m_device            = device;
+    m_useMemoryPriority = device->features().extMemoryPriority.memoryPriority;
+
+    std::string tracePath = DxvkMemoryTraceWriter::getTracePath();
+
+    if (!tracePath.empty())
+      m_trace = std::make_unique<DxvkMemoryTraceWriter>(tracePath, m_memProps);
+  }
+
+
+  DxvkMemoryAllocator::DxvkMemoryAllocator(
+    const Rc<vk::DeviceFn>&                 vkd,
+    const DxvkOptions&                      options,
+    const VkPhysicalDeviceProperties&       devProps,
+    const VkPhysicalDeviceMemoryProperties& memProps)
+  : m_vkd             (vkd),
+    m_device          (nullptr),
+    m_devProps        (devProps),
+    m_memProps        (memProps),
+    m_budgetThreshold (uint32_t(std::max(options.memoryBudgetThreshold, 0))),
+    m_trimSpareChunks (uint32_t(std::max(options.memorySpareChunks, 0))),
+    m_trimFrames      (uint32_t(std::max(options.memoryTrimFrames, 0))),
+    m_chunkSize       (VkDeviceSize(std::max(options.memoryChunkSize, 0)) << 20) {
+    bool isUnifiedMemoryArchitecture = true;
+
+    for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++)
+      isUnifiedMemoryArchitecture &= (m_memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+
     for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
       m_memHeaps[i].properties = m_memProps.memoryHeaps[i];
-      m_memHeaps[i].stats      = DxvkMemoryStats { 0, 0 };
       m_memHeaps[i].budget     = 0;
 
       /* Target 80% of a heap on systems where we want
        * to avoid oversubscribing memory heaps */
       if ((m_memProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
-       && (m_device->isUnifiedMemoryArchitecture()))
+       && (isUnifiedMemoryArchitecture))
         m_memHeaps[i].budget = (8 * m_memProps.memoryHeaps[i].size) / 10;
     }
     
@@ -180,7 +235,7 @@ namespace dxvk {
     /* Work around an issue on Nvidia drivers where using the entire
      * device_local | host_visible heap can cause crashes, presumably
      * due to subsequent internal driver allocations failing */
-    if (m_device->properties().core.properties.vendorID == uint16_t(DxvkGpuVendor::Nvidia)) {
+    if (m_devProps.vendorID == uint16_t(DxvkGpuVendor::Nvidia)) {
       for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
         constexpr VkMemoryPropertyFlags flags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
@@ -202,7 +257,46 @@ namespace dxvk {
     const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
           VkMemoryPropertyFlags             flags,
           float                             priority) {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    DxvkMemory result = this->allocMemory(req,
+      dedAllocReq, dedAllocInfo, flags, priority);
+
+    if (unlikely(m_trace != nullptr)) {
+      DxvkMemoryTraceEntry entry = { };
+      entry.memTypeId       = uint8_t(result.m_type->memTypeId);
+      entry.dedicated       = (dedAllocReq.prefersDedicatedAllocation  ? DxvkMemoryTracePrefersDedicated  : 0)
+                            | (dedAllocReq.requiresDedicatedAllocation ? DxvkMemoryTraceRequiresDedicated : 0);
+      entry.alignLog2       = uint8_t(bit::tzcnt(uint32_t(req->alignment)));
+      entry.frameId         = m_device->getCurrentFrameId();
+      entry.memoryTypeBits  = req->memoryTypeBits;
+      entry.memFlags        = flags;
+      entry.priority        = priority;
+      entry.size            = req->size;
+
+      m_trace->recordAlloc(entry, result.m_memory, result.m_offset);
+    }
+
+    return result;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::allocMemory(
+    const VkMemoryRequirements*             req,
+    const VkMemoryDedicatedRequirements&    dedAllocReq,
+    const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) {
+    // If device-local memory is running low, place low-priority
+    // resources in system memory before we start oversubscribing
+    // the heap. The defragmenter may move them back later on.
+    if (this->shouldDemote(req, flags, priority)) {
+      auto demotedDedAllocPtr = dedAllocReq.requiresDedicatedAllocation ? &dedAllocInfo : nullptr;
+
+      DxvkMemory result = this->tryAlloc(req, demotedDedAllocPtr,
+        flags & ~VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, priority, true);
+
+      if (result)
+        return result;
+    }
 
     // Try to allocate from a memory type which supports the given flags exactly
     auto dedAllocPtr = dedAllocReq.prefersDedicatedAllocation ? &dedAllocInfo : nullptr;
@@ -227,7 +321,12 @@ namespace dxvk {
     }
     
     if (!result) {
-      DxvkAdapterMemoryInfo memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
+      bool hasDriverInfo = m_device && m_device->extensions().extMemoryBudget;
+
+      DxvkAdapterMemoryInfo memHeapInfo = { };
+
+      if (hasDriverInfo)
+        memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
 
       Logger::err(str::format(
         "DxvkMemoryAllocator: Memory allocation failed",
@@ -238,9 +337,9 @@ namespace dxvk {
 
       for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
         Logger::err(str::format("Heap ", i, ": ",
-          (m_memHeaps[i].stats.memoryAllocated >> 20), " MB allocated, ",
-          (m_memHeaps[i].stats.memoryUsed      >> 20), " MB used, ",
-          m_device->extensions().extMemoryBudget
+          (m_memHeaps[i].memoryAllocated.load() >> 20), " MB allocated, ",
+          (m_memHeaps[i].memoryUsed.load()      >> 20), " MB used, ",
+          hasDriverInfo
             ? str::format(
                 (memHeapInfo.heaps[i].memoryAllocated >> 20), " MB allocated (driver), ",
                 (memHeapInfo.heaps[i].memoryBudget    >> 20), " MB budget (driver), ",
@@ -256,18 +355,207 @@ namespace dxvk {
   }
   
   
+  DxvkMemoryLockStats DxvkMemoryAllocator::getLockStats() const {
+    DxvkMemoryLockStats result;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      result.lockCount     += m_memTypes[i].lockCount.load();
+      result.lockContended += m_memTypes[i].lockContended.load();
+      result.cacheHits     += m_memTypes[i].cacheHits.load();
+    }
+
+    return result;
+  }
+
+
+  void DxvkMemoryAllocator::updateBudget() {
+    if (!m_budgetThreshold || !m_device)
+      return;
+
+    DxvkAdapterMemoryInfo memHeapInfo = m_device->adapter()->getMemoryHeapInfo();
+
+    for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
+      if (!(m_memHeaps[i].properties.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+        continue;
+
+      VkDeviceSize budget = memHeapInfo.heaps[i].memoryBudget;
+      VkDeviceSize usage  = memHeapInfo.heaps[i].memoryAllocated;
+      VkDeviceSize limit  = (budget * m_budgetThreshold) / 100;
+
+      // Only leave the pressure state once usage has dropped
+      // well below the limit, so that we do not keep moving
+      // resources back and forth between memory types
+      bool wasUnderPressure = m_memHeaps[i].underPressure.load();
+      bool isUnderPressure  = wasUnderPressure
+        ? usage + budget / 20 > limit
+        : usage > limit;
+
+      if (isUnderPressure != wasUnderPressure) {
+        m_memHeaps[i].underPressure = isUnderPressure;
+
+        Logger::info(str::format("DxvkMemoryAllocator: Heap ", i,
+          isUnderPressure ? " over" : " below", " budget threshold (",
+          usage >> 20, " MB used, ", budget >> 20, " MB budget)"));
+      }
+    }
+  }
+
+
+  bool DxvkMemoryAllocator::isUnderPressure() const {
+    for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
+      if (m_memHeaps[i].underPressure.load())
+        return true;
+    }
+
+    return false;
+  }
+
+
+  void DxvkMemoryAllocator::trimChunks(
+          uint32_t              frameId) {
+    if (!m_trimFrames || int32_t(frameId - m_trimFrameId) < int32_t(TrimInterval))
+      return;
+
+    m_trimFrameId = frameId;
+
+    auto now = high_resolution_clock::now();
+
+    std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> idle = { };
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      DxvkMemoryType* type = &m_memTypes[i];
+
+      // Slices in the caches keep their chunks alive, return
+      // them first so that we can reliably detect empty chunks
+      this->flushCaches(type);
+
+      auto lock = this->lockType(type);
+
+      uint32_t spareCount = 0;
+
+      for (auto c = type->chunks.begin(); c != type->chunks.end(); ) {
+        DxvkMemoryChunk* chunk = c->ptr();
+
+        if (chunk->used() || chunk->isEvacuating()) {
+          chunk->m_idle = false;
+          c++;
+          continue;
+        }
+
+        if (!chunk->m_idle) {
+          chunk->m_idle      = true;
+          chunk->m_idleFrame = frameId;
+          chunk->m_idleTime  = now;
+        }
+
+        // Keep chunks that have not been idle for long enough, as
+        // well as a few spare chunks in case the app allocates
+        // more resources soon, e.g. when loading a new level.
+        bool release = spareCount >= m_trimSpareChunks
+          && frameId - chunk->m_idleFrame >= m_trimFrames
+          && now - chunk->m_idleTime >= TrimDelay;
+
+        if (release) {
+          type->heap->memoryReleased += chunk->size();
+          c = type->chunks.erase(c);
+        } else {
+          idle[type->heapId] += chunk->size();
+          spareCount += 1;
+          c++;
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++)
+      m_memHeaps[i].memoryIdle = idle[i];
+  }
+
+
+  Rc<DxvkMemoryChunk> DxvkMemoryAllocator::beginEvacuation(
+    const std::unordered_map<DxvkMemoryChunk*, VkDeviceSize>& movable,
+          float                             maxUsage) {
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      DxvkMemoryType* type = &m_memTypes[i];
+
+      // Cached slices count as used, so return them
+      // first in order to get accurate chunk stats
+      this->flushCaches(type);
+
+      auto lock = this->lockType(type);
+
+      Rc<DxvkMemoryChunk> best;
+
+      for (const auto& chunk : type->chunks) {
+        VkDeviceSize used = chunk->used();
+
+        if (!used || chunk->isEvacuating()
+         || double(used) > double(chunk->size()) * double(maxUsage))
+          continue;
+
+        // We can only empty the chunk if all
+        // of its contents can be relocated
+        auto entry = movable.find(chunk.ptr());
+
+        if (entry == movable.end() || entry->second != used)
+          continue;
+
+        if (best != nullptr && used * best->size() >= best->used() * chunk->size())
+          continue;
+
+        // Make sure that the data fits into the remaining
+        // chunks so that we do not allocate new memory
+        VkDeviceSize available = 0;
+
+        for (const auto& other : type->chunks) {
+          if (other != chunk && !other->isEvacuating()
+           && other->isCompatible(chunk->m_memory.memFlags, chunk->m_memory.priority))
+            available += other->size() - other->used();
+        }
+
+        if (available >= 2 * used)
+          best = chunk;
+      }
+
+      if (best != nullptr) {
+        best->m_evacuating = true;
+        return best;
+      }
+    }
+
+    return nullptr;
+  }
+
+
+  void DxvkMemoryAllocator::endEvacuation(
+    const Rc<DxvkMemoryChunk>&              chunk) {
+    DxvkMemoryType* type = chunk->m_type;
+
+    // Slices freed while evacuation was starting may
+    // have ended up in a cache and keep the chunk alive
+    this->flushCaches(type);
+
+    auto lock = this->lockType(type);
+
+    if (!this->releaseEvacuatedChunk(type, chunk.ptr()))
+      chunk->m_evacuating = false;
+  }
+
+
   DxvkMemory DxvkMemoryAllocator::tryAlloc(
     const VkMemoryRequirements*             req,
     const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
           VkMemoryPropertyFlags             flags,
-          float                             priority) {
+          float                             priority,
+          bool                              skipDeviceLocal) {
     DxvkMemory result;
 
     for (uint32_t i = 0; i < m_memProps.memoryTypeCount && !result; i++) {
       const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
       const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+      const bool skipped   = skipDeviceLocal
+        && (m_memTypes[i].memType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
       
-      if (supported && adequate) {
+      if (supported && adequate && !skipped) {
         result = this->tryAllocFromType(&m_memTypes[i],
           flags, req->size, req->alignment, priority, dedAllocInfo);
       }
@@ -277,6 +565,29 @@ namespace dxvk {
   }
   
   
+  bool DxvkMemoryAllocator::shouldDemote(
+    const VkMemoryRequirements*             req,
+          VkMemoryPropertyFlags             flags,
+          float                             priority) const {
+    // Only demote resources that are not written by the GPU
+    // and that the application does not expect to be mapped
+    if (!m_budgetThreshold || priority >= 1.0f
+     || !(flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+     || (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+      return false;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      const bool supported = (req->memoryTypeBits & (1u << i)) != 0;
+      const bool adequate  = (m_memTypes[i].memType.propertyFlags & flags) == flags;
+
+      if (supported && adequate && m_memTypes[i].heap->underPressure.load())
+        return true;
+    }
+
+    return false;
+  }
+
+
   DxvkMemory DxvkMemoryAllocator::tryAllocFromType(
           DxvkMemoryType*                   type,
           VkMemoryPropertyFlags             flags,
@@ -297,28 +608,74 @@ namespace dxvk {
         type, flags, size, priority, dedAllocInfo);
 
       if (devMem.memHandle != VK_NULL_HANDLE)
-        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, devMem.memPointer);
+        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, ~0u, devMem.memPointer);
     } else {
-      for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
-        memory = type->chunks[i]->alloc(flags, size, align, priority);
-      
-      if (!memory) {
-        DxvkDeviceMemory devMem;
-        
-        for (uint32_t i = 0; i < 6 && (type->chunkSize >> i) >= size && !devMem.memHandle; i++)
-          devMem = tryAllocDeviceMemory(type, flags, type->chunkSize >> i, priority, nullptr);
+      // Small allocations can usually be served from the
+      // slice cache for the calling thread without locking
+      VkDeviceSize length = dxvk::align(size, align);
 
-        if (devMem.memHandle) {
-          Rc<DxvkMemoryChunk> chunk = new DxvkMemoryChunk(this, type, devMem);
-          memory = chunk->alloc(flags, size, align, priority);
+      if (length <= DxvkMemoryCache::MaxSize) {
+        DxvkMemoryCacheEntry entry;
 
-          type->chunks.push_back(std::move(chunk));
+        if (this->getCache(type).take(flags, length, align, priority, entry)) {
+          memory = DxvkMemory(this, entry.chunk, type, entry.memory,
+            entry.offset, entry.length, entry.block, entry.mapPtr);
+          type->cacheHits += 1;
         }
       }
+
+      if (!memory)
+        memory = this->tryAllocFromChunks(type, flags, size, align, priority);
     }
 
     if (memory)
-      type->heap->stats.memoryUsed += memory.m_length;
+      type->heap->memoryUsed += memory.m_length;
+
+    return memory;
+  }
+
+
+  DxvkMemory DxvkMemoryAllocator::tryAllocFromChunks(
+          DxvkMemoryType*                   type,
+          VkMemoryPropertyFlags             flags,
+          VkDeviceSize                      size,
+          VkDeviceSize                      align,
+          float                             priority) {
+    DxvkMemory memory;
+
+    auto lock = this->lockType(type);
+
+    for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
+      memory = type->chunks[i]->alloc(flags, size, align, priority);
+
+    // Return cached slices to their chunks before
+    // allocating more memory, and try again
+    if (!memory) {
+      lock.unlock();
+
+      if (this->flushCaches(type)) {
+        lock.lock();
+
+        for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
+          memory = type->chunks[i]->alloc(flags, size, align, priority);
+      } else {
+        lock.lock();
+      }
+    }
+
+    if (!memory) {
+      DxvkDeviceMemory devMem;
+
+      for (uint32_t i = 0; i < 6 && (type->chunkSize >> i) >= size && !devMem.memHandle; i++)
+        devMem = tryAllocDeviceMemory(type, flags, type->chunkSize >> i, priority, nullptr);
+
+      if (devMem.memHandle) {
+        Rc<DxvkMemoryChunk> chunk = new DxvkMemoryChunk(this, type, devMem);
+        memory = chunk->alloc(flags, size, align, priority);
+
+        type->chunks.push_back(std::move(chunk));
+      }
+    }
 
     return memory;
   }
@@ -331,9 +688,9 @@ namespace dxvk {
           float                             priority,
     const VkMemoryDedicatedAllocateInfo*    dedAllocInfo) {
     bool useMemoryPriority = (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-                          && (m_device->features().extMemoryPriority.memoryPriority);
+                          && (m_useMemoryPriority);
     
-    if (type->heap->budget && type->heap->stats.memoryAllocated + size > type->heap->budget)
+    if (type->heap->budget && type->heap->memoryAllocated + size > type->heap->budget)
       return DxvkDeviceMemory();
 
     DxvkDeviceMemory result;
@@ -365,23 +722,23 @@ namespace dxvk {
       }
     }
 
-    type->heap->stats.memoryAllocated += size;
-    m_device->adapter()->notifyHeapMemoryAlloc(type->heapId, size);
+    type->heap->memoryAllocated += size;
+
+    if (m_device)
+      m_device->adapter()->notifyHeapMemoryAlloc(type->heapId, size);
     return result;
   }
 
 
   void DxvkMemoryAllocator::free(
     const DxvkMemory&           memory) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    memory.m_type->heap->stats.memoryUsed -= memory.m_length;
+    if (unlikely(m_trace != nullptr))
+      m_trace->recordFree(m_device->getCurrentFrameId(), memory.m_memory, memory.m_offset);
+
+    memory.m_type->heap->memoryUsed -= memory.m_length;
 
     if (memory.m_chunk != nullptr) {
-      this->freeChunkMemory(
-        memory.m_type,
-        memory.m_chunk,
-        memory.m_offset,
-        memory.m_length);
+      this->freeChunkMemory(memory);
     } else {
       DxvkDeviceMemory devMem;
       devMem.memHandle  = memory.m_memory;
@@ -393,11 +750,45 @@ namespace dxvk {
 
   
   void DxvkMemoryAllocator::freeChunkMemory(
+    const DxvkMemory&           memory) {
+    DxvkMemoryType* type = memory.m_type;
+
+    DxvkMemoryCacheEntry entry;
+    entry.chunk  = memory.m_chunk;
+    entry.memory = memory.m_memory;
+    entry.offset = memory.m_offset;
+    entry.length = memory.m_length;
+    entry.block  = memory.m_block;
+    entry.mapPtr = memory.m_mapPtr;
+
+    if (entry.length <= DxvkMemoryCache::MaxSize && !entry.chunk->isEvacuating()) {
+      // If the cache is full, we need to return
+      // the oldest entry to its chunk instead
+      if (!this->getCache(type).store(entry, entry))
+        return;
+    }
+
+    auto lock = this->lockType(type);
+    entry.chunk->free(entry.block);
+
+    this->releaseEvacuatedChunk(type, entry.chunk);
+  }
+
+
+  bool DxvkMemoryAllocator::releaseEvacuatedChunk(
           DxvkMemoryType*       type,
-          DxvkMemoryChunk*      chunk,
-          VkDeviceSize          offset,
-          VkDeviceSize          length) {
-    chunk->free(offset, length);
+          DxvkMemoryChunk*      chunk) {
+    if (!chunk->isEvacuating() || chunk->used())
+      return false;
+
+    for (auto i = type->chunks.begin(); i != type->chunks.end(); i++) {
+      if (i->ptr() == chunk) {
+        type->chunks.erase(i);
+        break;
+      }
+    }
+
+    return true;
   }
   
 
@@ -405,8 +796,57 @@ namespace dxvk {
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory) {
     m_vkd->vkFreeMemory(m_vkd->device(), memory.memHandle, nullptr);
-    type->heap->stats.memoryAllocated -= memory.memSize;
-    m_device->adapter()->notifyHeapMemoryFree(type->heapId, memory.memSize);
+    type->heap->memoryAllocated -= memory.memSize;
+
+    if (m_device)
+      m_device->adapter()->notifyHeapMemoryFree(type->heapId, memory.memSize);
+  }
+
+
+  std::unique_lock<std::mutex> DxvkMemoryAllocator::lockType(
+          DxvkMemoryType*       type) {
+    std::unique_lock<std::mutex> lock(type->mutex, std::try_to_lock);
+
+    if (!lock) {
+      type->lockContended += 1;
+      lock.lock();
+    }
+
+    type->lockCount += 1;
+    return lock;
+  }
+
+
+  DxvkMemoryCache& DxvkMemoryAllocator::getCache(
+          DxvkMemoryType*       type) {
+    // Windows thread IDs are multiples of four, so use
+    // the upper bits of a multiplicative hash as index
+    uint32_t index = dxvk::this_thread::get_id() * 0x9E3779B1u;
+    return type->caches[index >> (32 - DxvkMemoryType::CacheCountLog2)];
+  }
+
+
+  bool DxvkMemoryAllocator::flushCaches(
+          DxvkMemoryType*       type) {
+    std::vector<DxvkMemoryCacheEntry> entries;
+
+    for (auto& cache : type->caches)
+      cache.flush(entries);
+
+    if (entries.empty())
+      return false;
+
+    auto lock = this->lockType(type);
+
+    for (const auto& entry : entries) {
+      entry.chunk->free(entry.block);
+
+      // The chunk may have started evacuation
+      // after the slice was put into the cache
+      this->releaseEvacuatedChunk(type, entry.chunk);
+    }
+
+    return true;
   }
 
 
@@ -415,12 +855,12 @@ namespace dxvk {
     VkMemoryHeap heap = m_memProps.memoryHeaps[type.heapIndex];
 
     // Default to a chunk size of 128 MiB
-    VkDeviceSize chunkSize = 128 << 20;
+    VkDeviceSize chunkSize = m_chunkSize ? m_chunkSize : VkDeviceSize(128 << 20);
 
     // Try to waste a bit less system memory in 32-bit
     // applications due to address space constraints
     #ifndef _WIN64
-    if (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    if (!m_chunkSize && (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
       chunkSize = 32 << 20;
     #endif
 
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "dxvk_adapter.h"
+#include "dxvk_allocator.h"
+#include "dxvk_memory_trace.h"
+#include "dxvk_options.h"
+
+#include "../util/util_time.h"
 
 namespace dxvk {
   
@@ -11,11 +18,32 @@ namespace dxvk {
    * \brief Memory stats
    * 
    * Reports the amount of device memory
-   * allocated and used by the application.
+   * allocated and used by the application,
+   * as well as the amount of memory held in
+   * empty chunks and the total amount that
+   * was returned to the driver by trimming.
    */
   struct DxvkMemoryStats {
     VkDeviceSize memoryAllocated = 0;
     VkDeviceSize memoryUsed      = 0;
+    VkDeviceSize memoryIdle      = 0;
+    VkDeviceSize memoryReleased  = 0;
+  };
+
+
+  /**
+   * \brief Memory allocator lock stats
+   *
+   * Reports how often the per-type allocator locks
+   * were taken, how often a thread had to wait for
+   * another thread, and how many allocations were
+   * served from the per-thread slice caches without
+   * taking a lock at all.
+   */
+  struct DxvkMemoryLockStats {
+    uint64_t lockCount     = 0;
+    uint64_t lockContended = 0;
+    uint64_t cacheHits     = 0;
   };
   
   
@@ -40,11 +68,107 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory heap and stores
    * its properties as well as allocation statistics.
+   * Statistics are atomic since multiple memory types
+   * with independent locks can share the same heap.
    */
   struct DxvkMemoryHeap {
     VkMemoryHeap      properties;
-    DxvkMemoryStats   stats;
     VkDeviceSize      budget;
+
+    /// Set while device-local usage is above the
+    /// configured fraction of the driver budget
+    std::atomic<bool> underPressure = { false };
+
+    std::atomic<VkDeviceSize> memoryAllocated = { 0 };
+    std::atomic<VkDeviceSize> memoryUsed      = { 0 };
+    std::atomic<VkDeviceSize> memoryIdle      = { 0 };
+    std::atomic<VkDeviceSize> memoryReleased  = { 0 };
+  };
+
+
+  /**
+   * \brief Cached memory slice
+   *
+   * Stores a slice that was freed by the application
+   * but not yet returned to the chunk it belongs to.
+   */
+  struct DxvkMemoryCacheEntry {
+    DxvkMemoryChunk*  chunk  = nullptr;
+    VkDeviceMemory    memory = VK_NULL_HANDLE;
+    VkDeviceSize      offset = 0;
+    VkDeviceSize      length = 0;
+    uint32_t          block  = ~0u;
+    void*             mapPtr = nullptr;
+  };
+
+
+  /**
+   * \brief Memory slice cache
+   *
+   * Keeps a small number of recently freed small slices
+   * per size class, so that they can be reused without
+   * taking the memory type lock. Each memory type owns
+   * one cache per thread slot, which keeps contention
+   * on the cache's own lock low.
+   */
+  class DxvkMemoryCache {
+
+  public:
+
+    constexpr static uint32_t MinClassBits = 8;
+    constexpr static uint32_t ClassCount   = 9;
+    constexpr static uint32_t EntryCount   = 4;
+
+    /// Largest slice size that will be cached
+    constexpr static VkDeviceSize MaxSize = VkDeviceSize(1) << (MinClassBits + ClassCount - 1);
+
+    /**
+     * \brief Stores a slice in the cache
+     *
+     * If the size class is full, the oldest entry is
+     * evicted and must be returned to its chunk.
+     * \param [in] entry The slice to store
+     * \param [out] evicted Evicted slice, if any
+     * \returns \c true if an entry was evicted
+     */
+    bool store(
+      const DxvkMemoryCacheEntry&   entry,
+            DxvkMemoryCacheEntry&   evicted);
+
+    /**
+     * \brief Retrieves a compatible slice
+     *
+     * \param [in] flags Requested memory flags
+     * \param [in] length Aligned allocation size
+     * \param [in] align Required alignment
+     * \param [in] priority Requested priority
+     * \param [out] entry The slice, if any
+     * \returns \c true if a slice was found
+     */
+    bool take(
+            VkMemoryPropertyFlags   flags,
+            VkDeviceSize            length,
+            VkDeviceSize            align,
+            float                   priority,
+            DxvkMemoryCacheEntry&   entry);
+
+    /**
+     * \brief Removes all slices from the cache
+     *
+     * \param [out] entries Vector to append slices to
+     */
+    void flush(
+            std::vector<DxvkMemoryCacheEntry>& entries);
+
+  private:
+
+    sync::Spinlock  m_lock;
+
+    std::array<uint32_t, ClassCount> m_counts = { };
+    std::array<std::array<DxvkMemoryCacheEntry, EntryCount>, ClassCount> m_entries;
+
+    static uint32_t getClass(VkDeviceSize length);
+
   };
 
 
@@ -53,9 +177,13 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory type and stores
    * memory chunks used to sub-allocate memory on
-   * this memory type.
+   * this memory type. The chunk list is protected
+   * by the per-type lock.
    */
   struct DxvkMemoryType {
+    constexpr static uint32_t CacheCountLog2 = 3;
+    constexpr static uint32_t CacheCount = 1u << CacheCountLog2;
+
     DxvkMemoryHeap*   heap;
     uint32_t          heapId;
 
@@ -64,7 +192,15 @@ namespace dxvk {
 
     VkDeviceSize      chunkSize;
 
+    std::mutex        mutex;
+
     std::vector<Rc<DxvkMemoryChunk>> chunks;
+
+    std::array<DxvkMemoryCache, CacheCount> caches;
+
+    std::atomic<uint64_t> lockCount     = { 0ull };
+    std::atomic<uint64_t> lockContended = { 0ull };
+    std::atomic<uint64_t> cacheHits     = { 0ull };
   };
   
   
@@ -86,6 +222,7 @@ namespace dxvk {
       VkDeviceMemory        memory,
       VkDeviceSize          offset,
       VkDeviceSize          length,
+      uint32_t              block,
       void*                 mapPtr);
     DxvkMemory             (DxvkMemory&& other);
     DxvkMemory& operator = (DxvkMemory&& other);
@@ -132,6 +269,28 @@ namespace dxvk {
       return m_length;
     }
 
+    /**
+     * \brief Memory type property flags
+     *
+     * These may differ from the flags requested at
+     * allocation time if the allocation was demoted
+     * to a slower memory type.
+     * \returns Property flags of the memory type
+     */
+    VkMemoryPropertyFlags propertyFlags() const {
+      return m_type ? m_type->memType.propertyFlags : 0;
+    }
+
+    /**
+     * \brief Chunk the slice was allocated from
+     * 
+     * \returns The memory chunk, or \c nullptr if
+     *    this slice uses a dedicated allocation.
+     */
+    DxvkMemoryChunk* chunk() const {
+      return m_chunk;
+    }
+
     /**
      * \brief Checks whether the memory slice is defined
      * 
@@ -150,6 +309,7 @@ namespace dxvk {
     VkDeviceMemory        m_memory = VK_NULL_HANDLE;
     VkDeviceSize          m_offset = 0;
     VkDeviceSize          m_length = 0;
+    uint32_t              m_block  = ~0u;
     void*                 m_mapPtr = nullptr;
     
     void free();
@@ -161,9 +321,12 @@ namespace dxvk {
    * \brief Memory chunk
    * 
    * A single chunk of memory that provides a
-   * sub-allocator. This is not thread-safe.
+   * sub-allocator. Allocations and frees run in
+   * constant time, see \ref DxvkRangeAllocator.
+   * This is not thread-safe.
    */
   class DxvkMemoryChunk : public RcObject {
+    friend class DxvkMemoryAllocator;
     
   public:
     
@@ -174,6 +337,47 @@ namespace dxvk {
     
     ~DxvkMemoryChunk();
 
+    /**
+     * \brief Checks whether the chunk can serve an allocation
+     *
+     * \param [in] flags Requested memory flags
+     * \param [in] priority Requested priority
+     * \returns \c true if flags and priority match
+     */
+    bool isCompatible(
+            VkMemoryPropertyFlags flags,
+            float                 priority) const {
+      return m_memory.memFlags == flags
+          && m_memory.priority == priority;
+    }
+
+    /**
+     * \brief Chunk size
+     * \returns Size of the chunk, in bytes
+     */
+    VkDeviceSize size() const {
+      return m_allocator.size();
+    }
+
+    /**
+     * \brief Number of bytes in use
+     * \returns Allocated size, in bytes
+     */
+    VkDeviceSize used() const {
+      return m_allocator.used();
+    }
+
+    /**
+     * \brief Checks whether the chunk is being evacuated
+     *
+     * Evacuated chunks do not serve any new allocations
+     * and are freed as soon as they become empty.
+     * \returns \c true if the chunk is being evacuated
+     */
+    bool isEvacuating() const {
+      return m_evacuating;
+    }
+
     /**
      * \brief Allocates memory from the chunk
      * 
@@ -197,25 +401,24 @@ namespace dxvk {
      * Returns a slice back to the chunk.
      * Called automatically when a memory
      * slice runs out of scope.
-     * \param [in] offset Slice offset
-     * \param [in] length Slice length
+     * \param [in] block Block index of the slice
      */
     void free(
-            VkDeviceSize  offset,
-            VkDeviceSize  length);
+            uint32_t      block);
     
   private:
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
-    
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkRangeAllocator    m_allocator;
+
+    std::atomic<bool>     m_evacuating = { false };
+
+    bool                  m_idle      = false;
+    uint32_t              m_idleFrame = 0;
+    high_resolution_clock::time_point m_idleTime;
     
   };
   
@@ -229,9 +432,31 @@ namespace dxvk {
   class DxvkMemoryAllocator {
     friend class DxvkMemory;
     friend class DxvkMemoryChunk;
+    /// Number of frames between two trim passes
+    constexpr static uint32_t TrimInterval = 30;
+    /// Minimum time a chunk must be idle before it gets released
+    constexpr static std::chrono::milliseconds TrimDelay = std::chrono::milliseconds(2000);
   public:
     
     DxvkMemoryAllocator(const DxvkDevice* device);
+
+    /**
+     * \brief Creates an allocator without a device
+     *
+     * Used to run the allocator against a stubbed set of
+     * device functions, e.g. in order to replay traces.
+     * Memory budget queries are not supported.
+     * \param [in] vkd Device functions
+     * \param [in] options Allocator options
+     * \param [in] devProps Device properties
+     * \param [in] memProps Memory properties
+     */
+    DxvkMemoryAllocator(
+      const Rc<vk::DeviceFn>&                 vkd,
+      const DxvkOptions&                      options,
+      const VkPhysicalDeviceProperties&       devProps,
+      const VkPhysicalDeviceMemoryProperties& memProps);
+
     ~DxvkMemoryAllocator();
     
     /**
@@ -272,8 +497,77 @@ namespace dxvk {
      * \returns Memory stats for this heap
      */
     DxvkMemoryStats getMemoryStats(uint32_t heap) const {
-      return m_memHeaps[heap].stats;
+      DxvkMemoryStats result;
+      result.memoryAllocated = m_memHeaps[heap].memoryAllocated.load();
+      result.memoryUsed      = m_memHeaps[heap].memoryUsed.load();
+      result.memoryIdle      = m_memHeaps[heap].memoryIdle.load();
+      result.memoryReleased  = m_memHeaps[heap].memoryReleased.load();
+      return result;
     }
+
+    /**
+     * \brief Queries lock stats
+     *
+     * \returns Lock contention counters
+     */
+    DxvkMemoryLockStats getLockStats() const;
+
+    /**
+     * \brief Updates memory budget state
+     *
+     * Queries the current heap usage and budget, using
+     * \c VK_EXT_memory_budget if supported and internal
+     * accounting otherwise, and determines whether any
+     * device-local heap is under memory pressure. Should
+     * be called once per frame.
+     */
+    void updateBudget();
+
+    /**
+     * \brief Checks for memory pressure
+     *
+     * \returns \c true if any device-local heap
+     *    is above the configured budget threshold
+     */
+    bool isUnderPressure() const;
+
+    /**
+     * \brief Releases idle memory chunks
+     *
+     * Returns chunks that have been empty for a while to the
+     * driver, except for a small number of spare chunks per
+     * memory type that are kept around in order to avoid
+     * allocation spikes when the application allocates
+     * resources again. Should be called once per frame.
+     * \param [in] frameId Current frame number
+     */
+    void trimChunks(
+            uint32_t              frameId);
+
+    /**
+     * \brief Picks a chunk to evacuate
+     *
+     * Looks for a poorly utilized chunk whose entire contents
+     * can be relocated, and stops serving allocations from it.
+     * The chunk will be freed once all slices are returned.
+     * \param [in] movable Number of relocatable bytes per chunk
+     * \param [in] maxUsage Maximum fraction of the chunk in use
+     * \returns The chunk to evacuate, or \c nullptr
+     */
+    Rc<DxvkMemoryChunk> beginEvacuation(
+      const std::unordered_map<DxvkMemoryChunk*, VkDeviceSize>& movable,
+            float                             maxUsage);
+
+    /**
+     * \brief Ends chunk evacuation
+     *
+     * Called once the defragmenter stops working on the
+     * chunk. If the chunk is empty, it will be released,
+     * otherwise it will serve allocations again.
+     * \param [in] chunk The chunk
+     */
+    void endEvacuation(
+      const Rc<DxvkMemoryChunk>&              chunk);
     
   private:
 
@@ -282,16 +576,46 @@ namespace dxvk {
     const VkPhysicalDeviceProperties       m_devProps;
     const VkPhysicalDeviceMemoryProperties m_memProps;
     
-    std::mutex                                      m_mutex;
     std::array<DxvkMemoryHeap, VK_MAX_MEMORY_HEAPS> m_memHeaps;
     std::array<DxvkMemoryType, VK_MAX_MEMORY_TYPES> m_memTypes;
 
+    uint32_t                               m_budgetThreshold = 0;
+
+    uint32_t                               m_trimSpareChunks = 0;
+    uint32_t                               m_trimFrames      = 0;
+    uint32_t                               m_trimFrameId     = 0;
+
+    VkDeviceSize                           m_chunkSize         = 0;
+    bool                                   m_useMemoryPriority = false;
+
+    std::unique_ptr<DxvkMemoryTraceWriter> m_trace;
+
+    DxvkMemory allocMemory(
+      const VkMemoryRequirements*             req,
+      const VkMemoryDedicatedRequirements&    dedAllocReq,
+      const VkMemoryDedicatedAllocateInfo&    dedAllocInfo,
+            VkMemoryPropertyFlags             flags,
+            float                             priority);
+
     DxvkMemory tryAlloc(
       const VkMemoryRequirements*             req,
       const VkMemoryDedicatedAllocateInfo*    dedAllocInfo,
             VkMemoryPropertyFlags             flags,
-            float                             priority);
+            float                             priority,
+            bool                              skipDeviceLocal = false);
+
+    bool shouldDemote(
+      const VkMemoryRequirements*             req,
+            VkMemoryPropertyFlags             flags,
+            float                             priority) const;
     
+    DxvkMemory tryAllocFromChunks(
+            DxvkMemoryType*                   type,
+            VkMemoryPropertyFlags             flags,
+            VkDeviceSize                      size,
+            VkDeviceSize                      align,
+            float                             priority);
+
     DxvkMemory tryAllocFromType(
             DxvkMemoryType*                   type,
             VkMemoryPropertyFlags             flags,
@@ -311,14 +635,24 @@ namespace dxvk {
       const DxvkMemory&           memory);
     
     void freeChunkMemory(
-            DxvkMemoryType*       type,
-            DxvkMemoryChunk*      chunk,
-            VkDeviceSize          offset,
-            VkDeviceSize          length);
+      const DxvkMemory&           memory);
     
     void freeDeviceMemory(
             DxvkMemoryType*       type,
             DxvkDeviceMemory      memory);
+
+    bool releaseEvacuatedChunk(
+            DxvkMemoryType*       type,
+            DxvkMemoryChunk*      chunk);
+
+    std::unique_lock<std::mutex> lockType(
+            DxvkMemoryType*       type);
+
+    DxvkMemoryCache& getCache(
+            DxvkMemoryType*       type);
+
+    bool flushCaches(
+            DxvkMemoryType*       type);
     
     VkDeviceSize pickChunkSize(
             uint32_t              memTypeId) const;
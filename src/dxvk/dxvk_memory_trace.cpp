@@ -0,0 +1,78 @@
+#include <cstring>
+
+#include "dxvk_memory_trace.h"
+
+namespace dxvk {
+
+  DxvkMemoryTraceWriter::DxvkMemoryTraceWriter(
+    const std::string&                      fileName,
+    const VkPhysicalDeviceMemoryProperties& memProps)
+  : m_stream(fileName, std::ios_base::binary | std::ios_base::trunc) {
+    if (!m_stream) {
+      Logger::warn(str::format("DxvkMemoryTraceWriter: Failed to open ", fileName));
+      return;
+    }
+
+    Logger::info(str::format("DxvkMemoryTraceWriter: Recording to ", fileName));
+
+    DxvkMemoryTraceHeader header = { };
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version  = Version;
+    header.memProps = memProps;
+
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  }
+
+
+  DxvkMemoryTraceWriter::~DxvkMemoryTraceWriter() {
+
+  }
+
+
+  void DxvkMemoryTraceWriter::recordAlloc(
+          DxvkMemoryTraceEntry    entry,
+          VkDeviceMemory          memory,
+          VkDeviceSize            offset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    entry.op      = DxvkMemoryTraceOp::Alloc;
+    entry.allocId = m_nextId++;
+
+    m_liveAllocs.insert({ LiveAlloc { memory, offset }, entry.allocId });
+    m_stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  }
+
+
+  void DxvkMemoryTraceWriter::recordFree(
+          uint32_t                frameId,
+          VkDeviceMemory          memory,
+          VkDeviceSize            offset) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto alloc = m_liveAllocs.find(LiveAlloc { memory, offset });
+
+    if (alloc == m_liveAllocs.end())
+      return;
+
+    DxvkMemoryTraceEntry entry = { };
+    entry.op      = DxvkMemoryTraceOp::Free;
+    entry.frameId = frameId;
+    entry.allocId = alloc->second;
+
+    m_liveAllocs.erase(alloc);
+    m_stream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  }
+
+
+  bool DxvkMemoryTraceWriter::validateHeader(
+    const DxvkMemoryTraceHeader&  header) {
+    return !std::memcmp(header.magic, Magic, sizeof(Magic))
+        && header.version == Version;
+  }
+
+
+  std::string DxvkMemoryTraceWriter::getTracePath() {
+    return env::getEnvVar("DXVK_MEMORY_TRACE");
+  }
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Memory trace operation
+   */
+  enum class DxvkMemoryTraceOp : uint8_t {
+    Alloc = 0,
+    Free  = 1,
+  };
+
+
+  /**
+   * \brief Memory trace header
+   *
+   * Stored at the start of the trace file. Contains the
+   * memory properties of the device the trace was recorded
+   * on, so that the allocator can be set up identically
+   * when replaying the trace.
+   */
+  struct DxvkMemoryTraceHeader {
+    char                              magic[4];
+    uint32_t                          version;
+    VkPhysicalDeviceMemoryProperties  memProps;
+  };
+
+
+  /**
+   * \brief Memory trace entry
+   *
+   * Fixed-size record for a single allocation or free.
+   * Allocations are identified by a unique ID so that
+   * free operations can refer back to them. For frees,
+   * only the operation, frame ID and allocation ID are
+   * meaningful.
+   */
+  struct DxvkMemoryTraceEntry {
+    DxvkMemoryTraceOp op;
+    uint8_t           memTypeId;
+    uint8_t           dedicated;
+    uint8_t           alignLog2;
+    uint32_t          frameId;
+    uint32_t          allocId;
+    uint32_t          memoryTypeBits;
+    uint32_t          memFlags;
+    float             priority;
+    uint64_t          size;
+  };
+
+  static_assert(sizeof(DxvkMemoryTraceEntry) == 32);
+
+  /// Dedicated allocation flags stored in trace entries
+  constexpr uint8_t DxvkMemoryTracePrefersDedicated  = 0x1;
+  constexpr uint8_t DxvkMemoryTraceRequiresDedicated = 0x2;
+
+
+  /**
+   * \brief Memory trace writer
+   *
+   * Records allocations and frees made through the memory
+   * allocator to a binary file. Enabled by setting the
+   * \c DXVK_MEMORY_TRACE environment variable to the
+   * path of the file to write.
+   */
+  class DxvkMemoryTraceWriter {
+    constexpr static char     Magic[4] = { 'D', 'X', 'M', 'T' };
+  public:
+
+    constexpr static uint32_t Version = 1;
+
+    DxvkMemoryTraceWriter(
+      const std::string&                      fileName,
+      const VkPhysicalDeviceMemoryProperties& memProps);
+
+    ~DxvkMemoryTraceWriter();
+
+    /**
+     * \brief Records an allocation
+     *
+     * \param [in] entry Allocation info. The operation
+     *    and allocation ID will be filled in.
+     * \param [in] memory Memory handle of the allocation
+     * \param [in] offset Offset of the allocation
+     */
+    void recordAlloc(
+            DxvkMemoryTraceEntry    entry,
+            VkDeviceMemory          memory,
+            VkDeviceSize            offset);
+
+    /**
+     * \brief Records a free
+     *
+     * \param [in] frameId Current frame ID
+     * \param [in] memory Memory handle of the allocation
+     * \param [in] offset Offset of the allocation
+     */
+    void recordFree(
+            uint32_t                frameId,
+            VkDeviceMemory          memory,
+            VkDeviceSize            offset);
+
+    /**
+     * \brief Checks whether a trace header is valid
+     *
+     * \param [in] header Header read from a trace file
+     * \returns \c true if magic and version match
+     */
+    static bool validateHeader(
+      const DxvkMemoryTraceHeader&  header);
+
+    /**
+     * \brief Retrieves trace file path
+     *
+     * \returns Path set via \c DXVK_MEMORY_TRACE,
+     *    or an empty string if tracing is disabled
+     */
+    static std::string getTracePath();
+
+  private:
+
+    struct LiveAlloc {
+      VkDeviceMemory  memory;
+      VkDeviceSize    offset;
+
+      bool operator == (const LiveAlloc& other) const {
+        return memory == other.memory && offset == other.offset;
+      }
+    };
+
+    struct LiveAllocHash {
+      size_t operator () (const LiveAlloc& alloc) const {
+        return std::hash<VkDeviceMemory>()(alloc.memory)
+             ^ std::hash<VkDeviceSize>()(alloc.offset);
+      }
+    };
+
+    std::mutex    m_mutex;
+    std::ofstream m_stream;
+    uint32_t      m_nextId = 0;
+
+    std::unordered_map<LiveAlloc, uint32_t, LiveAllocHash> m_liveAllocs;
+
+  };
+
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "dxvk_defrag.h"
+#include "dxvk_discard_ring.h"
 #include "dxvk_gpu_event.h"
 #include "dxvk_gpu_query.h"
 #include "dxvk_memory.h"
@@ -24,6 +26,8 @@ namespace dxvk {
     DxvkObjects(DxvkDevice* device)
     : m_device          (device),
       m_memoryManager   (device),
+      m_memoryDefrag    (device, m_memoryManager),
+      m_discardRing     (device, m_memoryManager),
       m_renderPassPool  (device),
       m_pipelineManager (device, &m_renderPassPool),
       m_eventPool       (device),
@@ -36,6 +40,14 @@ namespace dxvk {
       return m_memoryManager;
     }
 
+    DxvkMemoryDefragmenter& memoryDefrag() {
+      return m_memoryDefrag;
+    }
+
+    DxvkDiscardRing& discardRing() {
+      return m_discardRing;
+    }
+
     DxvkRenderPassPool& renderPassPool() {
       return m_renderPassPool;
     }
@@ -81,6 +93,8 @@ namespace dxvk {
     DxvkDevice*                   m_device;
 
     DxvkMemoryAllocator           m_memoryManager;
+    DxvkMemoryDefragmenter        m_memoryDefrag;
+    DxvkDiscardRing               m_discardRing;
     DxvkRenderPassPool            m_renderPassPool;
     DxvkPipelineManager           m_pipelineManager;
 
@@ -6,6 +6,16 @@ namespace dxvk {
     enableStateCache      = config.getOption<bool>    ("dxvk.enableStateCache",       true);
     enableOpenVR          = config.getOption<bool>    ("dxvk.enableOpenVR",           true);
     numCompilerThreads    = config.getOption<int32_t> ("dxvk.numCompilerThreads",     0);
+    memoryDefragBudget    = config.getOption<int32_t> ("dxvk.memoryDefragBudget",     0);
+    memoryBudgetThreshold = config.getOption<int32_t> ("dxvk.memoryBudgetThreshold",  0);
+    memoryTrimFrames      = config.getOption<int32_t> ("dxvk.memoryTrimFrames",       300);
+    memorySpareChunks     = config.getOption<int32_t> ("dxvk.memorySpareChunks",      1);
+    memoryChunkSize       = config.getOption<int32_t> ("dxvk.memoryChunkSize",        0);
+    asyncPipelineCompile  = config.getOption<bool>    ("dxvk.asyncPipelineCompile",   false);
+    csStateElimination    = config.getOption<bool>    ("dxvk.csStateElimination",     true);
+    spirvEliminateDeadCode = config.getOption<bool>   ("dxvk.spirvEliminateDeadCode", true);
+    spirvFoldConstants    = config.getOption<bool>    ("dxvk.spirvFoldConstants",     true);
+    spirvForwardStores    = config.getOption<bool>    ("dxvk.spirvForwardStores",     true);
     useRawSsbo            = config.getOption<Tristate>("dxvk.useRawSsbo",             Tristate::Auto);
     useEarlyDiscard       = config.getOption<Tristate>("dxvk.useEarlyDiscard",        Tristate::Auto);
     hud                   = config.getOption<std::string>("dxvk.hud", "");
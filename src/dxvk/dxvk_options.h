@@ -18,6 +18,41 @@ namespace dxvk {
     /// when using the state cache
     int32_t numCompilerThreads;
 
+    /// Amount of buffer memory, in MiB, that
+    /// may be relocated per frame in order to
+    /// defragment device memory. 0 disables.
+    int32_t memoryDefragBudget;
+
+    /// Percentage of the device-local memory budget
+    /// above which low-priority resources are placed
+    /// in system memory. 0 disables.
+    int32_t memoryBudgetThreshold;
+
+    /// Number of frames after which empty memory
+    /// chunks are released to the driver. 0 disables.
+    int32_t memoryTrimFrames;
+
+    /// Number of empty chunks to keep per memory type
+    int32_t memorySpareChunks;
+
+    /// Memory chunk size override, in MiB. 0 picks
+    /// a chunk size based on the memory heap size.
+    int32_t memoryChunkSize;
+
+    /// Compile missing graphics pipelines on the
+    /// worker threads and skip draws until done
+    bool asyncPipelineCompile;
+
+    /// Drop state commands that are overwritten
+    /// before being used by any draw or dispatch
+    bool csStateElimination;
+
+    /// SPIR-V optimizer passes to run
+    /// on translated shader code
+    bool spirvEliminateDeadCode;
+    bool spirvFoldConstants;
+    bool spirvForwardStores;
+
     /// Shader-related options
     Tristate useRawSsbo;
     Tristate useEarlyDiscard;
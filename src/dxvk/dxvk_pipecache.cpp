@@ -1,26 +1,221 @@
 #include "dxvk_pipecache.h"
+#include "dxvk_state_cache.h"
 
 namespace dxvk {
+
+  /**
+   * \brief Pipeline cache data header
+   *
+   * Header that every implementation puts in front
+   * of the pipeline cache data, as defined by the
+   * Vulkan spec for \c VK_PIPELINE_CACHE_HEADER_VERSION_ONE.
+   */
+  struct DxvkPipelineCacheDataHeader {
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t  pipelineCacheUUID[VK_UUID_SIZE];
+  };
+
+  // Wait this long after a pipeline was compiled before writing the
+  // cache, so that bursts of compiled pipelines only cause one write
+  constexpr static auto WriteDelay = std::chrono::seconds(5);
+
   
   DxvkPipelineCache::DxvkPipelineCache(
-    const Rc<vk::DeviceFn>& vkd)
-  : m_vkd(vkd) {
+    const Rc<vk::DeviceFn>&           vkd,
+    const VkPhysicalDeviceProperties& properties,
+    const std::string&                fileName)
+  : m_vkd(vkd), m_fileName(fileName) {
+    std::vector<char> data;
+
+    if (!m_fileName.empty())
+      data = readCacheData(properties);
+
     VkPipelineCacheCreateInfo info;
     info.sType            = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
     info.pNext            = nullptr;
     info.flags            = 0;
-    info.initialDataSize  = 0;
-    info.pInitialData     = nullptr;
+    info.initialDataSize  = data.size();
+    info.pInitialData     = data.size() ? data.data() : nullptr;
     
     if (m_vkd->vkCreatePipelineCache(m_vkd->device(),
-        &info, nullptr, &m_handle) != VK_SUCCESS)
-      throw DxvkError("DxvkPipelineCache: Failed to create cache");
+        &info, nullptr, &m_handle) != VK_SUCCESS) {
+      // Some drivers may reject data that passes our header
+      // check, in which case we just start with a new cache
+      info.initialDataSize  = 0;
+      info.pInitialData     = nullptr;
+
+      if (m_vkd->vkCreatePipelineCache(m_vkd->device(),
+          &info, nullptr, &m_handle) != VK_SUCCESS)
+        throw DxvkError("DxvkPipelineCache: Failed to create cache");
+    }
+
+    if (!m_fileName.empty())
+      m_writer = dxvk::thread([this] () { runWriter(); });
   }
   
   
   DxvkPipelineCache::~DxvkPipelineCache() {
+    if (m_writer.joinable()) {
+      { std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+      }
+
+      m_cond.notify_one();
+      m_writer.join();
+    }
+
     m_vkd->vkDestroyPipelineCache(
       m_vkd->device(), m_handle, nullptr);
   }
+
+
+  void DxvkPipelineCache::notifyUpdate() {
+    if (m_fileName.empty())
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_updateCount += 1;
+    m_cond.notify_one();
+  }
+
+
+  std::string DxvkPipelineCache::getFileSuffix(
+    const VkPhysicalDeviceProperties& properties) {
+    static const char hexDigits[] = "0123456789abcdef";
+
+    std::string uuid;
+
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+      uuid += hexDigits[properties.pipelineCacheUUID[i] >> 4];
+      uuid += hexDigits[properties.pipelineCacheUUID[i] & 0xF];
+    }
+
+    return str::format(".", std::hex,
+      properties.vendorID, "-",
+      properties.deviceID, "-",
+      uuid, ".dxvk-pipecache");
+  }
+
+
+  std::vector<char> DxvkPipelineCache::readCacheData(
+    const VkPhysicalDeviceProperties& properties) const {
+    std::ifstream file(m_fileName, std::ios_base::binary | std::ios_base::ate);
+
+    if (!file) {
+      Logger::warn("DXVK: No pipeline cache file found");
+      return std::vector<char>();
+    }
+
+    std::vector<char> data(size_t(file.tellg()));
+    file.seekg(0);
+
+    if (!file.read(data.data(), data.size())) {
+      Logger::warn("DXVK: Failed to read pipeline cache file");
+      return std::vector<char>();
+    }
+
+    // Don't rely on the driver to validate the header
+    DxvkPipelineCacheDataHeader header;
+
+    if (data.size() < sizeof(header)) {
+      Logger::warn("DXVK: Invalid pipeline cache file");
+      return std::vector<char>();
+    }
+
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    if (header.headerSize    < sizeof(header)
+     || header.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+     || header.vendorID      != properties.vendorID
+     || header.deviceID      != properties.deviceID
+     || std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE)) {
+      Logger::warn("DXVK: Pipeline cache file not compatible with device");
+      return std::vector<char>();
+    }
+
+    Logger::info(str::format("DXVK: Read ", data.size() >> 10, " kB of pipeline cache data"));
+    return data;
+  }
+
+
+  void DxvkPipelineCache::writeCacheData() const {
+    std::vector<char> data;
+    VkResult status;
+
+    // The cache may grow between the two calls
+    do {
+      size_t size = 0;
+
+      if (m_vkd->vkGetPipelineCacheData(m_vkd->device(),
+          m_handle, &size, nullptr) != VK_SUCCESS)
+        return;
+
+      data.resize(size);
+
+      status = m_vkd->vkGetPipelineCacheData(m_vkd->device(),
+        m_handle, &size, data.data());
+
+      data.resize(size);
+    } while (status == VK_INCOMPLETE);
+
+    if (status != VK_SUCCESS || data.empty())
+      return;
+
+    // Write to a temporary file first so that we never
+    // leave a truncated cache file behind if the process
+    // gets killed while writing
+    std::string tmpName = m_fileName + ".tmp";
+
+    { std::ofstream file(tmpName, std::ios_base::binary | std::ios_base::trunc);
+
+      if (!file && env::createDirectory(DxvkStateCache::getCacheDir()))
+        file = std::ofstream(tmpName, std::ios_base::binary | std::ios_base::trunc);
+
+      if (!file.write(data.data(), data.size())) {
+        Logger::warn("DXVK: Failed to write pipeline cache file");
+        return;
+      }
+    }
+
+    WCHAR srcPath[MAX_PATH];
+    WCHAR dstPath[MAX_PATH];
+    str::tows(tmpName.c_str(), srcPath);
+    str::tows(m_fileName.c_str(), dstPath);
+
+    if (!MoveFileExW(srcPath, dstPath, MOVEFILE_REPLACE_EXISTING))
+      Logger::warn("DXVK: Failed to replace pipeline cache file");
+  }
+
+
+  void DxvkPipelineCache::runWriter() {
+    env::setThreadName("dxvk-pipecache");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t writtenCount = 0;
+
+    while (!m_stopped) {
+      m_cond.wait(lock, [this, &writtenCount] () {
+        return m_stopped || m_updateCount != writtenCount;
+      });
+
+      // Give the application some time to compile
+      // more pipelines before writing the file
+      m_cond.wait_for(lock, WriteDelay, [this] () {
+        return m_stopped;
+      });
+
+      if (m_updateCount == writtenCount)
+        break;
+
+      writtenCount = m_updateCount;
+
+      lock.unlock();
+      writeCacheData();
+      lock.lock();
+    }
+  }
   
 }
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <fstream>
+#include <mutex>
 
 #include "dxvk_include.h"
 
@@ -10,6 +11,8 @@
 #include "../util/util_env.h"
 #include "../util/util_time.h"
 
+#include "../util/thread.h"
+
 namespace dxvk {
   
   /**
@@ -17,12 +20,22 @@ namespace dxvk {
    * 
    * Allows the Vulkan implementation to
    * re-use previously compiled pipelines.
+   * 
+   * If a file name is given, the cache is initialized
+   * with the data stored in that file, and a background
+   * thread writes the cache data back to the file some
+   * time after new pipelines have been compiled, so that
+   * subsequent runs do not depend on the driver's own
+   * shader cache.
    */
   class DxvkPipelineCache : public RcObject {
     
   public:
     
-    DxvkPipelineCache(const Rc<vk::DeviceFn>& vkd);
+    DxvkPipelineCache(
+      const Rc<vk::DeviceFn>&           vkd,
+      const VkPhysicalDeviceProperties& properties,
+      const std::string&                fileName);
     ~DxvkPipelineCache();
     
     /**
@@ -32,11 +45,47 @@ namespace dxvk {
     VkPipelineCache handle() const {
       return m_handle;
     }
+
+    /**
+     * \brief Notifies the cache of a new pipeline
+     * 
+     * Called whenever a pipeline has been compiled
+     * using this cache, so that the cache data gets
+     * written to disk eventually.
+     */
+    void notifyUpdate();
+
+    /**
+     * \brief Computes cache file name suffix
+     * 
+     * Cache data is only compatible with the device
+     * and driver that created it, so the file name
+     * contains the device ID and the cache UUID.
+     * \param [in] properties Device properties
+     * \returns File name suffix
+     */
+    static std::string getFileSuffix(
+      const VkPhysicalDeviceProperties& properties);
     
   private:
     
     Rc<vk::DeviceFn>        m_vkd;
-    VkPipelineCache         m_handle;
+    VkPipelineCache         m_handle = VK_NULL_HANDLE;
+
+    std::string             m_fileName;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    uint64_t                m_updateCount = 0;
+    bool                    m_stopped     = false;
+    dxvk::thread            m_writer;
+
+    std::vector<char> readCacheData(
+      const VkPhysicalDeviceProperties& properties) const;
+
+    void writeCacheData() const;
+
+    void runWriter();
     
   };
   
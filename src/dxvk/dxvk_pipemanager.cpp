@@ -7,17 +7,34 @@ namespace dxvk {
   DxvkPipelineManager::DxvkPipelineManager(
     const DxvkDevice*         device,
           DxvkRenderPassPool* passManager)
-  : m_device    (device),
-    m_cache     (new DxvkPipelineCache(device->vkd())) {
+  : m_device    (device) {
     std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
+    std::string pipeCacheFile;
+
+    // Only persist driver-side pipeline cache data together
+    // with the state cache, which controls the file location
+    bool enableStateCache = useStateCache != "0" && device->config().enableStateCache;
+
+    if (enableStateCache && env::getEnvVar("DXVK_PIPELINE_CACHE") != "0") {
+      pipeCacheFile = DxvkStateCache::getCacheFilePath(
+        DxvkPipelineCache::getFileSuffix(device->properties().core.properties));
+    }
+
+    m_cache = new DxvkPipelineCache(device->vkd(),
+      device->properties().core.properties, pipeCacheFile);
     
-    if (useStateCache != "0" && device->config().enableStateCache)
+    if (enableStateCache)
       m_stateCache = new DxvkStateCache(device, this, passManager);
+
+    if (enableStateCache && env::getEnvVar("DXVK_SHADER_CACHE") != "0")
+      m_shaderCache = new DxvkShaderCache(DxvkStateCache::getCacheFilePath(".dxvk-shaders"));
   }
   
   
   DxvkPipelineManager::~DxvkPipelineManager() {
-    
+    // Stop the worker threads before destroying
+    // the pipelines that they may be compiling
+    m_stateCache = nullptr;
   }
   
   
@@ -6,6 +6,7 @@
 
 #include "dxvk_compute.h"
 #include "dxvk_graphics.h"
+#include "dxvk_shader_cache.h"
 
 namespace dxvk {
 
@@ -89,12 +90,24 @@ namespace dxvk {
      * \returns \c true if shaders are being compiled
      */
     bool isCompilingShaders() const;
+
+    /**
+     * \brief Retrieves shader cache
+     * 
+     * The shader cache is only enabled
+     * together with the state cache.
+     * \returns Shader cache, or \c nullptr
+     */
+    Rc<DxvkShaderCache> shaderCache() const {
+      return m_shaderCache;
+    }
     
   private:
     
     const DxvkDevice*         m_device;
     Rc<DxvkPipelineCache>     m_cache;
     Rc<DxvkStateCache>        m_stateCache;
+    Rc<DxvkShaderCache>       m_shaderCache;
 
     std::atomic<uint32_t>     m_numComputePipelines  = { 0 };
     std::atomic<uint32_t>     m_numGraphicsPipelines = { 0 };
@@ -6,7 +6,7 @@ namespace dxvk {
   DxvkSampler::DxvkSampler(
           DxvkDevice*             device,
     const DxvkSamplerCreateInfo&  info)
-  : m_vkd(device->vkd()) {
+  : m_vkd(device->vkd()), m_info(info) {
     VkSamplerCustomBorderColorCreateInfoEXT borderColorInfo;
     borderColorInfo.sType               = VK_STRUCTURE_TYPE_SAMPLER_CUSTOM_BORDER_COLOR_CREATE_INFO_EXT;
     borderColorInfo.pNext               = nullptr;
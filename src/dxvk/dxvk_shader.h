@@ -220,6 +220,28 @@ namespace dxvk {
       return m_constData;
     }
     
+    /**
+     * \brief Resource slots
+     *
+     * Retrieves the resource slots
+     * used by the shader.
+     * \returns Resource slot infos
+     */
+    const std::vector<DxvkResourceSlot>& resourceSlots() const {
+      return m_slots;
+    }
+
+    /**
+     * \brief Retrieves SPIR-V code
+     *
+     * Returns the code that the shader was created
+     * with, without any resource bindings remapped.
+     * \returns Uncompressed SPIR-V code
+     */
+    SpirvCodeBuffer getRawCode() const {
+      return m_code.decompress();
+    }
+    
     /**
      * \brief Dumps SPIR-V shader
      * 
@@ -0,0 +1,342 @@
+#include <version.h>
+
+#include "dxvk_shader_cache.h"
+#include "dxvk_state_cache.h"
+
+#include "../util/util_lz4.h"
+
+namespace dxvk {
+
+  // Shaders larger than this are certainly not valid
+  constexpr static uint32_t MaxEntrySize = 64u << 20;
+
+
+  bool DxvkShaderCacheKey::eq(const DxvkShaderCacheKey& key) const {
+    return shaderKey.eq(key.shaderKey)
+        && optionsHash == key.optionsHash;
+  }
+
+
+  size_t DxvkShaderCacheKey::hash() const {
+    DxvkHashState hash;
+    hash.add(shaderKey.hash());
+    hash.add(optionsHash.dword(0));
+    return hash;
+  }
+
+
+  bool DxvkShaderCacheData::readShader(
+          Rc<DxvkShader>&           shader) {
+    uint32_t stage = 0;
+
+    if (!read(stage))
+      return false;
+
+    if (!stage) {
+      shader = nullptr;
+      return true;
+    }
+
+    std::vector<DxvkResourceSlot> slots;
+    std::vector<uint32_t>         constData;
+    std::vector<uint32_t>         code;
+
+    DxvkInterfaceSlots  iface;
+    DxvkShaderOptions   options;
+
+    if (!readVector(slots)
+     || !read(iface)
+     || !read(options)
+     || !readVector(constData)
+     || !readVector(code)
+     || code.empty())
+      return false;
+
+    shader = new DxvkShader(VkShaderStageFlagBits(stage),
+      slots.size(), slots.data(), iface,
+      SpirvCodeBuffer(code.size(), code.data()), options,
+      constData.empty()
+        ? DxvkShaderConstData()
+        : DxvkShaderConstData(constData.size(), constData.data()));
+    return true;
+  }
+
+
+  void DxvkShaderCacheData::writeShader(
+    const Rc<DxvkShader>&           shader) {
+    if (shader == nullptr) {
+      write(uint32_t(0));
+      return;
+    }
+
+    const DxvkShaderConstData& constData = shader->shaderConstants();
+    SpirvCodeBuffer code = shader->getRawCode();
+
+    write(uint32_t(shader->stage()));
+    writeVector(shader->resourceSlots());
+    write(shader->interfaceSlots());
+    write(shader->shaderOptions());
+
+    write(uint32_t(constData.sizeInBytes() / sizeof(uint32_t)));
+    writeRaw(constData.data(), constData.sizeInBytes());
+
+    write(uint32_t(code.dwords()));
+    writeRaw(code.data(), code.size());
+  }
+
+
+  bool DxvkShaderCacheData::readRaw(void* data, size_t size) {
+    if (size > m_data.size() - m_read)
+      return false;
+
+    if (size)
+      std::memcpy(data, &m_data[m_read], size);
+
+    m_read += size;
+    return true;
+  }
+
+
+  void DxvkShaderCacheData::writeRaw(const void* data, size_t size) {
+    size_t offset = m_data.size();
+    m_data.resize(offset + size);
+
+    if (size)
+      std::memcpy(&m_data[offset], data, size);
+  }
+
+
+  DxvkShaderCache::DxvkShaderCache(
+    const std::string&              fileName)
+  : m_fileName(fileName) {
+    // Any change to the compilers may change
+    // the generated code, so invalidate the
+    // cache whenever the version changes
+    DxvkShaderCacheHeader header;
+    header.compilerHash = Sha1Hash::compute(
+      DXVK_VERSION, std::strlen(DXVK_VERSION));
+
+    bool newFile = !readCacheFile(header);
+
+    if (newFile) {
+      Logger::warn("DXVK: Creating new shader cache file");
+
+      // Don't use any entries from the file
+      // that is about to get overwritten
+      m_entries.clear();
+      m_readFile.close();
+    }
+
+    m_writerThread = dxvk::thread([this, header, newFile] () {
+      writerFunc(header, newFile);
+    });
+  }
+
+
+  DxvkShaderCache::~DxvkShaderCache() {
+    { std::lock_guard<std::mutex> lock(m_writerLock);
+      m_stopped = true;
+    }
+
+    m_writerCond.notify_one();
+    m_writerThread.join();
+
+    Logger::info(str::format("DXVK: Shader cache: ",
+      m_hits.load(), " hits, ", m_misses.load(), " misses"));
+  }
+
+
+  bool DxvkShaderCache::lookup(
+    const DxvkShaderCacheKey&       key,
+          DxvkShaderCacheData&      data) {
+    auto entry = m_entries.find(key);
+
+    if (entry == m_entries.end()) {
+      m_misses += 1;
+      return false;
+    }
+
+    std::vector<char> compressed(entry->second.compressedSize);
+    bool success;
+
+    { std::lock_guard<std::mutex> lock(m_readLock);
+
+      m_readFile.clear();
+      success = m_readFile.seekg(entry->second.dataOffset)
+             && m_readFile.read(compressed.data(), compressed.size());
+    }
+
+    data.m_data.resize(entry->second.rawSize);
+    data.m_read = 0;
+
+    if (!success
+     || Sha1Hash::compute(compressed.data(), compressed.size()) != entry->second.dataHash
+     || !lz4::decompress(compressed.data(), compressed.size(), data.m_data.data(), data.m_data.size())) {
+      Logger::warn(str::format("DXVK: Failed to read shader ",
+        key.shaderKey.toString(), " from shader cache"));
+      m_misses += 1;
+      return false;
+    }
+
+    m_hits += 1;
+    return true;
+  }
+
+
+  void DxvkShaderCache::store(
+    const DxvkShaderCacheKey&       key,
+    const DxvkShaderCacheData&      data) {
+    // Compress on the calling thread, since multiple
+    // threads may be compiling shaders in parallel
+    WriterItem item;
+    item.data.resize(lz4::compressBound(data.m_data.size()));
+    item.data.resize(lz4::compress(data.m_data.data(),
+      data.m_data.size(), item.data.data(), item.data.size()));
+
+    if (item.data.empty() || data.m_data.size() > MaxEntrySize)
+      return;
+
+    item.header.shaderKey       = key.shaderKey;
+    item.header.optionsHash     = key.optionsHash;
+    item.header.rawSize         = uint32_t(data.m_data.size());
+    item.header.compressedSize  = uint32_t(item.data.size());
+    item.header.dataHash        = Sha1Hash::compute(item.data.data(), item.data.size());
+
+    std::lock_guard<std::mutex> lock(m_writerLock);
+    m_writerQueue.push(std::move(item));
+    m_writerCond.notify_one();
+  }
+
+
+  bool DxvkShaderCache::readCacheFile(
+    const DxvkShaderCacheHeader&    expectedHeader) {
+    m_readFile.open(m_fileName, std::ios_base::binary | std::ios_base::ate);
+
+    if (!m_readFile) {
+      Logger::warn("DXVK: No shader cache file found");
+      return false;
+    }
+
+    std::streamoff fileSize = m_readFile.tellg();
+    m_readFile.seekg(0);
+
+    DxvkShaderCacheHeader header;
+
+    if (!m_readFile.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(header.magic, expectedHeader.magic, sizeof(header.magic))
+     || header.version != expectedHeader.version) {
+      Logger::warn("DXVK: Invalid shader cache file");
+      return false;
+    }
+
+    if (header.compilerHash != expectedHeader.compilerHash) {
+      Logger::warn("DXVK: Shader cache file was created by a different DXVK version");
+      return false;
+    }
+
+    std::streamoff offset = sizeof(header);
+
+    while (offset < fileSize) {
+      DxvkShaderCacheEntryHeader entryHeader;
+
+      if (!m_readFile.read(reinterpret_cast<char*>(&entryHeader), sizeof(entryHeader))
+       || entryHeader.rawSize        > MaxEntrySize
+       || entryHeader.compressedSize > MaxEntrySize) {
+        // Entry boundaries can't be trusted after this
+        Logger::warn("DXVK: Invalid shader cache entry");
+        break;
+      }
+
+      EntryInfo info;
+      info.dataOffset     = offset + std::streamoff(sizeof(entryHeader));
+      info.rawSize        = entryHeader.rawSize;
+      info.compressedSize = entryHeader.compressedSize;
+      info.dataHash       = entryHeader.dataHash;
+
+      std::streamoff nextOffset = info.dataOffset + std::streamoff(info.compressedSize);
+
+      if (nextOffset > fileSize || !m_readFile.seekg(nextOffset)) {
+        Logger::warn("DXVK: Truncated shader cache entry");
+        break;
+      }
+
+      m_entries.insert({ { entryHeader.shaderKey, entryHeader.optionsHash }, info });
+      offset = nextOffset;
+    }
+
+    // This happens if the process was killed while writing an
+    // entry. Keep all entries read so far and drop the rest of
+    // the file, so that new entries get appended after them.
+    if (offset < fileSize) {
+      m_readFile.clear();
+
+      if (!env::truncateFile(m_fileName, uint64_t(offset))) {
+        Logger::warn("DXVK: Failed to truncate shader cache file");
+        return false;
+      }
+    }
+
+    Logger::info(str::format("DXVK: Read ", m_entries.size(), " shader cache entries"));
+    return true;
+  }
+
+
+  void DxvkShaderCache::writerFunc(
+    const DxvkShaderCacheHeader&    header,
+          bool                      newFile) {
+    env::setThreadName("dxvk-shader-cache");
+
+    std::ofstream file;
+
+    while (true) {
+      std::queue<WriterItem> items;
+
+      { std::unique_lock<std::mutex> lock(m_writerLock);
+
+        m_writerCond.wait(lock, [this] () {
+          return m_writerQueue.size()
+              || m_stopped;
+        });
+
+        if (m_writerQueue.empty())
+          break;
+
+        std::swap(items, m_writerQueue);
+      }
+
+      if (!file.is_open()) {
+        if (newFile) {
+          file = std::ofstream(m_fileName,
+            std::ios_base::binary |
+            std::ios_base::trunc);
+
+          if (!file && env::createDirectory(DxvkStateCache::getCacheDir())) {
+            file = std::ofstream(m_fileName,
+              std::ios_base::binary |
+              std::ios_base::trunc);
+          }
+
+          if (file) {
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            newFile = false;
+          }
+        } else {
+          file = std::ofstream(m_fileName,
+            std::ios_base::binary |
+            std::ios_base::app);
+        }
+      }
+
+      while (!items.empty()) {
+        const WriterItem& item = items.front();
+
+        file.write(reinterpret_cast<const char*>(&item.header), sizeof(item.header));
+        file.write(item.data.data(), item.data.size());
+        items.pop();
+      }
+
+      file.flush();
+    }
+  }
+
+}
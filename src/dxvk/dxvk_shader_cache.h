@@ -0,0 +1,248 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_shader.h"
+
+#include "../util/thread.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Shader cache file header
+   *
+   * Stores a hash of the DXVK version string, since
+   * any change to the shader compilers may change the
+   * generated code. Files created by a different
+   * version are discarded.
+   */
+  struct DxvkShaderCacheHeader {
+    char     magic[4]     = { 'D', 'X', 'S', 'C' };
+    uint32_t version      = 1;
+    Sha1Hash compilerHash;
+  };
+
+  static_assert(sizeof(DxvkShaderCacheHeader) == 28);
+
+
+  /**
+   * \brief Shader cache entry header
+   *
+   * Precedes the LZ4-compressed data of each entry.
+   * The options hash is provided by the front-end and
+   * identifies the options that affect code generation.
+   */
+  struct DxvkShaderCacheEntryHeader {
+    DxvkShaderKey shaderKey;
+    Sha1Hash      optionsHash;
+    uint32_t      rawSize;
+    uint32_t      compressedSize;
+    Sha1Hash      dataHash;
+  };
+
+  static_assert(sizeof(DxvkShaderCacheEntryHeader) == 72);
+
+
+  /**
+   * \brief Shader cache key
+   */
+  struct DxvkShaderCacheKey {
+    DxvkShaderKey shaderKey;
+    Sha1Hash      optionsHash;
+
+    bool eq(const DxvkShaderCacheKey& key) const;
+
+    size_t hash() const;
+  };
+
+
+  /**
+   * \brief Shader cache statistics
+   */
+  struct DxvkShaderCacheStats {
+    uint32_t hits;
+    uint32_t misses;
+  };
+
+
+  /**
+   * \brief Shader cache data
+   *
+   * Serialized form of one or more shader objects,
+   * along with any additional data that the front-end
+   * needs in order to recreate its own shader objects
+   * without running the shader compiler.
+   */
+  class DxvkShaderCacheData {
+    friend class DxvkShaderCache;
+  public:
+
+    /**
+     * \brief Checks whether all data has been read
+     * \returns \c true if there is no more data
+     */
+    bool eof() const {
+      return m_read == m_data.size();
+    }
+
+    template<typename T>
+    bool read(T& data) {
+      return readRaw(&data, sizeof(T));
+    }
+
+    template<typename T>
+    void write(const T& data) {
+      writeRaw(&data, sizeof(T));
+    }
+
+    template<typename T>
+    bool readVector(std::vector<T>& data) {
+      uint32_t count = 0;
+
+      if (!read(count) || count > (m_data.size() - m_read) / sizeof(T))
+        return false;
+
+      data.resize(count);
+      return readRaw(data.data(), count * sizeof(T));
+    }
+
+    template<typename T>
+    void writeVector(const std::vector<T>& data) {
+      write(uint32_t(data.size()));
+      writeRaw(data.data(), data.size() * sizeof(T));
+    }
+
+    /**
+     * \brief Reads a shader
+     *
+     * The shader key is not stored and
+     * must be set by the caller.
+     * \param [out] shader The shader, may be \c nullptr
+     * \returns \c true on success
+     */
+    bool readShader(
+            Rc<DxvkShader>&           shader);
+
+    /**
+     * \brief Writes a shader
+     * \param [in] shader The shader, may be \c nullptr
+     */
+    void writeShader(
+      const Rc<DxvkShader>&           shader);
+
+  private:
+
+    size_t            m_read = 0;
+    std::vector<char> m_data;
+
+    bool readRaw(void* data, size_t size);
+
+    void writeRaw(const void* data, size_t size);
+
+  };
+
+
+  /**
+   * \brief Shader cache
+   *
+   * Persistent on-disk cache for compiled shaders,
+   * which allows front-ends to skip shader compilation
+   * for shaders that were already compiled in a previous
+   * run. Only the entry headers are read on startup,
+   * entry data is read from the file on demand.
+   *
+   * New entries are appended to the file by a
+   * background thread, similar to the state cache.
+   */
+  class DxvkShaderCache : public RcObject {
+
+  public:
+
+    DxvkShaderCache(
+      const std::string&              fileName);
+
+    ~DxvkShaderCache();
+
+    /**
+     * \brief Looks up a shader
+     *
+     * \param [in] key Shader cache key
+     * \param [out] data Shader data
+     * \returns \c true if the shader was found
+     */
+    bool lookup(
+      const DxvkShaderCacheKey&       key,
+            DxvkShaderCacheData&      data);
+
+    /**
+     * \brief Stores a shader
+     *
+     * Compresses the data and queues it for being
+     * written to the file. Should only be called
+     * after a failed lookup.
+     * \param [in] key Shader cache key
+     * \param [in] data Shader data
+     */
+    void store(
+      const DxvkShaderCacheKey&       key,
+      const DxvkShaderCacheData&      data);
+
+    /**
+     * \brief Queries lookup statistics
+     * \returns Number of cache hits and misses
+     */
+    DxvkShaderCacheStats getStats() const {
+      DxvkShaderCacheStats result;
+      result.hits   = m_hits.load();
+      result.misses = m_misses.load();
+      return result;
+    }
+
+  private:
+
+    struct EntryInfo {
+      std::streamoff  dataOffset;
+      uint32_t        rawSize;
+      uint32_t        compressedSize;
+      Sha1Hash        dataHash;
+    };
+
+    struct WriterItem {
+      DxvkShaderCacheEntryHeader  header;
+      std::vector<char>           data;
+    };
+
+    std::string                       m_fileName;
+
+    std::mutex                        m_readLock;
+    std::ifstream                     m_readFile;
+
+    std::unordered_map<
+      DxvkShaderCacheKey, EntryInfo,
+      DxvkHash, DxvkEq> m_entries;
+
+    std::atomic<uint32_t>             m_hits   = { 0u };
+    std::atomic<uint32_t>             m_misses = { 0u };
+
+    std::mutex                        m_writerLock;
+    std::condition_variable           m_writerCond;
+    std::queue<WriterItem>            m_writerQueue;
+    bool                              m_stopped = false;
+    dxvk::thread                      m_writerThread;
+
+    bool readCacheFile(
+      const DxvkShaderCacheHeader&    expectedHeader);
+
+    void writerFunc(
+      const DxvkShaderCacheHeader&    header,
+            bool                      newFile);
+
+  };
+
+}
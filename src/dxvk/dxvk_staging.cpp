@@ -4,7 +4,7 @@
 namespace dxvk {
   
   DxvkStagingDataAlloc::DxvkStagingDataAlloc(const Rc<DxvkDevice>& device)
-  : m_device(device) {
+  : m_device(device), m_fence(new sync::Fence()) {
 
   }
 
@@ -15,43 +15,101 @@ namespace dxvk {
 
 
   DxvkBufferSlice DxvkStagingDataAlloc::alloc(VkDeviceSize align, VkDeviceSize size) {
-    if (size > MaxBufferSize)
-      return DxvkBufferSlice(createBuffer(size));
-    
-    if (m_buffer == nullptr)
-      m_buffer = createBuffer(MaxBufferSize);
-    
-    if (!m_buffer->isInUse())
-      m_offset = 0;
-    
-    m_offset = dxvk::align(m_offset, align);
+    m_bytes += size;
 
-    if (m_offset + size > MaxBufferSize) {
-      m_offset = 0;
+    return size <= MaxSmallSize
+      ? allocSmall(align, size)
+      : allocLarge(size);
+  }
+
+
+  void DxvkStagingDataAlloc::track(const Rc<DxvkCommandList>& cmdList) {
+    if (!m_bytes)
+      return;
+
+    cmdList->queueSignal(m_fence, m_sequence++);
+    cmdList->addStatCtr(DxvkStatCounter::StagingBytes, m_bytes);
+
+    m_bytes = 0;
+  }
+
+
+  void DxvkStagingDataAlloc::trim() {
+    m_page   = Page();
+    m_offset = 0;
 
-      if (m_buffers.size() < MaxBufferCount)
-        m_buffers.push(std::move(m_buffer));
+    while (!m_pages.empty())
+      m_pages.pop();
 
-      if (!m_buffers.front()->isInUse()) {
-        m_buffer = std::move(m_buffers.front());
-        m_buffers.pop();
+    for (auto& pages : m_largePages)
+      pages.clear();
+  }
+
+
+  DxvkBufferSlice DxvkStagingDataAlloc::allocSmall(VkDeviceSize align, VkDeviceSize size) {
+    m_offset = dxvk::align(m_offset, align);
+
+    if (m_page.buffer == nullptr || m_offset + size > PageSize) {
+      if (m_page.buffer != nullptr)
+        m_pages.push(std::move(m_page));
+
+      // Pages complete in the order they were retired, so
+      // only the oldest one needs to be checked for reuse
+      if (!m_pages.empty() && isIdle(m_pages.front())) {
+        m_page = std::move(m_pages.front());
+        m_pages.pop();
       } else {
-        m_buffer = createBuffer(MaxBufferSize);
+        m_page.buffer = createBuffer(PageSize);
       }
+
+      // Release the oldest pages after an upload burst so
+      // that we don't keep host memory allocated forever.
+      // Command lists still using them keep them alive.
+      while (m_pages.size() > MaxPageCount)
+        m_pages.pop();
+
+      m_offset = 0;
     }
 
-    DxvkBufferSlice slice(m_buffer, m_offset, size);
+    m_page.sequence = m_sequence;
+
+    DxvkBufferSlice slice(m_page.buffer, m_offset, size);
     m_offset = dxvk::align(m_offset + size, align);
     return slice;
   }
 
 
-  void DxvkStagingDataAlloc::trim() {
-    m_buffer = nullptr;
-    m_offset = 0;
+  DxvkBufferSlice DxvkStagingDataAlloc::allocLarge(VkDeviceSize size) {
+    // Uploads that exceed the largest size class are
+    // rare enough that caching the buffer is not useful
+    if (size > (VkDeviceSize(1) << MaxLargeClass))
+      return DxvkBufferSlice(createBuffer(size));
+
+    uint32_t sizeClass = MinLargeClass;
+
+    while ((VkDeviceSize(1) << sizeClass) < size)
+      sizeClass += 1;
+
+    auto& pages = m_largePages[sizeClass - MinLargeClass];
+
+    for (auto& page : pages) {
+      if (isIdle(page)) {
+        page.sequence = m_sequence;
+        return DxvkBufferSlice(page.buffer, 0, size);
+      }
+    }
+
+    // Drop the oldest buffer if the pool is full. Command
+    // lists that still use it keep it alive as needed.
+    if (pages.size() >= MaxLargeCount)
+      pages.erase(pages.begin());
+
+    Page page;
+    page.buffer   = createBuffer(VkDeviceSize(1) << sizeClass);
+    page.sequence = m_sequence;
+    pages.push_back(page);
 
-    while (!m_buffers.empty())
-      m_buffers.pop();
+    return DxvkBufferSlice(page.buffer, 0, size);
   }
 
 
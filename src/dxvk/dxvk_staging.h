@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
 #include <queue>
+#include <vector>
 
 #include "dxvk_buffer.h"
+#include "dxvk_cmdlist.h"
 
 namespace dxvk {
   
@@ -11,13 +14,26 @@ namespace dxvk {
   /**
    * \brief Staging data allocator
    *
-   * Allocates buffer slices for resource uploads,
-   * while trying to keep the number of allocations
-   * but also the amount of allocated memory low.
+   * Allocates buffer slices for resource uploads. Small
+   * allocations are sub-allocated linearly from a ring of
+   * fixed-size pages, larger ones are served from pools of
+   * power-of-two sized buffers. Buffers are reused once the
+   * command list that last used them has completed, which is
+   * tracked by assigning a sequence number to each command
+   * list that uses staging memory.
    */
   class DxvkStagingDataAlloc {
-    constexpr static VkDeviceSize MaxBufferSize  = 1 << 25; // 32 MiB
-    constexpr static uint32_t     MaxBufferCount = 2;
+    /// Size of pages used for small allocations
+    constexpr static VkDeviceSize PageSize       = 1 << 22; // 4 MiB
+    /// Largest allocation to serve from the page ring
+    constexpr static VkDeviceSize MaxSmallSize   = PageSize / 4;
+    /// Number of retired pages to keep around for reuse
+    constexpr static size_t       MaxPageCount   = 16;      // 64 MiB
+    /// Smallest and largest size class, as a power of two
+    constexpr static uint32_t     MinLargeClass  = 21;      // 2 MiB
+    constexpr static uint32_t     MaxLargeClass  = 28;      // 256 MiB
+    /// Number of buffers to keep around per size class
+    constexpr static size_t       MaxLargeCount  = 2;
   public:
 
     DxvkStagingDataAlloc(const Rc<DxvkDevice>& device);
@@ -33,6 +49,18 @@ namespace dxvk {
      */
     DxvkBufferSlice alloc(VkDeviceSize align, VkDeviceSize size);
 
+    /**
+     * \brief Tracks staging memory usage
+     *
+     * Must be called when the given command list has been
+     * recorded. If any staging memory was allocated since
+     * the last call, the command list will signal the
+     * current sequence number upon completion, and the
+     * number of bytes staged gets added to its counters.
+     * \param [in] cmdList The command list
+     */
+    void track(const Rc<DxvkCommandList>& cmdList);
+
     /**
      * \brief Deletes all staging buffers
      * 
@@ -43,11 +71,31 @@ namespace dxvk {
 
   private:
 
+    struct Page {
+      Rc<DxvkBuffer>  buffer;
+      uint64_t        sequence = 0;
+    };
+
     Rc<DxvkDevice>  m_device;
-    Rc<DxvkBuffer>  m_buffer;
+    Rc<sync::Fence> m_fence;
+
+    uint64_t        m_sequence = 1;
+    VkDeviceSize    m_bytes    = 0;
+
+    Page            m_page;
     VkDeviceSize    m_offset = 0;
 
-    std::queue<Rc<DxvkBuffer>> m_buffers;
+    std::queue<Page> m_pages;
+
+    std::array<std::vector<Page>, MaxLargeClass - MinLargeClass + 1> m_largePages;
+
+    DxvkBufferSlice allocSmall(VkDeviceSize align, VkDeviceSize size);
+
+    DxvkBufferSlice allocLarge(VkDeviceSize size);
+
+    bool isIdle(const Page& page) const {
+      return m_fence->value() >= page.sequence;
+    }
 
     Rc<DxvkBuffer> createBuffer(VkDeviceSize size);
 
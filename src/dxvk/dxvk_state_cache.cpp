@@ -8,89 +8,58 @@ namespace dxvk {
   static const DxvkShaderKey  g_nullShaderKey = DxvkShaderKey();
 
 
-  /**
-   * \brief Packed entry header
-   */
-  struct DxvkStateCacheEntryHeader {
-    uint32_t stageMask : 8;
-    uint32_t entrySize : 24;
-  };
-
-  
-  /**
-   * \brief State cache entry data
-   *
-   * Stores data for a single cache entry and
-   * provides convenience methods to access it.
-   */
-  class DxvkStateCacheEntryData {
-    constexpr static size_t MaxSize = 1024;
-  public:
+  constexpr static auto WriterDelay = std::chrono::seconds(2);
 
-    size_t size() const {
-      return m_size;
-    }
+  // Usage data is written once the startup window ends, and
+  // then at exponentially increasing intervals, since the
+  // process may be killed before the state cache is destroyed
+  constexpr static auto UsageSnapshotDelay = std::chrono::seconds(60);
 
-    const char* data() const {
-      return m_data;
-    }
+  // Pipelines first used within this time after startup are
+  // compiled in the order in which they were used last time
+  constexpr static uint32_t StartupWindowMs = 60000;
 
-    Sha1Hash computeHash() const {
-      return Sha1Hash::compute(m_data, m_size);
-    }
-
-    template<typename T>
-    bool read(T& data) {
-      if (m_read + sizeof(T) > m_size)
-        return false;
-      
-      std::memcpy(&data, &m_data[m_read], sizeof(T));
-      m_read += sizeof(T);
-      return true;
-    }
-
-    template<typename T>
-    bool write(const T& data) {
-      if (m_size + sizeof(T) > MaxSize)
-        return false;
-      
-      std::memcpy(&m_data[m_size], &data, sizeof(T));
-      m_size += sizeof(T);
-      return true;
-    }
+  // Usage data that is older than this number of runs is ignored
+  constexpr static uint32_t MaxUsageAge = 8;
 
-    bool readFromStream(std::istream& stream, size_t size) {
-      if (size > MaxSize)
-        return false;
-
-      if (!stream.read(m_data, size))
-        return false;
-
-      m_size = size;
-      m_read = 0;
-      return true;
-    }
-
-  private:
-
-    size_t m_size = 0;
-    size_t m_read = 0;
-    char   m_data[MaxSize];
+  // Rewrite the file once it has accumulated this many usage blocks
+  constexpr static uint32_t MaxUsageBlocks = 32;
 
+  enum class DxvkStateCachePriorityClass : uint32_t {
+    Startup = 0,
+    Used    = 1,
+    Unused  = 2,
   };
 
 
-  template<typename T>
-  bool readCacheEntryTyped(std::istream& stream, T& entry) {
-    auto data = reinterpret_cast<char*>(&entry);
-    auto size = sizeof(entry);
+  /**
+   * \brief Computes compile priority of an entry
+   *
+   * Lower values are compiled first. Pipelines needed
+   * during startup come first, ordered by the time of
+   * first use, followed by the remaining pipelines used
+   * in recent runs, ordered by use count.
+   * \param [in] usage Usage record, may be \c nullptr
+   * \param [in] currentRun Number of the current run
+   * \returns Priority value
+   */
+  static uint64_t computeEntryPriority(
+    const DxvkStateCacheUsage*  usage,
+          uint32_t              currentRun) {
+    DxvkStateCachePriorityClass priorityClass = DxvkStateCachePriorityClass::Unused;
+    uint32_t priorityValue = 0;
+
+    if (usage && usage->lastRun + MaxUsageAge >= currentRun) {
+      if (usage->firstUse < StartupWindowMs) {
+        priorityClass = DxvkStateCachePriorityClass::Startup;
+        priorityValue = usage->firstUse;
+      } else {
+        priorityClass = DxvkStateCachePriorityClass::Used;
+        priorityValue = ~usage->useCount;
+      }
+    }
 
-    if (!stream.read(data, size))
-      return false;
-    
-    Sha1Hash expectedHash = std::exchange(entry.hash, g_nullHash);
-    Sha1Hash computedHash = Sha1Hash::compute(entry);
-    return expectedHash == computedHash;
+    return (uint64_t(priorityClass) << 32) | priorityValue;
   }
 
 
@@ -121,11 +90,52 @@ namespace dxvk {
           DxvkPipelineManager*  pipeManager,
           DxvkRenderPassPool*   passManager)
   : m_pipeManager(pipeManager),
-    m_passManager(passManager) {
-    bool newFile = !readCacheFile();
+    m_passManager(passManager),
+    m_startTime  (high_resolution_clock::now()) {
+    std::vector<DxvkStateCacheUsage> usage;
+    uint32_t usageBlockCount = 0;
 
-    if (newFile) {
-      Logger::warn("DXVK: Creating new state cache file");
+    bool newFile = !readCacheFile(usage, usageBlockCount);
+
+    // Merge usage records of all previous runs
+    std::unordered_map<Sha1Hash, DxvkStateCacheUsage,
+      DxvkStateCacheEntryHashFn> usageMap;
+
+    for (const auto& record : usage) {
+      auto result = usageMap.insert({ record.entryHash, record });
+
+      if (!result.second)
+        result.first->second.merge(record);
+
+      m_currentRun = std::max(m_currentRun, record.lastRun + 1);
+    }
+
+    m_entryPriorities.resize(m_entries.size());
+
+    for (size_t i = 0; i < m_entries.size(); i++) {
+      auto record = usageMap.find(m_entries[i].hash);
+
+      m_entryPriorities[i] = computeEntryPriority(
+        record != usageMap.end() ? &record->second : nullptr,
+        m_currentRun);
+    }
+
+    if (newFile || usageBlockCount > MaxUsageBlocks) {
+      if (newFile)
+        Logger::warn("DXVK: Creating new state cache file");
+      else
+        Logger::info("DXVK: Compacting state cache file");
+
+      // Load all valid entries before truncating the file
+      std::vector<DxvkStateCacheEntry> entries;
+      entries.reserve(m_entries.size());
+
+      for (size_t i = 0; i < m_entries.size(); i++) {
+        auto entry = getEntry(i);
+
+        if (entry != nullptr)
+          entries.push_back(*entry);
+      }
 
       // Start with an empty file
       std::ofstream file(getCacheFileName(),
@@ -138,18 +148,26 @@ namespace dxvk {
           std::ios_base::trunc);
       }
 
-      // Write header with the current version number
-      DxvkStateCacheHeader header;
+      // Write header with the current version number, as well
+      // as all valid entries in case we're recovering or
+      // upgrading an existing cache file
+      DxvkStateCacheWriter writer(file);
+      writer.writeHeader();
+      writer.writeEntries(entries.data(), entries.size());
+
+      // Only keep one merged usage record per entry
+      std::vector<DxvkStateCacheUsage> mergedUsage;
 
-      auto data = reinterpret_cast<const char*>(&header);
-      auto size = sizeof(header);
+      for (const auto& entry : entries) {
+        auto record = usageMap.find(entry.hash);
 
-      file.write(data, size);
+        if (record != usageMap.end()) {
+          mergedUsage.push_back(record->second);
+          usageMap.erase(record);
+        }
+      }
 
-      // Write all valid entries to the cache file in
-      // case we're recovering a corrupted cache file
-      for (auto& e : m_entries)
-        writeCacheEntry(file, e);
+      writer.writeUsage(mergedUsage.data(), mergedUsage.size());
     }
 
     // Use half the available CPU cores for pipeline compilation
@@ -204,9 +222,9 @@ namespace dxvk {
     auto entries = m_entryMap.equal_range(shaders);
 
     for (auto e = entries.first; e != entries.second; e++) {
-      const DxvkStateCacheEntry& entry = m_entries[e->second];
+      auto entry = getEntry(e->second);
 
-      if (entry.format.eq(format) && entry.gpState == state)
+      if (entry && entry->format.eq(format) && entry->gpState == state)
         return;
     }
 
@@ -230,7 +248,9 @@ namespace dxvk {
     auto entries = m_entryMap.equal_range(shaders);
 
     for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].cpState == state)
+      auto entry = getEntry(e->second);
+
+      if (entry && entry->cpState == state)
         return;
     }
 
@@ -261,6 +281,7 @@ namespace dxvk {
 
     for (auto p = pipelines.first; p != pipelines.second; p++) {
       WorkerItem item;
+      item.priority = getPipelinePriority(p->second);
 
       if (!getShaderByKey(p->second.vs,  item.gp.vs)
        || !getShaderByKey(p->second.tcs, item.gp.tcs)
@@ -273,6 +294,7 @@ namespace dxvk {
       if (!workerLock)
         workerLock = std::unique_lock<std::mutex>(m_workerLock);
       
+      item.sequence = m_workerSequence++;
       m_workerQueue.push(item);
     }
 
@@ -281,6 +303,27 @@ namespace dxvk {
   }
 
 
+  void DxvkStateCache::compileGraphicsPipeline(
+          DxvkGraphicsPipeline*           pipeline,
+          DxvkGraphicsPipelineInstance*   instance) {
+    std::lock_guard<std::mutex> workerLock(m_workerLock);
+    m_asyncQueue.push({ pipeline, instance });
+    m_workerCond.notify_one();
+  }
+
+
+  void DxvkStateCache::registerUse(
+          DxvkGraphicsPipeline*           pipeline,
+          DxvkGraphicsPipelineInstance*   instance) {
+    auto time = std::chrono::duration_cast<std::chrono::milliseconds>(
+      high_resolution_clock::now() - m_startTime);
+
+    std::lock_guard<std::mutex> lock(m_writerLock);
+    m_usageQueue.push_back({ pipeline, instance,
+      uint32_t(std::min<int64_t>(time.count(), ~0u)) });
+  }
+
+
   DxvkShaderKey DxvkStateCache::getShaderKey(const Rc<DxvkShader>& shader) const {
     return shader != nullptr ? shader->getShaderKey() : g_nullShaderKey;
   }
@@ -301,6 +344,61 @@ namespace dxvk {
   }
 
 
+  void DxvkStateCache::addEntry(
+    const DxvkStateCacheEntry&      entry,
+          uint32_t                  blockId) {
+    size_t entryId = m_entries.size();
+    m_entries.push_back(entry);
+    m_entryBlocks.push_back(blockId);
+
+    mapPipelineToEntry(entry.shaders, entryId);
+
+    mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
+    mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
+    mapShaderToPipeline(entry.shaders.tes, entry.shaders);
+    mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
+    mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
+    mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
+  }
+
+
+  const DxvkStateCacheEntry* DxvkStateCache::getEntry(
+          size_t                    entryId) {
+    uint32_t blockId = m_entryBlocks[entryId];
+
+    if (blockId != ~0u) {
+      std::lock_guard<std::mutex> lock(m_blockLock);
+
+      if (!loadBlock(m_blocks[blockId]))
+        return nullptr;
+    }
+
+    return &m_entries[entryId];
+  }
+
+
+  bool DxvkStateCache::loadBlock(
+          BlockInfo&                block) {
+    if (block.status != BlockStatus::Pending)
+      return block.status == BlockStatus::Loaded;
+
+    // Mark the block as invalid until all entries are read
+    // successfully, so that we don't try to load it again
+    block.status = BlockStatus::Invalid;
+
+    std::ifstream file(getCacheFileName(), std::ios_base::binary);
+    DxvkStateCacheReader reader(file);
+
+    if (!reader.readBlockData(block.block, &m_entries[block.firstEntry])) {
+      Logger::warn("DXVK: Failed to read state cache block");
+      return false;
+    }
+
+    block.status = BlockStatus::Loaded;
+    return true;
+  }
+
+
   void DxvkStateCache::mapPipelineToEntry(
     const DxvkStateCacheKey&        key,
           size_t                    entryId) {
@@ -316,6 +414,19 @@ namespace dxvk {
   }
 
 
+  uint64_t DxvkStateCache::getPipelinePriority(
+    const DxvkStateCacheKey&        key) const {
+    uint64_t priority = ~0ull;
+
+    auto entries = m_entryMap.equal_range(key);
+
+    for (auto e = entries.first; e != entries.second; e++)
+      priority = std::min(priority, m_entryPriorities[e->second]);
+
+    return priority;
+  }
+
+
   void DxvkStateCache::compilePipelines(const WorkerItem& item) {
     DxvkStateCacheKey key;
     key.vs  = getShaderKey(item.gp.vs);
@@ -330,24 +441,30 @@ namespace dxvk {
       auto entries = m_entryMap.equal_range(key);
 
       for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
+        auto entry = getEntry(e->second);
 
-        auto rp = m_passManager->getRenderPass(entry.format);
-        pipeline->compilePipeline(entry.gpState, rp);
+        if (entry != nullptr) {
+          auto rp = m_passManager->getRenderPass(entry->format);
+          pipeline->compilePipeline(entry->gpState, rp);
+        }
       }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cp);
       auto entries = m_entryMap.equal_range(key);
 
       for (auto e = entries.first; e != entries.second; e++) {
-        const auto& entry = m_entries[e->second];
-        pipeline->compilePipeline(entry.cpState);
+        auto entry = getEntry(e->second);
+
+        if (entry != nullptr)
+          pipeline->compilePipeline(entry->cpState);
       }
     }
   }
 
 
-  bool DxvkStateCache::readCacheFile() {
+  bool DxvkStateCache::readCacheFile(
+          std::vector<DxvkStateCacheUsage>& usage,
+          uint32_t&                 usageBlockCount) {
     // Open state file and just fail if it doesn't exist
     std::ifstream ifile(getCacheFileName(), std::ios_base::binary);
 
@@ -359,38 +476,13 @@ namespace dxvk {
     // The header stores the state cache version,
     // we need to regenerate it if it's outdated
     DxvkStateCacheHeader newHeader;
-    DxvkStateCacheHeader curHeader;
+    DxvkStateCacheReader reader(ifile);
 
-    if (!readCacheHeader(ifile, curHeader)) {
-      Logger::warn("DXVK: Failed to read state cache header");
+    if (!reader.readHeader())
       return false;
-    }
-
-    // Struct size hasn't changed between v2 and v4
-    size_t expectedSize = newHeader.entrySize;
-
-    if (curHeader.version <= 4)
-      expectedSize = sizeof(DxvkStateCacheEntryV4);
-    else if (curHeader.version <= 5)
-      expectedSize = sizeof(DxvkStateCacheEntryV5);
-    else if (curHeader.version <= 6)
-      expectedSize = sizeof(DxvkStateCacheEntryV6);
-    else if (curHeader.version <= 7)
-      expectedSize = sizeof(DxvkStateCacheEntry);
-
-    if (curHeader.entrySize != expectedSize) {
-      Logger::warn("DXVK: State cache entry size changed");
-      return false;
-    }
-
-    // Discard caches of unsupported versions
-    if (curHeader.version < 2 || curHeader.version > newHeader.version) {
-      Logger::warn("DXVK: State cache version not supported");
-      return false;
-    }
 
     // Notify user about format conversion
-    if (curHeader.version != newHeader.version)
+    if (reader.version() != newHeader.version)
       Logger::warn(str::format("DXVK: Updating state cache version to v", newHeader.version));
 
     // Read actual cache entries from the file.
@@ -398,23 +490,43 @@ namespace dxvk {
     // regenerate the entire state cache file.
     uint32_t numInvalidEntries = 0;
 
-    while (ifile) {
-      DxvkStateCacheEntry entry;
+    if (reader.version() >= 9) {
+      // Only read the block indices here, the
+      // rest of the data is loaded on demand
+      std::vector<DxvkStateCacheEntry> entries;
+      std::vector<DxvkStateCacheUsage> blockUsage;
+
+      while (!reader.eof()) {
+        BlockInfo block;
+        block.firstEntry  = uint32_t(m_entries.size());
+        block.status      = BlockStatus::Pending;
+
+        if (!reader.readBlockIndex(block.block, entries, blockUsage)) {
+          // Block boundaries can't be trusted after this
+          Logger::warn("DXVK: Skipped invalid state cache block");
+          return false;
+        }
 
-      if (readCacheEntry(curHeader.version, ifile, entry)) {
-        size_t entryId = m_entries.size();
-        m_entries.push_back(entry);
+        if (block.block.type == DxvkStateCacheBlockType::Usage) {
+          usage.insert(usage.end(), blockUsage.begin(), blockUsage.end());
+          usageBlockCount += 1;
+          continue;
+        }
 
-        mapPipelineToEntry(entry.shaders, entryId);
+        uint32_t blockId = uint32_t(m_blocks.size());
+        m_blocks.push_back(block);
 
-        mapShaderToPipeline(entry.shaders.vs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.tcs, entry.shaders);
-        mapShaderToPipeline(entry.shaders.tes, entry.shaders);
-        mapShaderToPipeline(entry.shaders.gs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.fs,  entry.shaders);
-        mapShaderToPipeline(entry.shaders.cs,  entry.shaders);
-      } else if (ifile) {
-        numInvalidEntries += 1;
+        for (const auto& entry : entries)
+          addEntry(entry, blockId);
+      }
+    } else {
+      while (!reader.eof()) {
+        DxvkStateCacheEntry entry;
+
+        if (reader.readEntry(entry))
+          addEntry(entry, ~0u);
+        else if (!reader.eof())
+          numInvalidEntries += 1;
       }
     }
 
@@ -430,454 +542,7 @@ namespace dxvk {
     }
     
     // Rewrite entire state cache if it is outdated
-    return curHeader.version == newHeader.version;
-  }
-
-
-  bool DxvkStateCache::readCacheHeader(
-          std::istream&             stream,
-          DxvkStateCacheHeader&     header) const {
-    DxvkStateCacheHeader expected;
-
-    auto data = reinterpret_cast<char*>(&header);
-    auto size = sizeof(header);
-
-    if (!stream.read(data, size))
-      return false;
-    
-    for (uint32_t i = 0; i < 4; i++) {
-      if (expected.magic[i] != header.magic[i])
-        return false;
-    }
-    
-    return true;
-  }
-
-
-  bool DxvkStateCache::readCacheEntryV7(
-          uint32_t                  version,
-          std::istream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
-    if (version <= 6) {
-      DxvkStateCacheEntryV6 v6;
-
-      if (version <= 4) {
-        DxvkStateCacheEntryV4 v4;
-
-        if (!readCacheEntryTyped(stream, v4))
-          return false;
-
-        if (version == 2)
-          convertEntryV2(v4);
-
-        if (!convertEntryV4(v4, v6))
-          return false;
-      } else if (version <= 5) {
-        DxvkStateCacheEntryV5 v5;
-
-        if (!readCacheEntryTyped(stream, v5))
-          return false;
-
-        if (!convertEntryV5(v5, v6))
-          return false;
-      } else {
-        if (!readCacheEntryTyped(stream, v6))
-          return false;
-      }
-
-      return convertEntryV6(v6, entry);
-    } else {
-      return readCacheEntryTyped(stream, entry);
-    }
-  }
-
-
-  bool DxvkStateCache::readCacheEntry(
-          uint32_t                  version,
-          std::istream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
-    if (version < 8)
-      return readCacheEntryV7(version, stream, entry);
-
-    // Read entry metadata and actual data
-    DxvkStateCacheEntryHeader header;
-    DxvkStateCacheEntryData data;
-    Sha1Hash hash;
-  
-    if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))
-     || !stream.read(reinterpret_cast<char*>(&hash), sizeof(hash))
-     || !data.readFromStream(stream, header.entrySize))
-      return false;
-
-    // Validate hash, skip entry if invalid
-    if (hash != data.computeHash())
-      return false;
-
-    // Read shader hashes
-    VkShaderStageFlags stageMask = VkShaderStageFlags(header.stageMask);
-    auto keys = &entry.shaders.vs;
-
-    for (uint32_t i = 0; i < 6; i++) {
-      if (stageMask & VkShaderStageFlagBits(1 << i))
-        data.read(keys[i]);
-      else
-        keys[i] = g_nullShaderKey;
-    }
-
-    if (stageMask & VK_SHADER_STAGE_COMPUTE_BIT) {
-      if (!data.read(entry.cpState.bsBindingMask))
-        return false;
-    } else {
-      // Read packed render pass format
-      uint8_t sampleCount = 0;
-      uint8_t imageFormat = 0;
-      uint8_t imageLayout = 0;
-
-      if (!data.read(sampleCount)
-       || !data.read(imageFormat)
-       || !data.read(imageLayout))
-        return false;
-
-      entry.format.sampleCount = VkSampleCountFlagBits(sampleCount);
-      entry.format.depth.format = VkFormat(imageFormat);
-      entry.format.depth.layout = unpackImageLayout(imageLayout);
-
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
-        if (!data.read(imageFormat)
-         || !data.read(imageLayout))
-          return false;
-
-        entry.format.color[i].format = VkFormat(imageFormat);
-        entry.format.color[i].layout = unpackImageLayout(imageLayout);
-      }
-
-      if (!validateRenderPassFormat(entry.format))
-        return false;
-
-      // Read common pipeline state
-      if (!data.read(entry.gpState.bsBindingMask)
-       || !data.read(entry.gpState.ia)
-       || !data.read(entry.gpState.il)
-       || !data.read(entry.gpState.rs)
-       || !data.read(entry.gpState.ms)
-       || !data.read(entry.gpState.ds)
-       || !data.read(entry.gpState.om)
-       || !data.read(entry.gpState.dsFront)
-       || !data.read(entry.gpState.dsBack))
-        return false;
-
-      if (entry.gpState.il.attributeCount() > MaxNumVertexAttributes
-       || entry.gpState.il.bindingCount() > MaxNumVertexBindings)
-        return false;
-
-      // Read render target swizzles
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
-        if (!data.read(entry.gpState.omSwizzle[i]))
-          return false;
-      }
-
-      // Read render target blend info
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
-        if (!data.read(entry.gpState.omBlend[i]))
-          return false;
-      }
-
-      // Read defined vertex attributes
-      for (uint32_t i = 0; i < entry.gpState.il.attributeCount(); i++) {
-        if (!data.read(entry.gpState.ilAttributes[i]))
-          return false;
-      }
-
-      // Read defined vertex bindings
-      for (uint32_t i = 0; i < entry.gpState.il.bindingCount(); i++) {
-        if (!data.read(entry.gpState.ilBindings[i]))
-          return false;
-      }
-    }
-
-    // Read non-zero spec constants
-    auto& sc = (stageMask & VK_SHADER_STAGE_COMPUTE_BIT)
-      ? entry.cpState.sc
-      : entry.gpState.sc;
-
-    uint32_t specConstantMask = 0;
-
-    if (!data.read(specConstantMask))
-      return false;
-
-    for (uint32_t i = 0; i < MaxNumSpecConstants; i++) {
-      if (specConstantMask & (1 << i)) {
-        if (!data.read(sc.specConstants[i]))
-          return false;
-      }
-    }
-
-    return true;
-  }
-
-
-  void DxvkStateCache::writeCacheEntry(
-          std::ostream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
-    DxvkStateCacheEntryData data;
-    VkShaderStageFlags stageMask = 0;
-
-    // Write shader hashes
-    auto keys = &entry.shaders.vs;
-
-    for (uint32_t i = 0; i < 6; i++) {
-      if (!keys[i].eq(g_nullShaderKey)) {
-        stageMask |= VkShaderStageFlagBits(1 << i);
-        data.write(keys[i]);
-      }
-    }
-
-    if (stageMask & VK_SHADER_STAGE_COMPUTE_BIT) {
-      // Nothing else here to write out
-      data.write(entry.cpState.bsBindingMask);
-    } else {
-      // Pack render pass format
-      data.write(uint8_t(entry.format.sampleCount));
-      data.write(uint8_t(entry.format.depth.format));
-      data.write(packImageLayout(entry.format.depth.layout));
-
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
-        data.write(uint8_t(entry.format.color[i].format));
-        data.write(packImageLayout(entry.format.color[i].layout));
-      }
-
-      // Write out common pipeline state
-      data.write(entry.gpState.bsBindingMask);
-      data.write(entry.gpState.ia);
-      data.write(entry.gpState.il);
-      data.write(entry.gpState.rs);
-      data.write(entry.gpState.ms);
-      data.write(entry.gpState.ds);
-      data.write(entry.gpState.om);
-      data.write(entry.gpState.dsFront);
-      data.write(entry.gpState.dsBack);
-
-      // Write out render target swizzles and blend info
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
-        data.write(entry.gpState.omSwizzle[i]);
-
-      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
-        data.write(entry.gpState.omBlend[i]);
-
-      // Write out input layout for defined attributes
-      for (uint32_t i = 0; i < entry.gpState.il.attributeCount(); i++)
-        data.write(entry.gpState.ilAttributes[i]);
-
-      for (uint32_t i = 0; i < entry.gpState.il.bindingCount(); i++)
-        data.write(entry.gpState.ilBindings[i]);
-    }
-
-    // Write out all non-zero spec constants
-    auto& sc = (stageMask & VK_SHADER_STAGE_COMPUTE_BIT)
-      ? entry.cpState.sc
-      : entry.gpState.sc;
-
-    uint32_t specConstantMask = 0;
-
-    for (uint32_t i = 0; i < MaxNumSpecConstants; i++)
-      specConstantMask |= sc.specConstants[i] ? (1 << i) : 0;
-
-    data.write(specConstantMask);
-
-    for (uint32_t i = 0; i < MaxNumSpecConstants; i++) {
-      if (specConstantMask & (1 << i))
-        data.write(sc.specConstants[i]);
-    }
-
-    // General layout: header -> hash -> data
-    DxvkStateCacheEntryHeader header;
-    header.stageMask = uint8_t(stageMask);
-    header.entrySize = data.size();
-
-    Sha1Hash hash = data.computeHash();
-
-    stream.write(reinterpret_cast<char*>(&header), sizeof(header));
-    stream.write(reinterpret_cast<char*>(&hash), sizeof(hash));
-    stream.write(data.data(), data.size());
-    stream.flush();
-  }
-
-
-  bool DxvkStateCache::convertEntryV2(
-          DxvkStateCacheEntryV4&    entry) const {
-    // Semantics changed:
-    // v2: rsDepthClampEnable
-    // v3: rsDepthClipEnable
-    entry.gpState.rsDepthClipEnable = !entry.gpState.rsDepthClipEnable;
-
-    // Frontend changed: Depth bias
-    // will typically be disabled
-    entry.gpState.rsDepthBiasEnable = VK_FALSE;
-    return true;
-  }
-
-
-  bool DxvkStateCache::convertEntryV4(
-    const DxvkStateCacheEntryV4&    in,
-          DxvkStateCacheEntryV6&    out) const {
-    out.shaders = in.shaders;
-    out.format  = in.format;
-    out.hash    = in.hash;
-
-    out.cpState.bsBindingMask           = in.cpState.bsBindingMask;
-    out.gpState.bsBindingMask           = in.gpState.bsBindingMask;
-    
-    out.gpState.iaPrimitiveTopology     = in.gpState.iaPrimitiveTopology;
-    out.gpState.iaPrimitiveRestart      = in.gpState.iaPrimitiveRestart;
-    out.gpState.iaPatchVertexCount      = in.gpState.iaPatchVertexCount;
-    
-    out.gpState.ilAttributeCount        = in.gpState.ilAttributeCount;
-    out.gpState.ilBindingCount          = in.gpState.ilBindingCount;
-
-    for (uint32_t i = 0; i < in.gpState.ilAttributeCount; i++)
-      out.gpState.ilAttributes[i]       = in.gpState.ilAttributes[i];
-
-    for (uint32_t i = 0; i < in.gpState.ilBindingCount; i++) {
-      out.gpState.ilBindings[i]         = in.gpState.ilBindings[i];
-      out.gpState.ilDivisors[i]         = in.gpState.ilDivisors[i];
-    }
-    
-    out.gpState.rsDepthClipEnable       = in.gpState.rsDepthClipEnable;
-    out.gpState.rsDepthBiasEnable       = in.gpState.rsDepthBiasEnable;
-    out.gpState.rsPolygonMode           = in.gpState.rsPolygonMode;
-    out.gpState.rsCullMode              = in.gpState.rsCullMode;
-    out.gpState.rsFrontFace             = in.gpState.rsFrontFace;
-    out.gpState.rsViewportCount         = in.gpState.rsViewportCount;
-    out.gpState.rsSampleCount           = in.gpState.rsSampleCount;
-    
-    out.gpState.msSampleCount           = in.gpState.msSampleCount;
-    out.gpState.msSampleMask            = in.gpState.msSampleMask;
-    out.gpState.msEnableAlphaToCoverage = in.gpState.msEnableAlphaToCoverage;
-    
-    out.gpState.dsEnableDepthTest       = in.gpState.dsEnableDepthTest;
-    out.gpState.dsEnableDepthWrite      = in.gpState.dsEnableDepthWrite;
-    out.gpState.dsEnableStencilTest     = in.gpState.dsEnableStencilTest;
-    out.gpState.dsDepthCompareOp        = in.gpState.dsDepthCompareOp;
-    out.gpState.dsStencilOpFront        = in.gpState.dsStencilOpFront;
-    out.gpState.dsStencilOpBack         = in.gpState.dsStencilOpBack;
-    
-    out.gpState.omEnableLogicOp         = in.gpState.omEnableLogicOp;
-    out.gpState.omLogicOp               = in.gpState.omLogicOp;
-
-    for (uint32_t i = 0; i < 8; i++) {
-      out.gpState.omBlendAttachments[i] = in.gpState.omBlendAttachments[i];
-      out.gpState.omComponentMapping[i] = in.gpState.omComponentMapping[i];
-    }
-
-    return true;
-  }
-
-
-  bool DxvkStateCache::convertEntryV5(
-    const DxvkStateCacheEntryV5&    in,
-          DxvkStateCacheEntryV6&    out) const {
-    out.shaders = in.shaders;
-    out.gpState = in.gpState;
-    out.format  = in.format;
-    out.hash    = in.hash;
-
-    out.cpState.bsBindingMask = in.cpState.bsBindingMask;
-    return true;
-  }
-
-
-  bool DxvkStateCache::convertEntryV6(
-    const DxvkStateCacheEntryV6&    in,
-          DxvkStateCacheEntry&      out) const {
-    out.shaders = in.shaders;
-    out.format  = in.format;
-    out.hash    = in.hash;
-
-    if (in.shaders.cs.eq(g_nullShaderKey)) {
-      // Binding mask
-      out.gpState.bsBindingMask = in.gpState.bsBindingMask;
-
-      // Graphics state
-      out.gpState.ia = DxvkIaInfo(
-        in.gpState.iaPrimitiveTopology,
-        in.gpState.iaPrimitiveRestart,
-        in.gpState.iaPatchVertexCount);
-      
-      out.gpState.il = DxvkIlInfo(
-        in.gpState.ilAttributeCount,
-        in.gpState.ilBindingCount);
-      
-      for (uint32_t i = 0; i < in.gpState.ilAttributeCount; i++) {
-        out.gpState.ilAttributes[i] = DxvkIlAttribute(
-          in.gpState.ilAttributes[i].location,
-          in.gpState.ilAttributes[i].binding,
-          in.gpState.ilAttributes[i].format,
-          in.gpState.ilAttributes[i].offset);
-      }
-      
-      for (uint32_t i = 0; i < in.gpState.ilBindingCount; i++) {
-        out.gpState.ilBindings[i] = DxvkIlBinding(
-          in.gpState.ilBindings[i].binding,
-          in.gpState.ilBindings[i].stride,
-          in.gpState.ilBindings[i].inputRate,
-          in.gpState.ilDivisors[i]);
-      }
-      
-      out.gpState.rs = DxvkRsInfo(
-        in.gpState.rsDepthClipEnable,
-        in.gpState.rsDepthBiasEnable,
-        in.gpState.rsPolygonMode,
-        in.gpState.rsCullMode,
-        in.gpState.rsFrontFace,
-        in.gpState.rsViewportCount,
-        in.gpState.rsSampleCount);
-
-      out.gpState.ms = DxvkMsInfo(
-        in.gpState.msSampleCount,
-        in.gpState.msSampleMask,
-        in.gpState.msEnableAlphaToCoverage);
-      
-      out.gpState.ds = DxvkDsInfo(
-        in.gpState.dsEnableDepthTest,
-        in.gpState.dsEnableDepthWrite,
-        in.gpState.dsEnableDepthBoundsTest,
-        in.gpState.dsEnableStencilTest,
-        in.gpState.dsDepthCompareOp);
-      
-      out.gpState.dsFront = DxvkDsStencilOp(in.gpState.dsStencilOpFront);
-      out.gpState.dsBack  = DxvkDsStencilOp(in.gpState.dsStencilOpBack);
-
-      out.gpState.om = DxvkOmInfo(
-        in.gpState.omEnableLogicOp,
-        in.gpState.omLogicOp);
-      
-      for (uint32_t i = 0; i < 8 && i < MaxNumRenderTargets; i++) {
-        out.gpState.omBlend[i] = DxvkOmAttachmentBlend(
-          in.gpState.omBlendAttachments[i].blendEnable,
-          in.gpState.omBlendAttachments[i].srcColorBlendFactor,
-          in.gpState.omBlendAttachments[i].dstColorBlendFactor,
-          in.gpState.omBlendAttachments[i].colorBlendOp,
-          in.gpState.omBlendAttachments[i].srcAlphaBlendFactor,
-          in.gpState.omBlendAttachments[i].dstAlphaBlendFactor,
-          in.gpState.omBlendAttachments[i].alphaBlendOp,
-          in.gpState.omBlendAttachments[i].colorWriteMask);
-        
-        out.gpState.omSwizzle[i] = DxvkOmAttachmentSwizzle(
-          in.gpState.omComponentMapping[i]);
-      }
-
-      // Specialization constants
-      for (uint32_t i = 0; i < 8 && i < MaxNumSpecConstants; i++)
-        out.cpState.sc.specConstants[i] = in.cpState.scSpecConstants[i];
-    } else {
-      // Binding mask
-      out.cpState.bsBindingMask = in.cpState.bsBindingMask;
-
-      for (uint32_t i = 0; i < 8 && i < MaxNumSpecConstants; i++)
-        out.gpState.sc.specConstants[i] = in.gpState.scSpecConstants[i];
-    }
-
-    return true;
+    return reader.version() == newHeader.version;
   }
 
 
@@ -886,28 +551,40 @@ namespace dxvk {
 
     while (!m_stopThreads.load()) {
       WorkerItem item;
+      AsyncItem  asyncItem = { };
 
       { std::unique_lock<std::mutex> lock(m_workerLock);
 
-        if (m_workerQueue.empty()) {
+        if (m_workerQueue.empty() && m_asyncQueue.empty()) {
           m_workerBusy -= 1;
           m_workerCond.wait(lock, [this] () {
             return m_workerQueue.size()
+                || m_asyncQueue.size()
                 || m_stopThreads.load();
           });
 
-          if (!m_workerQueue.empty())
+          if (!m_workerQueue.empty() || !m_asyncQueue.empty())
             m_workerBusy += 1;
         }
 
-        if (m_workerQueue.empty())
+        if (m_workerQueue.empty() && m_asyncQueue.empty())
           break;
         
-        item = m_workerQueue.front();
-        m_workerQueue.pop();
+        // Pipelines requested by the application
+        // take priority over cached pipelines
+        if (!m_asyncQueue.empty()) {
+          asyncItem = m_asyncQueue.front();
+          m_asyncQueue.pop();
+        } else {
+          item = m_workerQueue.top();
+          m_workerQueue.pop();
+        }
       }
 
-      compilePipelines(item);
+      if (asyncItem.pipeline)
+        asyncItem.pipeline->compileInstance(asyncItem.instance);
+      else
+        compilePipelines(item);
     }
   }
 
@@ -917,35 +594,114 @@ namespace dxvk {
 
     std::ofstream file;
 
-    while (!m_stopThreads.load()) {
-      DxvkStateCacheEntry entry;
+    // Usage records of all pipeline instances used in
+    // this run, in the same order as the usage items
+    std::vector<UsageItem>            usageItems;
+    std::vector<DxvkStateCacheUsage>  usage;
+    uint64_t                          usageTotal = 0;
+
+    auto snapshotInterval = std::chrono::duration_cast<
+      high_resolution_clock::duration>(UsageSnapshotDelay);
+    auto snapshotTime = m_startTime + snapshotInterval;
+
+    bool stop = false;
+
+    while (!stop) {
+      std::vector<WriterItem> entries;
+      bool writeUsage = false;
 
       { std::unique_lock<std::mutex> lock(m_writerLock);
 
-        m_writerCond.wait(lock, [this] () {
+        m_writerCond.wait_for(lock, snapshotTime - high_resolution_clock::now(), [this] () {
           return m_writerQueue.size()
               || m_stopThreads.load();
         });
 
-        if (m_writerQueue.size() == 0)
-          break;
+        // Wait for more entries so that we can write
+        // one larger block, which compresses better
+        if (m_writerQueue.size()) {
+          m_writerCond.wait_for(lock, WriterDelay, [this] () {
+            return m_writerQueue.size() >= DxvkStateCacheWriter::MaxBlockEntries
+                || m_stopThreads.load();
+          });
+        }
+
+        while (m_writerQueue.size() && entries.size() < DxvkStateCacheWriter::MaxBlockEntries) {
+          entries.push_back(m_writerQueue.front());
+          m_writerQueue.pop();
+        }
+
+        stop = m_stopThreads.load() && m_writerQueue.empty();
+        writeUsage = stop || high_resolution_clock::now() >= snapshotTime;
+
+        if (writeUsage) {
+          usageItems.insert(usageItems.end(), m_usageQueue.begin(), m_usageQueue.end());
+          m_usageQueue.clear();
+        }
+      }
+
+      if (writeUsage) {
+        // Hash new entries on this thread rather than on
+        // the thread that first used the pipeline
+        for (size_t i = usage.size(); i < usageItems.size(); i++) {
+          const auto& shaders = usageItems[i].pipeline->shaders();
+
+          DxvkStateCacheEntry entry;
+          entry.shaders.vs  = getShaderKey(shaders.vs);
+          entry.shaders.tcs = getShaderKey(shaders.tcs);
+          entry.shaders.tes = getShaderKey(shaders.tes);
+          entry.shaders.gs  = getShaderKey(shaders.gs);
+          entry.shaders.fs  = getShaderKey(shaders.fs);
+          entry.gpState     = usageItems[i].instance->state();
+          entry.format      = usageItems[i].instance->renderPass()->format();
+
+          DxvkStateCacheUsage record;
+          record.entryHash  = DxvkStateCacheWriter::computeEntryHash(entry);
+          record.useCount   = 0;
+          record.firstUse   = usageItems[i].firstUse;
+          record.lastRun    = m_currentRun;
+          usage.push_back(record);
+        }
 
-        entry = m_writerQueue.front();
-        m_writerQueue.pop();
+        uint64_t newTotal = 0;
+
+        for (size_t i = 0; i < usage.size(); i++) {
+          usage[i].useCount = usageItems[i].instance->useCount();
+          newTotal += usage[i].useCount;
+        }
+
+        // Don't write redundant snapshots
+        writeUsage = newTotal != usageTotal;
+        usageTotal = newTotal;
+
+        snapshotInterval *= 2;
+        snapshotTime = high_resolution_clock::now() + snapshotInterval;
       }
 
-      if (!file) {
+      if (entries.empty() && !writeUsage)
+        continue;
+
+      if (!file.is_open()) {
         file = std::ofstream(getCacheFileName(),
           std::ios_base::binary |
           std::ios_base::app);
       }
 
-      writeCacheEntry(file, entry);
+      DxvkStateCacheWriter writer(file);
+      writer.writeEntries(entries.data(), entries.size());
+
+      if (writeUsage)
+        writer.writeUsage(usage.data(), usage.size());
     }
   }
 
 
   std::string DxvkStateCache::getCacheFileName() const {
+    return getCacheFilePath(".dxvk-cache");
+  }
+
+
+  std::string DxvkStateCache::getCacheFilePath(const std::string& suffix) {
     std::string path = getCacheDir();
 
     if (!path.empty() && *path.rbegin() != '/')
@@ -957,56 +713,13 @@ namespace dxvk {
     if (extp != std::string::npos && exeName.substr(extp + 1) == "exe")
       exeName.erase(extp);
     
-    path += exeName + ".dxvk-cache";
+    path += exeName + suffix;
     return path;
   }
 
 
-  std::string DxvkStateCache::getCacheDir() const {
+  std::string DxvkStateCache::getCacheDir() {
     return env::getEnvVar("DXVK_STATE_CACHE_PATH");
   }
 
-
-  uint8_t DxvkStateCache::packImageLayout(
-          VkImageLayout             layout) {
-    switch (layout) {
-      case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL: return 0x80;
-      case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL: return 0x81;
-      default: return uint8_t(layout);
-    }
-  }
-
-
-  VkImageLayout DxvkStateCache::unpackImageLayout(
-          uint8_t                   layout) {
-    switch (layout) {
-      case 0x80: return VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL;
-      case 0x81: return VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL;
-      default: return VkImageLayout(layout);
-    }
-  }
-
-
-  bool DxvkStateCache::validateRenderPassFormat(
-    const DxvkRenderPassFormat&     format) {
-    bool valid = true;
-
-    if (format.depth.format) {
-      valid &= format.depth.layout == VK_IMAGE_LAYOUT_GENERAL
-            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
-            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL
-            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL;
-    }
-
-    for (uint32_t i = 0; i < MaxNumRenderTargets && valid; i++) {
-      if (format.color[i].format) {
-        valid &= format.color[i].layout == VK_IMAGE_LAYOUT_GENERAL
-              || format.color[i].layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-      }
-    }
-
-    return valid;
-  }
-
 }
@@ -8,7 +8,9 @@
 #include <unordered_map>
 #include <vector>
 
-#include "dxvk_state_cache_types.h"
+#include "dxvk_state_cache_io.h"
+
+#include "../util/util_time.h"
 
 namespace dxvk {
 
@@ -71,6 +73,35 @@ namespace dxvk {
     void registerShader(
       const Rc<DxvkShader>&                 shader);
     
+    /**
+     * \brief Compiles a graphics pipeline instance
+     * 
+     * Queues a pending pipeline instance for compilation
+     * on the worker threads. These requests take priority
+     * over pipelines compiled from the cache file, since
+     * the application is waiting for them.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] instance The pending instance
+     */
+    void compileGraphicsPipeline(
+            DxvkGraphicsPipeline*           pipeline,
+            DxvkGraphicsPipelineInstance*   instance);
+    
+    /**
+     * \brief Records first use of a pipeline instance
+     * 
+     * Called when the application binds a graphics
+     * pipeline instance for the first time. The use
+     * counts of all recorded instances are written to
+     * the cache file periodically, so that pipelines
+     * can be compiled in order of priority next time.
+     * \param [in] pipeline The graphics pipeline
+     * \param [in] instance The pipeline instance
+     */
+    void registerUse(
+            DxvkGraphicsPipeline*           pipeline,
+            DxvkGraphicsPipelineInstance*   instance);
+
     /**
      * \brief Checks whether compiler threads are busy
      * \returns \c true if we're compiling shaders
@@ -79,6 +110,23 @@ namespace dxvk {
       return m_workerBusy.load() > 0;
     }
 
+    /**
+     * \brief Computes path of a cache file
+     * 
+     * Cache files are named after the executable and
+     * stored in the directory set by the user, if any.
+     * \param [in] suffix File name suffix
+     * \returns Full path of the cache file
+     */
+    static std::string getCacheFilePath(
+      const std::string&                    suffix);
+
+    /**
+     * \brief Queries cache directory
+     * \returns Cache directory set by the user
+     */
+    static std::string getCacheDir();
+
   private:
 
     using WriterItem = DxvkStateCacheEntry;
@@ -86,14 +134,53 @@ namespace dxvk {
     struct WorkerItem {
       DxvkGraphicsPipelineShaders gp;
       DxvkComputePipelineShaders  cp;
+      uint64_t                    priority;
+      uint64_t                    sequence;
+    };
+
+    struct WorkerItemOrder {
+      bool operator () (const WorkerItem& a, const WorkerItem& b) const {
+        // Lowest priority value first, FIFO otherwise
+        return a.priority != b.priority
+          ? a.priority > b.priority
+          : a.sequence > b.sequence;
+      }
+    };
+
+    struct UsageItem {
+      DxvkGraphicsPipeline*         pipeline;
+      DxvkGraphicsPipelineInstance* instance;
+      uint32_t                      firstUse;
+    };
+
+    struct AsyncItem {
+      DxvkGraphicsPipeline*         pipeline;
+      DxvkGraphicsPipelineInstance* instance;
+    };
+
+    enum class BlockStatus : uint32_t {
+      Pending,
+      Loaded,
+      Invalid,
+    };
+
+    struct BlockInfo {
+      DxvkStateCacheBlock block;
+      uint32_t            firstEntry;
+      BlockStatus         status;
     };
 
     DxvkPipelineManager*              m_pipeManager;
     DxvkRenderPassPool*               m_passManager;
 
     std::vector<DxvkStateCacheEntry>  m_entries;
+    std::vector<uint32_t>             m_entryBlocks;
+    std::vector<uint64_t>             m_entryPriorities;
     std::atomic<bool>                 m_stopThreads = { false };
 
+    std::mutex                        m_blockLock;
+    std::vector<BlockInfo>            m_blocks;
+
     std::mutex                        m_entryLock;
 
     std::unordered_multimap<
@@ -110,15 +197,23 @@ namespace dxvk {
 
     std::mutex                        m_workerLock;
     std::condition_variable           m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
+    std::priority_queue<WorkerItem,
+      std::vector<WorkerItem>,
+      WorkerItemOrder>                m_workerQueue;
+    uint64_t                          m_workerSequence = 0;
+    std::queue<AsyncItem>             m_asyncQueue;
     std::atomic<uint32_t>             m_workerBusy;
     std::vector<dxvk::thread>         m_workerThreads;
 
     std::mutex                        m_writerLock;
     std::condition_variable           m_writerCond;
     std::queue<WriterItem>            m_writerQueue;
+    std::vector<UsageItem>            m_usageQueue;
     dxvk::thread                      m_writerThread;
 
+    uint32_t                          m_currentRun = 1;
+    high_resolution_clock::time_point m_startTime;
+
     DxvkShaderKey getShaderKey(
       const Rc<DxvkShader>&           shader) const;
 
@@ -126,6 +221,16 @@ namespace dxvk {
       const DxvkShaderKey&            key,
             Rc<DxvkShader>&           shader) const;
     
+    void addEntry(
+      const DxvkStateCacheEntry&      entry,
+            uint32_t                  blockId);
+
+    const DxvkStateCacheEntry* getEntry(
+            size_t                    entryId);
+
+    bool loadBlock(
+            BlockInfo&                block);
+
     void mapPipelineToEntry(
       const DxvkStateCacheKey&        key,
             size_t                    entryId);
@@ -134,60 +239,21 @@ namespace dxvk {
       const DxvkShaderKey&            shader,
       const DxvkStateCacheKey&        key);
 
+    uint64_t getPipelinePriority(
+      const DxvkStateCacheKey&        key) const;
+
     void compilePipelines(
       const WorkerItem&               item);
 
-    bool readCacheFile();
-
-    bool readCacheHeader(
-            std::istream&             stream,
-            DxvkStateCacheHeader&     header) const;
+    bool readCacheFile(
+            std::vector<DxvkStateCacheUsage>& usage,
+            uint32_t&                 usageBlockCount);
 
-    bool readCacheEntryV7(
-            uint32_t                  version,
-            std::istream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
-    
-    bool readCacheEntry(
-            uint32_t                  version,
-            std::istream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
-    
-    void writeCacheEntry(
-            std::ostream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
-    
-    bool convertEntryV2(
-            DxvkStateCacheEntryV4&    entry) const;
-    
-    bool convertEntryV4(
-      const DxvkStateCacheEntryV4&    in,
-            DxvkStateCacheEntryV6&    out) const;
-    
-    bool convertEntryV5(
-      const DxvkStateCacheEntryV5&    in,
-            DxvkStateCacheEntryV6&    out) const;
-    
-    bool convertEntryV6(
-      const DxvkStateCacheEntryV6&    in,
-            DxvkStateCacheEntry&      out) const;
-    
     void workerFunc();
 
     void writerFunc();
 
     std::string getCacheFileName() const;
-    
-    std::string getCacheDir() const;
-
-    static uint8_t packImageLayout(
-            VkImageLayout             layout);
-
-    static VkImageLayout unpackImageLayout(
-            uint8_t                   layout);
-
-    static bool validateRenderPassFormat(
-      const DxvkRenderPassFormat&     format);
 
   };
 
@@ -0,0 +1,906 @@
+#include "dxvk_state_cache_io.h"
+
+#include "../util/util_lz4.h"
+
+namespace dxvk {
+
+  static const Sha1Hash       g_nullHash      = Sha1Hash::compute(nullptr, 0);
+  static const DxvkShaderKey  g_nullShaderKey = DxvkShaderKey();
+
+
+  /**
+   * \brief Packed entry header
+   */
+  struct DxvkStateCacheEntryHeader {
+    uint32_t stageMask : 8;
+    uint32_t entrySize : 24;
+  };
+
+  
+  /**
+   * \brief State cache entry data
+   *
+   * Stores serialized data for one or more cache
+   * entries and provides methods to access it.
+   */
+  class DxvkStateCacheEntryData {
+
+  public:
+
+    size_t size() const {
+      return m_data.size();
+    }
+
+    const char* data() const {
+      return m_data.data();
+    }
+
+    bool eof() const {
+      return m_read == m_data.size();
+    }
+
+    Sha1Hash computeHash() const {
+      return Sha1Hash::compute(m_data.data(), m_data.size());
+    }
+
+    template<typename T>
+    bool read(T& data) {
+      if (m_read + sizeof(T) > m_data.size())
+        return false;
+      
+      std::memcpy(&data, &m_data[m_read], sizeof(T));
+      m_read += sizeof(T);
+      return true;
+    }
+
+    template<typename T>
+    void write(const T& data) {
+      size_t offset = m_data.size();
+      m_data.resize(offset + sizeof(T));
+      std::memcpy(&m_data[offset], &data, sizeof(T));
+    }
+
+    bool readFromStream(std::istream& stream, size_t size) {
+      m_data.resize(size);
+      m_read = 0;
+
+      return bool(stream.read(m_data.data(), size));
+    }
+
+    bool decompress(const std::vector<char>& compressed, size_t size) {
+      m_data.resize(size);
+      m_read = 0;
+
+      return lz4::decompress(compressed.data(),
+        compressed.size(), m_data.data(), m_data.size());
+    }
+
+    std::vector<char> compress() const {
+      std::vector<char> result(lz4::compressBound(m_data.size()));
+      result.resize(lz4::compress(m_data.data(),
+        m_data.size(), result.data(), result.size()));
+      return result;
+    }
+
+  private:
+
+    size_t            m_read = 0;
+    std::vector<char> m_data;
+
+  };
+
+
+  template<typename T>
+  bool readCacheEntryTyped(std::istream& stream, T& entry) {
+    auto data = reinterpret_cast<char*>(&entry);
+    auto size = sizeof(entry);
+
+    if (!stream.read(data, size))
+      return false;
+    
+    Sha1Hash expectedHash = std::exchange(entry.hash, g_nullHash);
+    Sha1Hash computedHash = Sha1Hash::compute(entry);
+    return expectedHash == computedHash;
+  }
+
+
+  static VkShaderStageFlags getStageMask(
+    const DxvkStateCacheKey&        key) {
+    VkShaderStageFlags stageMask = 0;
+    auto keys = &key.vs;
+
+    for (uint32_t i = 0; i < 6; i++) {
+      if (!keys[i].eq(g_nullShaderKey))
+        stageMask |= VkShaderStageFlagBits(1 << i);
+    }
+
+    return stageMask;
+  }
+
+
+  static uint8_t packImageLayout(
+          VkImageLayout             layout) {
+    switch (layout) {
+      case VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL: return 0x80;
+      case VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL: return 0x81;
+      default: return uint8_t(layout);
+    }
+  }
+
+
+  static VkImageLayout unpackImageLayout(
+          uint8_t                   layout) {
+    switch (layout) {
+      case 0x80: return VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL;
+      case 0x81: return VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL;
+      default: return VkImageLayout(layout);
+    }
+  }
+
+
+  static bool validateRenderPassFormat(
+    const DxvkRenderPassFormat&     format) {
+    bool valid = true;
+
+    if (format.depth.format) {
+      valid &= format.depth.layout == VK_IMAGE_LAYOUT_GENERAL
+            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_STENCIL_ATTACHMENT_OPTIMAL
+            || format.depth.layout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_STENCIL_READ_ONLY_OPTIMAL;
+    }
+
+    for (uint32_t i = 0; i < MaxNumRenderTargets && valid; i++) {
+      if (format.color[i].format) {
+        valid &= format.color[i].layout == VK_IMAGE_LAYOUT_GENERAL
+              || format.color[i].layout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+      }
+    }
+
+    return valid;
+  }
+
+
+  static bool readEntryKeys(
+          DxvkStateCacheEntryData&  data,
+          VkShaderStageFlags        stageMask,
+          DxvkStateCacheEntry&      entry) {
+    auto keys = &entry.shaders.vs;
+
+    for (uint32_t i = 0; i < 6; i++) {
+      if (stageMask & VkShaderStageFlagBits(1 << i)) {
+        if (!data.read(keys[i]))
+          return false;
+      } else {
+        keys[i] = g_nullShaderKey;
+      }
+    }
+
+    return true;
+  }
+
+
+  static bool readEntryState(
+          DxvkStateCacheEntryData&  data,
+          VkShaderStageFlags        stageMask,
+          DxvkStateCacheEntry&      entry) {
+    if (stageMask & VK_SHADER_STAGE_COMPUTE_BIT) {
+      if (!data.read(entry.cpState.bsBindingMask))
+        return false;
+    } else {
+      // Read packed render pass format
+      uint8_t sampleCount = 0;
+      uint8_t imageFormat = 0;
+      uint8_t imageLayout = 0;
+
+      if (!data.read(sampleCount)
+       || !data.read(imageFormat)
+       || !data.read(imageLayout))
+        return false;
+
+      entry.format.sampleCount = VkSampleCountFlagBits(sampleCount);
+      entry.format.depth.format = VkFormat(imageFormat);
+      entry.format.depth.layout = unpackImageLayout(imageLayout);
+
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+        if (!data.read(imageFormat)
+         || !data.read(imageLayout))
+          return false;
+
+        entry.format.color[i].format = VkFormat(imageFormat);
+        entry.format.color[i].layout = unpackImageLayout(imageLayout);
+      }
+
+      if (!validateRenderPassFormat(entry.format))
+        return false;
+
+      // Read common pipeline state
+      if (!data.read(entry.gpState.bsBindingMask)
+       || !data.read(entry.gpState.ia)
+       || !data.read(entry.gpState.il)
+       || !data.read(entry.gpState.rs)
+       || !data.read(entry.gpState.ms)
+       || !data.read(entry.gpState.ds)
+       || !data.read(entry.gpState.om)
+       || !data.read(entry.gpState.dsFront)
+       || !data.read(entry.gpState.dsBack))
+        return false;
+
+      if (entry.gpState.il.attributeCount() > MaxNumVertexAttributes
+       || entry.gpState.il.bindingCount() > MaxNumVertexBindings)
+        return false;
+
+      // Read render target swizzles
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+        if (!data.read(entry.gpState.omSwizzle[i]))
+          return false;
+      }
+
+      // Read render target blend info
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+        if (!data.read(entry.gpState.omBlend[i]))
+          return false;
+      }
+
+      // Read defined vertex attributes
+      for (uint32_t i = 0; i < entry.gpState.il.attributeCount(); i++) {
+        if (!data.read(entry.gpState.ilAttributes[i]))
+          return false;
+      }
+
+      // Read defined vertex bindings
+      for (uint32_t i = 0; i < entry.gpState.il.bindingCount(); i++) {
+        if (!data.read(entry.gpState.ilBindings[i]))
+          return false;
+      }
+    }
+
+    // Read non-zero spec constants
+    auto& sc = (stageMask & VK_SHADER_STAGE_COMPUTE_BIT)
+      ? entry.cpState.sc
+      : entry.gpState.sc;
+
+    uint32_t specConstantMask = 0;
+
+    if (!data.read(specConstantMask))
+      return false;
+
+    for (uint32_t i = 0; i < MaxNumSpecConstants; i++) {
+      if (specConstantMask & (1 << i)) {
+        if (!data.read(sc.specConstants[i]))
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+
+  static void writeEntryKeys(
+          DxvkStateCacheEntryData&  data,
+          VkShaderStageFlags        stageMask,
+    const DxvkStateCacheEntry&      entry) {
+    auto keys = &entry.shaders.vs;
+
+    for (uint32_t i = 0; i < 6; i++) {
+      if (stageMask & VkShaderStageFlagBits(1 << i))
+        data.write(keys[i]);
+    }
+  }
+
+
+  static void writeEntryState(
+          DxvkStateCacheEntryData&  data,
+          VkShaderStageFlags        stageMask,
+    const DxvkStateCacheEntry&      entry) {
+    if (stageMask & VK_SHADER_STAGE_COMPUTE_BIT) {
+      // Nothing else here to write out
+      data.write(entry.cpState.bsBindingMask);
+    } else {
+      // Pack render pass format
+      data.write(uint8_t(entry.format.sampleCount));
+      data.write(uint8_t(entry.format.depth.format));
+      data.write(packImageLayout(entry.format.depth.layout));
+
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+        data.write(uint8_t(entry.format.color[i].format));
+        data.write(packImageLayout(entry.format.color[i].layout));
+      }
+
+      // Write out common pipeline state
+      data.write(entry.gpState.bsBindingMask);
+      data.write(entry.gpState.ia);
+      data.write(entry.gpState.il);
+      data.write(entry.gpState.rs);
+      data.write(entry.gpState.ms);
+      data.write(entry.gpState.ds);
+      data.write(entry.gpState.om);
+      data.write(entry.gpState.dsFront);
+      data.write(entry.gpState.dsBack);
+
+      // Write out render target swizzles and blend info
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
+        data.write(entry.gpState.omSwizzle[i]);
+
+      for (uint32_t i = 0; i < MaxNumRenderTargets; i++)
+        data.write(entry.gpState.omBlend[i]);
+
+      // Write out input layout for defined attributes
+      for (uint32_t i = 0; i < entry.gpState.il.attributeCount(); i++)
+        data.write(entry.gpState.ilAttributes[i]);
+
+      for (uint32_t i = 0; i < entry.gpState.il.bindingCount(); i++)
+        data.write(entry.gpState.ilBindings[i]);
+    }
+
+    // Write out all non-zero spec constants
+    auto& sc = (stageMask & VK_SHADER_STAGE_COMPUTE_BIT)
+      ? entry.cpState.sc
+      : entry.gpState.sc;
+
+    uint32_t specConstantMask = 0;
+
+    for (uint32_t i = 0; i < MaxNumSpecConstants; i++)
+      specConstantMask |= sc.specConstants[i] ? (1 << i) : 0;
+
+    data.write(specConstantMask);
+
+    for (uint32_t i = 0; i < MaxNumSpecConstants; i++) {
+      if (specConstantMask & (1 << i))
+        data.write(sc.specConstants[i]);
+    }
+  }
+
+
+  void DxvkStateCacheUsage::merge(const DxvkStateCacheUsage& other) {
+    if (other.lastRun == lastRun) {
+      useCount = std::max(useCount, other.useCount);
+      firstUse = std::min(firstUse, other.firstUse);
+    } else {
+      // Saturate so that counts never wrap around
+      useCount = uint32_t(std::min<uint64_t>(
+        uint64_t(useCount) + uint64_t(other.useCount), ~0u));
+
+      if (other.lastRun > lastRun) {
+        firstUse = other.firstUse;
+        lastRun  = other.lastRun;
+      }
+    }
+  }
+
+
+  DxvkStateCacheReader::DxvkStateCacheReader(
+          std::istream&             stream)
+  : m_stream(stream) {
+    std::streamoff offset = m_stream.tellg();
+    m_stream.seekg(0, std::ios_base::end);
+    m_size = m_stream.tellg();
+    m_stream.seekg(offset);
+  }
+
+
+  bool DxvkStateCacheReader::eof() {
+    return !m_stream || m_stream.tellg() >= m_size;
+  }
+
+
+  size_t DxvkStateCacheReader::bytesLeft() {
+    std::streamoff offset = m_stream.tellg();
+
+    return offset >= 0 && offset < m_size
+      ? size_t(m_size - offset)
+      : size_t(0);
+  }
+
+
+  bool DxvkStateCacheReader::readHeader() {
+    DxvkStateCacheHeader expected;
+
+    auto data = reinterpret_cast<char*>(&m_header);
+    auto size = sizeof(m_header);
+
+    if (!m_stream.read(data, size)
+     || std::memcmp(expected.magic, m_header.magic, sizeof(expected.magic))) {
+      Logger::warn("DXVK: Failed to read state cache header");
+      return false;
+    }
+
+    // Struct size hasn't changed between v2 and v4
+    size_t expectedSize = expected.entrySize;
+
+    if (m_header.version <= 4)
+      expectedSize = sizeof(DxvkStateCacheEntryV4);
+    else if (m_header.version <= 5)
+      expectedSize = sizeof(DxvkStateCacheEntryV5);
+    else if (m_header.version <= 6)
+      expectedSize = sizeof(DxvkStateCacheEntryV6);
+    else if (m_header.version <= 7)
+      expectedSize = sizeof(DxvkStateCacheEntry);
+
+    if (m_header.entrySize != expectedSize) {
+      Logger::warn("DXVK: State cache entry size changed");
+      return false;
+    }
+
+    // Discard caches of unsupported versions
+    if (m_header.version < 2 || m_header.version > expected.version) {
+      Logger::warn("DXVK: State cache version not supported");
+      return false;
+    }
+
+    return true;
+  }
+
+
+  bool DxvkStateCacheReader::readEntry(
+          DxvkStateCacheEntry&      entry) {
+    if (m_header.version < 8) {
+      if (!readEntryV7(entry))
+        return false;
+
+      entry.hash = DxvkStateCacheWriter::computeEntryHash(entry);
+      return true;
+    }
+
+    // Read entry metadata and actual data
+    DxvkStateCacheEntryHeader header;
+    DxvkStateCacheEntryData data;
+    Sha1Hash hash;
+  
+    if (!m_stream.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || !m_stream.read(reinterpret_cast<char*>(&hash), sizeof(hash))
+     || header.entrySize > bytesLeft()
+     || !data.readFromStream(m_stream, header.entrySize))
+      return false;
+
+    // Validate hash, skip entry if invalid
+    if (hash != data.computeHash())
+      return false;
+
+    VkShaderStageFlags stageMask = VkShaderStageFlags(header.stageMask);
+
+    if (!readEntryKeys(data, stageMask, entry)
+     || !readEntryState(data, stageMask, entry))
+      return false;
+
+    entry.hash = DxvkStateCacheWriter::computeEntryHash(entry);
+    return true;
+  }
+
+
+  bool DxvkStateCacheReader::readBlockIndex(
+          DxvkStateCacheBlock&      block,
+          std::vector<DxvkStateCacheEntry>& entries,
+          std::vector<DxvkStateCacheUsage>& usage) {
+    DxvkStateCacheBlockHeader header;
+
+    if (m_header.version < 10) {
+      DxvkStateCacheBlockHeaderV9 v9;
+
+      if (!m_stream.read(reinterpret_cast<char*>(&v9), sizeof(v9)))
+        return false;
+
+      header.type           = DxvkStateCacheBlockType::Entries;
+      header.entryCount     = v9.entryCount;
+      header.indexSize      = v9.indexSize;
+      header.rawSize        = v9.rawSize;
+      header.compressedSize = v9.compressedSize;
+      header.indexHash      = v9.indexHash;
+      header.dataHash       = v9.dataHash;
+    } else {
+      if (!m_stream.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    }
+
+    uint32_t maxEntryCount = header.type == DxvkStateCacheBlockType::Usage
+      ? DxvkStateCacheWriter::MaxUsageRecords
+      : DxvkStateCacheWriter::MaxBlockEntries;
+
+    // The header itself is not hashed, so make sure that a
+    // corrupted header cannot cause huge allocations. The
+    // packed pipeline state is smaller than the entry struct.
+    size_t maxRawSize = header.type == DxvkStateCacheBlockType::Entries
+      ? size_t(header.entryCount) * (sizeof(DxvkStateCacheEntry) + sizeof(uint32_t))
+      : size_t(0);
+
+    DxvkStateCacheEntryData index;
+
+    if (!header.entryCount || header.entryCount > maxEntryCount
+     || header.rawSize > maxRawSize
+     || header.indexSize > bytesLeft()
+     || !index.readFromStream(m_stream, header.indexSize)
+     || index.computeHash() != header.indexHash)
+      return false;
+
+    // Skip compressed data, but make sure that the
+    // block was not truncated while it was written
+    block.type            = header.type;
+    block.dataOffset      = m_stream.tellg();
+    block.entryCount      = header.entryCount;
+    block.rawSize         = header.rawSize;
+    block.compressedSize  = header.compressedSize;
+    block.dataHash        = header.dataHash;
+
+    if (block.dataOffset + std::streamoff(block.compressedSize) > m_size
+     || !m_stream.seekg(block.compressedSize, std::ios_base::cur))
+      return false;
+
+    entries.clear();
+    usage.clear();
+
+    switch (header.type) {
+      case DxvkStateCacheBlockType::Entries: {
+        // Read shader keys and hashes of all entries
+        entries.resize(header.entryCount);
+
+        for (auto& entry : entries) {
+          uint8_t stageMask = 0;
+
+          if (!index.read(stageMask)
+           || !readEntryKeys(index, VkShaderStageFlags(stageMask), entry))
+            return false;
+
+          // Older files don't store the hash, so
+          // it is computed when reading the data
+          if (m_header.version < 10)
+            entry.hash = g_nullHash;
+          else if (!index.read(entry.hash))
+            return false;
+        }
+      } break;
+
+      case DxvkStateCacheBlockType::Usage: {
+        usage.resize(header.entryCount);
+
+        for (auto& record : usage) {
+          if (!index.read(record))
+            return false;
+        }
+      } break;
+
+      default:
+        return false;
+    }
+
+    return index.eof();
+  }
+
+
+  bool DxvkStateCacheReader::readBlockData(
+    const DxvkStateCacheBlock&      block,
+          DxvkStateCacheEntry*      entries) {
+    std::vector<char> compressed(block.compressedSize);
+
+    if (!m_stream.seekg(block.dataOffset)
+     || !m_stream.read(compressed.data(), compressed.size())
+     || block.dataHash != Sha1Hash::compute(compressed.data(), compressed.size()))
+      return false;
+
+    DxvkStateCacheEntryData data;
+
+    if (!data.decompress(compressed, block.rawSize))
+      return false;
+
+    for (uint32_t i = 0; i < block.entryCount; i++) {
+      if (!readEntryState(data, getStageMask(entries[i].shaders), entries[i]))
+        return false;
+
+      if (m_header.version < 10)
+        entries[i].hash = DxvkStateCacheWriter::computeEntryHash(entries[i]);
+    }
+
+    return data.eof();
+  }
+
+
+  bool DxvkStateCacheReader::readEntryV7(
+          DxvkStateCacheEntry&      entry) {
+    uint32_t version = m_header.version;
+
+    if (version <= 6) {
+      DxvkStateCacheEntryV6 v6;
+
+      if (version <= 4) {
+        DxvkStateCacheEntryV4 v4;
+
+        if (!readCacheEntryTyped(m_stream, v4))
+          return false;
+
+        if (version == 2)
+          convertEntryV2(v4);
+
+        if (!convertEntryV4(v4, v6))
+          return false;
+      } else if (version <= 5) {
+        DxvkStateCacheEntryV5 v5;
+
+        if (!readCacheEntryTyped(m_stream, v5))
+          return false;
+
+        if (!convertEntryV5(v5, v6))
+          return false;
+      } else {
+        if (!readCacheEntryTyped(m_stream, v6))
+          return false;
+      }
+
+      return convertEntryV6(v6, entry);
+    } else {
+      return readCacheEntryTyped(m_stream, entry);
+    }
+  }
+
+
+  bool DxvkStateCacheReader::convertEntryV2(
+          DxvkStateCacheEntryV4&    entry) const {
+    // Semantics changed:
+    // v2: rsDepthClampEnable
+    // v3: rsDepthClipEnable
+    entry.gpState.rsDepthClipEnable = !entry.gpState.rsDepthClipEnable;
+
+    // Frontend changed: Depth bias
+    // will typically be disabled
+    entry.gpState.rsDepthBiasEnable = VK_FALSE;
+    return true;
+  }
+
+
+  bool DxvkStateCacheReader::convertEntryV4(
+    const DxvkStateCacheEntryV4&    in,
+          DxvkStateCacheEntryV6&    out) const {
+    out.shaders = in.shaders;
+    out.format  = in.format;
+    out.hash    = in.hash;
+
+    out.cpState.bsBindingMask           = in.cpState.bsBindingMask;
+    out.gpState.bsBindingMask           = in.gpState.bsBindingMask;
+    
+    out.gpState.iaPrimitiveTopology     = in.gpState.iaPrimitiveTopology;
+    out.gpState.iaPrimitiveRestart      = in.gpState.iaPrimitiveRestart;
+    out.gpState.iaPatchVertexCount      = in.gpState.iaPatchVertexCount;
+    
+    out.gpState.ilAttributeCount        = in.gpState.ilAttributeCount;
+    out.gpState.ilBindingCount          = in.gpState.ilBindingCount;
+
+    for (uint32_t i = 0; i < in.gpState.ilAttributeCount; i++)
+      out.gpState.ilAttributes[i]       = in.gpState.ilAttributes[i];
+
+    for (uint32_t i = 0; i < in.gpState.ilBindingCount; i++) {
+      out.gpState.ilBindings[i]         = in.gpState.ilBindings[i];
+      out.gpState.ilDivisors[i]         = in.gpState.ilDivisors[i];
+    }
+    
+    out.gpState.rsDepthClipEnable       = in.gpState.rsDepthClipEnable;
+    out.gpState.rsDepthBiasEnable       = in.gpState.rsDepthBiasEnable;
+    out.gpState.rsPolygonMode           = in.gpState.rsPolygonMode;
+    out.gpState.rsCullMode              = in.gpState.rsCullMode;
+    out.gpState.rsFrontFace             = in.gpState.rsFrontFace;
+    out.gpState.rsViewportCount         = in.gpState.rsViewportCount;
+    out.gpState.rsSampleCount           = in.gpState.rsSampleCount;
+    
+    out.gpState.msSampleCount           = in.gpState.msSampleCount;
+    out.gpState.msSampleMask            = in.gpState.msSampleMask;
+    out.gpState.msEnableAlphaToCoverage = in.gpState.msEnableAlphaToCoverage;
+    
+    out.gpState.dsEnableDepthTest       = in.gpState.dsEnableDepthTest;
+    out.gpState.dsEnableDepthWrite      = in.gpState.dsEnableDepthWrite;
+    out.gpState.dsEnableStencilTest     = in.gpState.dsEnableStencilTest;
+    out.gpState.dsDepthCompareOp        = in.gpState.dsDepthCompareOp;
+    out.gpState.dsStencilOpFront        = in.gpState.dsStencilOpFront;
+    out.gpState.dsStencilOpBack         = in.gpState.dsStencilOpBack;
+    
+    out.gpState.omEnableLogicOp         = in.gpState.omEnableLogicOp;
+    out.gpState.omLogicOp               = in.gpState.omLogicOp;
+
+    for (uint32_t i = 0; i < 8; i++) {
+      out.gpState.omBlendAttachments[i] = in.gpState.omBlendAttachments[i];
+      out.gpState.omComponentMapping[i] = in.gpState.omComponentMapping[i];
+    }
+
+    return true;
+  }
+
+
+  bool DxvkStateCacheReader::convertEntryV5(
+    const DxvkStateCacheEntryV5&    in,
+          DxvkStateCacheEntryV6&    out) const {
+    out.shaders = in.shaders;
+    out.gpState = in.gpState;
+    out.format  = in.format;
+    out.hash    = in.hash;
+
+    out.cpState.bsBindingMask = in.cpState.bsBindingMask;
+    return true;
+  }
+
+
+  bool DxvkStateCacheReader::convertEntryV6(
+    const DxvkStateCacheEntryV6&    in,
+          DxvkStateCacheEntry&      out) const {
+    out.shaders = in.shaders;
+    out.format  = in.format;
+    out.hash    = in.hash;
+
+    if (in.shaders.cs.eq(g_nullShaderKey)) {
+      // Binding mask
+      out.gpState.bsBindingMask = in.gpState.bsBindingMask;
+
+      // Graphics state
+      out.gpState.ia = DxvkIaInfo(
+        in.gpState.iaPrimitiveTopology,
+        in.gpState.iaPrimitiveRestart,
+        in.gpState.iaPatchVertexCount);
+      
+      out.gpState.il = DxvkIlInfo(
+        in.gpState.ilAttributeCount,
+        in.gpState.ilBindingCount);
+      
+      for (uint32_t i = 0; i < in.gpState.ilAttributeCount; i++) {
+        out.gpState.ilAttributes[i] = DxvkIlAttribute(
+          in.gpState.ilAttributes[i].location,
+          in.gpState.ilAttributes[i].binding,
+          in.gpState.ilAttributes[i].format,
+          in.gpState.ilAttributes[i].offset);
+      }
+      
+      for (uint32_t i = 0; i < in.gpState.ilBindingCount; i++) {
+        out.gpState.ilBindings[i] = DxvkIlBinding(
+          in.gpState.ilBindings[i].binding,
+          in.gpState.ilBindings[i].stride,
+          in.gpState.ilBindings[i].inputRate,
+          in.gpState.ilDivisors[i]);
+      }
+      
+      out.gpState.rs = DxvkRsInfo(
+        in.gpState.rsDepthClipEnable,
+        in.gpState.rsDepthBiasEnable,
+        in.gpState.rsPolygonMode,
+        in.gpState.rsCullMode,
+        in.gpState.rsFrontFace,
+        in.gpState.rsViewportCount,
+        in.gpState.rsSampleCount);
+
+      out.gpState.ms = DxvkMsInfo(
+        in.gpState.msSampleCount,
+        in.gpState.msSampleMask,
+        in.gpState.msEnableAlphaToCoverage);
+      
+      out.gpState.ds = DxvkDsInfo(
+        in.gpState.dsEnableDepthTest,
+        in.gpState.dsEnableDepthWrite,
+        in.gpState.dsEnableDepthBoundsTest,
+        in.gpState.dsEnableStencilTest,
+        in.gpState.dsDepthCompareOp);
+      
+      out.gpState.dsFront = DxvkDsStencilOp(in.gpState.dsStencilOpFront);
+      out.gpState.dsBack  = DxvkDsStencilOp(in.gpState.dsStencilOpBack);
+
+      out.gpState.om = DxvkOmInfo(
+        in.gpState.omEnableLogicOp,
+        in.gpState.omLogicOp);
+      
+      for (uint32_t i = 0; i < 8 && i < MaxNumRenderTargets; i++) {
+        out.gpState.omBlend[i] = DxvkOmAttachmentBlend(
+          in.gpState.omBlendAttachments[i].blendEnable,
+          in.gpState.omBlendAttachments[i].srcColorBlendFactor,
+          in.gpState.omBlendAttachments[i].dstColorBlendFactor,
+          in.gpState.omBlendAttachments[i].colorBlendOp,
+          in.gpState.omBlendAttachments[i].srcAlphaBlendFactor,
+          in.gpState.omBlendAttachments[i].dstAlphaBlendFactor,
+          in.gpState.omBlendAttachments[i].alphaBlendOp,
+          in.gpState.omBlendAttachments[i].colorWriteMask);
+        
+        out.gpState.omSwizzle[i] = DxvkOmAttachmentSwizzle(
+          in.gpState.omComponentMapping[i]);
+      }
+
+      // Specialization constants
+      for (uint32_t i = 0; i < 8 && i < MaxNumSpecConstants; i++)
+        out.cpState.sc.specConstants[i] = in.cpState.scSpecConstants[i];
+    } else {
+      // Binding mask
+      out.cpState.bsBindingMask = in.cpState.bsBindingMask;
+
+      for (uint32_t i = 0; i < 8 && i < MaxNumSpecConstants; i++)
+        out.gpState.sc.specConstants[i] = in.gpState.scSpecConstants[i];
+    }
+
+    return true;
+  }
+
+
+  DxvkStateCacheWriter::DxvkStateCacheWriter(
+          std::ostream&             stream)
+  : m_stream(stream) { }
+
+
+  void DxvkStateCacheWriter::writeHeader() {
+    DxvkStateCacheHeader header;
+
+    m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_stream.flush();
+  }
+
+
+  void DxvkStateCacheWriter::writeEntries(
+    const DxvkStateCacheEntry*      entries,
+          size_t                    entryCount) {
+    for (size_t first = 0; first < entryCount; first += MaxBlockEntries) {
+      size_t count = std::min<size_t>(entryCount - first, MaxBlockEntries);
+
+      // The index stores the stage mask and shader keys
+      // of each entry, everything else gets compressed
+      DxvkStateCacheEntryData index;
+      DxvkStateCacheEntryData data;
+
+      for (size_t i = first; i < first + count; i++) {
+        VkShaderStageFlags stageMask = getStageMask(entries[i].shaders);
+
+        index.write(uint8_t(stageMask));
+        writeEntryKeys(index, stageMask, entries[i]);
+        index.write(computeEntryHash(entries[i]));
+
+        writeEntryState(data, stageMask, entries[i]);
+      }
+
+      std::vector<char> compressed = data.compress();
+
+      DxvkStateCacheBlockHeader header;
+      header.type           = DxvkStateCacheBlockType::Entries;
+      header.entryCount     = uint32_t(count);
+      header.indexSize      = uint32_t(index.size());
+      header.rawSize        = uint32_t(data.size());
+      header.compressedSize = uint32_t(compressed.size());
+      header.indexHash      = index.computeHash();
+      header.dataHash       = Sha1Hash::compute(compressed.data(), compressed.size());
+
+      m_stream.write(reinterpret_cast<char*>(&header), sizeof(header));
+      m_stream.write(index.data(), index.size());
+      m_stream.write(compressed.data(), compressed.size());
+    }
+
+    m_stream.flush();
+  }
+
+
+  void DxvkStateCacheWriter::writeUsage(
+    const DxvkStateCacheUsage*      usage,
+          size_t                    usageCount) {
+    // Readers reject larger blocks
+    usageCount = std::min<size_t>(usageCount, MaxUsageRecords);
+
+    if (!usageCount)
+      return;
+
+    DxvkStateCacheEntryData index;
+
+    for (size_t i = 0; i < usageCount; i++)
+      index.write(usage[i]);
+
+    DxvkStateCacheBlockHeader header;
+    header.type           = DxvkStateCacheBlockType::Usage;
+    header.entryCount     = uint32_t(usageCount);
+    header.indexSize      = uint32_t(index.size());
+    header.rawSize        = 0;
+    header.compressedSize = 0;
+    header.indexHash      = index.computeHash();
+    header.dataHash       = g_nullHash;
+
+    m_stream.write(reinterpret_cast<char*>(&header), sizeof(header));
+    m_stream.write(index.data(), index.size());
+    m_stream.flush();
+  }
+
+
+  Sha1Hash DxvkStateCacheWriter::computeEntryHash(
+    const DxvkStateCacheEntry&      entry) {
+    VkShaderStageFlags stageMask = getStageMask(entry.shaders);
+
+    DxvkStateCacheEntryData data;
+    data.write(uint8_t(stageMask));
+    writeEntryKeys(data, stageMask, entry);
+    writeEntryState(data, stageMask, entry);
+    return data.computeHash();
+  }
+
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+
+#include "dxvk_state_cache_types.h"
+
+namespace dxvk {
+
+  /**
+   * \brief State cache block
+   *
+   * Type of a block in a v9 or newer file, as well as
+   * location and size of its compressed entry data.
+   */
+  struct DxvkStateCacheBlock {
+    DxvkStateCacheBlockType type;
+    std::streamoff  dataOffset;
+    uint32_t        entryCount;
+    uint32_t        rawSize;
+    uint32_t        compressedSize;
+    Sha1Hash        dataHash;
+  };
+
+
+  /**
+   * \brief Entry hash functor
+   *
+   * Allows using entry hashes as keys in hash maps.
+   * SHA-1 hashes are already uniformly distributed,
+   * so this simply returns the first dword.
+   */
+  struct DxvkStateCacheEntryHashFn {
+    size_t operator () (const Sha1Hash& hash) const {
+      return hash.dword(0);
+    }
+  };
+
+
+  /**
+   * \brief State cache reader
+   *
+   * Reads and validates state cache files of all
+   * supported versions. Entries of older versions
+   * are converted to the current entry format.
+   */
+  class DxvkStateCacheReader {
+
+  public:
+
+    DxvkStateCacheReader(
+            std::istream&             stream);
+
+    /**
+     * \brief File version
+     *
+     * Only valid after the header has been read.
+     * \returns State cache version of the file
+     */
+    uint32_t version() const {
+      return m_header.version;
+    }
+
+    /**
+     * \brief Checks whether the end of the file was reached
+     * \returns \c true if there is no more data to read
+     */
+    bool eof();
+
+    /**
+     * \brief Reads and validates file header
+     *
+     * Fails if the file is not a state cache
+     * file or if its version is not supported.
+     * \returns \c true on success
+     */
+    bool readHeader();
+
+    /**
+     * \brief Reads a single entry
+     *
+     * Only supported for files older than v9, which
+     * store entries individually. Invalid entries
+     * are skipped, so a return value of \c false
+     * does not necessarily mean that reading
+     * further entries will fail.
+     * \param [out] entry The entry
+     * \returns \c true if the entry is valid
+     */
+    bool readEntry(
+            DxvkStateCacheEntry&      entry);
+
+    /**
+     * \brief Reads block index
+     *
+     * Reads the shader keys and hashes of all entries
+     * in the next block and skips the compressed data,
+     * or reads all records if the block is a usage block.
+     * If this fails, the rest of the file is unusable.
+     * \param [out] block Block properties
+     * \param [out] entries Entries with shader keys
+     * \param [out] usage Usage records
+     * \returns \c true if the block index is valid
+     */
+    bool readBlockIndex(
+            DxvkStateCacheBlock&      block,
+            std::vector<DxvkStateCacheEntry>& entries,
+            std::vector<DxvkStateCacheUsage>& usage);
+
+    /**
+     * \brief Reads block data
+     *
+     * Reads pipeline state for entries previously
+     * returned by \ref readBlockIndex. May be used
+     * with a different reader for the same file.
+     * \param [in] block Block properties
+     * \param [in,out] entries Entries of the block
+     * \returns \c true if all entries are valid
+     */
+    bool readBlockData(
+      const DxvkStateCacheBlock&      block,
+            DxvkStateCacheEntry*      entries);
+
+  private:
+
+    std::istream&         m_stream;
+    std::streamoff        m_size = 0;
+    DxvkStateCacheHeader  m_header;
+
+    size_t bytesLeft();
+
+    bool readEntryV7(
+            DxvkStateCacheEntry&      entry);
+
+    bool convertEntryV2(
+            DxvkStateCacheEntryV4&    entry) const;
+
+    bool convertEntryV4(
+      const DxvkStateCacheEntryV4&    in,
+            DxvkStateCacheEntryV6&    out) const;
+
+    bool convertEntryV5(
+      const DxvkStateCacheEntryV5&    in,
+            DxvkStateCacheEntryV6&    out) const;
+
+    bool convertEntryV6(
+      const DxvkStateCacheEntryV6&    in,
+            DxvkStateCacheEntry&      out) const;
+
+  };
+
+
+  /**
+   * \brief State cache writer
+   *
+   * Writes state cache files in the current format.
+   * Since entries are stored in blocks, the header
+   * must only be written when creating a new file.
+   */
+  class DxvkStateCacheWriter {
+
+  public:
+
+    constexpr static uint32_t MaxBlockEntries = 256;
+    constexpr static uint32_t MaxUsageRecords = 1u << 20;
+
+    DxvkStateCacheWriter(
+            std::ostream&             stream);
+
+    /**
+     * \brief Writes file header
+     */
+    void writeHeader();
+
+    /**
+     * \brief Writes entries
+     *
+     * Entries are split into blocks of at
+     * most \c MaxBlockEntries entries each.
+     * \param [in] entries Entries to write
+     * \param [in] entryCount Number of entries
+     */
+    void writeEntries(
+      const DxvkStateCacheEntry*      entries,
+            size_t                    entryCount);
+
+    /**
+     * \brief Writes usage records
+     *
+     * All records are written to a single block,
+     * which represents one snapshot of the usage
+     * data of the current run.
+     * \param [in] usage Usage records to write
+     * \param [in] usageCount Number of records
+     */
+    void writeUsage(
+      const DxvkStateCacheUsage*      usage,
+            size_t                    usageCount);
+
+    /**
+     * \brief Computes hash of an entry
+     *
+     * Hashes the serialized entry, so that two entries
+     * have the same hash if and only if they would
+     * compile the same pipeline.
+     * \param [in] entry The entry
+     * \returns Entry hash
+     */
+    static Sha1Hash computeEntryHash(
+      const DxvkStateCacheEntry&      entry);
+
+  private:
+
+    std::ostream& m_stream;
+
+  };
+
+}
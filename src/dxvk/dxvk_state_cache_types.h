@@ -52,13 +52,94 @@ namespace dxvk {
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 8;
+    uint32_t version    = 10;
     uint32_t entrySize  = 0; /* no longer meaningful */
   };
 
   static_assert(sizeof(DxvkStateCacheHeader) == 12);
 
 
+  /**
+   * \brief State cache block type
+   */
+  enum class DxvkStateCacheBlockType : uint32_t {
+    Entries = 0,
+    Usage   = 1,
+  };
+
+
+  /**
+   * \brief State cache block header
+   * 
+   * Starting with v9, entries are stored in blocks.
+   * Each block has an uncompressed index that stores
+   * the shader keys of all entries in the block, so
+   * that the pipeline state itself, which is stored
+   * in compressed form, can be loaded on demand once
+   * the shaders become available.
+   * 
+   * Starting with v10, the index also stores the hash
+   * of each entry, and usage blocks store how often
+   * each entry was used in previous runs. Usage blocks
+   * only consist of an index, and have no data.
+   */
+  struct DxvkStateCacheBlockHeader {
+    DxvkStateCacheBlockType type;
+    uint32_t entryCount;
+    uint32_t indexSize;
+    uint32_t rawSize;
+    uint32_t compressedSize;
+    Sha1Hash indexHash;
+    Sha1Hash dataHash;
+  };
+
+  static_assert(sizeof(DxvkStateCacheBlockHeader) == 60);
+
+
+  /**
+   * \brief State cache usage record
+   * 
+   * Stores how often the pipeline described by
+   * an entry was bound in the run it was last
+   * seen in, and when it was first bound in that
+   * run, in milliseconds after startup. Runs are
+   * numbered consecutively.
+   */
+  struct DxvkStateCacheUsage {
+    Sha1Hash entryHash;
+    uint32_t useCount;
+    uint32_t firstUse;
+    uint32_t lastRun;
+
+    /**
+     * \brief Merges usage record of the same entry
+     * 
+     * Counts of different runs are accumulated, and
+     * the first use time of the most recent run is
+     * kept. Records of the same run are snapshots
+     * taken at different times, so the larger use
+     * count is kept in that case.
+     * \param [in] other Record to merge
+     */
+    void merge(const DxvkStateCacheUsage& other);
+  };
+
+  static_assert(sizeof(DxvkStateCacheUsage) == 32);
+
+
+  /**
+   * \brief Version 9 block header
+   */
+  struct DxvkStateCacheBlockHeaderV9 {
+    uint32_t entryCount;
+    uint32_t indexSize;
+    uint32_t rawSize;
+    uint32_t compressedSize;
+    Sha1Hash indexHash;
+    Sha1Hash dataHash;
+  };
+
+
   /**
    * \brief Version 4 graphics pipeline state
    */
@@ -14,12 +14,21 @@ namespace dxvk {
     CmdDrawCalls,             ///< Number of draw calls
     CmdDispatchCalls,         ///< Number of compute calls
     CmdRenderPassCount,       ///< Number of render passes
+    CmdDrawsDeferred,         ///< Number of draws skipped due to pending pipelines
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
     PipeCompilerBusy,         ///< Boolean indicating compiler activity
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     GpuIdleTicks,             ///< GPU idle time in microseconds
+    MemLockCount,             ///< Number of memory allocator lock acquisitions
+    MemLockContended,         ///< Number of contended memory allocator locks
+    MemCacheHits,             ///< Number of allocations served from slice caches
+    StagingBytes,             ///< Number of bytes uploaded through staging buffers
+    CsStateCmdCount,          ///< Number of state commands executed by the CS thread
+    CsStateCmdSkipped,        ///< Number of redundant state commands dropped
+    ShaderCacheHits,          ///< Number of shaders loaded from the shader cache
+    ShaderCacheMisses,        ///< Number of shaders not found in the shader cache
     NumCounters,              ///< Number of counters available
   };
   
@@ -35,6 +35,7 @@ namespace dxvk::hud {
     addItem<HudFrameTimeItem>("frametimes", -1);
     addItem<HudSubmissionStatsItem>("submissions", -1, device);
     addItem<HudDrawCallStatsItem>("drawcalls", -1, device);
+    addItem<HudStagingStatsItem>("staging", -1, device);
     addItem<HudPipelineStatsItem>("pipelines", -1, device);
     addItem<HudMemoryStatsItem>("memory", -1, device);
     addItem<HudGpuLoadItem>("gpuload", -1, device);
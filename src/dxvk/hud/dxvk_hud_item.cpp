@@ -348,6 +348,9 @@ namespace dxvk::hud {
       m_gpCount = diffCounters.getCtr(DxvkStatCounter::CmdDrawCalls);
       m_cpCount = diffCounters.getCtr(DxvkStatCounter::CmdDispatchCalls);
       m_rpCount = diffCounters.getCtr(DxvkStatCounter::CmdRenderPassCount);
+      m_scCount = diffCounters.getCtr(DxvkStatCounter::CsStateCmdCount);
+      m_scSkipped = diffCounters.getCtr(DxvkStatCounter::CsStateCmdSkipped);
+      m_deferred = diffCounters.getCtr(DxvkStatCounter::CmdDrawsDeferred);
 
       m_lastUpdate = time;
     }
@@ -392,6 +395,78 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_rpCount));
     
+    position.y += 20.0f;
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 0.25f, 0.5f, 1.0f, 1.0f },
+      "State commands:");
+    
+    renderer.drawText(16.0f,
+      { position.x + 192.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_scCount, " (", m_scCount ? (100 * m_scSkipped) / m_scCount : 0, "% dropped)"));
+    
+    if (m_device->config().asyncPipelineCompile) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 0.25f, 0.5f, 1.0f, 1.0f },
+        "Deferred draws:");
+      
+      renderer.drawText(16.0f,
+        { position.x + 192.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(m_deferred));
+    }
+    
+    position.y += 8.0f;
+    return position;
+  }
+
+
+  HudStagingStatsItem::HudStagingStatsItem(const Rc<DxvkDevice>& device)
+  : m_device(device) {
+
+  }
+
+
+  HudStagingStatsItem::~HudStagingStatsItem() {
+
+  }
+
+
+  void HudStagingStatsItem::update(dxvk::high_resolution_clock::time_point time) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(time - m_lastUpdate);
+
+    if (elapsed.count() >= UpdateInterval) {
+      DxvkStatCounters counters = m_device->getStatCounters();
+      auto diffCounters = counters.diff(m_prevCounters);
+
+      uint64_t bytes  = diffCounters.getCtr(DxvkStatCounter::StagingBytes);
+      uint64_t frames = diffCounters.getCtr(DxvkStatCounter::QueuePresentCount);
+
+      m_bytesPerFrame = frames ? bytes / frames : bytes;
+      m_prevCounters  = counters;
+      m_lastUpdate    = time;
+    }
+  }
+
+
+  HudPos HudStagingStatsItem::render(
+          HudRenderer&      renderer,
+          HudPos            position) {
+    position.y += 16.0f;
+
+    renderer.drawText(16.0f,
+      { position.x, position.y },
+      { 1.0f, 0.5f, 0.25f, 1.0f },
+      "Staging:");
+
+    renderer.drawText(16.0f,
+      { position.x + 108.0f, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      str::format(m_bytesPerFrame >> 10, " kB / frame"));
+
     position.y += 8.0f;
     return position;
   }
@@ -413,6 +488,8 @@ namespace dxvk::hud {
 
     m_graphicsPipelines = counters.getCtr(DxvkStatCounter::PipeCountGraphics);
     m_computePipelines  = counters.getCtr(DxvkStatCounter::PipeCountCompute);
+    m_shaderCacheHits   = counters.getCtr(DxvkStatCounter::ShaderCacheHits);
+    m_shaderCacheMisses = counters.getCtr(DxvkStatCounter::ShaderCacheMisses);
   }
 
 
@@ -441,6 +518,19 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       str::format(m_computePipelines));
 
+    if (m_shaderCacheHits + m_shaderCacheMisses) {
+      position.y += 20.0f;
+      renderer.drawText(16.0f,
+        { position.x, position.y },
+        { 1.0f, 0.25f, 1.0f, 1.0f },
+        "Cached shaders:");
+
+      renderer.drawText(16.0f,
+        { position.x + 240.0f, position.y },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        str::format(m_shaderCacheHits, " / ", m_shaderCacheHits + m_shaderCacheMisses));
+    }
+
     position.y += 8.0f;
     return position;
   }
@@ -486,6 +576,22 @@ namespace dxvk::hud {
         { 1.0f, 1.0f, 1.0f, 1.0f },
         text);
       position.y += 4.0f;
+
+      // Only show chunk stats for heaps that actually have
+      // memory allocated, in order to keep the HUD compact
+      if (m_heaps[i].memoryAllocated || m_heaps[i].memoryReleased) {
+        std::string chunkText = str::format(std::setfill(' '),
+          std::setw(5), m_heaps[i].memoryAllocated >> 20, " MB alloc, ",
+          m_heaps[i].memoryIdle     >> 20, " MB idle, ",
+          m_heaps[i].memoryReleased >> 20, " MB released");
+
+        position.y += 16.0f;
+        renderer.drawText(16.0f,
+          { position.x + 168.0f, position.y },
+          { 0.75f, 0.75f, 0.75f, 1.0f },
+          chunkText);
+        position.y += 4.0f;
+      }
     }
 
     position.y += 4.0f;
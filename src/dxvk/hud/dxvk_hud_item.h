@@ -279,6 +279,40 @@ namespace dxvk::hud {
     uint64_t          m_gpCount = 0;
     uint64_t          m_cpCount = 0;
     uint64_t          m_rpCount = 0;
+    uint64_t          m_scCount = 0;
+    uint64_t          m_scSkipped = 0;
+    uint64_t          m_deferred = 0;
+
+    dxvk::high_resolution_clock::time_point m_lastUpdate
+      = dxvk::high_resolution_clock::now();
+
+  };
+
+
+  /**
+   * \brief HUD item to display staging uploads
+   */
+  class HudStagingStatsItem : public HudItem {
+    constexpr static int64_t UpdateInterval = 500'000;
+  public:
+
+    HudStagingStatsItem(const Rc<DxvkDevice>& device);
+
+    ~HudStagingStatsItem();
+
+    void update(dxvk::high_resolution_clock::time_point time);
+
+    HudPos render(
+            HudRenderer&      renderer,
+            HudPos            position);
+
+  private:
+
+    Rc<DxvkDevice>    m_device;
+
+    DxvkStatCounters  m_prevCounters;
+
+    uint64_t          m_bytesPerFrame = 0;
 
     dxvk::high_resolution_clock::time_point m_lastUpdate
       = dxvk::high_resolution_clock::now();
@@ -309,6 +343,8 @@ namespace dxvk::hud {
 
     uint64_t m_graphicsPipelines = 0;
     uint64_t m_computePipelines = 0;
+    uint64_t m_shaderCacheHits = 0;
+    uint64_t m_shaderCacheMisses = 0;
 
   };
 
@@ -454,7 +454,6 @@ namespace dxvk {
   uint32_t SpirvModule::lateConst32(
           uint32_t                typeId) {
     uint32_t resultId = this->allocateId();
-    m_lateConsts.insert(resultId);
 
     m_typeConstDefs.putIns (spv::OpConstant, 4);
     m_typeConstDefs.putWord(typeId);
@@ -745,7 +744,10 @@ namespace dxvk {
   uint32_t SpirvModule::defArrayTypeUnique(
           uint32_t                typeId,
           uint32_t                length) {
+    std::array<uint32_t, 2> args = {{ typeId, length }};
+
     uint32_t resultId = this->allocateId();
+    this->indexTypeConst(spv::OpTypeArray, 0, args.size(), args.data());
     
     m_typeConstDefs.putIns (spv::OpTypeArray, 4);
     m_typeConstDefs.putWord(resultId);
@@ -767,6 +769,7 @@ namespace dxvk {
   uint32_t SpirvModule::defRuntimeArrayTypeUnique(
           uint32_t                typeId) {
     uint32_t resultId = this->allocateId();
+    this->indexTypeConst(spv::OpTypeRuntimeArray, 0, 1, &typeId);
     
     m_typeConstDefs.putIns (spv::OpTypeRuntimeArray, 3);
     m_typeConstDefs.putWord(resultId);
@@ -802,6 +805,7 @@ namespace dxvk {
           uint32_t                memberCount,
     const uint32_t*               memberTypes) {
     uint32_t resultId = this->allocateId();
+    this->indexTypeConst(spv::OpTypeStruct, 0, memberCount, memberTypes);
     
     m_typeConstDefs.putIns (spv::OpTypeStruct, 2 + memberCount);
     m_typeConstDefs.putWord(resultId);
@@ -3573,19 +3577,41 @@ namespace dxvk {
     // Since the type info is stored in the code buffer,
     // we can use the code buffer to look up type IDs as
     // well. Result IDs are always stored as argument 1.
-    for (auto ins : m_typeConstDefs) {
+    // The index only yields candidates, which may be hash
+    // collisions, so the operands need to be compared.
+    size_t   hash     = hashTypeConst(op, 0, argCount, argIds);
+    uint32_t offset   = ~0u;
+    uint32_t resultId = 0;
+
+    auto range = m_typeConstIndex.equal_range(hash);
+
+    for (auto e = range.first; e != range.second; e++) {
+      // Return the first declaration in case of duplicates
+      if (e->second > offset)
+        continue;
+
+      SpirvInstruction ins(m_typeConstDefs.data(),
+        e->second, m_typeConstDefs.dwords());
+
       bool match = ins.opCode() == op
                 && ins.length() == 2 + argCount;
       
       for (uint32_t i = 0; i < argCount && match; i++)
         match &= ins.arg(2 + i) == argIds[i];
       
-      if (match)
-        return ins.arg(1);
+      if (match) {
+        offset   = e->second;
+        resultId = ins.arg(1);
+      }
     }
+
+    if (resultId)
+      return resultId;
     
     // Type not yet declared, create a new one.
-    uint32_t resultId = this->allocateId();
+    resultId = this->allocateId();
+    this->indexTypeConst(op, 0, argCount, argIds);
+
     m_typeConstDefs.putIns (op, 2 + argCount);
     m_typeConstDefs.putWord(resultId);
     
@@ -3600,8 +3626,22 @@ namespace dxvk {
           uint32_t                typeId,
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Avoid declaring constants multiple times
-    for (auto ins : m_typeConstDefs) {
+    // Avoid declaring constants multiple times. Late
+    // constants are not indexed since their value
+    // is not known at the time they are declared.
+    size_t   hash     = hashTypeConst(op, typeId, argCount, argIds);
+    uint32_t offset   = ~0u;
+    uint32_t resultId = 0;
+
+    auto range = m_typeConstIndex.equal_range(hash);
+
+    for (auto e = range.first; e != range.second; e++) {
+      if (e->second > offset)
+        continue;
+
+      SpirvInstruction ins(m_typeConstDefs.data(),
+        e->second, m_typeConstDefs.dwords());
+
       bool match = ins.opCode() == op
                 && ins.length() == 3 + argCount
                 && ins.arg(1)   == typeId;
@@ -3609,17 +3649,19 @@ namespace dxvk {
       for (uint32_t i = 0; i < argCount && match; i++)
         match &= ins.arg(3 + i) == argIds[i];
       
-      if (!match)
-        continue;
-      
-      uint32_t id = ins.arg(2);
-
-      if (m_lateConsts.find(id) == m_lateConsts.end())
-        return id;
+      if (match) {
+        offset   = e->second;
+        resultId = ins.arg(2);
+      }
     }
+
+    if (resultId)
+      return resultId;
     
     // Constant not yet declared, make a new one
-    uint32_t resultId = this->allocateId();
+    resultId = this->allocateId();
+    this->indexTypeConst(op, typeId, argCount, argIds);
+
     m_typeConstDefs.putIns (op, 3 + argCount);
     m_typeConstDefs.putWord(typeId);
     m_typeConstDefs.putWord(resultId);
@@ -3630,6 +3672,43 @@ namespace dxvk {
   }
   
   
+  size_t SpirvModule::hashTypeConst(
+          spv::Op                 op,
+          uint32_t                typeId,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
+    // Types don't have a type ID, but since types and
+    // constants use different opcodes, that's fine
+    size_t hash = size_t(op) | (size_t(argCount) << 16);
+
+    auto add = [&hash] (uint32_t value) {
+      hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    add(typeId);
+
+    for (uint32_t i = 0; i < argCount; i++)
+      add(argIds[i]);
+
+    return hash;
+  }
+
+
+  void SpirvModule::indexTypeConst(
+          spv::Op                 op,
+          uint32_t                typeId,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
+    // Must be called before the declaration gets
+    // written, since we store its dword offset.
+    // Unique types are indexed too, so that defType
+    // can resolve matching operands to them.
+    m_typeConstIndex.insert({
+      hashTypeConst(op, typeId, argCount, argIds),
+      m_typeConstDefs.dwords() });
+  }
+  
+  
   void SpirvModule::instImportGlsl450() {
     m_instExtGlsl450 = this->allocateId();
     const char* name = "GLSL.std.450";
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <unordered_set>
+#include <unordered_map>
+#include <unordered_map>
 
 #include "spirv_code_buffer.h"
 
@@ -1237,7 +1238,7 @@ namespace dxvk {
     SpirvCodeBuffer m_variables;
     SpirvCodeBuffer m_code;
 
-    std::unordered_set<uint32_t> m_lateConsts;
+    std::unordered_multimap<size_t, uint32_t> m_typeConstIndex;
     
     uint32_t defType(
             spv::Op                 op, 
@@ -1250,6 +1251,18 @@ namespace dxvk {
             uint32_t                argCount,
       const uint32_t*               argIds);
     
+    static size_t hashTypeConst(
+            spv::Op                 op,
+            uint32_t                typeId,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
+    void indexTypeConst(
+            spv::Op                 op,
+            uint32_t                typeId,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
     void instImportGlsl450();
     
     uint32_t getImageOperandWordCount(
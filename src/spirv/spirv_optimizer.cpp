@@ -0,0 +1,900 @@
+#define SPV_ENABLE_UTILITY_CODE
+#include <spirv/spirv.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include "spirv_optimizer.h"
+
+#include "../util/util_time.h"
+
+namespace dxvk {
+
+  SpirvOptimizer::SpirvOptimizer(
+    const SpirvCodeBuffer&          code)
+  : m_words(code.data(), code.data() + code.dwords()) {
+    m_valid = parse();
+
+    if (!m_valid)
+      Logger::warn("SpirvOptimizer: Failed to parse module");
+  }
+
+
+  SpirvOptimizer::~SpirvOptimizer() {
+
+  }
+
+
+  void SpirvOptimizer::run(SpirvOptimizerPasses passes) {
+    if (!m_valid || passes.isClear())
+      return;
+
+    dxvk::high_resolution_clock::time_point t0, t1;
+
+    size_t dwordsBefore = m_words.size();
+
+    if (Logger::logLevel() <= LogLevel::Debug)
+      t0 = dxvk::high_resolution_clock::now();
+
+    // Forwarding stores exposes constant operands, and
+    // both passes leave behind a lot of unused code
+    if (passes.test(SpirvOptimizerPass::ForwardStores))
+      this->forwardStores();
+
+    if (passes.test(SpirvOptimizerPass::FoldConstants))
+      this->foldConstants();
+
+    if (passes.any(SpirvOptimizerPass::ForwardStores, SpirvOptimizerPass::FoldConstants))
+      this->applySubstitutions();
+
+    if (passes.test(SpirvOptimizerPass::EliminateDeadCode))
+      this->eliminateDeadCode();
+
+    if (Logger::logLevel() <= LogLevel::Debug) {
+      t1 = dxvk::high_resolution_clock::now();
+      auto td = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+      uint32_t dwords = 5;
+
+      for (const auto& ins : m_ins)
+        dwords += ins.removed ? 0 : ins.length;
+
+      Logger::debug(str::format("SpirvOptimizer: ", dwordsBefore, " -> ", dwords,
+        " dwords in ", td.count(), " us"));
+    }
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::getCode() const {
+    if (!m_valid)
+      return SpirvCodeBuffer(m_words.size(), m_words.data());
+
+    std::vector<uint32_t> code(m_words.begin(), m_words.begin() + 5);
+    code.reserve(m_words.size());
+
+    auto emit = [this, &code] (uint32_t i) {
+      const Instruction& ins = m_ins[i];
+
+      if (!ins.removed) {
+        code.insert(code.end(),
+          m_words.begin() + ins.offset,
+          m_words.begin() + ins.offset + ins.length);
+      }
+    };
+
+    // New constants must be declared before any function
+    for (uint32_t i = 0; i < m_functionStart; i++)
+      emit(i);
+
+    for (uint32_t i : m_newDecls)
+      emit(i);
+
+    for (uint32_t i = m_functionStart; i < m_functionEnd; i++)
+      emit(i);
+
+    return SpirvCodeBuffer(code.size(), code.data());
+  }
+
+
+  bool SpirvOptimizer::parse() {
+    if (m_words.size() < 5 || m_words[0] != spv::MagicNumber)
+      return false;
+
+    m_defs.resize(bound(), ~0u);
+    m_subst.resize(bound(), 0u);
+
+    uint32_t offset = 5;
+
+    while (offset < m_words.size()) {
+      uint32_t length = m_words[offset] >> spv::WordCountShift;
+
+      if (!length || length > m_words.size() - offset)
+        return false;
+
+      uint32_t index = m_ins.size();
+      m_ins.push_back({ offset, length, false });
+
+      spv::Op  op         = opCode(index);
+      uint32_t resultWord = getResultWord(op);
+
+      if (resultWord) {
+        if (resultWord >= length || word(index, resultWord) >= bound())
+          return false;
+
+        m_defs[word(index, resultWord)] = index;
+      }
+
+      if (op == spv::OpFunction && !m_functionStart)
+        m_functionStart = index;
+
+      if (op == spv::OpExtInstImport && length > 2) {
+        const char* name = reinterpret_cast<const char*>(&m_words[offset + 2]);
+        size_t maxLength = (length - 2) * sizeof(uint32_t);
+
+        if (std::memchr(name, 0, maxLength) && !std::strcmp(name, "GLSL.std.450"))
+          m_glslExtSet = word(index, 1);
+      }
+
+      offset += length;
+    }
+
+    m_functionEnd = m_ins.size();
+
+    if (!m_functionStart)
+      m_functionStart = m_functionEnd;
+
+    // Index scalar constants so that folded
+    // values can reuse existing declarations
+    for (uint32_t i = 0; i < m_functionStart; i++) {
+      spv::Op op = opCode(i);
+
+      if (op != spv::OpConstant
+       && op != spv::OpConstantTrue
+       && op != spv::OpConstantFalse)
+        continue;
+
+      uint32_t typeId = 0;
+      uint32_t value  = 0;
+
+      if (getConstant(word(i, 2), typeId, value))
+        m_constants.insert({ (uint64_t(typeId) << 32) | value, word(i, 2) });
+    }
+
+    return true;
+  }
+
+
+  void SpirvOptimizer::forwardStores() {
+    // Only consider variables that are exclusively accessed
+    // through plain loads and stores. Anything else, such as
+    // access chains or function call arguments, may read or
+    // write the variable in ways we don't track.
+    std::vector<bool> candidates(bound(), false);
+
+    for (uint32_t i = 0; i < m_functionEnd; i++) {
+      if (opCode(i) == spv::OpVariable && isLocalVariable(word(i, 2)))
+        candidates[word(i, 2)] = true;
+    }
+
+    for (uint32_t i = 0; i < m_functionEnd; i++) {
+      spv::Op  op     = opCode(i);
+      uint32_t length = m_ins[i].length;
+      uint32_t skip   = getResultWord(op);
+
+      switch (op) {
+        case spv::OpName:
+        case spv::OpMemberName:
+        case spv::OpDecorate:
+        case spv::OpMemberDecorate:
+          continue;
+
+        case spv::OpLoad:
+          if (length <= 4 || !(word(i, 4) & spv::MemoryAccessVolatileMask))
+            skip = 3;
+          break;
+
+        case spv::OpStore:
+          if (length <= 3 || !(word(i, 3) & spv::MemoryAccessVolatileMask))
+            skip = 1;
+          break;
+
+        default:
+          break;
+      }
+
+      for (uint32_t j = 1; j < length; j++) {
+        uint32_t id = word(i, j);
+
+        if (j != skip && id < candidates.size())
+          candidates[id] = false;
+      }
+    }
+
+    // Values are only tracked within a block. Function calls
+    // may access private variables, so they end tracking too.
+    std::vector<uint32_t> values(bound(), 0);
+    std::vector<uint32_t> stores(bound(), ~0u);
+    std::vector<uint32_t> epochs(bound(), 0);
+
+    uint32_t epoch = 1;
+
+    for (uint32_t i = m_functionStart; i < m_functionEnd; i++) {
+      spv::Op op = opCode(i);
+
+      switch (op) {
+        case spv::OpLabel:
+        case spv::OpFunction:
+        case spv::OpFunctionEnd:
+        case spv::OpFunctionCall:
+          epoch += 1;
+          break;
+
+        case spv::OpStore: {
+          uint32_t ptr = word(i, 1);
+
+          if (ptr >= candidates.size() || !candidates[ptr])
+            break;
+
+          // The previous store was never read
+          if (epochs[ptr] == epoch && stores[ptr] != ~0u)
+            m_ins[stores[ptr]].removed = true;
+
+          epochs[ptr] = epoch;
+          values[ptr] = resolve(word(i, 2));
+          stores[ptr] = i;
+        } break;
+
+        case spv::OpLoad: {
+          uint32_t ptr = word(i, 3);
+
+          if (ptr >= candidates.size() || !candidates[ptr])
+            break;
+
+          if (epochs[ptr] == epoch) {
+            m_subst[word(i, 2)] = values[ptr];
+            replaceWithCopy(i, values[ptr]);
+          } else {
+            epochs[ptr] = epoch;
+            values[ptr] = word(i, 2);
+            stores[ptr] = ~0u;
+          }
+        } break;
+
+        default:
+          break;
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::foldConstants() {
+    // Blocks are ordered such that definitions appear
+    // before their uses, except for phi operands, so
+    // folded results are visible to later instructions
+    for (uint32_t i = m_functionStart; i < m_functionEnd; i++) {
+      if (m_ins[i].removed || getResultWord(opCode(i)) != 2)
+        continue;
+
+      uint32_t value = foldInstruction(i);
+
+      if (value) {
+        m_subst[word(i, 2)] = value;
+        replaceWithCopy(i, value);
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::applySubstitutions() {
+    OpInfo info;
+
+    for (uint32_t i = m_functionStart; i < m_functionEnd; i++) {
+      if (m_ins[i].removed || !getOpInfo(opCode(i), info))
+        continue;
+
+      if (opCode(i) == spv::OpExtInst && word(i, 3) != m_glslExtSet)
+        continue;
+
+      uint32_t last = std::min(info.idLast, m_ins[i].length - 1);
+
+      for (uint32_t j = info.idFirst; j <= last; j++)
+        word(i, j) = resolve(word(i, j));
+    }
+  }
+
+
+  void SpirvOptimizer::eliminateDeadCode() {
+    std::vector<uint32_t> refs(bound(), 0);
+    std::vector<std::pair<uint32_t, uint32_t>> stores;
+
+    auto forAll = [this] (const auto& fn) {
+      for (uint32_t i = 0; i < m_functionEnd; i++)
+        fn(i);
+
+      for (uint32_t i : m_newDecls)
+        fn(i);
+    };
+
+    forAll([&] (uint32_t i) {
+      if (m_ins[i].removed)
+        return;
+
+      forEachRef(i, [&refs] (uint32_t id) { refs[id] += 1; });
+
+      if (opCode(i) == spv::OpStore && isLocalVariable(word(i, 1)))
+        stores.push_back({ word(i, 1), i });
+    });
+
+    std::sort(stores.begin(), stores.end());
+
+    // Removing an instruction releases its operands,
+    // which may make further instructions removable
+    std::vector<uint32_t> worklist;
+
+    forAll([&] (uint32_t i) {
+      if (isRemovable(i) && !refs[word(i, getResultWord(opCode(i)))])
+        worklist.push_back(i);
+    });
+
+    auto remove = [&] (uint32_t i) {
+      m_ins[i].removed = true;
+
+      forEachRef(i, [&] (uint32_t id) {
+        if (!(--refs[id])) {
+          uint32_t def = getDef(id);
+
+          if (def != ~0u && isRemovable(def))
+            worklist.push_back(def);
+        }
+      });
+    };
+
+    while (!worklist.empty()) {
+      uint32_t i = worklist.back();
+      worklist.pop_back();
+
+      if (m_ins[i].removed)
+        continue;
+
+      remove(i);
+
+      // Variables are only written to, so the stores can go too
+      if (opCode(i) == spv::OpVariable) {
+        auto range = std::equal_range(stores.begin(), stores.end(),
+          std::make_pair(word(i, 2), 0u),
+          [] (const auto& a, const auto& b) { return a.first < b.first; });
+
+        for (auto s = range.first; s != range.second; s++) {
+          if (!m_ins[s->second].removed)
+            remove(s->second);
+        }
+      }
+    }
+
+    // Drop debug names and decorations of removed IDs
+    for (uint32_t i = 0; i < m_functionStart; i++) {
+      switch (opCode(i)) {
+        case spv::OpName:
+        case spv::OpMemberName:
+        case spv::OpDecorate:
+        case spv::OpMemberDecorate: {
+          uint32_t def = getDef(word(i, 1));
+
+          if (def != ~0u && m_ins[def].removed)
+            m_ins[i].removed = true;
+        } break;
+
+        default:
+          break;
+      }
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::resolve(uint32_t id) const {
+    while (id < m_subst.size() && m_subst[id])
+      id = m_subst[id];
+
+    return id;
+  }
+
+
+  void SpirvOptimizer::replaceWithCopy(
+          uint32_t                  ins,
+          uint32_t                  valueId) {
+    // Users that we don't know the layout of may still
+    // refer to the result, so keep it defined. Any
+    // instruction with a result type has at least
+    // four words, so this fits.
+    word(ins, 0) = spv::OpCopyObject | (4u << spv::WordCountShift);
+    word(ins, 3) = valueId;
+
+    m_ins[ins].length = 4;
+  }
+
+
+  bool SpirvOptimizer::isRemovable(
+          uint32_t                  ins) const {
+    if (m_ins[ins].removed)
+      return false;
+
+    spv::Op op = opCode(ins);
+
+    switch (op) {
+      case spv::OpConstant:
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstantComposite:
+      case spv::OpConstantNull:
+      case spv::OpUndef:
+        return true;
+
+      case spv::OpVariable:
+        return isLocalVariable(word(ins, 2));
+
+      case spv::OpLoad:
+        return m_ins[ins].length <= 4
+            || !(word(ins, 4) & spv::MemoryAccessVolatileMask);
+
+      case spv::OpExtInst:
+        return word(ins, 3) == m_glslExtSet;
+
+      default: {
+        OpInfo info;
+        return getOpInfo(op, info) && info.pure;
+      }
+    }
+  }
+
+
+  bool SpirvOptimizer::isLocalVariable(
+          uint32_t                  id) const {
+    uint32_t def = getDef(id);
+
+    if (def == ~0u || opCode(def) != spv::OpVariable)
+      return false;
+
+    auto storage = spv::StorageClass(word(def, 3));
+
+    return storage == spv::StorageClassPrivate
+        || storage == spv::StorageClassFunction;
+  }
+
+
+  bool SpirvOptimizer::getScalarType(
+          uint32_t                  typeId,
+          spv::Op&                  op,
+          uint32_t&                 width) const {
+    uint32_t def = getDef(typeId);
+
+    if (def == ~0u)
+      return false;
+
+    op = opCode(def);
+
+    switch (op) {
+      case spv::OpTypeBool:
+        width = 1;
+        return true;
+
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+        width = word(def, 2);
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+
+  bool SpirvOptimizer::getConstant(
+          uint32_t                  id,
+          uint32_t&                 typeId,
+          uint32_t&                 value) const {
+    uint32_t def = getDef(id);
+
+    if (def == ~0u)
+      return false;
+
+    spv::Op  typeOp;
+    uint32_t width;
+
+    switch (opCode(def)) {
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+        typeId = word(def, 1);
+        value  = opCode(def) == spv::OpConstantTrue ? 1 : 0;
+        return true;
+
+      case spv::OpConstant:
+        typeId = word(def, 1);
+        value  = word(def, 3);
+
+        return m_ins[def].length == 4
+            && getScalarType(typeId, typeOp, width)
+            && width == 32;
+
+      default:
+        return false;
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::defConstant(
+          uint32_t                  typeId,
+          uint32_t                  value) {
+    auto entry = m_constants.find((uint64_t(typeId) << 32) | value);
+
+    if (entry != m_constants.end())
+      return entry->second;
+
+    spv::Op  typeOp;
+    uint32_t width;
+
+    if (!getScalarType(typeId, typeOp, width))
+      return 0;
+
+    uint32_t resultId = m_words[3]++;
+
+    m_defs.push_back(m_ins.size());
+    m_subst.push_back(0);
+
+    m_newDecls.push_back(m_ins.size());
+    m_ins.push_back({ uint32_t(m_words.size()), 0, false });
+
+    if (typeOp == spv::OpTypeBool) {
+      m_words.push_back((value ? spv::OpConstantTrue : spv::OpConstantFalse) | (3u << spv::WordCountShift));
+      m_words.push_back(typeId);
+      m_words.push_back(resultId);
+    } else {
+      m_words.push_back(spv::OpConstant | (4u << spv::WordCountShift));
+      m_words.push_back(typeId);
+      m_words.push_back(resultId);
+      m_words.push_back(value);
+    }
+
+    m_ins.back().length = m_words.size() - m_ins.back().offset;
+    m_constants.insert({ (uint64_t(typeId) << 32) | value, resultId });
+    return resultId;
+  }
+
+
+  uint32_t SpirvOptimizer::foldInstruction(
+          uint32_t                  ins) {
+    spv::Op  op     = opCode(ins);
+    uint32_t length = m_ins[ins].length;
+    uint32_t typeId = word(ins, 1);
+
+    spv::Op  typeOp;
+    uint32_t width;
+
+    // Copies, selections and extractions resolve to
+    // an existing value, which need not be constant
+    if (op == spv::OpCopyObject && length == 4)
+      return resolve(word(ins, 3));
+
+    if (op == spv::OpSelect && length == 6) {
+      uint32_t condType, cond;
+
+      if (!getConstant(resolve(word(ins, 3)), condType, cond))
+        return 0;
+
+      return resolve(word(ins, cond ? 4 : 5));
+    }
+
+    if (op == spv::OpCompositeExtract && length == 5) {
+      uint32_t def   = getDef(resolve(word(ins, 3)));
+      uint32_t index = word(ins, 4);
+
+      if (def == ~0u)
+        return 0;
+
+      if (opCode(def) == spv::OpConstantComposite) {
+        return index < m_ins[def].length - 3
+          ? word(def, 3 + index) : 0;
+      }
+
+      // Only vectors are guaranteed to be constructed
+      // from scalars if the counts match
+      if (opCode(def) == spv::OpCompositeConstruct) {
+        uint32_t vecType = getDef(word(def, 1));
+
+        if (vecType == ~0u || opCode(vecType) != spv::OpTypeVector
+         || word(vecType, 3) != m_ins[def].length - 3
+         || index >= word(vecType, 3))
+          return 0;
+
+        return resolve(word(def, 3 + index));
+      }
+
+      return 0;
+    }
+
+    // Everything else produces a 32-bit scalar or a boolean
+    if (!getScalarType(typeId, typeOp, width)
+     || (typeOp != spv::OpTypeBool && width != 32))
+      return 0;
+
+    uint32_t aType = 0, a = 0;
+    uint32_t bType = 0, b = 0;
+
+    if (length < 4 || !getConstant(resolve(word(ins, 3)), aType, a))
+      return 0;
+
+    if (length == 5 && !getConstant(resolve(word(ins, 4)), bType, b))
+      return 0;
+
+    if (length > 5 || aType == 0 || (length == 5 && bType == 0))
+      return 0;
+
+    bool binary = length == 5;
+
+    switch (op) {
+      case spv::OpBitcast:
+        return !binary && typeOp != spv::OpTypeBool
+            && getScalarType(aType, typeOp, width) && width == 32
+          ? defConstant(typeId, a) : 0;
+
+      case spv::OpNot:
+        return !binary && typeOp == spv::OpTypeInt
+          ? defConstant(typeId, ~a) : 0;
+
+      case spv::OpSNegate:
+        return !binary && typeOp == spv::OpTypeInt
+          ? defConstant(typeId, 0u - a) : 0;
+
+      case spv::OpLogicalNot:
+        return !binary && typeOp == spv::OpTypeBool
+          ? defConstant(typeId, !a) : 0;
+
+      default:
+        break;
+    }
+
+    if (!binary)
+      return 0;
+
+    if (typeOp == spv::OpTypeInt) {
+      switch (op) {
+        case spv::OpIAdd:               return defConstant(typeId, a + b);
+        case spv::OpISub:               return defConstant(typeId, a - b);
+        case spv::OpIMul:               return defConstant(typeId, a * b);
+        case spv::OpBitwiseAnd:         return defConstant(typeId, a & b);
+        case spv::OpBitwiseOr:          return defConstant(typeId, a | b);
+        case spv::OpBitwiseXor:         return defConstant(typeId, a ^ b);
+        case spv::OpUDiv:               return b ? defConstant(typeId, a / b) : 0;
+        case spv::OpUMod:               return b ? defConstant(typeId, a % b) : 0;
+        case spv::OpShiftLeftLogical:   return b < 32 ? defConstant(typeId, a << b) : 0;
+        case spv::OpShiftRightLogical:  return b < 32 ? defConstant(typeId, a >> b) : 0;
+        case spv::OpShiftRightArithmetic:
+          return b < 32 ? defConstant(typeId, uint32_t(int32_t(a) >> b)) : 0;
+        default:
+          return 0;
+      }
+    }
+
+    if (typeOp == spv::OpTypeBool) {
+      int32_t sa = int32_t(a);
+      int32_t sb = int32_t(b);
+
+      switch (op) {
+        case spv::OpIEqual:             return defConstant(typeId, a == b);
+        case spv::OpINotEqual:          return defConstant(typeId, a != b);
+        case spv::OpULessThan:          return defConstant(typeId, a <  b);
+        case spv::OpULessThanEqual:     return defConstant(typeId, a <= b);
+        case spv::OpUGreaterThan:       return defConstant(typeId, a >  b);
+        case spv::OpUGreaterThanEqual:  return defConstant(typeId, a >= b);
+        case spv::OpSLessThan:          return defConstant(typeId, sa <  sb);
+        case spv::OpSLessThanEqual:     return defConstant(typeId, sa <= sb);
+        case spv::OpSGreaterThan:       return defConstant(typeId, sa >  sb);
+        case spv::OpSGreaterThanEqual:  return defConstant(typeId, sa >= sb);
+        case spv::OpLogicalAnd:         return defConstant(typeId, a && b);
+        case spv::OpLogicalOr:          return defConstant(typeId, a || b);
+        case spv::OpLogicalEqual:       return defConstant(typeId, a == b);
+        case spv::OpLogicalNotEqual:    return defConstant(typeId, a != b);
+        default:
+          return 0;
+      }
+    }
+
+    return 0;
+  }
+
+
+  template<typename Fn>
+  void SpirvOptimizer::forEachRef(
+          uint32_t                  ins,
+    const Fn&                       fn) const {
+    spv::Op  op         = opCode(ins);
+    uint32_t length     = m_ins[ins].length;
+    uint32_t resultWord = getResultWord(op);
+    uint32_t skipWord   = 0;
+
+    switch (op) {
+      // Debug info and annotations don't keep
+      // their targets alive, and other words
+      // of these instructions are literals
+      case spv::OpName:
+      case spv::OpMemberName:
+      case spv::OpDecorate:
+      case spv::OpMemberDecorate:
+      case spv::OpString:
+      case spv::OpSource:
+      case spv::OpSourceExtension:
+      case spv::OpExtension:
+      case spv::OpExtInstImport:
+      case spv::OpCapability:
+      case spv::OpMemoryModel:
+        return;
+
+      case spv::OpConstant:
+      case spv::OpSpecConstant:
+        length = 2;
+        break;
+
+      // Stores alone don't keep a variable alive
+      case spv::OpStore:
+        if (isLocalVariable(word(ins, 1)))
+          skipWord = 1;
+        break;
+
+      default:
+        break;
+    }
+
+    for (uint32_t i = 1; i < length; i++) {
+      uint32_t id = word(ins, i);
+
+      if (i != resultWord && i != skipWord && id < bound())
+        fn(id);
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::getResultWord(
+          spv::Op                   op) {
+    bool hasResult = false;
+    bool hasType   = false;
+
+    spv::HasResultAndType(op, &hasResult, &hasType);
+
+    if (!hasResult)
+      return 0;
+
+    return hasType ? 2 : 1;
+  }
+
+
+  bool SpirvOptimizer::getOpInfo(
+          spv::Op                   op,
+          OpInfo&                   info) {
+    info.resultWord = getResultWord(op);
+    info.idFirst    = 3;
+    info.idLast     = ~0u;
+    info.pure       = true;
+
+    switch (op) {
+      case spv::OpLoad:
+      case spv::OpCompositeExtract:
+        info.idLast = 3;
+        return true;
+
+      case spv::OpCompositeInsert:
+      case spv::OpVectorShuffle:
+        info.idLast = 4;
+        return true;
+
+      case spv::OpExtInst:
+        info.idFirst = 5;
+        info.pure    = false;
+        return true;
+
+      case spv::OpStore:
+        info.idFirst = 1;
+        info.idLast  = 2;
+        info.pure    = false;
+        return true;
+
+      case spv::OpReturnValue:
+      case spv::OpBranchConditional:
+        info.idFirst = 1;
+        info.idLast  = 1;
+        info.pure    = false;
+        return true;
+
+      case spv::OpUndef:
+      case spv::OpCopyObject:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpCompositeConstruct:
+      case spv::OpSampledImage:
+      case spv::OpConvertFToU:
+      case spv::OpConvertFToS:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpUConvert:
+      case spv::OpSConvert:
+      case spv::OpFConvert:
+      case spv::OpQuantizeToF16:
+      case spv::OpBitcast:
+      case spv::OpSNegate:
+      case spv::OpFNegate:
+      case spv::OpIAdd:
+      case spv::OpFAdd:
+      case spv::OpISub:
+      case spv::OpFSub:
+      case spv::OpIMul:
+      case spv::OpFMul:
+      case spv::OpUDiv:
+      case spv::OpSDiv:
+      case spv::OpFDiv:
+      case spv::OpUMod:
+      case spv::OpSRem:
+      case spv::OpSMod:
+      case spv::OpFRem:
+      case spv::OpFMod:
+      case spv::OpVectorTimesScalar:
+      case spv::OpMatrixTimesScalar:
+      case spv::OpVectorTimesMatrix:
+      case spv::OpMatrixTimesVector:
+      case spv::OpMatrixTimesMatrix:
+      case spv::OpOuterProduct:
+      case spv::OpDot:
+      case spv::OpIAddCarry:
+      case spv::OpISubBorrow:
+      case spv::OpUMulExtended:
+      case spv::OpSMulExtended:
+      case spv::OpAny:
+      case spv::OpAll:
+      case spv::OpIsNan:
+      case spv::OpIsInf:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalNot:
+      case spv::OpSelect:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+      case spv::OpFOrdEqual:
+      case spv::OpFUnordEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFUnordNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFUnordLessThan:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFUnordGreaterThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFUnordLessThanEqual:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpFUnordGreaterThanEqual:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftLeftLogical:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpBitwiseAnd:
+      case spv::OpNot:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitCount:
+      case spv::OpPhi:
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief SPIR-V optimizer pass
+   */
+  enum class SpirvOptimizerPass : uint32_t {
+    EliminateDeadCode = 0,
+    FoldConstants     = 1,
+    ForwardStores     = 2,
+  };
+
+  using SpirvOptimizerPasses = Flags<SpirvOptimizerPass>;
+
+
+  /**
+   * \brief SPIR-V optimizer
+   *
+   * Runs a few simple passes on a complete SPIR-V module
+   * in order to remove the redundancies that the shader
+   * compilers produce by translating each instruction in
+   * isolation:
+   *
+   * - Store forwarding replaces loads from private and
+   *   function variables with the value that was last
+   *   stored to or loaded from the variable in the same
+   *   block, and removes stores that are overwritten
+   *   before the end of the block.
+   * - Constant folding evaluates 32-bit integer and
+   *   boolean operations on constant operands, as well
+   *   as selections and extractions of known values.
+   * - Dead code elimination removes unused constants,
+   *   variables that are never read and instructions
+   *   without side effects whose result is unused.
+   *
+   * Instructions whose operand layout is not known to
+   * the optimizer are never modified or removed, and
+   * any word of those instructions is treated as a
+   * potential ID reference.
+   */
+  class SpirvOptimizer {
+
+  public:
+
+    SpirvOptimizer(
+      const SpirvCodeBuffer&          code);
+
+    ~SpirvOptimizer();
+
+    /**
+     * \brief Runs optimization passes
+     *
+     * Does nothing if the code could not be parsed.
+     * \param [in] passes The passes to run
+     */
+    void run(SpirvOptimizerPasses passes);
+
+    /**
+     * \brief Retrieves optimized code
+     * \returns Code buffer with the optimized module
+     */
+    SpirvCodeBuffer getCode() const;
+
+  private:
+
+    struct Instruction {
+      uint32_t offset;
+      uint32_t length;
+      bool     removed;
+    };
+
+    struct OpInfo {
+      uint32_t resultWord;
+      uint32_t idFirst;
+      uint32_t idLast;
+      bool     pure;
+    };
+
+    bool                      m_valid = false;
+
+    std::vector<uint32_t>     m_words;
+    std::vector<Instruction>  m_ins;
+
+    uint32_t                  m_functionStart = 0;
+    uint32_t                  m_functionEnd   = 0;
+    std::vector<uint32_t>     m_newDecls;
+
+    std::vector<uint32_t>     m_defs;
+    std::vector<uint32_t>     m_subst;
+
+    std::unordered_map<uint64_t, uint32_t> m_constants;
+
+    uint32_t                  m_glslExtSet = 0;
+
+    bool parse();
+
+    void forwardStores();
+
+    void foldConstants();
+
+    void applySubstitutions();
+
+    void eliminateDeadCode();
+
+    uint32_t bound() const {
+      return m_words[3];
+    }
+
+    spv::Op opCode(uint32_t ins) const {
+      return spv::Op(m_words[m_ins[ins].offset] & spv::OpCodeMask);
+    }
+
+    uint32_t& word(uint32_t ins, uint32_t idx) {
+      return m_words[m_ins[ins].offset + idx];
+    }
+
+    uint32_t word(uint32_t ins, uint32_t idx) const {
+      return m_words[m_ins[ins].offset + idx];
+    }
+
+    uint32_t getDef(uint32_t id) const {
+      return id < m_defs.size() ? m_defs[id] : ~0u;
+    }
+
+    uint32_t resolve(uint32_t id) const;
+
+    void replaceWithCopy(
+            uint32_t                  ins,
+            uint32_t                  valueId);
+
+    bool isRemovable(
+            uint32_t                  ins) const;
+
+    bool isLocalVariable(
+            uint32_t                  id) const;
+
+    bool getScalarType(
+            uint32_t                  typeId,
+            spv::Op&                  op,
+            uint32_t&                 width) const;
+
+    bool getConstant(
+            uint32_t                  id,
+            uint32_t&                 typeId,
+            uint32_t&                 value) const;
+
+    uint32_t defConstant(
+            uint32_t                  typeId,
+            uint32_t                  value);
+
+    uint32_t foldInstruction(
+            uint32_t                  ins);
+
+    template<typename Fn>
+    void forEachRef(
+            uint32_t                  ins,
+      const Fn&                       fn) const;
+
+    static uint32_t getResultWord(
+            spv::Op                   op);
+
+    static bool getOpInfo(
+            spv::Op                   op,
+            OpInfo&                   info);
+
+  };
+
+}
@@ -19,6 +19,25 @@ namespace dxvk {
       return ++m_refCount;
     }
     
+    /**
+     * \brief Increments reference count if non-zero
+     * 
+     * Used to safely obtain a reference to an object
+     * that is looked up through a non-owning pointer
+     * and may be in the process of being destroyed.
+     * \returns \c true if a reference was acquired
+     */
+    bool tryIncRef() {
+      uint32_t count = m_refCount.load();
+
+      do {
+        if (!count)
+          return false;
+      } while (!m_refCount.compare_exchange_weak(count, count + 1));
+
+      return true;
+    }
+    
     /**
      * \brief Decrements reference count
      * \returns New reference count
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Lock-free multi-producer stack
+   *
+   * Any number of threads may push items without
+   * taking a lock. A single consumer takes all items
+   * at once, which avoids the ABA problem that comes
+   * with popping individual nodes from a lock-free
+   * stack. Nodes of drained items are kept and reused
+   * by later pushes, along with the item storage, so
+   * that pushing only allocates when the stack grows.
+   * \tparam T Item type
+   */
+  template<typename T>
+  class MpscStack {
+
+    struct Node {
+      Node* next;
+      T     data;
+    };
+
+  public:
+
+    MpscStack() { }
+
+    MpscStack             (const MpscStack&) = delete;
+    MpscStack& operator = (const MpscStack&) = delete;
+
+    ~MpscStack() {
+      freeNodes(m_head.exchange(nullptr, std::memory_order_acquire));
+      freeNodes(m_free.exchange(nullptr, std::memory_order_acquire));
+    }
+
+    /**
+     * \brief Checks whether the stack is empty
+     * \returns \c true if there are no items
+     */
+    bool empty() const {
+      return m_head.load(std::memory_order_relaxed) == nullptr;
+    }
+
+    /**
+     * \brief Pushes an item in place
+     *
+     * Safe to call from any thread. The given function
+     * initializes the item. If a node gets reused, the
+     * item still holds the contents of a drained item,
+     * so that e.g. vectors can keep their capacity.
+     * \param [in] fn Function that writes the item
+     */
+    template<typename Fn>
+    void emplace(const Fn& fn) {
+      Node* node = allocNode();
+      fn(node->data);
+      pushNodes(m_head, node, node);
+    }
+
+    /**
+     * \brief Pushes an item
+     *
+     * Safe to call from any thread.
+     * \param [in] data The item
+     */
+    void push(T&& data) {
+      emplace([&data] (T& item) {
+        item = std::move(data);
+      });
+    }
+
+    /**
+     * \brief Takes all items
+     *
+     * Removes all items from the stack and passes them
+     * to the given function, in the order in which they
+     * were pushed. The nodes are kept for later pushes.
+     * Must not be called concurrently.
+     * \param [in] fn Function to call for each item
+     */
+    template<typename Fn>
+    void drain(const Fn& fn) {
+      Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+      if (!node)
+        return;
+
+      // Restore push order, which is what
+      // the consumer will usually expect
+      Node* list = nullptr;
+      Node* last = node;
+
+      while (node) {
+        Node* next = node->next;
+        node->next = list;
+        list = node;
+        node = next;
+      }
+
+      for (Node* item = list; item; item = item->next)
+        fn(item->data);
+
+      pushNodes(m_free, list, last);
+    }
+
+  private:
+
+    std::atomic<Node*> m_head = { nullptr };
+    std::atomic<Node*> m_free = { nullptr };
+
+    Node* allocNode() {
+      // Take all spare nodes at once for the same reason
+      // that drain does, and put back the ones we don't need
+      Node* node = m_free.exchange(nullptr, std::memory_order_acquire);
+
+      if (!node)
+        return new Node { nullptr, T() };
+
+      if (node->next) {
+        Node* last = node->next;
+
+        while (last->next)
+          last = last->next;
+
+        pushNodes(m_free, node->next, last);
+      }
+
+      return node;
+    }
+
+    static void pushNodes(
+            std::atomic<Node*>& head,
+            Node*               first,
+            Node*               last) {
+      Node* next = head.load(std::memory_order_relaxed);
+
+      do {
+        last->next = next;
+      } while (!head.compare_exchange_weak(next, first,
+        std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    static void freeNodes(Node* node) {
+      while (node) {
+        Node* next = node->next;
+        delete node;
+        node = next;
+      }
+    }
+
+  };
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "../util_math.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Lock-free single-producer ring buffer
+   *
+   * Bounded queue that one producer thread and one
+   * consumer thread can access without locking. Each
+   * side caches the other side's index so that the
+   * shared cache line only needs to be read when the
+   * ring appears to be full or empty.
+   * \tparam T Item type, must be default-constructible
+   * \tparam Capacity Number of items, must be a power of two
+   */
+  template<typename T, size_t Capacity>
+  class SpscRing {
+    static_assert(Capacity && !(Capacity & (Capacity - 1)),
+      "Ring capacity must be a power of two");
+
+    constexpr static size_t Mask = Capacity - 1;
+  public:
+
+    SpscRing() { }
+
+    SpscRing             (const SpscRing&) = delete;
+    SpscRing& operator = (const SpscRing&) = delete;
+
+    /**
+     * \brief Checks whether the ring is empty
+     *
+     * Only reliable when called from the consumer,
+     * or from the producer when the result is \c false.
+     * \returns \c true if there are no items
+     */
+    bool empty() const {
+      return m_head.load(std::memory_order_acquire)
+          == m_tail.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Checks whether the ring is full
+     *
+     * Only reliable when called from the producer.
+     * \returns \c true if no item can be pushed
+     */
+    bool full() const {
+      return m_tail.load(std::memory_order_relaxed)
+           - m_head.load(std::memory_order_acquire) >= Capacity;
+    }
+
+    /**
+     * \brief Pushes an item
+     *
+     * Must only be called by the producer.
+     * \param [in] item The item
+     * \returns \c false if the ring is full, in
+     *    which case the item is left untouched
+     */
+    bool tryPush(T&& item) {
+      size_t tail = m_tail.load(std::memory_order_relaxed);
+
+      if (tail - m_headCache >= Capacity) {
+        m_headCache = m_head.load(std::memory_order_acquire);
+
+        if (tail - m_headCache >= Capacity)
+          return false;
+      }
+
+      m_items[tail & Mask] = std::move(item);
+      m_tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * \brief Pops an item
+     *
+     * Must only be called by the consumer.
+     * \param [out] item The item
+     * \returns \c false if the ring is empty
+     */
+    bool tryPop(T& item) {
+      size_t head = m_head.load(std::memory_order_relaxed);
+
+      if (head == m_tailCache) {
+        m_tailCache = m_tail.load(std::memory_order_acquire);
+
+        if (head == m_tailCache)
+          return false;
+      }
+
+      // Move the item out so that the slot does
+      // not keep any resources alive
+      item = std::move(m_items[head & Mask]);
+      m_head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+  private:
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t> m_head      = { 0ull };
+    size_t              m_tailCache = 0ull;
+
+    alignas(CACHE_LINE_SIZE)
+    std::atomic<size_t> m_tail      = { 0ull };
+    size_t              m_headCache = 0ull;
+
+    alignas(CACHE_LINE_SIZE)
+    std::array<T, Capacity> m_items;
+
+  };
+
+}
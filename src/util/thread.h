@@ -143,5 +143,9 @@ namespace dxvk {
     inline void yield() {
       SwitchToThread();
     }
+
+    inline uint32_t get_id() {
+      return uint32_t(GetCurrentThreadId());
+    }
   }
 }
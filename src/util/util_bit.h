@@ -166,6 +166,83 @@ namespace dxvk::bit {
     #endif
   }
 
+  /**
+   * \brief Hashes an aligned struct bit by bit
+   *
+   * Accumulates 64-bit products of the data mixed with
+   * a position-dependent key in independent lanes, so
+   * that large structs can be hashed at a rate similar
+   * to that of \c bcmpeq. Not suitable for persistent
+   * data since the result depends on the code path.
+   * \param [in] data The struct
+   * \returns Hash of the struct
+   */
+  template<typename T>
+  uint64_t bhash(const T* data) {
+    static_assert(alignof(T) >= 32 && sizeof(T) % 32 == 0);
+    constexpr uint64_t k = 0x9e3779b97f4a7c15ull;
+
+    uint64_t lanes[4];
+
+    #if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+    auto di = reinterpret_cast<const __m128i*>(data);
+
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+    __m128i key0 = _mm_set_epi64x(int64_t(k * 2), int64_t(k * 1));
+    __m128i key1 = _mm_set_epi64x(int64_t(k * 4), int64_t(k * 3));
+    __m128i step = _mm_set1_epi64x(int64_t(k * 4));
+
+    for (size_t i = 0; i < sizeof(T) / 16; i += 2) {
+      __m128i d0 = _mm_load_si128(di + i);
+      __m128i d1 = _mm_load_si128(di + i + 1);
+
+      // Multiply the low and high halves of each 64-bit
+      // word, and add the swapped data to the product so
+      // that no information gets lost if either is zero
+      __m128i dk0 = _mm_xor_si128(d0, key0);
+      __m128i dk1 = _mm_xor_si128(d1, key1);
+
+      acc0 = _mm_add_epi64(acc0, _mm_mul_epu32(dk0, _mm_shuffle_epi32(dk0, _MM_SHUFFLE(2, 3, 0, 1))));
+      acc1 = _mm_add_epi64(acc1, _mm_mul_epu32(dk1, _mm_shuffle_epi32(dk1, _MM_SHUFFLE(2, 3, 0, 1))));
+      acc0 = _mm_add_epi64(acc0, _mm_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2)));
+      acc1 = _mm_add_epi64(acc1, _mm_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2)));
+
+      key0 = _mm_add_epi64(key0, step);
+      key1 = _mm_add_epi64(key1, step);
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&lanes[0]), acc0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&lanes[2]), acc1);
+    #else
+    auto bytes = reinterpret_cast<const char*>(data);
+
+    for (size_t j = 0; j < 4; j++)
+      lanes[j] = 0;
+
+    for (size_t i = 0; i < sizeof(T); i += 32) {
+      for (size_t j = 0; j < 4; j++) {
+        uint64_t w;
+        std::memcpy(&w, bytes + i + 8 * j, sizeof(w));
+
+        uint64_t key = k * (i / 8 + j + 1);
+        uint64_t dk  = w ^ key;
+        lanes[j] += (dk & 0xffffffffull) * (dk >> 32);
+        lanes[j] += (w << 32) | (w >> 32);
+      }
+    }
+    #endif
+
+    uint64_t result = 0;
+
+    for (size_t j = 0; j < 4; j++) {
+      result = (result ^ lanes[j]) * k;
+      result ^= result >> 29;
+    }
+
+    return result;
+  }
+
   template <size_t Bits>
   class bitset {
     static constexpr size_t Dwords = align(Bits, 32) / 32;
@@ -53,4 +53,26 @@ namespace dxvk::env {
     return !!CreateDirectoryW(widePath, nullptr);
   }
   
+  
+  bool truncateFile(const std::string& path, uint64_t size) {
+    WCHAR widePath[MAX_PATH];
+    str::tows(path.c_str(), widePath);
+
+    HANDLE file = CreateFileW(widePath, GENERIC_WRITE,
+      FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+      return false;
+
+    LARGE_INTEGER offset;
+    offset.QuadPart = LONGLONG(size);
+
+    bool success = SetFilePointerEx(file, offset, nullptr, FILE_BEGIN)
+                && SetEndOfFile(file);
+
+    CloseHandle(file);
+    return success;
+  }
+  
 }
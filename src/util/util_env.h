@@ -45,4 +45,13 @@ namespace dxvk::env {
    */
   bool createDirectory(const std::string& path);
   
+  /**
+   * \brief Truncates a file
+   * 
+   * \param [in] path Path to the file
+   * \param [in] size New file size, in bytes
+   * \returns \c true on success
+   */
+  bool truncateFile(const std::string& path, uint64_t size);
+  
 }
@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstring>
+
+#include "util_lz4.h"
+
+namespace dxvk::lz4 {
+
+  // Format constraints, the last match must start at least 12
+  // bytes before the end of the block and the last 5 bytes
+  // are always stored as literals.
+  constexpr size_t MinMatch     = 4;
+  constexpr size_t MatchLimit   = 12;
+  constexpr size_t LastLiterals = 5;
+  constexpr size_t MaxOffset    = 65535;
+
+  constexpr uint32_t HashBits   = 12;
+
+  static uint32_t read32(const uint8_t* ptr) {
+    uint32_t result;
+    std::memcpy(&result, ptr, sizeof(result));
+    return result;
+  }
+
+
+  static uint32_t hash32(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HashBits);
+  }
+
+
+  static uint8_t* writeLength(uint8_t* dst, size_t length) {
+    while (length >= 255) {
+      *(dst++) = 255;
+      length  -= 255;
+    }
+
+    *(dst++) = uint8_t(length);
+    return dst;
+  }
+
+
+  static uint8_t* writeSequence(
+          uint8_t*  dst,
+          uint8_t*  dstEnd,
+    const uint8_t*  literals,
+          size_t    literalCount,
+          size_t    offset,
+          size_t    matchLength) {
+    // Token, literal length bytes, literals,
+    // offset and match length bytes
+    size_t maxSize = 1 + literalCount / 255 + 1 + literalCount
+                   + 2 + matchLength / 255 + 1;
+
+    if (size_t(dstEnd - dst) < maxSize)
+      return nullptr;
+
+    uint8_t* token = dst++;
+
+    *token = uint8_t(std::min<size_t>(literalCount, 15) << 4);
+
+    if (literalCount >= 15)
+      dst = writeLength(dst, literalCount - 15);
+
+    if (literalCount) {
+      std::memcpy(dst, literals, literalCount);
+      dst += literalCount;
+    }
+
+    // The last sequence has no match
+    if (matchLength) {
+      *(dst++) = uint8_t(offset);
+      *(dst++) = uint8_t(offset >> 8);
+
+      size_t length = matchLength - MinMatch;
+      *token |= uint8_t(std::min<size_t>(length, 15));
+
+      if (length >= 15)
+        dst = writeLength(dst, length - 15);
+    }
+
+    return dst;
+  }
+
+
+  size_t compress(
+    const void*   src,
+          size_t  srcSize,
+          void*   dst,
+          size_t  dstSize) {
+    auto in     = reinterpret_cast<const uint8_t*>(src);
+    auto inEnd  = in + srcSize;
+    auto out    = reinterpret_cast<uint8_t*>(dst);
+    auto outEnd = out + dstSize;
+
+    // Positions of the most recent occurence of each hashed
+    // four-byte sequence, relative to the start of the input
+    uint32_t table[1u << HashBits];
+
+    for (auto& entry : table)
+      entry = ~0u;
+
+    const uint8_t* anchor = in;
+    const uint8_t* ptr    = in;
+
+    if (srcSize > MatchLimit) {
+      const uint8_t* matchEnd = inEnd - LastLiterals;
+      const uint8_t* scanEnd  = inEnd - MatchLimit;
+
+      while (ptr < scanEnd) {
+        uint32_t sequence = read32(ptr);
+        uint32_t& entry   = table[hash32(sequence)];
+
+        const uint8_t* ref = entry != ~0u ? in + entry : nullptr;
+        entry = uint32_t(ptr - in);
+
+        if (!ref || size_t(ptr - ref) > MaxOffset || read32(ref) != sequence) {
+          ptr += 1;
+          continue;
+        }
+
+        // Extend the match backwards into pending literals
+        while (ptr > anchor && ref > in && ptr[-1] == ref[-1]) {
+          ptr -= 1;
+          ref -= 1;
+        }
+
+        size_t matchLength = MinMatch;
+
+        while (ptr + matchLength < matchEnd && ptr[matchLength] == ref[matchLength])
+          matchLength += 1;
+
+        out = writeSequence(out, outEnd, anchor,
+          size_t(ptr - anchor), size_t(ptr - ref), matchLength);
+
+        if (!out)
+          return 0;
+
+        ptr   += matchLength;
+        anchor = ptr;
+      }
+    }
+
+    out = writeSequence(out, outEnd, anchor,
+      size_t(inEnd - anchor), 0, 0);
+
+    if (!out)
+      return 0;
+
+    return size_t(out - reinterpret_cast<uint8_t*>(dst));
+  }
+
+
+  bool decompress(
+    const void*   src,
+          size_t  srcSize,
+          void*   dst,
+          size_t  dstSize) {
+    auto in     = reinterpret_cast<const uint8_t*>(src);
+    auto inEnd  = in + srcSize;
+    auto out    = reinterpret_cast<uint8_t*>(dst);
+    auto outBeg = out;
+    auto outEnd = out + dstSize;
+
+    while (in < inEnd) {
+      uint8_t token = *(in++);
+
+      // Decode literal length
+      size_t literalCount = token >> 4;
+
+      if (literalCount == 15) {
+        uint8_t next;
+
+        do {
+          if (in == inEnd)
+            return false;
+
+          next = *(in++);
+          literalCount += next;
+        } while (next == 255);
+      }
+
+      if (size_t(inEnd - in) < literalCount
+       || size_t(outEnd - out) < literalCount)
+        return false;
+
+      if (literalCount) {
+        std::memcpy(out, in, literalCount);
+        in  += literalCount;
+        out += literalCount;
+      }
+
+      // The last sequence ends after the literals
+      if (in == inEnd)
+        break;
+
+      if (size_t(inEnd - in) < 2)
+        return false;
+
+      size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+      in += 2;
+
+      if (!offset || size_t(out - outBeg) < offset)
+        return false;
+
+      // Decode match length
+      size_t matchLength = token & 0xF;
+
+      if (matchLength == 15) {
+        uint8_t next;
+
+        do {
+          if (in == inEnd)
+            return false;
+
+          next = *(in++);
+          matchLength += next;
+        } while (next == 255);
+      }
+
+      matchLength += MinMatch;
+
+      if (size_t(outEnd - out) < matchLength)
+        return false;
+
+      // Matches may overlap the output, so
+      // we have to copy byte by byte here
+      const uint8_t* ref = out - offset;
+
+      for (size_t i = 0; i < matchLength; i++)
+        out[i] = ref[i];
+
+      out += matchLength;
+    }
+
+    return out == outEnd;
+  }
+
+}
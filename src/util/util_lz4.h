@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dxvk::lz4 {
+
+  /**
+   * \brief Computes maximum compressed size
+   * 
+   * Incompressible data grows slightly when
+   * compressed, this returns the worst case.
+   * \param [in] size Uncompressed data size
+   * \returns Required size of the destination buffer
+   */
+  inline size_t compressBound(size_t size) {
+    return size + size / 255 + 16;
+  }
+
+  /**
+   * \brief Compresses data
+   * 
+   * Produces a raw LZ4 block without any frame
+   * headers, so the caller needs to store the
+   * uncompressed size separately.
+   * \param [in] src Data to compress
+   * \param [in] srcSize Size of the data, in bytes
+   * \param [out] dst Destination buffer
+   * \param [in] dstSize Size of the destination buffer
+   * \returns Compressed size, or 0 if \c dst is too small
+   */
+  size_t compress(
+    const void*   src,
+          size_t  srcSize,
+          void*   dst,
+          size_t  dstSize);
+
+  /**
+   * \brief Decompresses data
+   * 
+   * Validates the compressed data, so that corrupted
+   * input will never read or write out of bounds.
+   * \param [in] src Compressed LZ4 block
+   * \param [in] srcSize Size of the compressed block
+   * \param [out] dst Destination buffer
+   * \param [in] dstSize Exact uncompressed size
+   * \returns \c true if the block decompressed to
+   *    exactly \c dstSize bytes, \c false otherwise
+   */
+  bool decompress(
+    const void*   src,
+          size_t  srcSize,
+          void*   dst,
+          size_t  dstSize);
+
+}
@@ -1,4 +1,5 @@
 #include "vulkan_loader.h"
+#include "vulkan_null.h"
 
 namespace dxvk::vk {
 
@@ -6,16 +7,23 @@ namespace dxvk::vk {
 
   extern "C"
   PFN_vkVoidFunction native_vkGetInstanceProcAddrWINE(VkInstance instance, const char *name);
-  static const PFN_vkGetInstanceProcAddr GetInstanceProcAddr = native_vkGetInstanceProcAddrWINE;
+  static const PFN_vkGetInstanceProcAddr NativeGetInstanceProcAddr = native_vkGetInstanceProcAddrWINE;
 
 #else
 
-  static const PFN_vkGetInstanceProcAddr GetInstanceProcAddr = vkGetInstanceProcAddr;
+  static const PFN_vkGetInstanceProcAddr NativeGetInstanceProcAddr = vkGetInstanceProcAddr;
 
 #endif
 
+  static PFN_vkGetInstanceProcAddr GetInstanceProcAddr() {
+    static const PFN_vkGetInstanceProcAddr s_fn = isNullDeviceEnabled()
+      ? &nullGetInstanceProcAddr
+      : NativeGetInstanceProcAddr;
+    return s_fn;
+  }
+
   PFN_vkVoidFunction LibraryLoader::sym(const char* name) const {
-    return dxvk::vk::GetInstanceProcAddr(nullptr, name);
+    return dxvk::vk::GetInstanceProcAddr()(nullptr, name);
   }
   
   
@@ -24,13 +32,18 @@ namespace dxvk::vk {
   
   
   PFN_vkVoidFunction InstanceLoader::sym(const char* name) const {
-    return dxvk::vk::GetInstanceProcAddr(m_instance, name);
+    return dxvk::vk::GetInstanceProcAddr()(m_instance, name);
   }
   
   
   DeviceLoader::DeviceLoader(bool owned, VkInstance instance, VkDevice device)
   : m_getDeviceProcAddr(reinterpret_cast<PFN_vkGetDeviceProcAddr>(
-      dxvk::vk::GetInstanceProcAddr(instance, "vkGetDeviceProcAddr"))),
+      dxvk::vk::GetInstanceProcAddr()(instance, "vkGetDeviceProcAddr"))),
+    m_device(device), m_owned(owned) { }
+  
+  
+  DeviceLoader::DeviceLoader(bool owned, VkDevice device, PFN_vkGetDeviceProcAddr getDeviceProcAddr)
+  : m_getDeviceProcAddr(getDeviceProcAddr),
     m_device(device), m_owned(owned) { }
   
   
@@ -53,6 +66,8 @@ namespace dxvk::vk {
   
   DeviceFn::DeviceFn(bool owned, VkInstance instance, VkDevice device)
   : DeviceLoader(owned, instance, device) { }
+  DeviceFn::DeviceFn(bool owned, VkDevice device, PFN_vkGetDeviceProcAddr getDeviceProcAddr)
+  : DeviceLoader(owned, device, getDeviceProcAddr) { }
   DeviceFn::~DeviceFn() {
     if (m_owned)
       this->vkDestroyDevice(m_device, nullptr);
@@ -0,0 +1,1565 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "vulkan_null.h"
+
+#include "../util/log/log.h"
+
+#include "../util/util_env.h"
+#include "../util/util_math.h"
+#include "../util/util_string.h"
+
+namespace dxvk::vk {
+
+  /**
+   * \brief Generic null function
+   *
+   * Does nothing and returns a zero-initialized value,
+   * which for functions returning \c VkResult means
+   * \c VK_SUCCESS. Used for all commands that do not
+   * need to return any data.
+   */
+  template<typename Fn>
+  struct NullFn;
+
+  template<typename R, typename... Args>
+  struct NullFn<R (VKAPI_PTR*)(Args...)> {
+    static R VKAPI_CALL call(Args...) {
+      return R();
+    }
+  };
+
+
+  /**
+   * \brief Memory object
+   *
+   * Host memory is only allocated when the
+   * application maps the memory object.
+   */
+  struct NullMemory {
+    VkDeviceSize  size;
+    void*         data;
+  };
+
+
+  /**
+   * \brief Buffer object
+   */
+  struct NullBuffer {
+    VkDeviceSize  size;
+  };
+
+
+  /**
+   * \brief Image object
+   *
+   * Images are laid out as if every texel took 16 bytes,
+   * i.e. the largest possible texel or block size, with
+   * all mip levels of a layer stored consecutively.
+   */
+  struct NullImage {
+    VkExtent3D    extent;
+    uint32_t      mipLevels;
+    uint32_t      arrayLayers;
+    uint32_t      samples;
+    VkDeviceSize  layerSize;
+  };
+
+
+  /**
+   * \brief Swap chain object
+   */
+  struct NullSwapchain {
+    std::vector<VkImage>  images;
+    uint32_t              nextImage;
+  };
+
+
+  constexpr VkDeviceSize NullTexelSize = 16;
+  constexpr VkDeviceSize NullAlignment = 256;
+
+  static std::atomic<uint64_t> g_nullHandleId = { 1ull };
+
+  // Dispatchable handles only need to be unique
+  // and non-null since we never dispatch anything
+  static char g_nullInstance;
+  static char g_nullAdapter;
+  static char g_nullDevice;
+  static char g_nullQueue;
+
+
+  template<typename T>
+  T nullHandle(uint64_t id) {
+    if constexpr (std::is_pointer<T>::value)
+      return reinterpret_cast<T>(uintptr_t(id));
+    else
+      return T(id);
+  }
+
+
+  template<typename T>
+  T nullHandle() {
+    return nullHandle<T>(g_nullHandleId++);
+  }
+
+
+  template<typename T, typename Obj>
+  T nullHandleFromObject(Obj* object) {
+    return nullHandle<T>(uint64_t(reinterpret_cast<uintptr_t>(object)));
+  }
+
+
+  template<typename Obj, typename T>
+  Obj* nullObjectFromHandle(T handle) {
+    if constexpr (std::is_pointer<T>::value)
+      return reinterpret_cast<Obj*>(handle);
+    else
+      return reinterpret_cast<Obj*>(uintptr_t(handle));
+  }
+
+
+  template<typename T>
+  VkResult nullWriteArray(
+          uint32_t*             pCount,
+          T*                    pData,
+    const std::vector<T>&       items) {
+    if (!pData) {
+      *pCount = uint32_t(items.size());
+      return VK_SUCCESS;
+    }
+
+    uint32_t count = std::min(*pCount, uint32_t(items.size()));
+
+    for (uint32_t i = 0; i < count; i++)
+      pData[i] = items[i];
+
+    *pCount = count;
+    return count < items.size() ? VK_INCOMPLETE : VK_SUCCESS;
+  }
+
+
+  static VkPhysicalDeviceLimits getNullDeviceLimits() {
+    VkPhysicalDeviceLimits limits = { };
+    limits.maxImageDimension1D                              = 16384;
+    limits.maxImageDimension2D                              = 16384;
+    limits.maxImageDimension3D                              = 2048;
+    limits.maxImageDimensionCube                            = 16384;
+    limits.maxImageArrayLayers                              = 2048;
+    limits.maxTexelBufferElements                           = 1u << 27;
+    limits.maxUniformBufferRange                            = 65536;
+    limits.maxStorageBufferRange                            = ~0u;
+    limits.maxPushConstantsSize                             = 256;
+    limits.maxMemoryAllocationCount                         = 4096;
+    limits.maxSamplerAllocationCount                        = 4000;
+    limits.bufferImageGranularity                           = 1;
+    limits.sparseAddressSpaceSize                           = 0;
+    limits.maxBoundDescriptorSets                           = 8;
+    limits.maxPerStageDescriptorSamplers                    = 1u << 20;
+    limits.maxPerStageDescriptorUniformBuffers              = 1u << 20;
+    limits.maxPerStageDescriptorStorageBuffers              = 1u << 20;
+    limits.maxPerStageDescriptorSampledImages               = 1u << 20;
+    limits.maxPerStageDescriptorStorageImages               = 1u << 20;
+    limits.maxPerStageDescriptorInputAttachments            = 1u << 20;
+    limits.maxPerStageResources                             = 1u << 20;
+    limits.maxDescriptorSetSamplers                         = 1u << 20;
+    limits.maxDescriptorSetUniformBuffers                   = 1u << 20;
+    limits.maxDescriptorSetUniformBuffersDynamic            = 8;
+    limits.maxDescriptorSetStorageBuffers                   = 1u << 20;
+    limits.maxDescriptorSetStorageBuffersDynamic            = 8;
+    limits.maxDescriptorSetSampledImages                    = 1u << 20;
+    limits.maxDescriptorSetStorageImages                    = 1u << 20;
+    limits.maxDescriptorSetInputAttachments                 = 1u << 20;
+    limits.maxVertexInputAttributes                         = 32;
+    limits.maxVertexInputBindings                           = 32;
+    limits.maxVertexInputAttributeOffset                    = 2047;
+    limits.maxVertexInputBindingStride                      = 2048;
+    limits.maxVertexOutputComponents                        = 128;
+    limits.maxTessellationGenerationLevel                   = 64;
+    limits.maxTessellationPatchSize                         = 32;
+    limits.maxTessellationControlPerVertexInputComponents   = 128;
+    limits.maxTessellationControlPerVertexOutputComponents  = 128;
+    limits.maxTessellationControlPerPatchOutputComponents   = 120;
+    limits.maxTessellationControlTotalOutputComponents      = 4096;
+    limits.maxTessellationEvaluationInputComponents         = 128;
+    limits.maxTessellationEvaluationOutputComponents        = 128;
+    limits.maxGeometryShaderInvocations                     = 32;
+    limits.maxGeometryInputComponents                       = 128;
+    limits.maxGeometryOutputComponents                      = 128;
+    limits.maxGeometryOutputVertices                        = 1024;
+    limits.maxGeometryTotalOutputComponents                 = 1024;
+    limits.maxFragmentInputComponents                       = 128;
+    limits.maxFragmentOutputAttachments                     = 8;
+    limits.maxFragmentDualSrcAttachments                    = 1;
+    limits.maxFragmentCombinedOutputResources               = 1u << 20;
+    limits.maxComputeSharedMemorySize                       = 65536;
+    limits.maxComputeWorkGroupCount[0]                      = 65535;
+    limits.maxComputeWorkGroupCount[1]                      = 65535;
+    limits.maxComputeWorkGroupCount[2]                      = 65535;
+    limits.maxComputeWorkGroupInvocations                   = 1024;
+    limits.maxComputeWorkGroupSize[0]                       = 1024;
+    limits.maxComputeWorkGroupSize[1]                       = 1024;
+    limits.maxComputeWorkGroupSize[2]                       = 1024;
+    limits.subPixelPrecisionBits                            = 8;
+    limits.subTexelPrecisionBits                            = 8;
+    limits.mipmapPrecisionBits                              = 8;
+    limits.maxDrawIndexedIndexValue                         = ~0u;
+    limits.maxDrawIndirectCount                             = ~0u;
+    limits.maxSamplerLodBias                                = 16.0f;
+    limits.maxSamplerAnisotropy                             = 16.0f;
+    limits.maxViewports                                     = 16;
+    limits.maxViewportDimensions[0]                         = 16384;
+    limits.maxViewportDimensions[1]                         = 16384;
+    limits.viewportBoundsRange[0]                           = -32768.0f;
+    limits.viewportBoundsRange[1]                           =  32767.0f;
+    limits.viewportSubPixelBits                             = 8;
+    limits.minMemoryMapAlignment                            = 64;
+    limits.minTexelBufferOffsetAlignment                    = 16;
+    limits.minUniformBufferOffsetAlignment                  = 256;
+    limits.minStorageBufferOffsetAlignment                  = 16;
+    limits.minTexelOffset                                   = -32;
+    limits.maxTexelOffset                                   = 31;
+    limits.minTexelGatherOffset                             = -32;
+    limits.maxTexelGatherOffset                             = 31;
+    limits.minInterpolationOffset                           = -0.5f;
+    limits.maxInterpolationOffset                           = 0.4375f;
+    limits.subPixelInterpolationOffsetBits                  = 4;
+    limits.maxFramebufferWidth                              = 16384;
+    limits.maxFramebufferHeight                             = 16384;
+    limits.maxFramebufferLayers                             = 2048;
+    limits.framebufferColorSampleCounts                     = 0xF;
+    limits.framebufferDepthSampleCounts                     = 0xF;
+    limits.framebufferStencilSampleCounts                   = 0xF;
+    limits.framebufferNoAttachmentsSampleCounts             = 0xF;
+    limits.maxColorAttachments                              = 8;
+    limits.sampledImageColorSampleCounts                    = 0xF;
+    limits.sampledImageIntegerSampleCounts                  = 0xF;
+    limits.sampledImageDepthSampleCounts                    = 0xF;
+    limits.sampledImageStencilSampleCounts                  = 0xF;
+    limits.storageImageSampleCounts                         = 0xF;
+    limits.maxSampleMaskWords                               = 1;
+    limits.timestampComputeAndGraphics                      = VK_TRUE;
+    limits.timestampPeriod                                  = 1.0f;
+    limits.maxClipDistances                                 = 8;
+    limits.maxCullDistances                                 = 8;
+    limits.maxCombinedClipAndCullDistances                  = 8;
+    limits.discreteQueuePriorities                          = 2;
+    limits.pointSizeRange[0]                                = 1.0f;
+    limits.pointSizeRange[1]                                = 64.0f;
+    limits.lineWidthRange[0]                                = 1.0f;
+    limits.lineWidthRange[1]                                = 1.0f;
+    limits.pointSizeGranularity                             = 1.0f;
+    limits.lineWidthGranularity                             = 1.0f;
+    limits.strictLines                                      = VK_FALSE;
+    limits.standardSampleLocations                          = VK_TRUE;
+    limits.optimalBufferCopyOffsetAlignment                 = 1;
+    limits.optimalBufferCopyRowPitchAlignment               = 1;
+    limits.nonCoherentAtomSize                              = 64;
+    return limits;
+  }
+
+
+  /**
+   * \brief Configurable device limit
+   */
+  struct NullDeviceLimit {
+    const char* name;
+    size_t      offset;
+    size_t      size;
+  };
+
+  #define VULKAN_NULL_LIMIT(name) { #name, \
+    offsetof(VkPhysicalDeviceLimits, name), \
+    sizeof(VkPhysicalDeviceLimits::name) }
+
+  static const NullDeviceLimit g_nullDeviceLimits[] = {
+    VULKAN_NULL_LIMIT(maxImageDimension1D),
+    VULKAN_NULL_LIMIT(maxImageDimension2D),
+    VULKAN_NULL_LIMIT(maxImageDimension3D),
+    VULKAN_NULL_LIMIT(maxImageDimensionCube),
+    VULKAN_NULL_LIMIT(maxImageArrayLayers),
+    VULKAN_NULL_LIMIT(maxTexelBufferElements),
+    VULKAN_NULL_LIMIT(maxUniformBufferRange),
+    VULKAN_NULL_LIMIT(maxStorageBufferRange),
+    VULKAN_NULL_LIMIT(maxPushConstantsSize),
+    VULKAN_NULL_LIMIT(maxMemoryAllocationCount),
+    VULKAN_NULL_LIMIT(maxSamplerAllocationCount),
+    VULKAN_NULL_LIMIT(bufferImageGranularity),
+    VULKAN_NULL_LIMIT(maxBoundDescriptorSets),
+    VULKAN_NULL_LIMIT(maxPerStageDescriptorSamplers),
+    VULKAN_NULL_LIMIT(maxPerStageDescriptorUniformBuffers),
+    VULKAN_NULL_LIMIT(maxPerStageDescriptorStorageBuffers),
+    VULKAN_NULL_LIMIT(maxPerStageDescriptorSampledImages),
+    VULKAN_NULL_LIMIT(maxPerStageDescriptorStorageImages),
+    VULKAN_NULL_LIMIT(maxPerStageResources),
+    VULKAN_NULL_LIMIT(maxDescriptorSetSamplers),
+    VULKAN_NULL_LIMIT(maxDescriptorSetUniformBuffers),
+    VULKAN_NULL_LIMIT(maxDescriptorSetUniformBuffersDynamic),
+    VULKAN_NULL_LIMIT(maxDescriptorSetStorageBuffers),
+    VULKAN_NULL_LIMIT(maxDescriptorSetStorageBuffersDynamic),
+    VULKAN_NULL_LIMIT(maxDescriptorSetSampledImages),
+    VULKAN_NULL_LIMIT(maxDescriptorSetStorageImages),
+    VULKAN_NULL_LIMIT(maxVertexInputAttributes),
+    VULKAN_NULL_LIMIT(maxVertexInputBindings),
+    VULKAN_NULL_LIMIT(maxVertexInputAttributeOffset),
+    VULKAN_NULL_LIMIT(maxVertexInputBindingStride),
+    VULKAN_NULL_LIMIT(maxVertexOutputComponents),
+    VULKAN_NULL_LIMIT(maxGeometryOutputVertices),
+    VULKAN_NULL_LIMIT(maxGeometryTotalOutputComponents),
+    VULKAN_NULL_LIMIT(maxFragmentInputComponents),
+    VULKAN_NULL_LIMIT(maxComputeSharedMemorySize),
+    VULKAN_NULL_LIMIT(maxComputeWorkGroupInvocations),
+    VULKAN_NULL_LIMIT(maxDrawIndexedIndexValue),
+    VULKAN_NULL_LIMIT(maxDrawIndirectCount),
+    VULKAN_NULL_LIMIT(maxViewports),
+    VULKAN_NULL_LIMIT(minMemoryMapAlignment),
+    VULKAN_NULL_LIMIT(minTexelBufferOffsetAlignment),
+    VULKAN_NULL_LIMIT(minUniformBufferOffsetAlignment),
+    VULKAN_NULL_LIMIT(minStorageBufferOffsetAlignment),
+    VULKAN_NULL_LIMIT(maxFramebufferWidth),
+    VULKAN_NULL_LIMIT(maxFramebufferHeight),
+    VULKAN_NULL_LIMIT(maxFramebufferLayers),
+    VULKAN_NULL_LIMIT(framebufferColorSampleCounts),
+    VULKAN_NULL_LIMIT(framebufferDepthSampleCounts),
+    VULKAN_NULL_LIMIT(maxColorAttachments),
+    VULKAN_NULL_LIMIT(maxClipDistances),
+    VULKAN_NULL_LIMIT(maxCullDistances),
+    VULKAN_NULL_LIMIT(optimalBufferCopyOffsetAlignment),
+    VULKAN_NULL_LIMIT(optimalBufferCopyRowPitchAlignment),
+    VULKAN_NULL_LIMIT(nonCoherentAtomSize),
+  };
+
+  #undef VULKAN_NULL_LIMIT
+
+
+  static bool setNullDeviceLimit(
+          VkPhysicalDeviceLimits& limits,
+    const std::string&            name,
+          uint64_t                value) {
+    for (const auto& limit : g_nullDeviceLimits) {
+      if (name != limit.name)
+        continue;
+
+      auto dst = reinterpret_cast<char*>(&limits) + limit.offset;
+
+      if (limit.size == sizeof(uint32_t)) {
+        uint32_t v = uint32_t(value);
+        std::memcpy(dst, &v, sizeof(v));
+      } else {
+        std::memcpy(dst, &value, sizeof(value));
+      }
+
+      return true;
+    }
+
+    return false;
+  }
+
+
+  NullDeviceDesc parseNullDeviceDesc(const std::string& args) {
+    NullDeviceDesc desc = { };
+    desc.vramSize   = VkDeviceSize(4096) << 20;
+    desc.sysmemSize = VkDeviceSize(8192) << 20;
+
+    VkPhysicalDeviceProperties& props = desc.properties;
+    props.apiVersion    = VK_MAKE_VERSION(1, 2, VK_HEADER_VERSION);
+    props.driverVersion = VK_MAKE_VERSION(1, 0, 0);
+    props.vendorID      = 0;
+    props.deviceID      = 0;
+    props.deviceType    = VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+    props.limits        = getNullDeviceLimits();
+
+    std::strncpy(props.deviceName, "DXVK null device",
+      VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+      props.pipelineCacheUUID[i] = uint8_t(i);
+
+    std::stringstream stream(args);
+    std::string option;
+
+    while (std::getline(stream, option, ',')) {
+      size_t eq = option.find('=');
+
+      if (eq == std::string::npos)
+        continue;
+
+      std::string key   = option.substr(0, eq);
+      std::string value = option.substr(eq + 1);
+
+      if (key == "deviceName") {
+        std::strncpy(props.deviceName, value.c_str(),
+          VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+        continue;
+      }
+
+      char* end = nullptr;
+      uint64_t number = std::strtoull(value.c_str(), &end, 0);
+
+      if (value.empty() || *end) {
+        Logger::warn(str::format("Null device: Invalid value for ", key, ": ", value));
+        continue;
+      }
+
+      if (key == "vendorID")
+        props.vendorID = uint32_t(number);
+      else if (key == "deviceID")
+        props.deviceID = uint32_t(number);
+      else if (key == "vram")
+        desc.vramSize = number << 20;
+      else if (key == "sysmem")
+        desc.sysmemSize = number << 20;
+      else if (!setNullDeviceLimit(props.limits, key, number))
+        Logger::warn(str::format("Null device: Unknown option: ", key));
+    }
+
+    return desc;
+  }
+
+
+  static const NullDeviceDesc& getNullDeviceDesc() {
+    static const NullDeviceDesc s_desc = parseNullDeviceDesc(
+      env::getEnvVar("DXVK_NULL_DEVICE"));
+    return s_desc;
+  }
+
+
+  bool isNullDeviceEnabled() {
+    static const bool s_enabled = !env::getEnvVar("DXVK_NULL_DEVICE").empty();
+    return s_enabled;
+  }
+
+
+  static std::vector<VkExtensionProperties> getNullInstanceExtensions() {
+    return {
+      { VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME, VK_KHR_GET_SURFACE_CAPABILITIES_2_SPEC_VERSION },
+      { VK_KHR_SURFACE_EXTENSION_NAME,                    VK_KHR_SURFACE_SPEC_VERSION                    },
+      { VK_KHR_WIN32_SURFACE_EXTENSION_NAME,              VK_KHR_WIN32_SURFACE_SPEC_VERSION              },
+    };
+  }
+
+
+  static std::vector<VkExtensionProperties> getNullDeviceExtensions() {
+    return {
+      { VK_EXT_DEPTH_CLIP_ENABLE_EXTENSION_NAME,            VK_EXT_DEPTH_CLIP_ENABLE_SPEC_VERSION            },
+      { VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME,             VK_EXT_HOST_QUERY_RESET_SPEC_VERSION             },
+      { VK_EXT_SHADER_STENCIL_EXPORT_EXTENSION_NAME,        VK_EXT_SHADER_STENCIL_EXPORT_SPEC_VERSION        },
+      { VK_EXT_SHADER_VIEWPORT_INDEX_LAYER_EXTENSION_NAME,  VK_EXT_SHADER_VIEWPORT_INDEX_LAYER_SPEC_VERSION  },
+      { VK_EXT_TRANSFORM_FEEDBACK_EXTENSION_NAME,           VK_EXT_TRANSFORM_FEEDBACK_SPEC_VERSION           },
+      { VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_EXTENSION_NAME,     VK_EXT_VERTEX_ATTRIBUTE_DIVISOR_SPEC_VERSION     },
+      { VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME,          VK_KHR_CREATE_RENDERPASS_2_SPEC_VERSION          },
+      { VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME,        VK_KHR_DEPTH_STENCIL_RESOLVE_SPEC_VERSION        },
+      { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME,          VK_KHR_DRAW_INDIRECT_COUNT_SPEC_VERSION          },
+      { VK_KHR_DRIVER_PROPERTIES_EXTENSION_NAME,            VK_KHR_DRIVER_PROPERTIES_SPEC_VERSION            },
+      { VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME,            VK_KHR_IMAGE_FORMAT_LIST_SPEC_VERSION            },
+      { VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE_EXTENSION_NAME, VK_KHR_SAMPLER_MIRROR_CLAMP_TO_EDGE_SPEC_VERSION },
+      { VK_KHR_SWAPCHAIN_EXTENSION_NAME,                    VK_KHR_SWAPCHAIN_SPEC_VERSION                    },
+    };
+  }
+
+
+  static VkPhysicalDeviceMemoryProperties getNullMemoryProperties() {
+    const NullDeviceDesc& desc = getNullDeviceDesc();
+
+    VkPhysicalDeviceMemoryProperties props = { };
+    props.memoryHeapCount = 2;
+    props.memoryHeaps[0] = { desc.vramSize,   VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+    props.memoryHeaps[1] = { desc.sysmemSize, 0 };
+
+    props.memoryTypeCount = 3;
+    props.memoryTypes[0] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+    props.memoryTypes[1] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                           | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, 1 };
+    props.memoryTypes[2] = { VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+                           | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                           | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1 };
+    return props;
+  }
+
+
+  static VkFormatProperties getNullFormatProperties(VkFormat format) {
+    VkFormatProperties props = { };
+
+    if (format != VK_FORMAT_UNDEFINED) {
+      VkFormatFeatureFlags imageFeatures
+        = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
+        | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT
+        | VK_FORMAT_FEATURE_STORAGE_IMAGE_ATOMIC_BIT
+        | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT
+        | VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT
+        | VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+        | VK_FORMAT_FEATURE_BLIT_SRC_BIT
+        | VK_FORMAT_FEATURE_BLIT_DST_BIT
+        | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT
+        | VK_FORMAT_FEATURE_TRANSFER_SRC_BIT
+        | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+
+      props.linearTilingFeatures  = imageFeatures;
+      props.optimalTilingFeatures = imageFeatures;
+      props.bufferFeatures
+        = VK_FORMAT_FEATURE_UNIFORM_TEXEL_BUFFER_BIT
+        | VK_FORMAT_FEATURE_STORAGE_TEXEL_BUFFER_BIT
+        | VK_FORMAT_FEATURE_STORAGE_TEXEL_BUFFER_ATOMIC_BIT
+        | VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT;
+    }
+
+    return props;
+  }
+
+
+  static VkImageFormatProperties getNullImageFormatProperties() {
+    const NullDeviceDesc& desc = getNullDeviceDesc();
+
+    VkImageFormatProperties props = { };
+    props.maxExtent       = VkExtent3D { 16384, 16384, 2048 };
+    props.maxMipLevels    = 15;
+    props.maxArrayLayers  = desc.properties.limits.maxImageArrayLayers;
+    props.sampleCounts    = desc.properties.limits.framebufferColorSampleCounts;
+    props.maxResourceSize = desc.vramSize;
+    return props;
+  }
+
+
+  static VkSurfaceCapabilitiesKHR getNullSurfaceCapabilities() {
+    VkSurfaceCapabilitiesKHR caps = { };
+    caps.minImageCount            = 1;
+    caps.maxImageCount            = 16;
+    caps.currentExtent            = VkExtent2D { ~0u, ~0u };
+    caps.minImageExtent           = VkExtent2D { 1, 1 };
+    caps.maxImageExtent           = VkExtent2D { 16384, 16384 };
+    caps.maxImageArrayLayers      = 1;
+    caps.supportedTransforms      = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    caps.currentTransform         = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    caps.supportedCompositeAlpha  = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    caps.supportedUsageFlags      = VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+                                  | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                                  | VK_IMAGE_USAGE_SAMPLED_BIT
+                                  | VK_IMAGE_USAGE_STORAGE_BIT
+                                  | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    return caps;
+  }
+
+
+  static std::vector<VkSurfaceFormatKHR> getNullSurfaceFormats() {
+    return {
+      { VK_FORMAT_B8G8R8A8_UNORM,           VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+      { VK_FORMAT_B8G8R8A8_SRGB,            VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+      { VK_FORMAT_R8G8B8A8_UNORM,           VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+      { VK_FORMAT_R8G8B8A8_SRGB,            VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+      { VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+      { VK_FORMAT_R16G16B16A16_SFLOAT,      VK_COLOR_SPACE_SRGB_NONLINEAR_KHR },
+    };
+  }
+
+
+  static NullImage* createNullImage(
+          VkExtent3D              extent,
+          uint32_t                mipLevels,
+          uint32_t                arrayLayers,
+          uint32_t                samples) {
+    auto image = new NullImage();
+    image->extent       = extent;
+    image->mipLevels    = mipLevels;
+    image->arrayLayers  = arrayLayers;
+    image->samples      = samples;
+    image->layerSize    = 0;
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+      image->layerSize += NullTexelSize
+        * std::max(extent.width  >> i, 1u)
+        * std::max(extent.height >> i, 1u)
+        * std::max(extent.depth  >> i, 1u);
+    }
+
+    image->layerSize = align(image->layerSize, NullAlignment);
+    return image;
+  }
+
+
+  static VkMemoryRequirements getNullMemoryRequirements(VkDeviceSize size) {
+    VkMemoryRequirements req;
+    req.size           = align(std::max<VkDeviceSize>(size, 1), NullAlignment);
+    req.alignment      = NullAlignment;
+    req.memoryTypeBits = (1u << getNullMemoryProperties().memoryTypeCount) - 1;
+    return req;
+  }
+
+
+  namespace nulldrv {
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateInstance(
+      const VkInstanceCreateInfo*               pCreateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkInstance*                         pInstance) {
+      *pInstance = reinterpret_cast<VkInstance>(&g_nullInstance);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceLayerProperties(
+            uint32_t*                           pPropertyCount,
+            VkLayerProperties*                  pProperties) {
+      *pPropertyCount = 0;
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateInstanceExtensionProperties(
+      const char*                               pLayerName,
+            uint32_t*                           pPropertyCount,
+            VkExtensionProperties*              pProperties) {
+      return nullWriteArray(pPropertyCount, pProperties, getNullInstanceExtensions());
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkEnumeratePhysicalDevices(
+            VkInstance                          instance,
+            uint32_t*                           pPhysicalDeviceCount,
+            VkPhysicalDevice*                   pPhysicalDevices) {
+      return nullWriteArray(pPhysicalDeviceCount, pPhysicalDevices,
+        { reinterpret_cast<VkPhysicalDevice>(&g_nullAdapter) });
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(
+            VkPhysicalDevice                    physicalDevice,
+      const char*                               pLayerName,
+            uint32_t*                           pPropertyCount,
+            VkExtensionProperties*              pProperties) {
+      return nullWriteArray(pPropertyCount, pProperties, getNullDeviceExtensions());
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures(
+            VkPhysicalDevice                    physicalDevice,
+            VkPhysicalDeviceFeatures*           pFeatures) {
+      // The feature struct only consists of booleans
+      auto features = reinterpret_cast<VkBool32*>(pFeatures);
+
+      for (size_t i = 0; i < sizeof(*pFeatures) / sizeof(VkBool32); i++)
+        features[i] = VK_TRUE;
+
+      pFeatures->sparseBinding = VK_FALSE;
+      pFeatures->sparseResidencyBuffer = VK_FALSE;
+      pFeatures->sparseResidencyImage2D = VK_FALSE;
+      pFeatures->sparseResidencyImage3D = VK_FALSE;
+      pFeatures->sparseResidency2Samples = VK_FALSE;
+      pFeatures->sparseResidency4Samples = VK_FALSE;
+      pFeatures->sparseResidency8Samples = VK_FALSE;
+      pFeatures->sparseResidency16Samples = VK_FALSE;
+      pFeatures->sparseResidencyAliased = VK_FALSE;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFeatures2(
+            VkPhysicalDevice                    physicalDevice,
+            VkPhysicalDeviceFeatures2*          pFeatures) {
+      nulldrv::vkGetPhysicalDeviceFeatures(physicalDevice, &pFeatures->features);
+
+      for (auto s = reinterpret_cast<VkBaseOutStructure*>(pFeatures->pNext); s; s = s->pNext) {
+        switch (s->sType) {
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES: {
+            auto f = reinterpret_cast<VkPhysicalDeviceShaderDrawParametersFeatures*>(s);
+            f->shaderDrawParameters = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DEPTH_CLIP_ENABLE_FEATURES_EXT: {
+            auto f = reinterpret_cast<VkPhysicalDeviceDepthClipEnableFeaturesEXT*>(s);
+            f->depthClipEnable = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES_EXT: {
+            auto f = reinterpret_cast<VkPhysicalDeviceHostQueryResetFeaturesEXT*>(s);
+            f->hostQueryReset = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TRANSFORM_FEEDBACK_FEATURES_EXT: {
+            auto f = reinterpret_cast<VkPhysicalDeviceTransformFeedbackFeaturesEXT*>(s);
+            f->transformFeedback = VK_TRUE;
+            f->geometryStreams   = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_ATTRIBUTE_DIVISOR_FEATURES_EXT: {
+            auto f = reinterpret_cast<VkPhysicalDeviceVertexAttributeDivisorFeaturesEXT*>(s);
+            f->vertexAttributeInstanceRateDivisor     = VK_TRUE;
+            f->vertexAttributeInstanceRateZeroDivisor = VK_TRUE;
+          } break;
+
+          default:
+            break;
+        }
+      }
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(
+            VkPhysicalDevice                    physicalDevice,
+            VkPhysicalDeviceProperties*         pProperties) {
+      *pProperties = getNullDeviceDesc().properties;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties2(
+            VkPhysicalDevice                    physicalDevice,
+            VkPhysicalDeviceProperties2*        pProperties) {
+      nulldrv::vkGetPhysicalDeviceProperties(physicalDevice, &pProperties->properties);
+
+      for (auto s = reinterpret_cast<VkBaseOutStructure*>(pProperties->pNext); s; s = s->pNext) {
+        switch (s->sType) {
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES: {
+            auto p = reinterpret_cast<VkPhysicalDeviceIDProperties*>(s);
+
+            for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+              p->deviceUUID[i] = uint8_t(i);
+              p->driverUUID[i] = uint8_t(i);
+            }
+
+            p->deviceLUIDValid = VK_FALSE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES: {
+            auto p = reinterpret_cast<VkPhysicalDeviceSubgroupProperties*>(s);
+            p->subgroupSize               = 32;
+            p->supportedStages            = VK_SHADER_STAGE_ALL_GRAPHICS
+                                          | VK_SHADER_STAGE_COMPUTE_BIT;
+            p->supportedOperations        = VK_SUBGROUP_FEATURE_BASIC_BIT
+                                          | VK_SUBGROUP_FEATURE_VOTE_BIT
+                                          | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT
+                                          | VK_SUBGROUP_FEATURE_BALLOT_BIT
+                                          | VK_SUBGROUP_FEATURE_SHUFFLE_BIT
+                                          | VK_SUBGROUP_FEATURE_SHUFFLE_RELATIVE_BIT
+                                          | VK_SUBGROUP_FEATURE_CLUSTERED_BIT
+                                          | VK_SUBGROUP_FEATURE_QUAD_BIT;
+            p->quadOperationsInAllStages  = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TRANSFORM_FEEDBACK_PROPERTIES_EXT: {
+            auto p = reinterpret_cast<VkPhysicalDeviceTransformFeedbackPropertiesEXT*>(s);
+            p->maxTransformFeedbackStreams                = 4;
+            p->maxTransformFeedbackBuffers                = 4;
+            p->maxTransformFeedbackBufferSize             = ~0u;
+            p->maxTransformFeedbackStreamDataSize         = 512;
+            p->maxTransformFeedbackBufferDataSize         = 512;
+            p->maxTransformFeedbackBufferDataStride       = 2048;
+            p->transformFeedbackQueries                   = VK_TRUE;
+            p->transformFeedbackStreamsLinesTriangles     = VK_TRUE;
+            p->transformFeedbackRasterizationStreamSelect = VK_TRUE;
+            p->transformFeedbackDraw                      = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VERTEX_ATTRIBUTE_DIVISOR_PROPERTIES_EXT: {
+            auto p = reinterpret_cast<VkPhysicalDeviceVertexAttributeDivisorPropertiesEXT*>(s);
+            p->maxVertexAttribDivisor = ~0u;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DEPTH_STENCIL_RESOLVE_PROPERTIES_KHR: {
+            auto p = reinterpret_cast<VkPhysicalDeviceDepthStencilResolvePropertiesKHR*>(s);
+            p->supportedDepthResolveModes   = VK_RESOLVE_MODE_SAMPLE_ZERO_BIT_KHR
+                                            | VK_RESOLVE_MODE_MIN_BIT_KHR
+                                            | VK_RESOLVE_MODE_MAX_BIT_KHR;
+            p->supportedStencilResolveModes = VK_RESOLVE_MODE_SAMPLE_ZERO_BIT_KHR;
+            p->independentResolveNone       = VK_TRUE;
+            p->independentResolve           = VK_TRUE;
+          } break;
+
+          case VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DRIVER_PROPERTIES_KHR: {
+            auto p = reinterpret_cast<VkPhysicalDeviceDriverPropertiesKHR*>(s);
+            p->driverID = VkDriverIdKHR(0);
+            std::strncpy(p->driverName, "DXVK null driver", VK_MAX_DRIVER_NAME_SIZE_KHR - 1);
+            std::strncpy(p->driverInfo, "", VK_MAX_DRIVER_INFO_SIZE_KHR - 1);
+          } break;
+
+          default:
+            break;
+        }
+      }
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(
+            VkPhysicalDevice                    physicalDevice,
+            VkFormat                            format,
+            VkFormatProperties*                 pFormatProperties) {
+      *pFormatProperties = getNullFormatProperties(format);
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceFormatProperties2(
+            VkPhysicalDevice                    physicalDevice,
+            VkFormat                            format,
+            VkFormatProperties2*                pFormatProperties) {
+      pFormatProperties->formatProperties = getNullFormatProperties(format);
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceImageFormatProperties(
+            VkPhysicalDevice                    physicalDevice,
+            VkFormat                            format,
+            VkImageType                         type,
+            VkImageTiling                       tiling,
+            VkImageUsageFlags                   usage,
+            VkImageCreateFlags                  flags,
+            VkImageFormatProperties*            pImageFormatProperties) {
+      *pImageFormatProperties = getNullImageFormatProperties();
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceImageFormatProperties2(
+            VkPhysicalDevice                    physicalDevice,
+      const VkPhysicalDeviceImageFormatInfo2*   pImageFormatInfo,
+            VkImageFormatProperties2*           pImageFormatProperties) {
+      pImageFormatProperties->imageFormatProperties = getNullImageFormatProperties();
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(
+            VkPhysicalDevice                    physicalDevice,
+            VkPhysicalDeviceMemoryProperties*   pMemoryProperties) {
+      *pMemoryProperties = getNullMemoryProperties();
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties2(
+            VkPhysicalDevice                    physicalDevice,
+            VkPhysicalDeviceMemoryProperties2*  pMemoryProperties) {
+      pMemoryProperties->memoryProperties = getNullMemoryProperties();
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(
+            VkPhysicalDevice                    physicalDevice,
+            uint32_t*                           pQueueFamilyPropertyCount,
+            VkQueueFamilyProperties*            pQueueFamilyProperties) {
+      VkQueueFamilyProperties props = { };
+      props.queueFlags                  = VK_QUEUE_GRAPHICS_BIT
+                                        | VK_QUEUE_COMPUTE_BIT
+                                        | VK_QUEUE_TRANSFER_BIT;
+      props.queueCount                  = 1;
+      props.timestampValidBits          = 64;
+      props.minImageTransferGranularity = VkExtent3D { 1, 1, 1 };
+
+      nullWriteArray(pQueueFamilyPropertyCount, pQueueFamilyProperties, { props });
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties2(
+            VkPhysicalDevice                    physicalDevice,
+            uint32_t*                           pQueueFamilyPropertyCount,
+            VkQueueFamilyProperties2*           pQueueFamilyProperties) {
+      VkQueueFamilyProperties props;
+      uint32_t count = 1;
+
+      nulldrv::vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, &props);
+
+      if (pQueueFamilyProperties && *pQueueFamilyPropertyCount)
+        pQueueFamilyProperties->queueFamilyProperties = props;
+
+      *pQueueFamilyPropertyCount = pQueueFamilyProperties
+        ? std::min(*pQueueFamilyPropertyCount, 1u) : 1u;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceSparseImageFormatProperties(
+            VkPhysicalDevice                    physicalDevice,
+            VkFormat                            format,
+            VkImageType                         type,
+            VkSampleCountFlagBits               samples,
+            VkImageUsageFlags                   usage,
+            VkImageTiling                       tiling,
+            uint32_t*                           pPropertyCount,
+            VkSparseImageFormatProperties*      pProperties) {
+      *pPropertyCount = 0;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceSparseImageFormatProperties2(
+            VkPhysicalDevice                    physicalDevice,
+      const VkPhysicalDeviceSparseImageFormatInfo2* pFormatInfo,
+            uint32_t*                           pPropertyCount,
+            VkSparseImageFormatProperties2*     pProperties) {
+      *pPropertyCount = 0;
+    }
+
+
+    static VKAPI_ATTR VkBool32 VKAPI_CALL vkGetPhysicalDeviceWin32PresentationSupportKHR(
+            VkPhysicalDevice                    physicalDevice,
+            uint32_t                            queueFamilyIndex) {
+      return VK_TRUE;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateWin32SurfaceKHR(
+            VkInstance                          instance,
+      const VkWin32SurfaceCreateInfoKHR*        pCreateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkSurfaceKHR*                       pSurface) {
+      *pSurface = nullHandle<VkSurfaceKHR>();
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceSupportKHR(
+            VkPhysicalDevice                    physicalDevice,
+            uint32_t                            queueFamilyIndex,
+            VkSurfaceKHR                        surface,
+            VkBool32*                           pSupported) {
+      *pSupported = VK_TRUE;
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
+            VkPhysicalDevice                    physicalDevice,
+            VkSurfaceKHR                        surface,
+            VkSurfaceCapabilitiesKHR*           pSurfaceCapabilities) {
+      *pSurfaceCapabilities = getNullSurfaceCapabilities();
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceCapabilities2KHR(
+            VkPhysicalDevice                    physicalDevice,
+      const VkPhysicalDeviceSurfaceInfo2KHR*    pSurfaceInfo,
+            VkSurfaceCapabilities2KHR*          pSurfaceCapabilities) {
+      pSurfaceCapabilities->surfaceCapabilities = getNullSurfaceCapabilities();
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormatsKHR(
+            VkPhysicalDevice                    physicalDevice,
+            VkSurfaceKHR                        surface,
+            uint32_t*                           pSurfaceFormatCount,
+            VkSurfaceFormatKHR*                 pSurfaceFormats) {
+      return nullWriteArray(pSurfaceFormatCount, pSurfaceFormats, getNullSurfaceFormats());
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfaceFormats2KHR(
+            VkPhysicalDevice                    physicalDevice,
+      const VkPhysicalDeviceSurfaceInfo2KHR*    pSurfaceInfo,
+            uint32_t*                           pSurfaceFormatCount,
+            VkSurfaceFormat2KHR*                pSurfaceFormats) {
+      auto formats = getNullSurfaceFormats();
+
+      if (!pSurfaceFormats) {
+        *pSurfaceFormatCount = uint32_t(formats.size());
+        return VK_SUCCESS;
+      }
+
+      uint32_t count = std::min(*pSurfaceFormatCount, uint32_t(formats.size()));
+
+      for (uint32_t i = 0; i < count; i++)
+        pSurfaceFormats[i].surfaceFormat = formats[i];
+
+      *pSurfaceFormatCount = count;
+      return count < formats.size() ? VK_INCOMPLETE : VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPhysicalDeviceSurfacePresentModesKHR(
+            VkPhysicalDevice                    physicalDevice,
+            VkSurfaceKHR                        surface,
+            uint32_t*                           pPresentModeCount,
+            VkPresentModeKHR*                   pPresentModes) {
+      return nullWriteArray(pPresentModeCount, pPresentModes, {
+        VK_PRESENT_MODE_IMMEDIATE_KHR,
+        VK_PRESENT_MODE_MAILBOX_KHR,
+        VK_PRESENT_MODE_FIFO_KHR });
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateDevice(
+            VkPhysicalDevice                    physicalDevice,
+      const VkDeviceCreateInfo*                 pCreateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkDevice*                           pDevice) {
+      *pDevice = reinterpret_cast<VkDevice>(&g_nullDevice);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetDeviceQueue(
+            VkDevice                            device,
+            uint32_t                            queueFamilyIndex,
+            uint32_t                            queueIndex,
+            VkQueue*                            pQueue) {
+      *pQueue = reinterpret_cast<VkQueue>(&g_nullQueue);
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(
+            VkDevice                            device,
+      const VkMemoryAllocateInfo*               pAllocateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkDeviceMemory*                     pMemory) {
+      auto memory = new NullMemory();
+      memory->size = pAllocateInfo->allocationSize;
+      memory->data = nullptr;
+
+      *pMemory = nullHandleFromObject<VkDeviceMemory>(memory);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkFreeMemory(
+            VkDevice                            device,
+            VkDeviceMemory                      memory,
+      const VkAllocationCallbacks*              pAllocator) {
+      auto object = nullObjectFromHandle<NullMemory>(memory);
+
+      if (object) {
+        std::free(object->data);
+        delete object;
+      }
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(
+            VkDevice                            device,
+            VkDeviceMemory                      memory,
+            VkDeviceSize                        offset,
+            VkDeviceSize                        size,
+            VkMemoryMapFlags                    flags,
+            void**                              ppData) {
+      auto object = nullObjectFromHandle<NullMemory>(memory);
+
+      if (!object->data)
+        object->data = std::calloc(size_t(object->size), 1);
+
+      if (!object->data)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+      *ppData = reinterpret_cast<char*>(object->data) + offset;
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateBuffer(
+            VkDevice                            device,
+      const VkBufferCreateInfo*                 pCreateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkBuffer*                           pBuffer) {
+      auto buffer = new NullBuffer();
+      buffer->size = pCreateInfo->size;
+
+      *pBuffer = nullHandleFromObject<VkBuffer>(buffer);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkDestroyBuffer(
+            VkDevice                            device,
+            VkBuffer                            buffer,
+      const VkAllocationCallbacks*              pAllocator) {
+      delete nullObjectFromHandle<NullBuffer>(buffer);
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements(
+            VkDevice                            device,
+            VkBuffer                            buffer,
+            VkMemoryRequirements*               pMemoryRequirements) {
+      auto object = nullObjectFromHandle<NullBuffer>(buffer);
+      *pMemoryRequirements = getNullMemoryRequirements(object->size);
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetBufferMemoryRequirements2(
+            VkDevice                            device,
+      const VkBufferMemoryRequirementsInfo2*    pInfo,
+            VkMemoryRequirements2*              pMemoryRequirements) {
+      nulldrv::vkGetBufferMemoryRequirements(device, pInfo->buffer,
+        &pMemoryRequirements->memoryRequirements);
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateImage(
+            VkDevice                            device,
+      const VkImageCreateInfo*                  pCreateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkImage*                            pImage) {
+      auto image = createNullImage(
+        pCreateInfo->extent,
+        pCreateInfo->mipLevels,
+        pCreateInfo->arrayLayers,
+        uint32_t(pCreateInfo->samples));
+
+      *pImage = nullHandleFromObject<VkImage>(image);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkDestroyImage(
+            VkDevice                            device,
+            VkImage                             image,
+      const VkAllocationCallbacks*              pAllocator) {
+      delete nullObjectFromHandle<NullImage>(image);
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements(
+            VkDevice                            device,
+            VkImage                             image,
+            VkMemoryRequirements*               pMemoryRequirements) {
+      auto object = nullObjectFromHandle<NullImage>(image);
+
+      *pMemoryRequirements = getNullMemoryRequirements(
+        object->layerSize * object->arrayLayers * object->samples);
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetImageMemoryRequirements2(
+            VkDevice                            device,
+      const VkImageMemoryRequirementsInfo2*     pInfo,
+            VkMemoryRequirements2*              pMemoryRequirements) {
+      nulldrv::vkGetImageMemoryRequirements(device, pInfo->image,
+        &pMemoryRequirements->memoryRequirements);
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetImageSparseMemoryRequirements(
+            VkDevice                            device,
+            VkImage                             image,
+            uint32_t*                           pSparseMemoryRequirementCount,
+            VkSparseImageMemoryRequirements*    pSparseMemoryRequirements) {
+      *pSparseMemoryRequirementCount = 0;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetImageSparseMemoryRequirements2(
+            VkDevice                            device,
+      const VkImageSparseMemoryRequirementsInfo2* pInfo,
+            uint32_t*                           pSparseMemoryRequirementCount,
+            VkSparseImageMemoryRequirements2*   pSparseMemoryRequirements) {
+      *pSparseMemoryRequirementCount = 0;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetImageSubresourceLayout(
+            VkDevice                            device,
+            VkImage                             image,
+      const VkImageSubresource*                 pSubresource,
+            VkSubresourceLayout*                pLayout) {
+      auto object = nullObjectFromHandle<NullImage>(image);
+
+      VkDeviceSize offset = object->layerSize * pSubresource->arrayLayer;
+
+      for (uint32_t i = 0; i < pSubresource->mipLevel; i++) {
+        offset += NullTexelSize
+          * std::max(object->extent.width  >> i, 1u)
+          * std::max(object->extent.height >> i, 1u)
+          * std::max(object->extent.depth  >> i, 1u);
+      }
+
+      uint32_t mip = pSubresource->mipLevel;
+
+      pLayout->offset     = offset;
+      pLayout->rowPitch   = NullTexelSize * std::max(object->extent.width  >> mip, 1u);
+      pLayout->depthPitch = pLayout->rowPitch * std::max(object->extent.height >> mip, 1u);
+      pLayout->size       = pLayout->depthPitch * std::max(object->extent.depth >> mip, 1u);
+      pLayout->arrayPitch = object->layerSize;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetEventStatus(
+            VkDevice                            device,
+            VkEvent                             event) {
+      return VK_EVENT_SET;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetQueryPoolResults(
+            VkDevice                            device,
+            VkQueryPool                         queryPool,
+            uint32_t                            firstQuery,
+            uint32_t                            queryCount,
+            size_t                              dataSize,
+            void*                               pData,
+            VkDeviceSize                        stride,
+            VkQueryResultFlags                  flags) {
+      std::memset(pData, 0, dataSize);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetPipelineCacheData(
+            VkDevice                            device,
+            VkPipelineCache                     pipelineCache,
+            size_t*                             pDataSize,
+            void*                               pData) {
+      *pDataSize = 0;
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateGraphicsPipelines(
+            VkDevice                            device,
+            VkPipelineCache                     pipelineCache,
+            uint32_t                            createInfoCount,
+      const VkGraphicsPipelineCreateInfo*       pCreateInfos,
+      const VkAllocationCallbacks*              pAllocator,
+            VkPipeline*                         pPipelines) {
+      for (uint32_t i = 0; i < createInfoCount; i++)
+        pPipelines[i] = nullHandle<VkPipeline>();
+
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateComputePipelines(
+            VkDevice                            device,
+            VkPipelineCache                     pipelineCache,
+            uint32_t                            createInfoCount,
+      const VkComputePipelineCreateInfo*        pCreateInfos,
+      const VkAllocationCallbacks*              pAllocator,
+            VkPipeline*                         pPipelines) {
+      for (uint32_t i = 0; i < createInfoCount; i++)
+        pPipelines[i] = nullHandle<VkPipeline>();
+
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkAllocateDescriptorSets(
+            VkDevice                            device,
+      const VkDescriptorSetAllocateInfo*        pAllocateInfo,
+            VkDescriptorSet*                    pDescriptorSets) {
+      for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++)
+        pDescriptorSets[i] = nullHandle<VkDescriptorSet>();
+
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkAllocateCommandBuffers(
+            VkDevice                            device,
+      const VkCommandBufferAllocateInfo*        pAllocateInfo,
+            VkCommandBuffer*                    pCommandBuffers) {
+      for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++)
+        pCommandBuffers[i] = nullHandle<VkCommandBuffer>();
+
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkGetRenderAreaGranularity(
+            VkDevice                            device,
+            VkRenderPass                        renderPass,
+            VkExtent2D*                         pGranularity) {
+      *pGranularity = VkExtent2D { 1, 1 };
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkCreateSwapchainKHR(
+            VkDevice                            device,
+      const VkSwapchainCreateInfoKHR*           pCreateInfo,
+      const VkAllocationCallbacks*              pAllocator,
+            VkSwapchainKHR*                     pSwapchain) {
+      VkExtent3D extent = {
+        pCreateInfo->imageExtent.width,
+        pCreateInfo->imageExtent.height, 1 };
+
+      auto swapchain = new NullSwapchain();
+      swapchain->nextImage = 0;
+
+      for (uint32_t i = 0; i < std::max(pCreateInfo->minImageCount, 1u); i++) {
+        swapchain->images.push_back(nullHandleFromObject<VkImage>(
+          createNullImage(extent, 1, pCreateInfo->imageArrayLayers, 1)));
+      }
+
+      *pSwapchain = nullHandleFromObject<VkSwapchainKHR>(swapchain);
+      return VK_SUCCESS;
+    }
+
+
+    static VKAPI_ATTR void VKAPI_CALL vkDestroySwapchainKHR(
+            VkDevice                            device,
+            VkSwapchainKHR                      swapchain,
+      const VkAllocationCallbacks*              pAllocator) {
+      auto object = nullObjectFromHandle<NullSwapchain>(swapchain);
+
+      if (object) {
+        for (auto image : object->images)
+          delete nullObjectFromHandle<NullImage>(image);
+
+        delete object;
+      }
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkGetSwapchainImagesKHR(
+            VkDevice                            device,
+            VkSwapchainKHR                      swapchain,
+            uint32_t*                           pSwapchainImageCount,
+            VkImage*                            pSwapchainImages) {
+      auto object = nullObjectFromHandle<NullSwapchain>(swapchain);
+      return nullWriteArray(pSwapchainImageCount, pSwapchainImages, object->images);
+    }
+
+
+    static VKAPI_ATTR VkResult VKAPI_CALL vkAcquireNextImageKHR(
+            VkDevice                            device,
+            VkSwapchainKHR                      swapchain,
+            uint64_t                            timeout,
+            VkSemaphore                         semaphore,
+            VkFence                             fence,
+            uint32_t*                           pImageIndex) {
+      auto object = nullObjectFromHandle<NullSwapchain>(swapchain);
+
+      *pImageIndex = object->nextImage;
+      object->nextImage = (object->nextImage + 1) % uint32_t(object->images.size());
+      return VK_SUCCESS;
+    }
+
+
+    /**
+     * \brief Creates a handle for any object type
+     *
+     * Used for all objects that do not need to
+     * store any data, e.g. views and samplers.
+     */
+    template<typename Fn>
+    struct NullCreateFn;
+
+    template<typename Info, typename T>
+    struct NullCreateFn<VkResult (VKAPI_PTR*)(VkDevice, const Info*, const VkAllocationCallbacks*, T*)> {
+      static VkResult VKAPI_CALL call(VkDevice, const Info*, const VkAllocationCallbacks*, T* pHandle) {
+        *pHandle = nullHandle<T>();
+        return VK_SUCCESS;
+      }
+    };
+
+  }
+
+
+  #define VULKAN_NULL_FN(name) \
+    { #name, reinterpret_cast<PFN_vkVoidFunction>(&NullFn<PFN_ ## name>::call) }
+  #define VULKAN_NULL_CREATE_FN(name) \
+    { #name, reinterpret_cast<PFN_vkVoidFunction>(&nulldrv::NullCreateFn<PFN_ ## name>::call) }
+  #define VULKAN_NULL_IMPL(name) \
+    { #name, reinterpret_cast<PFN_vkVoidFunction>(static_cast<PFN_ ## name>(&nulldrv::name)) }
+
+  static const std::unordered_map<std::string, PFN_vkVoidFunction>& getNullFunctions() {
+    static const std::unordered_map<std::string, PFN_vkVoidFunction> s_functions = {
+      { "vkGetInstanceProcAddr", reinterpret_cast<PFN_vkVoidFunction>(&nullGetInstanceProcAddr) },
+      { "vkGetDeviceProcAddr",   reinterpret_cast<PFN_vkVoidFunction>(&nullGetInstanceProcAddr) },
+
+      // Library functions
+      VULKAN_NULL_IMPL(vkCreateInstance),
+      VULKAN_NULL_IMPL(vkEnumerateInstanceLayerProperties),
+      VULKAN_NULL_IMPL(vkEnumerateInstanceExtensionProperties),
+
+      // Instance functions
+      VULKAN_NULL_IMPL(vkCreateDevice),
+      VULKAN_NULL_FN  (vkDestroyInstance),
+      VULKAN_NULL_IMPL(vkEnumerateDeviceExtensionProperties),
+      VULKAN_NULL_IMPL(vkEnumeratePhysicalDevices),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceFeatures),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceFeatures2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceFormatProperties),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceFormatProperties2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceProperties2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceImageFormatProperties),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceImageFormatProperties2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceMemoryProperties),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceMemoryProperties2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceProperties),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceQueueFamilyProperties),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceQueueFamilyProperties2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSparseImageFormatProperties),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSparseImageFormatProperties2),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSurfaceCapabilities2KHR),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSurfaceFormats2KHR),
+      VULKAN_NULL_IMPL(vkCreateWin32SurfaceKHR),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceWin32PresentationSupportKHR),
+      VULKAN_NULL_FN  (vkDestroySurfaceKHR),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSurfaceSupportKHR),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSurfaceCapabilitiesKHR),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSurfaceFormatsKHR),
+      VULKAN_NULL_IMPL(vkGetPhysicalDeviceSurfacePresentModesKHR),
+
+      // Device functions
+      VULKAN_NULL_FN  (vkDestroyDevice),
+      VULKAN_NULL_IMPL(vkGetDeviceQueue),
+      VULKAN_NULL_FN  (vkQueueSubmit),
+      VULKAN_NULL_FN  (vkQueueWaitIdle),
+      VULKAN_NULL_FN  (vkDeviceWaitIdle),
+      VULKAN_NULL_IMPL(vkAllocateMemory),
+      VULKAN_NULL_IMPL(vkFreeMemory),
+      VULKAN_NULL_IMPL(vkMapMemory),
+      VULKAN_NULL_FN  (vkUnmapMemory),
+      VULKAN_NULL_FN  (vkFlushMappedMemoryRanges),
+      VULKAN_NULL_FN  (vkInvalidateMappedMemoryRanges),
+      VULKAN_NULL_FN  (vkGetDeviceMemoryCommitment),
+      VULKAN_NULL_FN  (vkBindBufferMemory),
+      VULKAN_NULL_FN  (vkBindImageMemory),
+      VULKAN_NULL_IMPL(vkGetBufferMemoryRequirements),
+      VULKAN_NULL_IMPL(vkGetBufferMemoryRequirements2),
+      VULKAN_NULL_IMPL(vkGetImageMemoryRequirements),
+      VULKAN_NULL_IMPL(vkGetImageMemoryRequirements2),
+      VULKAN_NULL_IMPL(vkGetImageSparseMemoryRequirements),
+      VULKAN_NULL_IMPL(vkGetImageSparseMemoryRequirements2),
+      VULKAN_NULL_FN  (vkQueueBindSparse),
+      VULKAN_NULL_CREATE_FN(vkCreateFence),
+      VULKAN_NULL_FN  (vkDestroyFence),
+      VULKAN_NULL_FN  (vkResetFences),
+      VULKAN_NULL_FN  (vkGetFenceStatus),
+      VULKAN_NULL_FN  (vkWaitForFences),
+      VULKAN_NULL_CREATE_FN(vkCreateSemaphore),
+      VULKAN_NULL_FN  (vkDestroySemaphore),
+      VULKAN_NULL_CREATE_FN(vkCreateEvent),
+      VULKAN_NULL_FN  (vkDestroyEvent),
+      VULKAN_NULL_IMPL(vkGetEventStatus),
+      VULKAN_NULL_FN  (vkSetEvent),
+      VULKAN_NULL_FN  (vkResetEvent),
+      VULKAN_NULL_CREATE_FN(vkCreateQueryPool),
+      VULKAN_NULL_FN  (vkDestroyQueryPool),
+      VULKAN_NULL_IMPL(vkGetQueryPoolResults),
+      VULKAN_NULL_IMPL(vkCreateBuffer),
+      VULKAN_NULL_IMPL(vkDestroyBuffer),
+      VULKAN_NULL_CREATE_FN(vkCreateBufferView),
+      VULKAN_NULL_FN  (vkDestroyBufferView),
+      VULKAN_NULL_IMPL(vkCreateImage),
+      VULKAN_NULL_IMPL(vkDestroyImage),
+      VULKAN_NULL_IMPL(vkGetImageSubresourceLayout),
+      VULKAN_NULL_CREATE_FN(vkCreateImageView),
+      VULKAN_NULL_FN  (vkDestroyImageView),
+      VULKAN_NULL_CREATE_FN(vkCreateShaderModule),
+      VULKAN_NULL_FN  (vkDestroyShaderModule),
+      VULKAN_NULL_CREATE_FN(vkCreatePipelineCache),
+      VULKAN_NULL_FN  (vkDestroyPipelineCache),
+      VULKAN_NULL_IMPL(vkGetPipelineCacheData),
+      VULKAN_NULL_FN  (vkMergePipelineCaches),
+      VULKAN_NULL_IMPL(vkCreateGraphicsPipelines),
+      VULKAN_NULL_IMPL(vkCreateComputePipelines),
+      VULKAN_NULL_FN  (vkDestroyPipeline),
+      VULKAN_NULL_CREATE_FN(vkCreatePipelineLayout),
+      VULKAN_NULL_FN  (vkDestroyPipelineLayout),
+      VULKAN_NULL_CREATE_FN(vkCreateSampler),
+      VULKAN_NULL_FN  (vkDestroySampler),
+      VULKAN_NULL_CREATE_FN(vkCreateDescriptorSetLayout),
+      VULKAN_NULL_FN  (vkDestroyDescriptorSetLayout),
+      VULKAN_NULL_CREATE_FN(vkCreateDescriptorPool),
+      VULKAN_NULL_FN  (vkDestroyDescriptorPool),
+      VULKAN_NULL_FN  (vkResetDescriptorPool),
+      VULKAN_NULL_IMPL(vkAllocateDescriptorSets),
+      VULKAN_NULL_FN  (vkFreeDescriptorSets),
+      VULKAN_NULL_FN  (vkUpdateDescriptorSets),
+      VULKAN_NULL_CREATE_FN(vkCreateFramebuffer),
+      VULKAN_NULL_FN  (vkDestroyFramebuffer),
+      VULKAN_NULL_CREATE_FN(vkCreateRenderPass),
+      VULKAN_NULL_FN  (vkDestroyRenderPass),
+      VULKAN_NULL_IMPL(vkGetRenderAreaGranularity),
+      VULKAN_NULL_CREATE_FN(vkCreateCommandPool),
+      VULKAN_NULL_FN  (vkDestroyCommandPool),
+      VULKAN_NULL_FN  (vkResetCommandPool),
+      VULKAN_NULL_IMPL(vkAllocateCommandBuffers),
+      VULKAN_NULL_FN  (vkFreeCommandBuffers),
+      VULKAN_NULL_FN  (vkBeginCommandBuffer),
+      VULKAN_NULL_FN  (vkEndCommandBuffer),
+      VULKAN_NULL_FN  (vkResetCommandBuffer),
+      VULKAN_NULL_CREATE_FN(vkCreateDescriptorUpdateTemplate),
+      VULKAN_NULL_FN  (vkDestroyDescriptorUpdateTemplate),
+      VULKAN_NULL_FN  (vkUpdateDescriptorSetWithTemplate),
+      VULKAN_NULL_FN  (vkCmdBindPipeline),
+      VULKAN_NULL_FN  (vkCmdSetViewport),
+      VULKAN_NULL_FN  (vkCmdSetScissor),
+      VULKAN_NULL_FN  (vkCmdSetLineWidth),
+      VULKAN_NULL_FN  (vkCmdSetDepthBias),
+      VULKAN_NULL_FN  (vkCmdSetBlendConstants),
+      VULKAN_NULL_FN  (vkCmdSetDepthBounds),
+      VULKAN_NULL_FN  (vkCmdSetStencilCompareMask),
+      VULKAN_NULL_FN  (vkCmdSetStencilWriteMask),
+      VULKAN_NULL_FN  (vkCmdSetStencilReference),
+      VULKAN_NULL_FN  (vkCmdBindDescriptorSets),
+      VULKAN_NULL_FN  (vkCmdBindIndexBuffer),
+      VULKAN_NULL_FN  (vkCmdBindVertexBuffers),
+      VULKAN_NULL_FN  (vkCmdDraw),
+      VULKAN_NULL_FN  (vkCmdDrawIndexed),
+      VULKAN_NULL_FN  (vkCmdDrawIndirect),
+      VULKAN_NULL_FN  (vkCmdDrawIndexedIndirect),
+      VULKAN_NULL_FN  (vkCmdDispatch),
+      VULKAN_NULL_FN  (vkCmdDispatchIndirect),
+      VULKAN_NULL_FN  (vkCmdCopyBuffer),
+      VULKAN_NULL_FN  (vkCmdCopyImage),
+      VULKAN_NULL_FN  (vkCmdBlitImage),
+      VULKAN_NULL_FN  (vkCmdCopyBufferToImage),
+      VULKAN_NULL_FN  (vkCmdCopyImageToBuffer),
+      VULKAN_NULL_FN  (vkCmdUpdateBuffer),
+      VULKAN_NULL_FN  (vkCmdFillBuffer),
+      VULKAN_NULL_FN  (vkCmdClearColorImage),
+      VULKAN_NULL_FN  (vkCmdClearDepthStencilImage),
+      VULKAN_NULL_FN  (vkCmdClearAttachments),
+      VULKAN_NULL_FN  (vkCmdResolveImage),
+      VULKAN_NULL_FN  (vkCmdSetEvent),
+      VULKAN_NULL_FN  (vkCmdResetEvent),
+      VULKAN_NULL_FN  (vkCmdWaitEvents),
+      VULKAN_NULL_FN  (vkCmdPipelineBarrier),
+      VULKAN_NULL_FN  (vkCmdBeginQuery),
+      VULKAN_NULL_FN  (vkCmdEndQuery),
+      VULKAN_NULL_FN  (vkCmdResetQueryPool),
+      VULKAN_NULL_FN  (vkCmdWriteTimestamp),
+      VULKAN_NULL_FN  (vkCmdCopyQueryPoolResults),
+      VULKAN_NULL_FN  (vkCmdPushConstants),
+      VULKAN_NULL_FN  (vkCmdBeginRenderPass),
+      VULKAN_NULL_FN  (vkCmdNextSubpass),
+      VULKAN_NULL_FN  (vkCmdEndRenderPass),
+      VULKAN_NULL_FN  (vkCmdExecuteCommands),
+
+      // VK_KHR_create_renderpass2
+      VULKAN_NULL_CREATE_FN(vkCreateRenderPass2KHR),
+      VULKAN_NULL_FN  (vkCmdBeginRenderPass2KHR),
+      VULKAN_NULL_FN  (vkCmdNextSubpass2KHR),
+      VULKAN_NULL_FN  (vkCmdEndRenderPass2KHR),
+
+      // VK_KHR_draw_indirect_count
+      VULKAN_NULL_FN  (vkCmdDrawIndirectCountKHR),
+      VULKAN_NULL_FN  (vkCmdDrawIndexedIndirectCountKHR),
+
+      // VK_KHR_swapchain
+      VULKAN_NULL_IMPL(vkCreateSwapchainKHR),
+      VULKAN_NULL_IMPL(vkDestroySwapchainKHR),
+      VULKAN_NULL_IMPL(vkGetSwapchainImagesKHR),
+      VULKAN_NULL_IMPL(vkAcquireNextImageKHR),
+      VULKAN_NULL_FN  (vkQueuePresentKHR),
+
+      // VK_EXT_host_query_reset
+      VULKAN_NULL_FN  (vkResetQueryPoolEXT),
+
+      // VK_EXT_transform_feedback
+      VULKAN_NULL_FN  (vkCmdBindTransformFeedbackBuffersEXT),
+      VULKAN_NULL_FN  (vkCmdBeginTransformFeedbackEXT),
+      VULKAN_NULL_FN  (vkCmdEndTransformFeedbackEXT),
+      VULKAN_NULL_FN  (vkCmdDrawIndirectByteCountEXT),
+      VULKAN_NULL_FN  (vkCmdBeginQueryIndexedEXT),
+      VULKAN_NULL_FN  (vkCmdEndQueryIndexedEXT),
+    };
+
+    return s_functions;
+  }
+
+  #undef VULKAN_NULL_FN
+  #undef VULKAN_NULL_CREATE_FN
+  #undef VULKAN_NULL_IMPL
+
+
+  VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL nullGetInstanceProcAddr(
+          VkInstance              instance,
+    const char*                   pName) {
+    const auto& functions = getNullFunctions();
+    auto entry = functions.find(pName);
+
+    return entry != functions.end()
+      ? entry->second
+      : nullptr;
+  }
+
+}
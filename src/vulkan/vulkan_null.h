@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+#include "vulkan_loader.h"
+
+namespace dxvk::vk {
+
+  /**
+   * \brief Null device description
+   *
+   * Properties of the physical device that the null
+   * Vulkan implementation reports. Defaults can be
+   * overridden through \c DXVK_NULL_DEVICE, which
+   * takes a comma-separated list of \c key=value
+   * pairs, where keys are \c vendorID, \c deviceID,
+   * \c deviceName, \c vram and \c sysmem (heap sizes
+   * in MiB), or the name of most integer members of
+   * \c VkPhysicalDeviceLimits.
+   */
+  struct NullDeviceDesc {
+    VkPhysicalDeviceProperties  properties;
+    VkDeviceSize                vramSize;
+    VkDeviceSize                sysmemSize;
+  };
+
+  /**
+   * \brief Checks whether the null implementation is enabled
+   *
+   * The null implementation is used instead of the system's
+   * Vulkan loader if \c DXVK_NULL_DEVICE is set to any
+   * non-empty value.
+   * \returns \c true if the null implementation is used
+   */
+  bool isNullDeviceEnabled();
+
+  /**
+   * \brief Parses null device description
+   *
+   * \param [in] args Comma-separated list of options
+   * \returns Device description with the given
+   *    options applied on top of the defaults
+   */
+  NullDeviceDesc parseNullDeviceDesc(const std::string& args);
+
+  /**
+   * \brief Null implementation of \c vkGetInstanceProcAddr
+   *
+   * Returns functions that hand out fake handles, accept
+   * all commands, and complete all GPU work immediately.
+   * This allows running the entire DXVK stack without a
+   * GPU in order to measure CPU overhead. Memory is only
+   * backed by system memory when it gets mapped.
+   * \param [in] instance Instance handle, ignored
+   * \param [in] pName Function name
+   * \returns Function pointer, or \c nullptr if
+   *    the function is not implemented
+   */
+  VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL nullGetInstanceProcAddr(
+          VkInstance              instance,
+    const char*                   pName);
+
+}
@@ -0,0 +1,101 @@
+#include <array>
+#include <iterator>
+#include <fstream>
+
+#include "../../src/dxbc/dxbc_module.h"
+#include "../../src/dxvk/dxvk_shader.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-benchmark.log");
+}
+
+using namespace dxvk;
+
+constexpr uint32_t RunCount = 10;
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);  
+  
+  if (argc < 2) {
+    Logger::err("Usage: dxbc-benchmark input.dxbc...");
+    return 1;
+  }
+  
+  DxbcModuleInfo moduleInfo;
+  moduleInfo.options.useSubgroupOpsForAtomicCounters = true;
+  moduleInfo.options.useDemoteToHelperInvocation = true;
+  moduleInfo.options.minSsboAlignment = 4;
+  moduleInfo.tess = nullptr;
+  moduleInfo.xfb = nullptr;
+
+  const std::array<SpirvOptimizerPasses, 2> passes = {{
+    SpirvOptimizerPasses(),
+    SpirvOptimizerPasses(
+      SpirvOptimizerPass::EliminateDeadCode,
+      SpirvOptimizerPass::FoldConstants,
+      SpirvOptimizerPass::ForwardStores),
+  }};
+
+  // Compile each shader multiple times and
+  // report the fastest run to reduce noise.
+  // Each shader is compiled without and with
+  // the SPIR-V optimizer.
+  std::array<std::chrono::microseconds, 2> totalTime = { };
+  std::array<size_t, 2> totalSize = { };
+
+  for (int i = 1; i < argc; i++) {
+    std::string ifileName = str::fromws(argv[i]);
+
+    try {
+      std::ifstream ifile(ifileName, std::ios::binary);
+      std::vector<char> dxbcCode(
+        (std::istreambuf_iterator<char>(ifile)),
+        (std::istreambuf_iterator<char>()));
+      
+      DxbcReader reader(dxbcCode.data(), dxbcCode.size());
+      DxbcModule module(reader);
+
+      std::array<std::chrono::microseconds, 2> bestTime;
+      std::array<size_t, 2> codeSize = { };
+
+      for (uint32_t p = 0; p < passes.size(); p++) {
+        moduleInfo.options.spirvPasses = passes[p];
+        bestTime[p] = std::chrono::microseconds::max();
+
+        for (uint32_t j = 0; j < RunCount; j++) {
+          auto t0 = dxvk::high_resolution_clock::now();
+          Rc<DxvkShader> shader = module.compile(moduleInfo, ifileName);
+          auto t1 = dxvk::high_resolution_clock::now();
+
+          bestTime[p] = std::min(bestTime[p], std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0));
+          codeSize[p] = shader->getRawCode().size();
+        }
+
+        totalTime[p] += bestTime[p];
+        totalSize[p] += codeSize[p];
+      }
+
+      Logger::info(str::format(ifileName, ": ",
+        codeSize[0], " bytes, ", bestTime[0].count(), " us -> ",
+        codeSize[1], " bytes, ", bestTime[1].count(), " us"));
+    } catch (const DxvkError& e) {
+      Logger::err(str::format(ifileName, ": ", e.message()));
+    }
+  }
+
+  Logger::info(str::format("Total: ",
+    totalSize[0], " bytes, ", totalTime[0].count(), " us -> ",
+    totalSize[1], " bytes, ", totalTime[1].count(), " us"));
+  return 0;
+}
@@ -0,0 +1,293 @@
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "../../src/dxvk/dxvk_allocator.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-allocator.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Single trace operation
+ *
+ * Allocations are identified by the index of the
+ * operation that created them, so that frees can
+ * refer back to them.
+ */
+struct TraceOp {
+  bool          isAlloc;
+  uint32_t      id;
+  VkDeviceSize  size;
+  VkDeviceSize  align;
+};
+
+
+/**
+ * \brief Reference implementation
+ *
+ * The linear free list scan that \c DxvkMemoryChunk
+ * used before switching to \c DxvkRangeAllocator.
+ */
+class LegacyAllocator {
+
+public:
+
+  LegacyAllocator(VkDeviceSize size) {
+    m_freeList.push_back({ 0, size });
+  }
+
+  DxvkRange alloc(VkDeviceSize size, VkDeviceSize align) {
+    if (m_freeList.size() == 0)
+      return DxvkRange();
+
+    auto bestSlice = m_freeList.begin();
+
+    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
+      if (slice->length == size) {
+        bestSlice = slice;
+        break;
+      } else if (slice->length > bestSlice->length) {
+        bestSlice = slice;
+      }
+    }
+
+    const VkDeviceSize sliceStart = bestSlice->offset;
+    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
+
+    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
+    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
+
+    if (allocEnd > sliceEnd)
+      return DxvkRange();
+
+    m_freeList.erase(bestSlice);
+
+    if (allocStart != sliceStart)
+      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
+
+    if (allocEnd != sliceEnd)
+      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
+
+    DxvkRange result;
+    result.offset = allocStart;
+    result.length = allocEnd - allocStart;
+    return result;
+  }
+
+  void free(const DxvkRange& range) {
+    VkDeviceSize offset = range.offset;
+    VkDeviceSize length = range.length;
+
+    auto curr = m_freeList.begin();
+
+    while (curr != m_freeList.end()) {
+      if (curr->offset == offset + length) {
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else if (curr->offset + curr->length == offset) {
+        offset -= curr->length;
+        length += curr->length;
+        curr = m_freeList.erase(curr);
+      } else {
+        curr++;
+      }
+    }
+
+    m_freeList.push_back({ offset, length });
+  }
+
+private:
+
+  struct FreeSlice {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+  };
+
+  std::vector<FreeSlice> m_freeList;
+
+};
+
+
+class RangeAllocator {
+
+public:
+
+  RangeAllocator(VkDeviceSize size)
+  : m_allocator(size) { }
+
+  DxvkRange alloc(VkDeviceSize size, VkDeviceSize align) {
+    return m_allocator.alloc(size, align);
+  }
+
+  void free(const DxvkRange& range) {
+    m_allocator.free(range.block);
+  }
+
+private:
+
+  DxvkRangeAllocator m_allocator;
+
+};
+
+
+/**
+ * \brief Reads a text trace
+ *
+ * Each line is either \c "a <id> <size> <align>"
+ * or \c "f <id>". Unknown lines are ignored.
+ */
+std::vector<TraceOp> readTrace(const std::string& fileName) {
+  std::vector<TraceOp> ops;
+  std::ifstream file(fileName);
+  std::string line;
+
+  while (std::getline(file, line)) {
+    std::stringstream stream(line);
+    std::string type;
+    TraceOp op = { };
+
+    stream >> type >> op.id;
+
+    if (type == "a") {
+      op.isAlloc = true;
+      stream >> op.size >> op.align;
+      ops.push_back(op);
+    } else if (type == "f") {
+      op.isAlloc = false;
+      ops.push_back(op);
+    }
+  }
+
+  return ops;
+}
+
+
+/**
+ * \brief Generates a synthetic streaming trace
+ *
+ * Mimics level streaming with a mix of small buffers and
+ * larger image allocations, where a random subset of the
+ * live allocations gets replaced every iteration.
+ */
+std::vector<TraceOp> generateTrace(VkDeviceSize chunkSize) {
+  std::vector<TraceOp> ops;
+  std::vector<uint32_t> live;
+  std::vector<VkDeviceSize> sizes;
+  std::mt19937 rng(0x1234);
+
+  VkDeviceSize liveSize = 0;
+  uint32_t nextId = 0;
+
+  for (uint32_t i = 0; i < 200000; i++) {
+    bool doAlloc = live.empty() || (liveSize < chunkSize / 2 && (rng() % 3) != 0);
+
+    if (doAlloc) {
+      TraceOp op;
+      op.isAlloc = true;
+      op.id      = nextId++;
+
+      if (rng() % 8) {
+        op.size  = 256 + (rng() % 65536);
+        op.align = 256;
+      } else {
+        op.size  = 65536 << (rng() % 7);
+        op.align = 65536;
+      }
+
+      liveSize += op.size;
+      live.push_back(op.id);
+      sizes.push_back(op.size);
+      ops.push_back(op);
+    } else {
+      uint32_t index = rng() % live.size();
+
+      TraceOp op = { };
+      op.isAlloc = false;
+      op.id      = live[index];
+      ops.push_back(op);
+
+      liveSize -= sizes[op.id];
+      live[index] = live.back();
+      live.pop_back();
+    }
+  }
+
+  return ops;
+}
+
+
+template<typename Allocator>
+void runTrace(const char* name, VkDeviceSize chunkSize, const std::vector<TraceOp>& ops) {
+  Allocator allocator(chunkSize);
+
+  std::vector<DxvkRange> ranges;
+  std::vector<bool>      valid;
+
+  uint32_t failed = 0;
+  VkDeviceSize used = 0;
+  VkDeviceSize peak = 0;
+
+  auto t0 = dxvk::high_resolution_clock::now();
+
+  for (const auto& op : ops) {
+    if (op.id >= ranges.size()) {
+      ranges.resize(op.id + 1);
+      valid.resize(op.id + 1, false);
+    }
+
+    if (op.isAlloc) {
+      DxvkRange range = allocator.alloc(op.size, op.align);
+
+      if (range.length) {
+        ranges[op.id] = range;
+        valid[op.id]  = true;
+        used += range.length;
+        peak  = std::max(peak, used);
+      } else {
+        failed += 1;
+      }
+    } else if (valid[op.id]) {
+      allocator.free(ranges[op.id]);
+      valid[op.id] = false;
+      used -= ranges[op.id].length;
+    }
+  }
+
+  auto t1 = dxvk::high_resolution_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+  Logger::info(str::format(name, ":",
+    "\n  Operations:   ", ops.size(),
+    "\n  ns/op:        ", double(ns) / double(ops.size()),
+    "\n  Failed:       ", failed,
+    "\n  Peak used:    ", peak >> 10, " kB"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  VkDeviceSize chunkSize = 128 << 20;
+
+  std::vector<TraceOp> ops = argc >= 2
+    ? readTrace(str::fromws(argv[1]))
+    : generateTrace(chunkSize);
+
+  runTrace<LegacyAllocator>("Legacy free list", chunkSize, ops);
+  runTrace<RangeAllocator> ("Segregated fit",   chunkSize, ops);
+  return 0;
+}
@@ -0,0 +1,437 @@
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../../src/dxvk/dxvk_state_cache_io.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cache-tool.log");
+}
+
+using namespace dxvk;
+
+static const std::array<const char*, 6> g_stageNames = {{
+  "VS", "TCS", "TES", "GS", "FS", "CS",
+}};
+
+
+/**
+ * \brief Entry filter
+ *
+ * Shader keys read from a text file with one key per
+ * line, in the same format as printed by the tool.
+ */
+struct EntryFilter {
+  std::unordered_set<std::string> keepShaders;
+  std::unordered_set<std::string> dropShaders;
+
+  bool accept(const DxvkStateCacheEntry& entry) const {
+    auto keys = &entry.shaders.vs;
+
+    for (uint32_t i = 0; i < g_stageNames.size(); i++) {
+      if (keys[i].eq(DxvkShaderKey()))
+        continue;
+
+      std::string key = keys[i].toString();
+
+      if (!keepShaders.empty() && !keepShaders.count(key))
+        return false;
+
+      if (dropShaders.count(key))
+        return false;
+    }
+
+    return true;
+  }
+};
+
+
+using UsageMap = std::unordered_map<Sha1Hash,
+  DxvkStateCacheUsage, DxvkStateCacheEntryHashFn>;
+
+
+static void mergeUsage(UsageMap& usage, const DxvkStateCacheUsage& record) {
+  auto result = usage.insert({ record.entryHash, record });
+
+  if (!result.second)
+    result.first->second.merge(record);
+}
+
+
+static bool readShaderList(const std::string& fileName, std::unordered_set<std::string>& list) {
+  std::ifstream file(fileName);
+
+  if (!file) {
+    std::cerr << "Failed to open " << fileName << std::endl;
+    return false;
+  }
+
+  std::string line;
+
+  while (std::getline(file, line)) {
+    while (!line.empty() && std::isspace(uint8_t(line.back())))
+      line.pop_back();
+
+    if (!line.empty())
+      list.insert(line);
+  }
+
+  return true;
+}
+
+
+/**
+ * \brief Reads all entries of a cache file
+ *
+ * Decodes all blocks of v9 and newer files, and
+ * converts entries of older versions to the current
+ * format. Usage records of all runs are merged.
+ * \returns \c false if the file could not be read
+ */
+static bool readCacheFile(
+  const std::string&                  fileName,
+        std::vector<DxvkStateCacheEntry>& entries,
+        UsageMap&                     usage,
+        uint32_t&                     version,
+        uint32_t&                     numInvalid) {
+  std::ifstream file(fileName, std::ios_base::binary);
+
+  if (!file) {
+    std::cerr << "Failed to open " << fileName << std::endl;
+    return false;
+  }
+
+  DxvkStateCacheReader reader(file);
+
+  if (!reader.readHeader()) {
+    std::cerr << fileName << " is not a supported state cache file" << std::endl;
+    return false;
+  }
+
+  version    = reader.version();
+  numInvalid = 0;
+
+  if (version >= 9) {
+    std::vector<DxvkStateCacheEntry> blockEntries;
+    std::vector<DxvkStateCacheUsage> blockUsage;
+
+    while (!reader.eof()) {
+      DxvkStateCacheBlock block;
+
+      // Block boundaries can't be trusted after this
+      if (!reader.readBlockIndex(block, blockEntries, blockUsage)) {
+        numInvalid += 1;
+        break;
+      }
+
+      if (block.type == DxvkStateCacheBlockType::Usage) {
+        for (const auto& record : blockUsage)
+          mergeUsage(usage, record);
+        continue;
+      }
+
+      if (!reader.readBlockData(block, blockEntries.data())) {
+        numInvalid += block.entryCount;
+        continue;
+      }
+
+      entries.insert(entries.end(), blockEntries.begin(), blockEntries.end());
+    }
+  } else {
+    while (!reader.eof()) {
+      DxvkStateCacheEntry entry;
+
+      if (reader.readEntry(entry))
+        entries.push_back(entry);
+      else if (!reader.eof())
+        numInvalid += 1;
+    }
+  }
+
+  return true;
+}
+
+
+static std::string formatRenderPass(const DxvkRenderPassFormat& format) {
+  std::string result = str::format(uint32_t(format.sampleCount), "x");
+
+  result += str::format(" ", format.depth.format
+    ? str::format(format.depth.format)
+    : std::string("no depth"));
+
+  for (uint32_t i = 0; i < MaxNumRenderTargets; i++) {
+    if (format.color[i].format)
+      result += str::format(", ", i, ": ", format.color[i].format);
+  }
+
+  return result;
+}
+
+
+static int printInfo(const std::vector<std::string>& fileNames) {
+  for (const auto& fileName : fileNames) {
+    std::vector<DxvkStateCacheEntry> entries;
+    UsageMap usage;
+    uint32_t version    = 0;
+    uint32_t numInvalid = 0;
+
+    if (!readCacheFile(fileName, entries, usage, version, numInvalid))
+      return 1;
+
+    std::cout << fileName << ": v" << version << ", "
+              << entries.size() << " entries";
+
+    if (numInvalid)
+      std::cout << ", " << numInvalid << " invalid";
+
+    std::cout << std::endl;
+
+    // Number of unique shaders and entries per stage
+    std::array<std::unordered_set<std::string>, 6> shaders;
+    std::array<uint32_t, 6> stageEntries = { };
+
+    std::map<std::string, uint32_t> stageMasks;
+    std::map<std::string, uint32_t> formats;
+
+    for (const auto& entry : entries) {
+      auto keys = &entry.shaders.vs;
+      std::string mask;
+
+      for (uint32_t i = 0; i < g_stageNames.size(); i++) {
+        if (keys[i].eq(DxvkShaderKey()))
+          continue;
+
+        shaders[i].insert(keys[i].toString());
+        stageEntries[i] += 1;
+
+        mask += mask.empty() ? "" : "+";
+        mask += g_stageNames[i];
+      }
+
+      stageMasks[mask] += 1;
+
+      if (entry.shaders.cs.eq(DxvkShaderKey()))
+        formats[formatRenderPass(entry.format)] += 1;
+    }
+
+    std::cout << "  Shader stages:" << std::endl;
+
+    for (uint32_t i = 0; i < g_stageNames.size(); i++) {
+      if (stageEntries[i]) {
+        std::cout << "    " << g_stageNames[i] << ": "
+                  << shaders[i].size() << " shaders, "
+                  << stageEntries[i] << " entries" << std::endl;
+      }
+    }
+
+    std::cout << "  Pipeline types:" << std::endl;
+
+    for (const auto& m : stageMasks)
+      std::cout << "    " << m.first << ": " << m.second << " entries" << std::endl;
+
+    std::cout << "  Render pass formats:" << std::endl;
+
+    for (const auto& f : formats)
+      std::cout << "    " << f.first << ": " << f.second << " entries" << std::endl;
+
+    // Usage records may refer to entries that were
+    // never written, e.g. if the process was killed
+    uint32_t lastRun      = 0;
+    uint32_t usedEntries  = 0;
+    uint32_t usedLastRun  = 0;
+    uint64_t totalUses    = 0;
+
+    for (const auto& u : usage)
+      lastRun = std::max(lastRun, u.second.lastRun);
+
+    for (const auto& entry : entries) {
+      auto record = usage.find(entry.hash);
+
+      if (record != usage.end()) {
+        usedEntries += 1;
+        usedLastRun += record->second.lastRun == lastRun ? 1 : 0;
+        totalUses   += record->second.useCount;
+      }
+    }
+
+    if (!usage.empty()) {
+      std::cout << "  Usage:" << std::endl
+                << "    Runs: " << lastRun << std::endl
+                << "    Used entries: " << usedEntries
+                << " (" << usedLastRun << " in last run)" << std::endl
+                << "    Total uses: " << totalUses << std::endl;
+    }
+  }
+
+  return 0;
+}
+
+
+static int printShaders(const std::vector<std::string>& fileNames) {
+  std::set<std::string> shaders;
+
+  for (const auto& fileName : fileNames) {
+    std::vector<DxvkStateCacheEntry> entries;
+    UsageMap usage;
+    uint32_t version    = 0;
+    uint32_t numInvalid = 0;
+
+    if (!readCacheFile(fileName, entries, usage, version, numInvalid))
+      return 1;
+
+    for (const auto& entry : entries) {
+      auto keys = &entry.shaders.vs;
+
+      for (uint32_t i = 0; i < g_stageNames.size(); i++) {
+        if (!keys[i].eq(DxvkShaderKey()))
+          shaders.insert(keys[i].toString());
+      }
+    }
+  }
+
+  for (const auto& s : shaders)
+    std::cout << s << std::endl;
+
+  return 0;
+}
+
+
+static int mergeFiles(
+  const std::string&                  outputName,
+  const std::vector<std::string>&     inputNames,
+  const EntryFilter&                  filter) {
+  std::vector<DxvkStateCacheEntry> result;
+  UsageMap resultUsage;
+
+  std::unordered_set<Sha1Hash, DxvkStateCacheEntryHashFn> hashes;
+
+  for (const auto& inputName : inputNames) {
+    std::vector<DxvkStateCacheEntry> entries;
+    UsageMap usage;
+    uint32_t version    = 0;
+    uint32_t numInvalid = 0;
+
+    if (!readCacheFile(inputName, entries, usage, version, numInvalid))
+      return 1;
+
+    for (const auto& u : usage)
+      mergeUsage(resultUsage, u.second);
+
+    uint32_t numAdded    = 0;
+    uint32_t numFiltered = 0;
+
+    for (const auto& entry : entries) {
+      if (!filter.accept(entry)) {
+        numFiltered += 1;
+        continue;
+      }
+
+      if (hashes.insert(entry.hash).second) {
+        result.push_back(entry);
+        numAdded += 1;
+      }
+    }
+
+    std::cout << inputName << ": v" << version << ", "
+              << entries.size() << " entries, "
+              << numAdded << " added, "
+              << numFiltered << " filtered, "
+              << numInvalid << " invalid" << std::endl;
+  }
+
+  std::ofstream file(outputName, std::ios_base::binary | std::ios_base::trunc);
+
+  if (!file) {
+    std::cerr << "Failed to create " << outputName << std::endl;
+    return 1;
+  }
+
+  // Only keep usage records of entries that were kept
+  std::vector<DxvkStateCacheUsage> usage;
+
+  for (const auto& entry : result) {
+    auto record = resultUsage.find(entry.hash);
+
+    if (record != resultUsage.end())
+      usage.push_back(record->second);
+  }
+
+  DxvkStateCacheWriter writer(file);
+  writer.writeHeader();
+  writer.writeEntries(result.data(), result.size());
+  writer.writeUsage(usage.data(), usage.size());
+
+  if (!file) {
+    std::cerr << "Failed to write " << outputName << std::endl;
+    return 1;
+  }
+
+  std::cout << outputName << ": " << result.size() << " entries" << std::endl;
+  return 0;
+}
+
+
+static void printUsage() {
+  std::cerr
+    << "Usage:" << std::endl
+    << "  dxvk-cache-tool info <file>..." << std::endl
+    << "      Prints entry statistics per shader stage and render pass format." << std::endl
+    << "  dxvk-cache-tool shaders <file>..." << std::endl
+    << "      Prints the keys of all shaders used by the given files." << std::endl
+    << "  dxvk-cache-tool merge [--keep <list>] [--drop <list>] <output> <input>..." << std::endl
+    << "      Merges entries of all input files and removes duplicates. Files" << std::endl
+    << "      of older versions are converted to the current version, so this" << std::endl
+    << "      can also be used with a single input to upgrade a file. Usage" << std::endl
+    << "      data of the kept entries is merged into a single record each." << std::endl
+    << "      --keep: Only keep entries whose shaders are all listed in <list>." << std::endl
+    << "      --drop: Remove entries that use any shader listed in <list>." << std::endl
+    << "      Lists contain one shader key per line, as printed by 'shaders'." << std::endl;
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    printUsage();
+    return 1;
+  }
+
+  std::string command = argv[1];
+  std::vector<std::string> args(argv + 2, argv + argc);
+
+  if (command == "info")
+    return printInfo(args);
+
+  if (command == "shaders")
+    return printShaders(args);
+
+  if (command == "merge") {
+    EntryFilter filter;
+    size_t i = 0;
+
+    for ( ; i + 1 < args.size(); i += 2) {
+      if (args[i] == "--keep") {
+        if (!readShaderList(args[i + 1], filter.keepShaders))
+          return 1;
+      } else if (args[i] == "--drop") {
+        if (!readShaderList(args[i + 1], filter.dropShaders))
+          return 1;
+      } else {
+        break;
+      }
+    }
+
+    if (args.size() < i + 2) {
+      printUsage();
+      return 1;
+    }
+
+    return mergeFiles(args[i], std::vector<std::string>(
+      args.begin() + i + 1, args.end()), filter);
+  }
+
+  printUsage();
+  return 1;
+}
@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_cs.h"
+
+#include "../../src/util/thread.h"
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cs-dispatch.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Reference implementation
+ *
+ * Chunk queue that \c DxvkCsThread used before
+ * switching to a lock-free ring. Every dispatch
+ * takes a mutex and wakes up the worker.
+ */
+class LegacyCsThread {
+
+public:
+
+  LegacyCsThread(const Rc<DxvkContext>& context)
+  : m_context(context), m_thread([this] { threadFunc(); }) { }
+
+  ~LegacyCsThread() {
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped.store(true);
+    }
+
+    m_condOnAdd.notify_one();
+    m_thread.join();
+  }
+
+  uint64_t dispatchChunk(DxvkCsChunkRef&& chunk) {
+    uint64_t seq;
+
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      seq = ++m_chunksDispatched;
+      m_chunksQueued.push(std::move(chunk));
+    }
+
+    m_condOnAdd.notify_one();
+    return seq;
+  }
+
+  void synchronize(uint64_t seq) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    seq = std::min(seq, m_chunksDispatched);
+
+    m_condOnSync.wait(lock, [this, seq] {
+      return m_chunksExecuted >= seq;
+    });
+  }
+
+private:
+
+  const Rc<DxvkContext>       m_context;
+
+  std::atomic<bool>           m_stopped = { false };
+  std::mutex                  m_mutex;
+  std::condition_variable     m_condOnAdd;
+  std::condition_variable     m_condOnSync;
+  std::queue<DxvkCsChunkRef>  m_chunksQueued;
+  uint64_t                    m_chunksDispatched = 0;
+  uint64_t                    m_chunksExecuted   = 0;
+  dxvk::thread                m_thread;
+
+  void threadFunc() {
+    DxvkCsChunkRef chunk;
+
+    while (!m_stopped.load()) {
+      { std::unique_lock<std::mutex> lock(m_mutex);
+        if (chunk) {
+          m_chunksExecuted += 1;
+          m_condOnSync.notify_one();
+
+          chunk = DxvkCsChunkRef();
+        }
+
+        m_condOnAdd.wait(lock, [this] {
+          return (m_chunksQueued.size() != 0)
+              || (m_stopped.load());
+        });
+
+        if (m_chunksQueued.size() != 0) {
+          chunk = std::move(m_chunksQueued.front());
+          m_chunksQueued.pop();
+        }
+      }
+
+      if (chunk)
+        chunk->executeAll(m_context.ptr());
+    }
+  }
+
+};
+
+
+/**
+ * \brief Records a chunk
+ *
+ * \param [in] pool Chunk pool
+ * \param [in] cmdCount Number of commands
+ * \param [in] fn Command to record
+ * \returns The chunk
+ */
+template<typename Fn>
+DxvkCsChunkRef recordChunk(
+        DxvkCsChunkPool&  pool,
+        uint32_t          cmdCount,
+        Fn                fn) {
+  DxvkCsChunkRef chunk(pool.allocChunk(DxvkCsChunkFlag::SingleUse), &pool);
+
+  for (uint32_t i = 0; i < cmdCount; i++) {
+    Fn cmd = fn;
+    chunk->push(cmd);
+  }
+
+  return chunk;
+}
+
+
+/**
+ * \brief Measures dispatch throughput
+ *
+ * Dispatches a large number of chunks back to back and
+ * waits for all of them at the end, which is what an
+ * application with high draw rates would look like.
+ * \param [in] name Name of the implementation
+ * \param [in] cmdCount Number of commands per chunk
+ */
+template<typename CsThread>
+void runThroughputTest(
+  const char*       name,
+        uint32_t    cmdCount) {
+  constexpr uint32_t ChunkCount = 1 << 18;
+
+  DxvkCsChunkPool pool;
+
+  std::atomic<uint64_t> counter = { 0ull };
+  std::chrono::nanoseconds dispatchTime(0);
+
+  auto t0 = dxvk::high_resolution_clock::now();
+
+  // Commands do not touch the context, so we don't need a device
+  { CsThread csThread { Rc<DxvkContext>() };
+
+    for (uint32_t i = 0; i < ChunkCount; i++) {
+      DxvkCsChunkRef chunk = recordChunk(pool, cmdCount,
+        [&counter] (DxvkContext*) { counter.fetch_add(1, std::memory_order_relaxed); });
+
+      auto d0 = dxvk::high_resolution_clock::now();
+      csThread.dispatchChunk(std::move(chunk));
+      auto d1 = dxvk::high_resolution_clock::now();
+
+      dispatchTime += d1 - d0;
+    }
+
+    csThread.synchronize(DxvkCsThread::SynchronizeAll);
+  }
+
+  auto t1 = dxvk::high_resolution_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+  Logger::info(str::format(name, " (throughput):",
+    "\n  Chunks:          ", ChunkCount,
+    "\n  Commands/chunk:  ", cmdCount,
+    "\n  Total time:      ", ns / 1000000, " ms",
+    "\n  Chunks/s:        ", uint64_t(double(ChunkCount) * 1.0e9 / double(ns)),
+    "\n  ns/dispatch:     ", double(dispatchTime.count()) / double(ChunkCount),
+    "\n  Commands run:    ", counter.load()));
+}
+
+
+/**
+ * \brief Measures dispatch latency
+ *
+ * Measures the time between dispatching a chunk and the
+ * worker starting to execute it. With an idle interval,
+ * the worker will have gone to sleep before each chunk,
+ * so this includes the cost of waking it up.
+ * \param [in] name Name of the implementation
+ * \param [in] idleMs Time to wait between chunks
+ */
+template<typename CsThread>
+void runLatencyTest(
+  const char*       name,
+        uint32_t    idleMs) {
+  constexpr uint32_t ChunkCount = 2048;
+
+  DxvkCsChunkPool pool;
+  CsThread csThread { Rc<DxvkContext>() };
+
+  std::vector<double> latencies;
+  latencies.reserve(ChunkCount);
+
+  for (uint32_t i = 0; i < ChunkCount; i++) {
+    if (idleMs)
+      Sleep(idleMs);
+
+    dxvk::high_resolution_clock::time_point t1;
+
+    DxvkCsChunkRef chunk = recordChunk(pool, 1,
+      [&t1] (DxvkContext*) { t1 = dxvk::high_resolution_clock::now(); });
+
+    auto t0 = dxvk::high_resolution_clock::now();
+    csThread.synchronize(csThread.dispatchChunk(std::move(chunk)));
+
+    latencies.push_back(double(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  Logger::info(str::format(name, " (latency, ", idleMs, " ms idle):",
+    "\n  Median:          ", latencies[latencies.size() / 2] / 1000.0, " us",
+    "\n  99th percentile: ", latencies[latencies.size() * 99 / 100] / 1000.0, " us",
+    "\n  Max:             ", latencies.back() / 1000.0, " us"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  uint32_t cmdCount = argc > 1 ? std::stoi(str::fromws(argv[1])) : 16;
+
+  runThroughputTest<LegacyCsThread>("Mutex",     cmdCount);
+  runThroughputTest<DxvkCsThread>  ("Lock-free", cmdCount);
+
+  for (uint32_t idleMs : { 0u, 1u }) {
+    runLatencyTest<LegacyCsThread>("Mutex",     idleMs);
+    runLatencyTest<DxvkCsThread>  ("Lock-free", idleMs);
+  }
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include <unordered_map>
+
+#include "../../src/dxvk/dxvk_cs_capture.h"
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_instance.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cs-replay.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Replay timings
+ *
+ * Time spent on the CPU for each category of
+ * records, either for one frame or in total.
+ */
+struct ReplayTimings {
+  std::chrono::nanoseconds create = std::chrono::nanoseconds(0);
+  std::chrono::nanoseconds record = std::chrono::nanoseconds(0);
+  std::chrono::nanoseconds submit = std::chrono::nanoseconds(0);
+  uint32_t                 commands = 0;
+
+  ReplayTimings& operator += (const ReplayTimings& other) {
+    create   += other.create;
+    record   += other.record;
+    submit   += other.submit;
+    commands += other.commands;
+    return *this;
+  }
+};
+
+
+static double toMs(std::chrono::nanoseconds ns) {
+  return double(ns.count()) / 1000000.0;
+}
+
+
+static void logTimings(const std::string& prefix, const ReplayTimings& t, uint32_t div) {
+  Logger::info(str::format(prefix,
+    ": ", t.commands / div, " commands",
+    ", record ", toMs(t.record) / double(div), " ms",
+    ", submit ", toMs(t.submit) / double(div), " ms",
+    ", create ", toMs(t.create) / double(div), " ms"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxvk-cs-replay <capture>");
+    Logger::err("Set DXVK_NULL_DEVICE=1 in order to measure CPU overhead without a GPU.");
+    return 1;
+  }
+
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    Rc<DxvkAdapter>  adapter  = instance->enumAdapters(0);
+
+    if (adapter == nullptr) {
+      Logger::err("No Vulkan adapter found");
+      return 1;
+    }
+
+    Rc<DxvkDevice> device = adapter->createDevice(instance, adapter->features());
+
+    DxvkCsCaptureReader reader(device, str::fromws(argv[1]));
+
+    if (!reader.valid()) {
+      Logger::err("Failed to read CS capture");
+      return 1;
+    }
+
+    // Records from different contexts are replayed on
+    // separate contexts, which we create on first use
+    std::unordered_map<uint16_t, Rc<DxvkContext>> contexts;
+
+    ReplayTimings frame;
+    ReplayTimings total;
+    uint32_t      frameCount = 0;
+
+    DxvkCsCaptureRecord record;
+
+    while (reader.readRecord(record)) {
+      if (record.op == DxvkCsCaptureOp::EndFrame) {
+        logTimings(str::format("Frame ", frameCount), frame, 1);
+
+        total += frame;
+        frame  = ReplayTimings();
+        frameCount += 1;
+        continue;
+      }
+
+      bool isCreate = record.op <= DxvkCsCaptureOp::CreateShader;
+
+      DxvkContext* ctx = nullptr;
+
+      if (!isCreate) {
+        auto& entry = contexts[record.contextId];
+
+        if (entry == nullptr) {
+          entry = device->createContext();
+          entry->beginRecording(device->createCommandList());
+        }
+
+        ctx = entry.ptr();
+      }
+
+      auto t0 = dxvk::high_resolution_clock::now();
+      reader.replayRecord(ctx);
+      auto t1 = dxvk::high_resolution_clock::now();
+
+      if (isCreate) {
+        frame.create += t1 - t0;
+      } else if (record.op == DxvkCsCaptureOp::EndRecording) {
+        frame.submit += t1 - t0;
+      } else {
+        frame.record   += t1 - t0;
+        frame.commands += 1;
+      }
+    }
+
+    for (const auto& ctx : contexts) {
+      device->submitCommandList(ctx.second->endRecording(),
+        VK_NULL_HANDLE, VK_NULL_HANDLE);
+    }
+
+    device->waitForIdle();
+
+    if (frameCount)
+      logTimings("Average", total, frameCount);
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,254 @@
+#include <fstream>
+
+#include "../../src/dxvk/dxvk_memory.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-memory-replay.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Stub device state
+ *
+ * Keeps track of the amount of memory that the
+ * allocator would have committed on a real device.
+ */
+struct StubDevice {
+  uint64_t      nextHandle = 1;
+  VkDeviceSize  committed  = 0;
+  VkDeviceSize  peak       = 0;
+  uint32_t      allocCount = 0;
+
+  std::unordered_map<uint64_t, VkDeviceSize> sizes;
+};
+
+static StubDevice g_device;
+
+
+VKAPI_ATTR VkResult VKAPI_CALL stubAllocateMemory(
+        VkDevice                device,
+  const VkMemoryAllocateInfo*   pAllocateInfo,
+  const VkAllocationCallbacks*  pAllocator,
+        VkDeviceMemory*         pMemory) {
+  uint64_t handle = g_device.nextHandle++;
+  g_device.sizes.insert({ handle, pAllocateInfo->allocationSize });
+
+  g_device.committed  += pAllocateInfo->allocationSize;
+  g_device.peak        = std::max(g_device.peak, g_device.committed);
+  g_device.allocCount += 1;
+
+  *pMemory = VkDeviceMemory(handle);
+  return VK_SUCCESS;
+}
+
+
+VKAPI_ATTR void VKAPI_CALL stubFreeMemory(
+        VkDevice                device,
+        VkDeviceMemory          memory,
+  const VkAllocationCallbacks*  pAllocator) {
+  auto entry = g_device.sizes.find(uint64_t(memory));
+  g_device.committed -= entry->second;
+  g_device.sizes.erase(entry);
+}
+
+
+VKAPI_ATTR VkResult VKAPI_CALL stubMapMemory(
+        VkDevice                device,
+        VkDeviceMemory          memory,
+        VkDeviceSize            offset,
+        VkDeviceSize            size,
+        VkMemoryMapFlags        flags,
+        void**                  ppData) {
+  // The allocator only computes pointers into mapped
+  // memory and never accesses it, so any unique and
+  // non-null address will do here.
+  *ppData = reinterpret_cast<void*>(uintptr_t(uint64_t(memory)) << 20);
+  return VK_SUCCESS;
+}
+
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL stubGetDeviceProcAddr(
+        VkDevice                device,
+  const char*                   pName) {
+  std::string name = pName;
+
+  if (name == "vkAllocateMemory")
+    return reinterpret_cast<PFN_vkVoidFunction>(&stubAllocateMemory);
+  if (name == "vkFreeMemory")
+    return reinterpret_cast<PFN_vkVoidFunction>(&stubFreeMemory);
+  if (name == "vkMapMemory")
+    return reinterpret_cast<PFN_vkVoidFunction>(&stubMapMemory);
+
+  return nullptr;
+}
+
+
+/**
+ * \brief Reads a memory trace
+ *
+ * \param [in] fileName Trace file
+ * \param [out] header Trace header
+ * \param [out] entries Trace entries
+ * \returns \c true on success
+ */
+bool readTrace(
+  const std::string&                  fileName,
+        DxvkMemoryTraceHeader&        header,
+        std::vector<DxvkMemoryTraceEntry>& entries) {
+  std::ifstream file(fileName, std::ios_base::binary);
+
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+   || !DxvkMemoryTraceWriter::validateHeader(header))
+    return false;
+
+  DxvkMemoryTraceEntry entry;
+
+  while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry)))
+    entries.push_back(entry);
+
+  return true;
+}
+
+
+void replayTrace(
+  const DxvkMemoryTraceHeader&              header,
+  const std::vector<DxvkMemoryTraceEntry>&  entries,
+        int32_t                             chunkSizeMib) {
+  g_device = StubDevice();
+
+  Config config;
+  config.setOption("dxvk.memoryChunkSize", std::to_string(chunkSizeMib));
+
+  DxvkOptions options(config);
+
+  VkPhysicalDeviceProperties devProps = { };
+
+  Rc<vk::DeviceFn> vkd = new vk::DeviceFn(false,
+    VK_NULL_HANDLE, &stubGetDeviceProcAddr);
+
+  DxvkMemoryAllocator allocator(vkd, options, devProps, header.memProps);
+
+  std::vector<DxvkMemory> allocs;
+
+  uint32_t frameId    = entries.empty() ? 0 : entries[0].frameId;
+  uint32_t frameCount = 0;
+  uint32_t failed     = 0;
+
+  double fragSum     = 0.0;
+  double fragAtPeak  = 0.0;
+
+  VkDeviceSize peakCommitted = 0;
+
+  std::chrono::nanoseconds opTime(0);
+
+  auto t0 = dxvk::high_resolution_clock::now();
+
+  for (const auto& e : entries) {
+    if (e.frameId != frameId) {
+      auto t1 = dxvk::high_resolution_clock::now();
+      opTime += t1 - t0;
+
+      // Sample fragmentation at the end of each frame,
+      // i.e. the fraction of committed memory not in use
+      VkDeviceSize allocated = 0;
+      VkDeviceSize used      = 0;
+
+      for (uint32_t i = 0; i < header.memProps.memoryHeapCount; i++) {
+        DxvkMemoryStats stats = allocator.getMemoryStats(i);
+        allocated += stats.memoryAllocated;
+        used      += stats.memoryUsed;
+      }
+
+      double frag = allocated ? 1.0 - double(used) / double(allocated) : 0.0;
+      fragSum += frag;
+
+      if (allocated > peakCommitted) {
+        peakCommitted = allocated;
+        fragAtPeak    = frag;
+      }
+
+      frameId     = e.frameId;
+      frameCount += 1;
+
+      allocator.trimChunks(frameId);
+      t0 = dxvk::high_resolution_clock::now();
+    }
+
+    if (e.allocId >= allocs.size())
+      allocs.resize(e.allocId + 1);
+
+    if (e.op == DxvkMemoryTraceOp::Alloc) {
+      VkMemoryRequirements req;
+      req.size           = e.size;
+      req.alignment      = VkDeviceSize(1) << e.alignLog2;
+      req.memoryTypeBits = e.memoryTypeBits;
+
+      VkMemoryDedicatedRequirements dedReq = { };
+      dedReq.sType                       = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+      dedReq.prefersDedicatedAllocation  = (e.dedicated & DxvkMemoryTracePrefersDedicated)  ? VK_TRUE : VK_FALSE;
+      dedReq.requiresDedicatedAllocation = (e.dedicated & DxvkMemoryTraceRequiresDedicated) ? VK_TRUE : VK_FALSE;
+
+      VkMemoryDedicatedAllocateInfo dedInfo = { };
+      dedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+
+      try {
+        allocs[e.allocId] = allocator.alloc(&req, dedReq, dedInfo, e.memFlags, e.priority);
+      } catch (const DxvkError&) {
+        failed += 1;
+      }
+    } else {
+      allocs[e.allocId] = DxvkMemory();
+    }
+  }
+
+  opTime += dxvk::high_resolution_clock::now() - t0;
+
+  Logger::info(str::format("Chunk size: ",
+    chunkSizeMib ? str::format(chunkSizeMib, " MB") : std::string("default"),
+    "\n  Operations:      ", entries.size(),
+    "\n  Frames:          ", frameCount,
+    "\n  ns/op:           ", double(opTime.count()) / double(std::max<size_t>(entries.size(), 1)),
+    "\n  Failed:          ", failed,
+    "\n  Device allocs:   ", g_device.allocCount,
+    "\n  Peak committed:  ", g_device.peak >> 20, " MB",
+    "\n  Fragmentation:   ", 100.0 * (frameCount ? fragSum / double(frameCount) : 0.0), "% (average), ",
+                             100.0 * fragAtPeak, "% (at peak)"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxvk-memory-replay <trace> [chunk size in MB]...");
+    return 1;
+  }
+
+  DxvkMemoryTraceHeader header;
+  std::vector<DxvkMemoryTraceEntry> entries;
+
+  if (!readTrace(str::fromws(argv[1]), header, entries)) {
+    Logger::err("Failed to read memory trace");
+    return 1;
+  }
+
+  if (argc == 2)
+    replayTrace(header, entries, 0);
+
+  for (int i = 2; i < argc; i++)
+    replayTrace(header, entries, std::stoi(str::fromws(argv[i])));
+
+  return 0;
+}
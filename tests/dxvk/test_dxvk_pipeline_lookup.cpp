@@ -0,0 +1,109 @@
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_graphics.h"
+
+#include "../../src/util/util_time.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-pipeline-lookup.log");
+}
+
+using namespace dxvk;
+
+constexpr uint32_t LookupCount = 1000000;
+
+/**
+ * \brief Creates distinct pipeline states
+ *
+ * Only varies a spec constant and the stride of the
+ * last vertex binding, so that the linear search has
+ * to compare most of the state vector in each step.
+ */
+std::vector<DxvkGraphicsPipelineStateInfo> createStates(uint32_t count) {
+  std::vector<DxvkGraphicsPipelineStateInfo> states(count);
+
+  for (uint32_t i = 0; i < count; i++) {
+    states[i].sc.specConstants[0] = i % 7;
+    states[i].ilBindings[MaxNumVertexBindings - 1] = DxvkIlBinding(
+      MaxNumVertexBindings - 1, 4 * (i / 7), VK_VERTEX_INPUT_RATE_VERTEX, 0);
+  }
+
+  return states;
+}
+
+
+void runBenchmark(uint32_t instanceCount) {
+  auto states = createStates(instanceCount);
+
+  // Same as the render pass pointer, only used for comparisons
+  auto rp = reinterpret_cast<const DxvkRenderPass*>(uintptr_t(0x1000));
+
+  std::deque<DxvkGraphicsPipelineInstance> instances;
+  DxvkGraphicsPipelineInstanceTable table;
+
+  for (uint32_t i = 0; i < instanceCount; i++) {
+    auto instance = &instances.emplace_back(states[i], states[i].hash(),
+      rp, VkPipeline(uint64_t(i + 1)));
+    table.insert(instance);
+  }
+
+  // Look up instances in random order to defeat
+  // branch prediction on the linear search
+  std::mt19937 rng(instanceCount);
+  std::uniform_int_distribution<uint32_t> dist(0, instanceCount - 1);
+
+  std::vector<uint32_t> indices(LookupCount);
+
+  for (auto& index : indices)
+    index = dist(rng);
+
+  uint64_t linearSum = 0;
+  uint64_t hashedSum = 0;
+
+  auto t0 = dxvk::high_resolution_clock::now();
+
+  for (uint32_t index : indices) {
+    for (auto& instance : instances) {
+      if (instance.isCompatible(states[index], rp)) {
+        linearSum += uint64_t(instance.pipeline());
+        break;
+      }
+    }
+  }
+
+  auto t1 = dxvk::high_resolution_clock::now();
+
+  for (uint32_t index : indices) {
+    auto instance = table.find(states[index], rp);
+
+    if (instance)
+      hashedSum += uint64_t(instance->pipeline());
+  }
+
+  auto t2 = dxvk::high_resolution_clock::now();
+
+  auto linearNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+  auto hashedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1);
+
+  Logger::info(str::format(instanceCount, " instances:",
+    "\n  Linear: ", double(linearNs.count()) / double(LookupCount), " ns/lookup",
+    "\n  Hashed: ", double(hashedNs.count()) / double(LookupCount), " ns/lookup",
+    linearSum == hashedSum ? "" : "\n  Results do not match"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  for (uint32_t count : { 1u, 10u, 100u, 1000u })
+    runBenchmark(count);
+
+  return 0;
+}
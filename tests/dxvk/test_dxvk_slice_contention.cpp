@@ -0,0 +1,203 @@
+#include <atomic>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_buffer.h"
+
+#include "../../src/util/thread.h"
+#include "../../src/util/util_time.h"
+
+#include "../../src/util/sync/sync_list.h"
+#include "../../src/util/sync/sync_spinlock.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-slice-contention.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Reference implementation
+ *
+ * Free list handling that \c DxvkBuffer used before
+ * switching to a lock-free return stack. Every freed
+ * slice takes a lock that the allocating thread also
+ * needs when it runs out of slices.
+ */
+class LegacySlicePool {
+
+public:
+
+  bool alloc(DxvkBufferSliceHandle& slice) {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+
+    if (m_freeSlices.empty()) {
+      std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+      std::swap(m_freeSlices, m_nextSlices);
+    }
+
+    if (m_freeSlices.empty())
+      return false;
+
+    slice = m_freeSlices.back();
+    m_freeSlices.pop_back();
+    return true;
+  }
+
+  void free(std::vector<DxvkBufferSliceHandle>&& slices) {
+    for (const auto& slice : slices) {
+      std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+      m_nextSlices.push_back(slice);
+    }
+  }
+
+private:
+
+  sync::Spinlock m_freeMutex;
+  sync::Spinlock m_swapMutex;
+
+  std::vector<DxvkBufferSliceHandle> m_freeSlices;
+  std::vector<DxvkBufferSliceHandle> m_nextSlices;
+
+};
+
+
+/**
+ * \brief Lock-free implementation
+ *
+ * Mirrors what \c DxvkBuffer does now. Slices are
+ * returned in batches through a lock-free stack.
+ */
+class LockFreeSlicePool {
+
+public:
+
+  bool alloc(DxvkBufferSliceHandle& slice) {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+
+    if (m_freeSlices.empty()) {
+      m_returnedSlices.drain([this] (const std::vector<DxvkBufferSliceHandle>& slices) {
+        m_freeSlices.insert(m_freeSlices.end(), slices.begin(), slices.end());
+      });
+    }
+
+    if (m_freeSlices.empty())
+      return false;
+
+    slice = m_freeSlices.back();
+    m_freeSlices.pop_back();
+    return true;
+  }
+
+  void free(std::vector<DxvkBufferSliceHandle>&& slices) {
+    m_returnedSlices.emplace([&slices] (std::vector<DxvkBufferSliceHandle>& item) {
+      item.assign(slices.begin(), slices.end());
+    });
+  }
+
+private:
+
+  sync::Spinlock m_freeMutex;
+
+  std::vector<DxvkBufferSliceHandle> m_freeSlices;
+
+  sync::MpscStack<std::vector<DxvkBufferSliceHandle>> m_returnedSlices;
+
+};
+
+
+/**
+ * \brief Runs the benchmark for one implementation
+ *
+ * Each producer thread returns a fixed number of slices
+ * in batches, which simulates command lists completing
+ * on the queue thread. The main thread allocates slices
+ * until all of them have been consumed, which simulates
+ * the application discarding the buffer.
+ * \param [in] name Name of the implementation
+ * \param [in] threadCount Number of producer threads
+ * \param [in] batchSize Number of slices freed at once
+ */
+template<typename Pool>
+void runBenchmark(
+  const char*       name,
+        uint32_t    threadCount,
+        uint32_t    batchSize) {
+  constexpr uint32_t SlicesPerThread = 1 << 20;
+
+  Pool pool;
+
+  std::atomic<bool> start = { false };
+  std::vector<dxvk::thread> threads;
+
+  for (uint32_t i = 0; i < threadCount; i++) {
+    threads.emplace_back([&pool, &start, i, batchSize] {
+      while (!start.load())
+        continue;
+
+      for (uint32_t j = 0; j < SlicesPerThread; j += batchSize) {
+        std::vector<DxvkBufferSliceHandle> slices(batchSize);
+
+        for (uint32_t k = 0; k < batchSize; k++) {
+          slices[k].handle = VK_NULL_HANDLE;
+          slices[k].offset = VkDeviceSize(i) << 32 | (j + k);
+          slices[k].length = 256;
+          slices[k].mapPtr = nullptr;
+        }
+
+        pool.free(std::move(slices));
+      }
+    });
+  }
+
+  uint64_t total    = uint64_t(threadCount) * SlicesPerThread;
+  uint64_t consumed = 0;
+  uint64_t misses   = 0;
+
+  auto t0 = dxvk::high_resolution_clock::now();
+  start.store(true);
+
+  while (consumed < total) {
+    DxvkBufferSliceHandle slice;
+
+    if (pool.alloc(slice))
+      consumed += 1;
+    else
+      misses += 1;
+  }
+
+  auto t1 = dxvk::high_resolution_clock::now();
+
+  for (auto& thread : threads)
+    thread.join();
+
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+
+  Logger::info(str::format(name, ":",
+    "\n  Threads:         ", threadCount,
+    "\n  Batch size:      ", batchSize,
+    "\n  Total time:      ", ns / 1000000, " ms",
+    "\n  ns/slice:        ", double(ns) / double(total),
+    "\n  Empty polls:     ", misses));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  uint32_t threadCount = argc > 1 ? std::stoi(str::fromws(argv[1])) : 4;
+  uint32_t batchSize   = argc > 2 ? std::stoi(str::fromws(argv[2])) : 16;
+
+  runBenchmark<LegacySlicePool>  ("Spinlock",  threadCount, batchSize);
+  runBenchmark<LockFreeSlicePool>("Lock-free", threadCount, 1);
+  runBenchmark<LockFreeSlicePool>("Lock-free", threadCount, batchSize);
+  return 0;
+}